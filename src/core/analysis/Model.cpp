@@ -247,6 +247,25 @@ const std::vector<DagNode *>& Model::getDagNodes() const
 }
 
 
+/**
+ * Can independent copies of this model be used on different threads at the same time?
+ * This is the case if all DAG nodes are thread safe.
+ */
+bool Model::isThreadSafe() const
+{
+    
+    for (size_t i = 0; i < nodes.size(); ++i)
+    {
+        if ( nodes[i]->isThreadSafe() == false )
+        {
+            return false;
+        }
+    }
+    
+    return true;
+}
+
+
 /**
  * Non-constant getter function for the vector of DAG nodes of the model.
  *
@@ -47,6 +47,7 @@ namespace RevBayesCore {
         const std::vector<DagNode*>&                                getDagNodes() const;                                        //!< Constant getter function of the set of DAG nodes contained in the model graph.
         const DagNodeMap&                                           getNodesMap() const;                                        //!< Constant getter function of the map between the pointer of the original DAG nodes to the pointers of the copied DAG nodes.
         std::vector<DagNode*>                                       getOrderedStochasticNodes();  //!< Get vector of nodes in parent-children order, starting from the first node
+        bool                                                        isThreadSafe() const;                                       //!< Can independent copies of this model be used on different threads at the same time?
         
     protected:
         void                                                        setActivePIDSpecialized(size_t i, size_t n);   //!< Set the active PID and number of processes for this model.
@@ -25,6 +25,7 @@
 #include "RbVector.h"
 #include "RbVectorImpl.h"
 #include "StoppingRule.h"
+#include "ThreadPool.h"
 #include "Trace.h"
 
 
@@ -58,6 +59,7 @@ MonteCarloAnalysis::MonteCarloAnalysis(MonteCarloSampler *m, size_t r, MonteCarl
 MonteCarloAnalysis::MonteCarloAnalysis(const MonteCarloAnalysis &a) : Cloneable(), Parallelizable(a),
     replicates( a.replicates ),
     runs(a.replicates,NULL),
+    replicate_rngs( a.replicate_rngs ),
     trace_combination( a.trace_combination )
 {
     
@@ -113,6 +115,7 @@ MonteCarloAnalysis& MonteCarloAnalysis::operator=(const MonteCarloAnalysis &a)
         runs = std::vector<MonteCarloSampler*>(a.replicates,NULL);
         
         replicates          = a.replicates;
+        replicate_rngs      = a.replicate_rngs;
         trace_combination   = a.trace_combination;
         
         // create replicate Monte Carlo samplers
@@ -169,15 +172,7 @@ void MonteCarloAnalysis::burnin(size_t generations, size_t tuningInterval, bool
 {
     
     // Initialize objects needed by chain
-    for (size_t i=0; i<replicates; ++i)
-    {
-        
-        if ( runs[i] != NULL )
-        {
-            runs[i]->initializeSampler(underPrior);
-        }
-        
-    }
+    runReplicates( [&](size_t i) { runs[i]->initializeSampler(underPrior); } );
     
     
     // reset the counters for the move schedules
@@ -218,22 +213,17 @@ void MonteCarloAnalysis::burnin(size_t generations, size_t tuningInterval, bool
             progress.update(k);
         }
         
-        for (size_t i=0; i<replicates; ++i)
+        runReplicates( [&](size_t i)
         {
+            runs[i]->nextCycle(false);
             
-            if ( runs[i] != NULL )
+            // check for autotuning
+            if ( k % tuningInterval == 0 && k != generations )
             {
-                runs[i]->nextCycle(false);
-                
-                // check for autotuning
-                if ( k % tuningInterval == 0 && k != generations )
-                {
-                    runs[i]->tune();
-                }
-                
+                runs[i]->tune();
             }
             
-        }
+        } );
         
     }
     
@@ -338,6 +328,7 @@ void MonteCarloAnalysis::initializeFromCheckpoint(const path &checkpoint_file)
         }
         
         // then, initialize the sample for that replicate
+        ScopedRandomNumberGenerator scoped_rng( &replicate_rngs[i] );
         runs[i]->initializeSamplerFromCheckpoint();
     }
 }
@@ -552,17 +543,17 @@ void MonteCarloAnalysis::resetReplicates( void )
         
     }
     
-    // get new random starting values
-    size_t replicate_start = size_t(floor( (double(pid-active_PID) / num_processes ) * replicates ) ) + active_PID;
-    
-    RandomNumberGenerator *rng = GLOBAL_RNG;
-    for (size_t j=0; j<(2*replicate_start); ++j) rng->uniform01();
+    // split the random number generator into one stream per replicate
+    // all processes create the same streams, so a replicate gets the same random numbers on whichever process it runs
+    replicate_rngs = GLOBAL_RNG->createStreams( replicates );
     
     
     // redraw initial states for replicates
     for (size_t i = 0; i < replicates; ++i)
     {
         
+        ScopedRandomNumberGenerator scoped_rng( &replicate_rngs[i] );
+        
         if ( i > 0 && runs[i] != NULL )
         {
             runs[i]->redrawStartingValues();
@@ -588,14 +579,6 @@ void MonteCarloAnalysis::resetReplicates( void )
         
     }
     
-    // to be safe, we should synchronize the random number generators
-    // Sebastian: We cannot re-synchronize the RNG after we just shifted it.
-    // If an anlysis has all values preset, then each replicate would be identical!!!
-//#ifdef RB_MPI
-//    MpiUtilities::synchronizeRNG( analysis_comm );
-//#else
-//    MpiUtilities::synchronizeRNG(  );
-//#endif
 }
 
 
@@ -660,6 +643,15 @@ void MonteCarloAnalysis::run( size_t kIterations, RbVector<StoppingRule> rules,
         RBOUT( ss.str() );
     }
     
+    // tell the stopping rules about the replicates before the monitors write anything,
+    // so that the convergence rules can collect the samples while they are written
+    for (size_t i=0; i<rules.size(); ++i)
+    {
+        
+        rules[i].setNumberOfRuns( replicates );
+        
+    }
+    
     // Start monitor(s)
     for (size_t i=0; i<replicates; ++i)
     {
@@ -694,6 +686,7 @@ void MonteCarloAnalysis::run( size_t kIterations, RbVector<StoppingRule> rules,
         
         if ( runs[i] != NULL && runs[i]->getCurrentGeneration() == 0 )
         {
+            ScopedRandomNumberGenerator scoped_rng( &replicate_rngs[i] );
             
             runs[i]->writeMonitorHeaders( false );
             runs[i]->monitor(0);
@@ -721,7 +714,6 @@ void MonteCarloAnalysis::run( size_t kIterations, RbVector<StoppingRule> rules,
     for (size_t i=0; i<rules.size(); ++i)
     {
         
-        rules[i].setNumberOfRuns( replicates );
         rules[i].runStarted();
         
     }
@@ -732,39 +724,33 @@ void MonteCarloAnalysis::run( size_t kIterations, RbVector<StoppingRule> rules,
     do {
         
         ++gen;
-        for (size_t i=0; i<replicates; ++i)
+        
+        // the replicates run concurrently; we wait for all of them before we apply the stopping rules
+        runReplicates( [&](size_t i)
         {
             
-            if ( runs[i] != NULL )
+            runs[i]->nextCycle(true);
+            
+            // Monitor
+            runs[i]->monitor(gen);
+            
+            // check for autotuning
+            if ( tuning_interval != 0 && (gen % tuning_interval) == 0 )
             {
                 
-                // @todo: #thread
-                // This part should be done on several threads if possible
-                // Sebastian: this call is very slow; a lot of work happens in nextCycle()
-                runs[i]->nextCycle(true);
+                runs[i]->tune();
                 
-                // Monitor
-                runs[i]->monitor(gen);
+            }
+            
+            // check for autotuning
+            if ( checkpoint_interval != 0 && (gen % checkpoint_interval) == 0 )
+            {
                 
-                // check for autotuning
-                if ( tuning_interval != 0 && (gen % tuning_interval) == 0 )
-                {
-                    
-                    runs[i]->tune();
-                    
-                }
-                
-                // check for autotuning
-                if ( checkpoint_interval != 0 && (gen % checkpoint_interval) == 0 )
-                {
-                    
-                    runs[i]->checkpoint();
-                    
-                }
+                runs[i]->checkpoint();
                 
             }
             
-        }
+        } );
         
         converged = true;
         size_t numConvergenceRules = 0;
@@ -808,6 +794,14 @@ void MonteCarloAnalysis::run( size_t kIterations, RbVector<StoppingRule> rules,
         
     }
     
+    // the monitors are done, so the stopping rules can release what they kept during the run
+    for (size_t i=0; i<rules.size(); ++i)
+    {
+        
+        rules[i].runEnded();
+        
+    }
+    
     
 #ifdef RB_MPI
     // wait until all replicates complete
@@ -823,6 +817,49 @@ void MonteCarloAnalysis::run( size_t kIterations, RbVector<StoppingRule> rules,
 
 
 
+/**
+ * Apply a task to all replicates of this process.
+ * The replicates are independent (each has its own model, monitors and random number stream),
+ * so we run them concurrently on the thread pool. This function returns once all replicates are done.
+ *
+ * \param[in]    task    The task, called with the index of the replicate.
+ */
+void MonteCarloAnalysis::runReplicates( const std::function<void(size_t)> &task )
+{
+    
+    bool thread_safe = true;
+    std::vector< std::function<void(void)> > replicate_tasks;
+    for (size_t i=0; i<replicates; ++i)
+    {
+        
+        if ( runs[i] != NULL )
+        {
+            thread_safe &= runs[i]->getModel().isThreadSafe();
+            replicate_tasks.push_back( [this, &task, i]
+            {
+                ScopedRandomNumberGenerator scoped_rng( &replicate_rngs[i] );
+                task( i );
+            } );
+        }
+        
+    }
+    
+    if ( thread_safe == true )
+    {
+        ThreadPool::threadPoolInstance().run( replicate_tasks );
+    }
+    else
+    {
+        // some part of the model cannot be used concurrently, so we run the replicates one after the other
+        for (size_t i=0; i<replicate_tasks.size(); ++i)
+        {
+            replicate_tasks[i]();
+        }
+    }
+    
+}
+
+
 void MonteCarloAnalysis::runPriorSampler( size_t kIterations, RbVector<StoppingRule> rules, size_t tuning_interval )
 {
     
@@ -857,17 +894,15 @@ void MonteCarloAnalysis::runPriorSampler( size_t kIterations, RbVector<StoppingR
     }
     
     // Initialize objects needed by chain
-    for (size_t i=0; i<replicates; ++i)
+    runReplicates( [&](size_t i) { runs[i]->initializeSampler(true); } );
+    
+    
+    // tell the stopping rules about the replicates before the monitors write anything
+    for (size_t i=0; i<rules.size(); ++i)
     {
-        
-        if ( runs[i] != NULL )
-        {
-            runs[i]->initializeSampler(true);
-        }
-        
+        rules[i].setNumberOfRuns( replicates );
     }
     
-    
     // Start monitor(s)
     for (size_t i=0; i<replicates; ++i)
     {
@@ -902,6 +937,7 @@ void MonteCarloAnalysis::runPriorSampler( size_t kIterations, RbVector<StoppingR
         
         if ( runs[i] != NULL && runs[i]->getCurrentGeneration() == 0 )
         {
+            ScopedRandomNumberGenerator scoped_rng( &replicate_rngs[i] );
             
             runs[i]->writeMonitorHeaders( false );
             runs[i]->monitor(0);
@@ -923,7 +959,6 @@ void MonteCarloAnalysis::runPriorSampler( size_t kIterations, RbVector<StoppingR
     // reset the stopping rules
     for (size_t i=0; i<rules.size(); ++i)
     {
-        rules[i].setNumberOfRuns( replicates );
         rules[i].runStarted();
     }
     
@@ -933,25 +968,21 @@ void MonteCarloAnalysis::runPriorSampler( size_t kIterations, RbVector<StoppingR
     bool converged = false;
     do {
         ++gen;
-        for (size_t i=0; i<replicates; ++i)
+        runReplicates( [&](size_t i)
         {
-            if ( runs[i] != NULL )
+            runs[i]->nextCycle(true);
+            
+            // Monitor
+            runs[i]->monitor(gen);
+            
+            // check for autotuning
+            if ( tuning_interval != 0 && (gen % tuning_interval) == 0 )
             {
-                runs[i]->nextCycle(true);
                 
-                // Monitor
-                runs[i]->monitor(gen);
+                runs[i]->tune();
                 
-                // check for autotuning
-                if ( tuning_interval != 0 && (gen % tuning_interval) == 0 )
-                {
-                    
-                    runs[i]->tune();
-                    
-                }
             }
-
-        }
+        } );
         
         converged = true;
         size_t numConvergenceRules = 0;
@@ -994,6 +1025,14 @@ void MonteCarloAnalysis::runPriorSampler( size_t kIterations, RbVector<StoppingR
         
     }
     
+    // the monitors are done, so the stopping rules can release what they kept during the run
+    for (size_t i=0; i<rules.size(); ++i)
+    {
+        
+        rules[i].runEnded();
+        
+    }
+    
     
 #ifdef RB_MPI
     // wait until all replicates complete
@@ -5,10 +5,12 @@
 #include "MonteCarloAnalysisOptions.h"
 #include "RbFileManager.h"
 #include "Parallelizable.h"
+#include "RandomNumberGenerator.h"
 #include "RbVector.h"
 #include "StoppingRule.h"
 #include "Trace.h"
 
+#include <functional>
 #include <vector>
 
 
@@ -26,6 +28,10 @@ namespace RevBayesCore {
      *
      * The Monte Carlo Analysis object is mostly used to run independent MonteCarloSamplers
      * and check for convergence between them.
+     * Each replicate draws its random numbers from its own stream of the global random number generator,
+     * so the replicates are reproducible independent of how they are distributed among processes.
+     * The replicates of one process run concurrently on the thread pool and only synchronize
+     * at the end of each iteration, where the stopping rules are evaluated.
      *
      *
      * @copyright Copyright 2009-
@@ -78,9 +84,11 @@ namespace RevBayesCore {
 #else
         void                                                resetReplicates(void);
 #endif
+        void                                                runReplicates(const std::function<void(size_t)> &task);          //!< Apply the task to all replicates of this process, concurrently on the thread pool
 
         size_t                                              replicates;
         std::vector<MonteCarloSampler*>                     runs;
+        std::vector<RandomNumberGenerator>                  replicate_rngs;                                                 //!< One independent random number stream per replicate
         MonteCarloAnalysisOptions::TraceCombinationTypes    trace_combination;
     };
     
@@ -11,6 +11,8 @@
 #include "HomologousDiscreteCharacterData.h"
 #include "PosteriorPredictiveSimulation.h"
 #include "StateDependentSpeciationExtinctionProcess.h"
+#include "RandomNumberFactory.h"
+#include "RandomNumberGenerator.h"
 #include "RbFileManager.h"
 #include "AbstractHomologousDiscreteCharacterData.h"
 #include "Cloneable.h"
@@ -95,10 +97,16 @@ void RevBayesCore::PosteriorPredictiveSimulation::run( int thinning )
     while ( index_sample % thinning > 0 ) ++index_sample;
     size_t current_pp_sim = size_t( floor( index_sample / thinning ) );
     
+    // every simulation gets its own random number stream
+    // so that the simulated data do not depend on how the simulations are distributed among processes
+    size_t n_sims = (n_samples + thinning - 1) / thinning;
+    std::vector<RandomNumberGenerator> sim_rngs = GLOBAL_RNG->createStreams( n_sims );
     
     for ( ; index_sample <= sim_pid_end; ++current_pp_sim, index_sample += thinning)
     {
         
+        ScopedRandomNumberGenerator scoped_rng( &sim_rngs[current_pp_sim] );
+        
         
         // create a new directory name for this simulation
         path sim_directory_name = directory / ("posterior_predictive_sim_" + std::to_string(current_pp_sim + 1));
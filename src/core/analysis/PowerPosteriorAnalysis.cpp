@@ -1,9 +1,13 @@
 #include <stddef.h>
 #include <cmath>
+#include <functional>
 #include <iostream>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
 
+#include "Model.h"
 #include "MonteCarloSampler.h"
 #include "MoveSchedule.h"
 #include "MpiUtilities.h"
@@ -14,7 +18,9 @@
 #include "Cloneable.h"
 #include "MonteCarloAnalysisOptions.h"
 #include "Parallelizable.h"
+#include "RandomNumberFactory.h"
 #include "StringUtilities.h"
+#include "ThreadPool.h"
 
 
 #ifdef RB_MPI
@@ -28,7 +34,9 @@ PowerPosteriorAnalysis::PowerPosteriorAnalysis(MonteCarloSampler *m, const path
     powers(),
     sampler( m ),
     sampleFreq( 100 ),
-    processors_per_likelihood( k )
+    processors_per_likelihood( k ),
+    independent_stones( false ),
+    print_stone_progress( true )
 {
     
     initMPI();
@@ -40,7 +48,10 @@ PowerPosteriorAnalysis::PowerPosteriorAnalysis(const PowerPosteriorAnalysis &a)
     powers( a.powers ),
     sampler( a.sampler->clone() ),
     sampleFreq( a.sampleFreq ),
-    processors_per_likelihood( a.processors_per_likelihood )
+    processors_per_likelihood( a.processors_per_likelihood ),
+    independent_stones( a.independent_stones ),
+    stone_rngs( a.stone_rngs ),
+    print_stone_progress( a.print_stone_progress )
 {
     
 }
@@ -71,6 +82,9 @@ PowerPosteriorAnalysis& PowerPosteriorAnalysis::operator=(const PowerPosteriorAn
         sampler                         = a.sampler->clone();
         sampleFreq                      = a.sampleFreq;
         processors_per_likelihood       = a.processors_per_likelihood;
+        independent_stones              = a.independent_stones;
+        stone_rngs                      = a.stone_rngs;
+        print_stone_progress            = a.print_stone_progress;
         
     }
     
@@ -189,15 +203,38 @@ void PowerPosteriorAnalysis::runAll(size_t gen, double burnin_fraction, size_t p
     size_t stone_block_start =  floor( ( floor( pid   /double(processors_per_likelihood)) / (double(num_processes) / processors_per_likelihood) ) * powers.size() );
     size_t stone_block_end   =  floor( ( ceil( (pid+1)/double(processors_per_likelihood)) / (double(num_processes) / processors_per_likelihood) ) * powers.size() );
     
-    // Run the chain
+    // every independent stone gets its own random number stream
+    // so that a stone gives the same result independent of the process or thread it runs on
+    if ( independent_stones == true )
+    {
+        stone_rngs = GLOBAL_RNG->createStreams( powers.size() );
+    }
+    
+    // independent stones can run concurrently, chained stones continue from the state of the previous stone
+    std::vector< std::function<void(void)> > stone_tasks;
     for (size_t i = stone_block_start; i < stone_block_end; ++i)
     {
     
         // run the i-th stone
-        runStone(i, gen, burnin_fraction, pre_burnin_generations, tuning_interval);
+        stone_tasks.push_back( [=]{ runStone(i, gen, burnin_fraction, pre_burnin_generations, tuning_interval); } );
         
     }
     
+    ThreadPool &pool = ThreadPool::threadPoolInstance();
+    bool concurrent = independent_stones == true && pool.getNumberOfThreads() > 1 && stone_tasks.size() > 1 && sampler->getModel().isThreadSafe() == true;
+    print_stone_progress = (concurrent == false);
+    if ( concurrent == true )
+    {
+        pool.run( stone_tasks );
+    }
+    else
+    {
+        for (size_t i = 0; i < stone_tasks.size(); ++i)
+        {
+            stone_tasks[i]();
+        }
+    }
+    
 #ifdef RB_MPI
     // wait until all chains complete
     MPI_Barrier(MPI_COMM_WORLD);
@@ -217,7 +254,48 @@ void PowerPosteriorAnalysis::runAll(size_t gen, double burnin_fraction, size_t p
 
 
 
+/**
+ * Run the stone with the given index.
+ * Chained stones continue on the sampler of the analysis, i.e. from the state of the previous stone.
+ * Independent stones start from their own copy of the burnt-in sampler and draw from their own random number stream.
+ */
 void PowerPosteriorAnalysis::runStone(size_t idx, size_t gen, double burnin_fraction, size_t pre_burnin_generations, size_t tuning_interval)
+{
+    
+    if ( independent_stones == false )
+    {
+        runStone( *sampler, idx, gen, burnin_fraction, pre_burnin_generations, tuning_interval );
+        return;
+    }
+    
+    // every stone starts from its own copy of the (burnt-in) sampler
+    std::unique_ptr<MonteCarloSampler> stone_sampler;
+    {
+        std::lock_guard<std::mutex> lock( sampler_mutex );
+        stone_sampler.reset( sampler->clone() );
+        
+        if ( stone_rngs.size() != powers.size() )
+        {
+            stone_rngs = GLOBAL_RNG->createStreams( powers.size() );
+        }
+    }
+    
+    // all random numbers of this stone come from its own stream
+    ScopedRandomNumberGenerator scoped_rng( &stone_rngs[idx] );
+    
+    runStone( *stone_sampler, idx, gen, burnin_fraction, pre_burnin_generations, tuning_interval );
+    
+    // the stones run concurrently, so we only report that this one is done
+    if ( process_active == true && print_stone_progress == false )
+    {
+        std::lock_guard<std::mutex> lock( output_mutex );
+        std::cout << "Step " << (idx+1) << " / " << powers.size() << " finished" << std::endl;
+    }
+    
+}
+
+
+void PowerPosteriorAnalysis::runStone(MonteCarloSampler &stone_sampler, size_t idx, size_t gen, double burnin_fraction, size_t pre_burnin_generations, size_t tuning_interval)
 {
     // create the directory if necessary
     if (filename.filename().empty() or filename.filename_is_dot() or filename.filename_is_dot_dot())
@@ -234,7 +312,7 @@ void PowerPosteriorAnalysis::runStone(size_t idx, size_t gen, double burnin_frac
     outStream << "state\t" << "power\t" << "likelihood" << std::endl;
 
     // reset the sampler
-    sampler->reset();
+    stone_sampler.reset();
 
     size_t burnin = size_t( ceil( burnin_fraction*gen ) );
     
@@ -242,7 +320,7 @@ void PowerPosteriorAnalysis::runStone(size_t idx, size_t gen, double burnin_frac
     size_t digits = size_t( ceil( log10( powers.size() ) ) );
     
     // print output for users
-    if ( process_active ==true )
+    if ( process_active == true && print_stone_progress == true )
     {
         std::cout << "Step ";
         for (size_t d = size_t( ceil( log10( idx+1.1 ) ) ); d < digits; d++ )
@@ -255,34 +333,34 @@ void PowerPosteriorAnalysis::runStone(size_t idx, size_t gen, double burnin_frac
     }
     
     // set the power of this sampler
-    sampler->setLikelihoodHeat( powers[idx] );
+    stone_sampler.setLikelihoodHeat( powers[idx] );
     
-    sampler->addFileMonitorExtension( stone_tag, false);
+    stone_sampler.addFileMonitorExtension( stone_tag, false);
     
     // let's do a pre-burnin
     for (size_t k=1; k<=pre_burnin_generations; k++)
     {
         
-        sampler->nextCycle(false);
+        stone_sampler.nextCycle(false);
         
         // check for autotuning
         if ( k % tuning_interval == 0 && k != pre_burnin_generations )
         {
-            sampler->tune();
+            stone_sampler.tune();
         }
         
     }
     
     // Monitor
-    sampler->startMonitors(gen, false);
-    sampler->writeMonitorHeaders( false );
-    sampler->monitor(0);
+    stone_sampler.startMonitors(gen, false);
+    stone_sampler.writeMonitorHeaders( false );
+    stone_sampler.monitor(0);
     
     double p = powers[idx];
     for (size_t k=1; k<=gen; ++k)
     {
         
-        if ( process_active == true )
+        if ( process_active == true && print_stone_progress == true )
         {
             if ( k % printInterval == 0 )
             {
@@ -291,22 +369,22 @@ void PowerPosteriorAnalysis::runStone(size_t idx, size_t gen, double burnin_frac
             }
         }
         
-        sampler->nextCycle( true );
+        stone_sampler.nextCycle( true );
 
         // Monitor
-        sampler->monitor(k);
+        stone_sampler.monitor(k);
         
         // sample the likelihood
         if ( k > burnin && k % sampleFreq == 0 )
         {
             // compute the joint likelihood
-            double likelihood = sampler->getModelLnProbability(true);
+            double likelihood = stone_sampler.getModelLnProbability(true);
             outStream << k << "\t" << p << "\t" << likelihood << std::endl;
         }
             
     }
     
-    if ( process_active == true )
+    if ( process_active == true && print_stone_progress == true )
     {
         std::cout << std::endl;
     }
@@ -314,7 +392,7 @@ void PowerPosteriorAnalysis::runStone(size_t idx, size_t gen, double burnin_frac
     outStream.close();
     
     // Monitor
-    sampler->finishMonitors( 1, MonteCarloAnalysisOptions::NONE );
+    stone_sampler.finishMonitors( 1, MonteCarloAnalysisOptions::NONE );
     
 }
 
@@ -366,6 +444,12 @@ void PowerPosteriorAnalysis::summarizeStones( void )
 }
 
 
+void PowerPosteriorAnalysis::setIndependentStones(bool tf)
+{
+    independent_stones = tf;
+}
+
+
 void PowerPosteriorAnalysis::setPowers(const std::vector<double> &p)
 {
     powers = p;
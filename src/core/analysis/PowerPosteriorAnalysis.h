@@ -3,9 +3,12 @@
 
 #include "Cloneable.h"
 #include "Parallelizable.h"
+#include "RandomNumberGenerator.h"
 #include "RbVector.h"
 #include "RbFileManager.h"
 
+#include <mutex>
+
 namespace RevBayesCore {
     
     class MonteCarloSampler;
@@ -16,6 +19,9 @@ namespace RevBayesCore {
      * A power posterior analysis runs an analysis for a vector of powers
      * where the likelihood during each analysis run is raised to the given power.
      * The likelihood values and the current powers are stored in a file.
+     * By default the stones run one after the other on the same sampler, so each stone starts from the state of the previous one.
+     * With independent stones, each stone starts from its own copy of the burnt-in sampler with its own random number stream and file,
+     * so the stones of a process can run concurrently on the thread pool.
      *
      *
      * @copyright Copyright 2009-
@@ -38,12 +44,14 @@ namespace RevBayesCore {
         void                                    runAll(size_t g, double burn_frac, size_t preburn_gen, size_t tune_int);
         void                                    runStone(size_t idx, size_t g, double burn_frac, size_t preburn_gen, size_t tune_int);
         void                                    summarizeStones(void);
+        void                                    setIndependentStones(bool tf);
         void                                    setPowers(const std::vector<double> &p);
         void                                    setSampleFreq(size_t sf);
         
     private:
         
         void                                    initMPI(void);
+        void                                    runStone(MonteCarloSampler &stone_sampler, size_t idx, size_t g, double burn_frac, size_t preburn_gen, size_t tune_int);
         
         // members
         path                                    filename;
@@ -51,6 +59,11 @@ namespace RevBayesCore {
         MonteCarloSampler*                      sampler;
         size_t                                  sampleFreq;                                                                     //!< The rate of the distribution
         size_t                                  processors_per_likelihood;
+        bool                                    independent_stones;                                                             //!< Does every stone start from its own copy of the burnt-in sampler?
+        std::vector<RandomNumberGenerator>      stone_rngs;                                                                     //!< One independent random number stream per stone (only for independent stones)
+        bool                                    print_stone_progress;                                                           //!< Print the progress within a stone (only if the stones run one after the other)
+        std::mutex                              sampler_mutex;                                                                  //!< Guards copying the sampler from concurrently running stones
+        std::mutex                              output_mutex;                                                                   //!< Guards the screen output of concurrently running stones
 
     };
     
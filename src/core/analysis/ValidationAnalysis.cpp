@@ -46,11 +46,9 @@ ValidationAnalysis::ValidationAnalysis( const MonteCarloAnalysis &m, size_t n, c
     size_t run_block_end   = std::max( int(run_block_start), int(floor( (double(pid+1) / num_processes ) * num_runs) ) - 1);
     int number_processes_per_run = ceil( double(num_processes) / num_runs );
     
-    // we need to change the random number generator when using MPI so that they are not synchronized anymore
-    for ( size_t i=0; i<pid; ++i )
-    {
-        GLOBAL_RNG->setSeed( int(floor( GLOBAL_RNG->uniform01()*1E5 )) );
-    }
+    // every simulation gets its own random number stream
+    // so that the simulations do not depend on how they are distributed among processes
+    std::vector<RandomNumberGenerator> sim_rngs = GLOBAL_RNG->createStreams( num_runs );
     
 #ifdef RB_MPI
 //    size_t active_proc = floor( pid / double(processors_per_likelihood) ) * processors_per_likelihood;
@@ -66,6 +64,8 @@ ValidationAnalysis::ValidationAnalysis( const MonteCarloAnalysis &m, size_t n, c
         
         if ( i >= run_block_start && i <= run_block_end)
         {
+            ScopedRandomNumberGenerator scoped_rng( &sim_rngs[i] );
+            
             // create a new directory name for this simulation
             path sim_directory_name = output_directory / ("Validation_Sim_" + std::to_string(i));
             
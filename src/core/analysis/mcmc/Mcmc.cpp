@@ -1216,6 +1216,23 @@ void Mcmc::setChainActive(bool tf)
 }
 
 
+/**
+ * Set whether the moves of this chain use delayed acceptance.
+ * The moves then first accept or reject on the prior and the Hastings ratio,
+ * and compute the likelihoods only for the proposals that pass this first stage.
+ * The flag is part of the moves and thus kept when the chain is copied.
+ */
+void Mcmc::setDelayedAcceptance(bool tf)
+{
+    
+    for (RbIterator<Move> it = moves.begin(); it != moves.end(); ++it)
+    {
+        it->setDelayedAcceptance( tf );
+    }
+    
+}
+
+
 /**
  * Set the heat of the likelihood of the current chain.
  * This heat is used in posterior posterior MCMC algorithms to
@@ -72,6 +72,7 @@ namespace RevBayesCore {
         void                                                setChainPriorHeat(double v);
         void                                                setChainIndex(size_t idx);                                                              //!< Set the index of the chain
         void                                                setCheckpointFile(const path &f);
+        void                                                setDelayedAcceptance(bool tf);                                                          //!< Set whether the moves screen proposals with the prior before computing the likelihoods
         void                                                setLikelihoodHeat(double v);                                                            //!< Set the heating temparature of the likelihood of the chain
         void                                                setModel(Model *m, bool redraw);
         void                                                setMoves(const RbVector<Move> &mvs);
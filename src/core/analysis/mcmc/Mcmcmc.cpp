@@ -28,6 +28,7 @@
 #include "RbVector.h"
 #include "RbVectorImpl.h"
 #include "StringUtilities.h"
+#include "ThreadPool.h"
 
 #ifdef RB_MPI
 #include <mpi.h>
@@ -132,6 +133,7 @@ Mcmcmc::Mcmcmc(const Model& m, const RbVector<Move> &mv, const RbVector<Monitor>
     chains = std::vector<Mcmc*>(num_chains, NULL);
     chain_values.resize(num_chains, 0.0);
     chain_heats.resize(num_chains, 0.0);
+    chain_rngs.resize(num_chains);
     chain_prev_boundary.resize(num_chains, boundary::intermediate);
     chain_half_trips.resize(num_chains, 0);
     heat_visitors.resize(num_chains, {0,0});
@@ -207,6 +209,7 @@ Mcmcmc::Mcmcmc(const Mcmcmc &m) : MonteCarloSampler(m)
     
     chain_values            = m.chain_values;
     chain_heats             = m.chain_heats;
+    chain_rngs              = m.chain_rngs;
     chain_prev_boundary     = m.chain_prev_boundary;
     chain_half_trips        = m.chain_half_trips;
     heat_visitors           = m.heat_visitors;
@@ -451,9 +454,24 @@ void Mcmcmc::initializeChains(void)
 }
 
 
+/**
+ * Split the random number generator into one independent stream per chain.
+ * We create a stream for every chain, also for the chains of other processes, so that each chain
+ * gets the same stream independent of the number of processes and threads.
+ */
+void Mcmcmc::initializeChainRandomNumberGenerators( void )
+{
+    
+    chain_rngs = GLOBAL_RNG->createStreams( num_chains );
+    
+}
+
+
 void Mcmcmc::initializeSampler( bool priorOnly )
 {
     
+    initializeChainRandomNumberGenerators();
+    
     // initialize each chain
     for (size_t i = 0; i < num_chains; ++i)
     {
@@ -471,6 +489,8 @@ void Mcmcmc::initializeSampler( bool priorOnly )
 void Mcmcmc::initializeSamplerFromCheckpoint( void )
 {
     
+    initializeChainRandomNumberGenerators();
+    
     for (size_t i = 0; i < num_chains; ++i)
     {
             
@@ -503,21 +523,41 @@ void Mcmcmc::nextCycle(bool advanceCycle)
 {
     
     // run each chain for this process
+    // the chains are independent between two swaps, so we advance them concurrently
+    // and only synchronize at the swap below
+    std::vector< std::function<void(void)> > chain_tasks;
     for (size_t i = 0; i < num_chains; ++i)
     {
         
         if ( chains[i] != NULL )
         {
-            // @todo: #thread
-            // This part should be done on several threads if possible
-            // Sebastian: this call is very slow; a lot of work happens in nextCycle()
-
-            // advance chain j by a single cycle
-            chains[i]->nextCycle( advanceCycle );
+            Mcmc* chain = chains[i];
+            RandomNumberGenerator* chain_rng = &chain_rngs[i];
+            chain_tasks.push_back( [chain, chain_rng, advanceCycle]
+            {
+                // all random numbers drawn during this cycle come from the chain's own generator
+                ScopedRandomNumberGenerator scoped_rng( chain_rng );
+                
+                // advance chain j by a single cycle
+                chain->nextCycle( advanceCycle );
+            } );
         }
         
     } // loop over chains for this process
     
+    if ( base_chain->getModel().isThreadSafe() == true )
+    {
+        ThreadPool::threadPoolInstance().run( chain_tasks );
+    }
+    else
+    {
+        // some part of the model cannot be used concurrently, so we run the chains one after the other
+        for (size_t i = 0; i < chain_tasks.size(); ++i)
+        {
+            chain_tasks[i]();
+        }
+    }
+    
     if ( advanceCycle == true )
     {
         // advance gen counter
@@ -1207,6 +1247,7 @@ void Mcmcmc::setActivePIDSpecialized(size_t i, size_t n)
     chains.clear();
     chain_values.clear();
     chain_heats.clear();
+    chain_rngs.clear();
     chain_prev_boundary.clear();
     chain_half_trips.clear();
     heat_visitors.clear();
@@ -1216,6 +1257,7 @@ void Mcmcmc::setActivePIDSpecialized(size_t i, size_t n)
     chains.resize(num_chains);
     chain_values.resize(num_chains, 0.0);
     chain_heats.resize(num_chains, 0.0);
+    chain_rngs.resize(num_chains);
     chain_prev_boundary.resize(num_chains, boundary::intermediate);
     chain_half_trips.resize(num_chains, 0);
     heat_visitors.resize(num_chains, {0,0});
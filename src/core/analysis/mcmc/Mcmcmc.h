@@ -6,6 +6,7 @@
 #include "Monitor.h"
 #include "MonteCarloSampler.h"
 #include "Move.h"
+#include "RandomNumberGenerator.h"
 
 #include <vector>
 
@@ -80,6 +81,7 @@ namespace RevBayesCore {
         
     private:
         void                                    initializeChains(void);
+        void                                    initializeChainRandomNumberGenerators(void);
         void                                    swapChains(const std::string swap_method);
         void                                    swapMovesTuningInfo(RbVector<Move> &mvsj, RbVector<Move> &mvsk);
         void                                    swapNeighborChains(void);
@@ -103,6 +105,7 @@ namespace RevBayesCore {
         std::vector<Mcmc*>                      chains;
         std::vector<double>                     chain_values;
         std::vector<double>                     chain_heats;
+        std::vector<RandomNumberGenerator>      chain_rngs;                                         // each chain draws from its own generator so that the result does not depend on the thread schedule
 
         std::vector<boundary>                   chain_prev_boundary;                                // has the chain most recently visited the hottest or coldest temperature
         std::vector<int>                        chain_half_trips;                                   // how many trips has the chain made from hottest -> coldest or coldest to hottest
@@ -0,0 +1,36 @@
+#include "BurninEstimatorContinuous.h"
+
+#include <functional>
+
+#include "ThreadPool.h"
+
+using namespace RevBayesCore;
+
+
+/**
+ * Estimate the burnin of each trace, e.g., of all parameter columns of a trace file, and return the largest one.
+ * The traces are analysed concurrently on the global thread pool.
+ */
+size_t BurninEstimatorContinuous::estimateMaximumBurnin(const std::vector<TraceNumeric>& traces)
+{
+
+    std::vector<size_t> burnins( traces.size(), 0 );
+
+    std::vector< std::function<void(void)> > tasks;
+    for (size_t i = 0; i < traces.size(); ++i)
+    {
+        tasks.push_back( [this, &traces, &burnins, i]() { burnins[i] = estimateBurnin( traces[i] ); } );
+    }
+    ThreadPool::threadPoolInstance().run( tasks );
+
+    size_t max_burnin = 0;
+    for (size_t i = 0; i < burnins.size(); ++i)
+    {
+        if ( max_burnin < burnins[i] )
+        {
+            max_burnin = burnins[i];
+        }
+    }
+
+    return max_burnin;
+}
@@ -29,6 +29,7 @@ namespace RevBayesCore {
     
         virtual BurninEstimatorContinuous*      clone(void) const = 0;                                              //!< Clone function. This is similar to the copy constructor but useful in inheritance.
         virtual std::size_t                     estimateBurnin(const TraceNumeric& trace) = 0;
+        std::size_t                             estimateMaximumBurnin(const std::vector<TraceNumeric>& traces);    //!< The largest burnin of all traces, estimated concurrently
     };
     
 }
@@ -8,6 +8,7 @@
 
 #include "EssMax.h"
 
+#include <vector>
 
 #include "RbMathLogic.h"
 #include "Cloneable.h"
@@ -42,15 +43,22 @@ size_t EssMax::estimateBurnin(const TraceNumeric& trace)
     double  max_ess     = 0;
     size_t  best_burnin = 0;
     
-    // iterate over possible burnins
+    // collect the possible burnins
+    std::vector<long> burnins;
     for (size_t i=0; i<frac*trace.size(); i+=blockSize) {
-        // analyse trace for this burnin
-        double ess = trace.getESS(i, trace.size());
-        
+        burnins.push_back( long(i) );
+    }
+    
+    // analyse the trace for all burnins at once
+    std::vector<double> ess;
+    std::vector<double> sem;
+    trace.getWindowStatistics(burnins, trace.size(), ess, sem);
+    
+    for (size_t i=0; i<burnins.size(); ++i) {
         // check if the new ess is better than any previous ones
-        if (RbMath::isFinite(ess) && max_ess < ess) {
-            max_ess = ess;
-            best_burnin = i;
+        if (RbMath::isFinite(ess[i]) && max_ess < ess[i]) {
+            max_ess = ess[i];
+            best_burnin = size_t(burnins[i]);
         }
     }
     
@@ -8,6 +8,7 @@
 
 #include "SemMin.h"
 
+#include <vector>
 
 #include "RbConstants.h"
 #include "RbMathLogic.h"
@@ -45,15 +46,22 @@ size_t SemMin::estimateBurnin(const TraceNumeric& trace) {
     double  min_sem     = RbConstants::Double::max;
     size_t  best_burnin = 0;
     
-    // iterate over possible burnins
+    // collect the possible burnins
+    std::vector<long> burnins;
     for (size_t i=0; i<trace.size(); i+=blockSize) {
-        // make mean invalid for recalculation
-        double sem = trace.getSEM(i, trace.size());
-        
-        // check if the new ess is better than any previous ones
-        if (RbMath::isFinite(sem) && sem > 0 && min_sem > sem) {
-            min_sem = sem;
-            best_burnin = i;
+        burnins.push_back( long(i) );
+    }
+    
+    // analyse the trace for all burnins at once
+    std::vector<double> ess;
+    std::vector<double> sem;
+    trace.getWindowStatistics(burnins, trace.size(), ess, sem);
+    
+    for (size_t i=0; i<burnins.size(); ++i) {
+        // check if the new sem is better than any previous ones
+        if (RbMath::isFinite(sem[i]) && sem[i] > 0 && min_sem > sem[i]) {
+            min_sem = sem[i];
+            best_burnin = size_t(burnins[i]);
         }
     }
     
@@ -0,0 +1,141 @@
+#include "EssAccumulator.h"
+
+#include <algorithm>
+
+#include "RbConstants.h"
+#include "TraceNumeric.h"
+
+using namespace RevBayesCore;
+
+
+EssAccumulator::EssAccumulator( void ) :
+    num_samples( 0 ),
+    shift( 0.0 ),
+    sum( 0.0 ),
+    last_values( NUM_LAGS, 0.0 ),
+    newest( NUM_LAGS - 1 ),
+    lagged_sums( NUM_LAGS, 0.0 )
+{
+
+}
+
+
+/**
+ * Add the next sample. We add the products of the sample with each of the previous values up to the maximum lag.
+ */
+void EssAccumulator::addValue(double x)
+{
+
+    if ( num_samples == 0 )
+    {
+        shift = x;
+    }
+    double y = x - shift;
+
+    if ( first_values.size() < NUM_LAGS )
+    {
+        first_values.push_back( y );
+    }
+
+    // walk back from the newest value of the ring buffer
+    lagged_sums[0] += y * y;
+    size_t num_lags = std::min( num_samples, NUM_LAGS - 1 );
+    size_t pos = newest;
+    for (size_t k = 1; k <= num_lags; ++k)
+    {
+        lagged_sums[k] += y * last_values[pos];
+        pos = ( pos == 0 ? NUM_LAGS - 1 : pos - 1 );
+    }
+
+    newest = ( newest + 1 == NUM_LAGS ? 0 : newest + 1 );
+    last_values[newest] = y;
+
+    sum += y;
+    ++num_samples;
+
+}
+
+
+/**
+ * Compute the autocovariances around the current mean from the running sums and apply
+ * the same initial positive sequence estimator as TraceNumeric.
+ */
+void EssAccumulator::computeStatistics(double &ess, double &sem) const
+{
+
+    size_t n = num_samples;
+    size_t max_lag = ( n < 2 ? 0 : std::min( n - 1, NUM_LAGS ) );
+    double m = ( n > 0 ? sum / n : 0.0 );
+
+    // the sums of the first and of the last k values are excluded from the sums over the lagged ranges
+    std::vector<double> gamma( max_lag, 0.0 );
+    double first_sum = 0.0;
+    double last_sum = 0.0;
+    size_t pos = newest;
+    for (size_t k = 0; k < max_lag; ++k)
+    {
+        double samples = double(n - k);
+        gamma[k] = (lagged_sums[k] - m * ((sum - last_sum) + (sum - first_sum)) + samples * m * m) / samples;
+
+        first_sum += first_values[k];
+        last_sum += last_values[pos];
+        pos = ( pos == 0 ? NUM_LAGS - 1 : pos - 1 );
+    }
+
+    TraceNumeric::computeStatisticsFromAutocovariances( gamma, n, ess, sem );
+}
+
+
+double EssAccumulator::getESS( void ) const
+{
+
+    double ess = 0.0;
+    double sem = 0.0;
+    computeStatistics( ess, sem );
+
+    return ess;
+}
+
+
+double EssAccumulator::getMean( void ) const
+{
+
+    if ( num_samples == 0 )
+    {
+        return RbConstants::Double::nan;
+    }
+
+    return shift + sum / num_samples;
+}
+
+
+size_t EssAccumulator::getNumberOfSamples( void ) const
+{
+
+    return num_samples;
+}
+
+
+double EssAccumulator::getSEM( void ) const
+{
+
+    double ess = 0.0;
+    double sem = 0.0;
+    computeStatistics( ess, sem );
+
+    return sem;
+}
+
+
+void EssAccumulator::reset( void )
+{
+
+    num_samples = 0;
+    shift       = 0.0;
+    sum         = 0.0;
+    newest      = NUM_LAGS - 1;
+    first_values.clear();
+    std::fill( last_values.begin(), last_values.end(), 0.0 );
+    std::fill( lagged_sums.begin(), lagged_sums.end(), 0.0 );
+
+}
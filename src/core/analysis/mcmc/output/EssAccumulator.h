@@ -0,0 +1,52 @@
+#ifndef EssAccumulator_H
+#define EssAccumulator_H
+
+#include <stddef.h>
+#include <vector>
+
+namespace RevBayesCore {
+
+    /**
+     * @brief Online accumulator of the effective sample size (ESS) of a stream of samples.
+     *
+     * The accumulator keeps the running sums of the lagged products x_j * x_{j+k} for the lags
+     * used by the ESS of TraceNumeric, together with the first and the last values of the stream.
+     * Adding a sample costs one product per lag, and the ESS, SEM and mean of all samples added so far
+     * can be queried at any time without keeping the samples, e.g., by a monitor or a stopping rule.
+     * The values are centered by the first sample to keep the sums well-conditioned.
+     * The statistics equal those of a TraceNumeric with the same values (up to rounding).
+     *
+     * @copyright Copyright 2009-
+     * @author The RevBayes Development Core Team
+     * @since 2026-10-16, version 1.2.2
+     */
+    class EssAccumulator {
+
+    public:
+                                    EssAccumulator(void);
+
+        void                        addValue(double x);                                     //!< Add the next sample of the stream
+        double                      getESS(void) const;                                     //!< The effective sample size of all samples so far
+        double                      getMean(void) const;                                    //!< The mean of all samples so far
+        size_t                      getNumberOfSamples(void) const;
+        double                      getSEM(void) const;                                     //!< The standard error of the mean of all samples so far
+        void                        reset(void);                                            //!< Remove all samples
+
+    private:
+
+        void                        computeStatistics(double &ess, double &sem) const;
+
+        static constexpr size_t     NUM_LAGS = 1000;                                        //!< The maximum lag of the ESS of TraceNumeric
+
+        size_t                      num_samples;
+        double                      shift;                                                  //!< The first sample, subtracted from all values
+        double                      sum;                                                    //!< The sum of the centered values
+        std::vector<double>         first_values;                                           //!< The first NUM_LAGS centered values
+        std::vector<double>         last_values;                                            //!< Ring buffer of the last NUM_LAGS centered values
+        size_t                      newest;                                                 //!< The position of the newest value in the ring buffer
+        std::vector<double>         lagged_sums;                                            //!< The sums of y_j * y_{j+k} for the lags k
+    };
+
+}
+
+#endif
@@ -2,18 +2,226 @@
 
 #include <math.h>
 #include <stddef.h>
+#include <algorithm>
+#include <complex>
+#include <functional>
 #include <vector>
 
 #include "GewekeTest.h"
 #include "StationarityTest.h"
 #include "Cloner.h"
 #include "RbConstants.h" // IWYU pragma: keep
+#include "RbException.h"
+#include "ThreadPool.h"
 
 using namespace RevBayesCore;
 using namespace std;
 
 #define MAX_LAG 1000
 
+// the number of lags that we compute directly before we switch to the fast Fourier transform
+#define MAX_DIRECT_LAG 32
+
+
+namespace {
+
+    /**
+     * Geyer's initial positive sequence estimator of the variance of the mean.
+     * The autocovariances are added lag by lag; from lag 2 on, the pairs of consecutive lags are added
+     * to the variance until the sum of a pair is not positive anymore or we reached the maximum lag.
+     */
+    class InitialSequence {
+
+    public:
+        InitialSequence(size_t n) :
+            samples( n ),
+            max_lag( n < 2 ? 0 : std::min( n - 1, size_t(MAX_LAG) ) ),
+            lag( 0 ),
+            gamma_0( 0.0 ),
+            gamma_prev( 0.0 ),
+            var_stat( 0.0 ),
+            finished( n < 2 )
+        {}
+
+        void addAutocovariance(double gamma)
+        {
+            if ( lag == 0 )
+            {
+                gamma_0 = gamma;
+                var_stat = gamma;
+            }
+            else if ( lag % 2 == 0 )
+            {
+                // fancy stopping criterion :)
+                if ( gamma_prev + gamma > 0 )
+                {
+                    var_stat += 2.0 * (gamma_prev + gamma);
+                }
+                else
+                {
+                    finished = true;
+                }
+            }
+
+            gamma_prev = gamma;
+            ++lag;
+            finished = ( finished || lag >= max_lag );
+        }
+
+        size_t getLag(void) const { return lag; }
+        bool isFinished(void) const { return finished; }
+
+        void getStatistics(double &ess, double &sem) const
+        {
+            if ( samples < 2 )
+            {
+                ess = RbConstants::Double::nan;
+                sem = RbConstants::Double::nan;
+                return;
+            }
+
+            // standard error of mean
+            sem = sqrt(var_stat / samples);
+
+            // auto correlation time
+            double act = var_stat / gamma_0;
+
+            // effective sample size
+            ess = samples / act;
+        }
+
+    private:
+        size_t samples;
+        size_t max_lag;
+        size_t lag;
+        double gamma_0;
+        double gamma_prev;
+        double var_stat;
+        bool   finished;
+    };
+
+
+    /**
+     * In-place iterative radix-2 fast Fourier transform. The size of the data has to be a power of two.
+     */
+    void fastFourierTransform(std::vector< std::complex<double> > &a, bool inverse)
+    {
+
+        size_t n = a.size();
+
+        // bit-reversal permutation
+        for (size_t i = 1, j = 0; i < n; ++i)
+        {
+            size_t bit = n >> 1;
+            for ( ; j & bit; bit >>= 1)
+            {
+                j ^= bit;
+            }
+            j ^= bit;
+            if ( i < j )
+            {
+                std::swap( a[i], a[j] );
+            }
+        }
+
+        for (size_t len = 2; len <= n; len <<= 1)
+        {
+            double angle = 2.0 * RbConstants::PI / double(len) * ( inverse ? 1.0 : -1.0 );
+            std::complex<double> w_len( cos(angle), sin(angle) );
+            for (size_t i = 0; i < n; i += len)
+            {
+                std::complex<double> w( 1.0, 0.0 );
+                for (size_t j = 0; j < len / 2; ++j)
+                {
+                    std::complex<double> u = a[i+j];
+                    std::complex<double> v = a[i+j+len/2] * w;
+                    a[i+j] = u + v;
+                    a[i+j+len/2] = u - v;
+                    w *= w_len;
+                }
+            }
+        }
+
+    }
+
+
+    /**
+     * Compute the autocovariances of the values for the lags 0 to max_lag-1 with a fast Fourier transform.
+     * The deviations are zero-padded to avoid the circular wrap-around.
+     */
+    std::vector<double> computeAutocovariances(const double* x, size_t samples, double mean, size_t max_lag)
+    {
+
+        size_t n = 1;
+        while ( n < 2 * samples )
+        {
+            n <<= 1;
+        }
+
+        std::vector< std::complex<double> > a( n, std::complex<double>(0.0, 0.0) );
+        for (size_t j = 0; j < samples; ++j)
+        {
+            a[j] = x[j] - mean;
+        }
+
+        fastFourierTransform( a, false );
+        for (size_t i = 0; i < n; ++i)
+        {
+            a[i] = std::norm( a[i] );
+        }
+        fastFourierTransform( a, true );
+
+        std::vector<double> gamma( max_lag );
+        for (size_t lag = 0; lag < max_lag; ++lag)
+        {
+            gamma[lag] = a[lag].real() / double(n) / double(samples - lag);
+        }
+
+        return gamma;
+    }
+
+
+    /**
+     * Compute the ESS and SEM of the values in [begin,end) with the given mean.
+     */
+    void computeTraceStatistics(const std::vector<double> &values, size_t begin, size_t end, double mean, double &ess, double &sem)
+    {
+
+        size_t samples = ( end > begin ? end - begin : 0 );
+        const double* x = values.data() + begin;
+
+        InitialSequence sequence( samples );
+        std::vector<double> gamma;
+        while ( sequence.isFinished() == false )
+        {
+            size_t lag = sequence.getLag();
+
+            if ( gamma.empty() == true && lag >= MAX_DIRECT_LAG )
+            {
+                // the sequence is long, so we get all remaining lags at once
+                gamma = computeAutocovariances( x, samples, mean, std::min( samples - 1, size_t(MAX_LAG) ) );
+            }
+
+            if ( gamma.empty() == false )
+            {
+                sequence.addAutocovariance( gamma[lag] );
+            }
+            else
+            {
+                double g = 0.0;
+                for (size_t j = 0; j < samples - lag; ++j)
+                {
+                    g += (x[j] - mean) * (x[j+lag] - mean);
+                }
+                sequence.addAutocovariance( g / double(samples - lag) );
+            }
+        }
+
+        sequence.getStatistics( ess, sem );
+    }
+
+}
+
 /**
  * 
  */
@@ -160,62 +368,184 @@ double TraceNumeric::getSEM() const
 
 
 /**
- * Analyze trace
+ * Compute the ESS and SEM of all traces concurrently on the global thread pool,
+ * e.g., for the many parameter columns of a trace file.
+ * The statistics are stored in the traces, so that the following calls of getESS() and getSEM() are cheap.
+ */
+void TraceNumeric::computeCorrelationStatistics(const std::vector<TraceNumeric> &traces)
+{
+
+    std::vector< std::function<void(void)> > tasks;
+    for (size_t i = 0; i < traces.size(); ++i)
+    {
+        const TraceNumeric* t = &traces[i];
+        tasks.push_back( [t]() { t->update(); } );
+    }
+
+    ThreadPool::threadPoolInstance().run( tasks );
+
+}
+
+
+/**
+ * Apply the initial positive sequence estimator to the autocovariances of the lags 0,1,... of a sample,
+ * e.g., computed from running sums. The vector has to contain at least min(samples-1,1000) lags.
+ */
+void TraceNumeric::computeStatisticsFromAutocovariances(const std::vector<double> &gamma, size_t samples, double &ess, double &sem)
+{
+
+    InitialSequence sequence( samples );
+    while ( sequence.isFinished() == false )
+    {
+        sequence.addAutocovariance( gamma[ sequence.getLag() ] );
+    }
+
+    sequence.getStatistics( ess, sem );
+}
+
+
+/**
+ * Compute the ESS and SEM of several windows [begins[i],end) of the trace at once.
+ * This is much faster than calling getESS(begin,end) for every window, because the lagged sums
+ * of products are accumulated in one backward sweep per lag and shared among all windows.
+ * The values are centered by the mean of the largest window to keep the sums well-conditioned.
  *
+ * @param begins    the begin indices of the windows
+ * @param end       the common end index (exclusive) of the windows
+ * @param ess       the effective sample sizes of the windows
+ * @param sem       the standard errors of the means of the windows
  */
-void TraceNumeric::update() const
+void TraceNumeric::getWindowStatistics(const std::vector<long> &begins, long end, std::vector<double> &ess_values, std::vector<double> &sem_values) const
 {
-    // if we have not yet calculated the mean, do this now
 
-    getMean();
+    size_t num_windows = begins.size();
+    ess_values.assign( num_windows, RbConstants::Double::nan );
+    sem_values.assign( num_windows, RbConstants::Double::nan );
 
-    if( stats_dirty == false ) return;
+    if ( end < 0 || size_t(end) > values.size() )
+    {
+        throw RbException("The end of the windows is outside of the trace.");
+    }
 
-    size_t samples = values.size() - burnin;
-    size_t maxLag = (samples - 1 < MAX_LAG ? samples - 1 : MAX_LAG);
+    // sort the windows by decreasing begin so that one backward sweep passes all of them in order
+    std::vector<size_t> order;
+    long first = end;
+    for (size_t w = 0; w < num_windows; ++w)
+    {
+        if ( begins[w] < 0 )
+        {
+            throw RbException("The begin of a window is outside of the trace.");
+        }
+        if ( begins[w] < end )
+        {
+            order.push_back( w );
+            first = std::min( first, begins[w] );
+        }
+    }
+    std::sort( order.begin(), order.end(), [&begins](size_t a, size_t b) { return begins[a] > begins[b]; } );
 
-    double* gammaStat = new double[maxLag];
-    // setting values to 0
-    for (size_t i=0; i<maxLag; i++)
+    size_t n = size_t(end - first);
+    if ( n == 0 )
     {
-        gammaStat[i] = 0;
+        return;
     }
-    double varStat = 0.0;
 
-    for (size_t lag = 0; lag < maxLag; lag++) {
-        for (size_t j = 0; j < samples - lag; j++) {
-            double del1 = values.at(burnin + j) - mean;
-            double del2 = values.at(burnin + j + lag) - mean;
-            gammaStat[lag] += (del1 * del2);
+    // center the values and compute their suffix sums
+    double shift = 0.0;
+    for (size_t j = 0; j < n; ++j)
+    {
+        shift += values[first + j];
+    }
+    shift /= n;
+
+    std::vector<double> y( n );
+    std::vector<double> suffix( n + 1, 0.0 );
+    for (size_t j = 0; j < n; ++j)
+    {
+        y[j] = values[first + j] - shift;
+    }
+    for (size_t j = n; j > 0; --j)
+    {
+        suffix[j-1] = suffix[j] + y[j-1];
+    }
+
+    std::vector<InitialSequence> sequences;
+    std::vector<size_t> window_begin;
+    for (size_t k = 0; k < order.size(); ++k)
+    {
+        size_t b = size_t(begins[ order[k] ] - first);
+        window_begin.push_back( b );
+        sequences.push_back( InitialSequence( n - b ) );
+    }
+
+    for (size_t lag = 0; ; ++lag)
+    {
+        // the smallest begin of a window that still needs this lag
+        size_t lowest = n;
+        for (size_t k = 0; k < sequences.size(); ++k)
+        {
+            if ( sequences[k].isFinished() == false )
+            {
+                lowest = std::min( lowest, window_begin[k] );
+            }
+        }
+        if ( lowest == n )
+        {
+            break;
         }
 
-        gammaStat[lag] /= ((double) (samples - lag));
+        // sweep backwards and accumulate sum_{j=b}^{n-1-lag} y_j * y_{j+lag} for the begins b of the windows
+        double lagged_sum = 0.0;
+        size_t j = n - lag;
+        for (size_t k = 0; k < sequences.size(); ++k)
+        {
+            size_t b = window_begin[k];
+            if ( b < lowest )
+            {
+                break;
+            }
+            while ( j > b )
+            {
+                --j;
+                lagged_sum += y[j] * y[j+lag];
+            }
 
-        if (lag == 0) {
-            varStat = gammaStat[0];
-        } else if (lag % 2 == 0) {
-            // fancy stopping criterion :)
-            if (gammaStat[lag - 1] + gammaStat[lag] > 0) {
-                varStat += 2.0 * (gammaStat[lag - 1] + gammaStat[lag]);
+            if ( sequences[k].isFinished() == false )
+            {
+                // the autocovariance around the mean of this window
+                double samples = double(n - b);
+                double m = suffix[b] / samples;
+                double head = suffix[b] - suffix[n - lag];
+                double tail = suffix[b + lag];
+                double gamma = (lagged_sum - m * (head + tail) + (samples - lag) * m * m) / (samples - lag);
+                sequences[k].addAutocovariance( gamma );
             }
-            // stop
-            else
-                maxLag = lag;
         }
     }
 
-    // standard error of mean
-    sem = sqrt(varStat / samples);
+    for (size_t k = 0; k < sequences.size(); ++k)
+    {
+        sequences[k].getStatistics( ess_values[ order[k] ], sem_values[ order[k] ] );
+    }
 
-    // auto correlation time
-    double act = varStat / gammaStat[0];
+}
 
-    // effective sample size
-    ess = samples / act;
 
-    stats_dirty = false;
+/**
+ * Analyze trace
+ *
+ */
+void TraceNumeric::update() const
+{
+    // if we have not yet calculated the mean, do this now
+
+    getMean();
+
+    if( stats_dirty == false ) return;
 
-    delete[] gammaStat;
+    computeTraceStatistics( values, burnin, values.size(), mean, ess, sem );
+
+    stats_dirty = false;
 }
 
 /**
@@ -229,48 +559,7 @@ void TraceNumeric::update(long inbegin, long inend) const
 
     if( statsw_dirty == false ) return;
 
-    size_t samples = end - begin;
-    size_t maxLag = (samples - 1 < MAX_LAG ? samples - 1 : MAX_LAG);
-
-    double* gammaStat = new double[maxLag];
-    // setting values to 0
-    for (size_t i=0; i<maxLag; i++) {
-        gammaStat[i] = 0;
-    }
-    double varStat = 0.0;
-
-    for (size_t lag = 0; lag < maxLag; lag++) {
-        for (size_t j = 0; j < samples - lag; j++) {
-            double del1 = values.at(begin + j) - meanw;
-            double del2 = values.at(begin + j + lag) - meanw;
-            gammaStat[lag] += (del1 * del2);
-        }
-
-        gammaStat[lag] /= ((double) (samples - lag));
-
-        if (lag == 0) {
-            varStat = gammaStat[0];
-        } else if (lag % 2 == 0) {
-            // fancy stopping criterion :)
-            if (gammaStat[lag - 1] + gammaStat[lag] > 0) {
-                varStat += 2.0 * (gammaStat[lag - 1] + gammaStat[lag]);
-            }
-            // stop
-            else
-                maxLag = lag;
-        }
-    }
-
-    // standard error of mean
-    semw = sqrt(varStat / samples);
-
-    // auto correlation time
-    double act = varStat / gammaStat[0];
-
-    // effective sample size
-    essw = samples / act;
-
-    delete[] gammaStat;
+    computeTraceStatistics( values, begin, end, meanw, essw, semw );
 
     statsw_dirty = false;
 }
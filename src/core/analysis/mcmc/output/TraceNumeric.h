@@ -1,10 +1,23 @@
 #ifndef TraceNumeric_H
 #define TraceNumeric_H
 
+#include <stddef.h>
+#include <vector>
+
 #include "Trace.h"
 
 namespace RevBayesCore {
 
+    /**
+     * @brief Trace of a real-valued parameter with its mean, effective sample size (ESS) and standard error of the mean (SEM).
+     *
+     * The ESS and SEM are computed with Geyer's initial positive sequence estimator: the autocovariances are
+     * added in pairs of consecutive lags until a pair sum is not positive anymore (at most 1000 lags).
+     * The first lags are computed directly; if the sequence is still running after those, all remaining
+     * autocovariances are computed at once with a fast Fourier transform.
+     * The statistics of many windows that share their end (e.g., for burnin estimation) are computed together
+     * from shared lagged sums, and the statistics of many traces can be computed concurrently.
+     */
     class TraceNumeric : public Trace<double> {
     
     public:
@@ -20,9 +33,13 @@ namespace RevBayesCore {
         double                  getMean(long begin, long end) const;            //!< compute the mean for the trace with begin and end indices of the values
         double                  getESS(long begin, long end) const;             //!< compute the effective sample size with begin and end indices of the values
         double                  getSEM(long begin, long end) const;             //!< compute the effective sample size with begin and end indices of the values
+        void                    getWindowStatistics(const std::vector<long> &begins, long end, std::vector<double> &ess, std::vector<double> &sem) const;   //!< compute the ESS and SEM of the windows [begins[i],end) together
 
         void                    computeStatistics(void);
 
+        static void             computeCorrelationStatistics(const std::vector<TraceNumeric> &traces);                 //!< compute the ESS and SEM of all traces concurrently
+        static void             computeStatisticsFromAutocovariances(const std::vector<double> &gamma, size_t samples, double &ess, double &sem);     //!< apply the initial positive sequence estimator to the autocovariances
+
         //int                     hasConverged() const                            { return converged; }
         int                     hasPassedGewekeTest() const                     { return passedGewekeTest; }
         int                     hasPassedStationarityTest() const               { return passedStationarityTest; }
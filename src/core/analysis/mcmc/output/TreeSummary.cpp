@@ -6,6 +6,7 @@
 #include <iterator>
 #include <limits>
 #include <map>
+#include <mutex>
 #include <ostream>
 #include <set>
 #include <string>
@@ -19,6 +20,7 @@
 #include "RbConstants.h"
 #include "RbException.h"
 #include "RbMathCombinatorialFunctions.h"
+#include "RbSettings.h"
 #include "RbVectorUtilities.h"
 #include "RlUserInterface.h"
 #include "StringUtilities.h"
@@ -29,6 +31,7 @@
 #include "RbBitSet.h"
 #include "Taxon.h"
 #include "TaxonMap.h"
+#include "ThreadPool.h"
 #include "Trace.h"
 #include "TraceTree.h"
 #include "Tree.h"
@@ -36,6 +39,22 @@
 using namespace RevBayesCore;
 
 
+namespace {
+
+    /*
+     * The SplitMix64 finalizer: a bijection of 64-bit words that mixes all input bits into all output bits.
+     */
+    inline uint64_t mixBits( uint64_t z )
+    {
+        z += 0x9e3779b97f4a7c15ULL;
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+        return z ^ (z >> 31);
+    }
+
+}
+
+
 /*
  * TreeSummary constructor
  */
@@ -648,7 +667,7 @@ void TreeSummary::annotateTree( Tree &tree, AnnotationReport report, bool verbos
 
     RBOUT("Annotating tree ...");
 
-    std::string newick;
+    size_t topology_index = 0;
 
     if ( report.conditional_tree_ages )
     {
@@ -681,11 +700,11 @@ void TreeSummary::annotateTree( Tree &tree, AnnotationReport report, bool verbos
             throw(RbException("Rooting of input tree differs from the tree sample"));
         }
 
-        newick = tmp_tree->getPlainNewickRepresentation();
+        topology_index = topology_records.getIndex( computeTopologyHash( tmp_tree->getRoot() ) );
 
         delete tmp_tree;
 
-        if ( tree_clade_ages.find(newick) == tree_clade_ages.end() )
+        if ( topology_index == topology_records.size() )
         {
             throw(RbException("Could not find input tree in tree sample"));
         }
@@ -701,6 +720,8 @@ void TreeSummary::annotateTree( Tree &tree, AnnotationReport report, bool verbos
 
         Clade clade = n->getClade();
         Split split( clade.getBitRepresentation(), clade.getMrca(), rooted);
+        size_t split_index = findSplit( split );
+        bool split_sampled = ( split_index < split_records.size() );
 
         // annotate clade posterior prob
         if ( ( !n->isTip() || ( n->isRoot() && !clade.getMrca().empty() ) ) && report.clade_probs )
@@ -728,26 +749,47 @@ void TreeSummary::annotateTree( Tree &tree, AnnotationReport report, bool verbos
         {
             Clade parent_clade = n->getParent().getClade();
             Split parent_split = Split( parent_clade.getBitRepresentation(), parent_clade.getMrca(), rooted);
+            size_t parent_index = findSplit( parent_split );
 
-            std::map<Split, std::vector<double> >& condCladeAges = conditional_clade_ages[parent_split];
-            node_ages = report.conditional_clade_ages ? condCladeAges[split] : clade_ages[split];
+            // the ages of this split conditional on the parent split
+            std::vector<double> cond_clade_ages;
+            if ( split_sampled == true && parent_index < split_records.size() )
+            {
+                const std::map<size_t, std::vector<double> >& cond_ages = split_records.getValue( parent_index ).conditional_ages;
+                std::map<size_t, std::vector<double> >::const_iterator it = cond_ages.find( split_index );
+                if ( it != cond_ages.end() )
+                {
+                    cond_clade_ages = it->second;
+                }
+            }
+
+            if ( report.conditional_clade_ages == true )
+            {
+                node_ages = cond_clade_ages;
+            }
+            else if ( split_sampled == true )
+            {
+                node_ages = split_records.getValue( split_index ).ages;
+            }
 
             // annotate CCPs
             if ( !n->isTip() && report.conditional_clade_probs )
             {
                 double parentCladeFreq = splitFrequency( parent_split );
-                double ccp = condCladeAges[split].size() / parentCladeFreq;
+                double ccp = cond_clade_ages.size() / parentCladeFreq;
                 n->addNodeParameter("ccp",ccp);
             }
         }
-        else
+        else if ( split_sampled == true )
         {
-            node_ages = clade_ages[split];
+            node_ages = split_records.getValue( split_index ).ages;
         }
 
         if ( report.conditional_tree_ages )
         {
-            node_ages = tree_clade_ages[newick][split];
+            const std::map<size_t, std::vector<double> >& tree_ages = topology_records.getValue( topology_index ).split_ages;
+            std::map<size_t, std::vector<double> >::const_iterator it = tree_ages.find( split_index );
+            node_ages = ( it != tree_ages.end() ? it->second : std::vector<double>() );
         }
 
         // set the node ages/branch lengths
@@ -885,24 +927,92 @@ double TreeSummary::cladeProbability(const RevBayesCore::Clade &c, bool verbose
 }
 
 
-TreeSummary::Split TreeSummary::collectTreeSample(const TopologyNode& n, RbBitSet& intaxa, std::string newick, std::map<Split, long>& cladeCountMap)
+/**
+ * Collect the splits and the topology of one tree sample.
+ * Unrooted trees are rerooted at the outgroup or, if none was set, at the given tip.
+ */
+void TreeSummary::collectTree(const Tree &tree, const std::string &default_outgroup, SampleTable &table) const
+{
+
+    // we only need a copy of the tree if we have to reroot it
+    const Tree *sample_tree = &tree;
+    Tree rerooted_tree;
+
+    if ( rooted == false )
+    {
+        rerooted_tree = tree;
+        if ( outgroup )
+        {
+            rerooted_tree.reroot( *outgroup, false, true );
+        }
+        else
+        {
+            rerooted_tree.reroot( default_outgroup, false, true );
+        }
+        sample_tree = &rerooted_tree;
+    }
+
+    // get the clades for this tree
+    SplitHash root_hash;
+    bool contains_first = false;
+    std::vector<std::pair<size_t, double> > tree_splits;
+    collectTreeSample(sample_tree->getRoot(), table, root_hash, contains_first, tree_splits);
+
+    // count the topology; we only need the newick string the first time we see a topology
+    SplitHash topology_hash = computeTopologyHash( sample_tree->getRoot() );
+    size_t topology_index = table.topologies.getIndex( topology_hash );
+    if ( topology_index == table.topologies.size() )
+    {
+        topology_index = table.topologies.insert( topology_hash, TopologyRecord( sample_tree->getPlainNewickRepresentation() ) );
+    }
+
+    TopologyRecord& topology = table.topologies.getValue( topology_index );
+    topology.count++;
+    for (size_t j = 0; j < tree_splits.size(); ++j)
+    {
+        topology.split_ages[ tree_splits[j].first ].push_back( tree_splits[j].second );
+    }
+
+}
+
+
+/**
+ * Collect the splits of the subtree below this node.
+ * We identify each split by the XOR of random 128-bit keys of its taxa (and of its sampled ancestors),
+ * so the hash of a node is simply the XOR of the hashes of its children and we never build a bitset
+ * for a split we have seen before.
+ *
+ * \param[in]     n               The root of the subtree.
+ * \param[in,out] table           The table of the splits collected so far.
+ * \param[out]    split_hash      The XOR of the keys of the taxa in this subtree.
+ * \param[out]    contains_first  Does the subtree contain the first taxon (for flipping unrooted splits)?
+ * \param[out]    tree_splits     The index and age of every split of this tree.
+ * \return The index of the split of this node.
+ */
+size_t TreeSummary::collectTreeSample(const TopologyNode& n, SampleTable& table, SplitHash& split_hash, bool& contains_first, std::vector<std::pair<size_t, double> >& tree_splits) const
 {
     double age = (clock ? n.getAge() : n.getBranchLength() );
 
-    std::vector<Split> child_splits;
+    std::vector<size_t> child_splits;
 
-    RbBitSet taxa(intaxa.size());
     std::set<Taxon> mrca;
+    SplitHash mrca_hash;
+
+    split_hash     = SplitHash();
+    contains_first = false;
 
     if ( n.isTip() )
     {
-        n.getTaxa(taxa);
+        size_t bit_index = taxon_bit_indices.at( n.getTaxon().getName() );
+        split_hash     = taxon_split_keys[bit_index];
+        contains_first = (bit_index == 0);
 
         if ( rooted && n.isSampledAncestor() )
         {
-            sampled_ancestor_counts[n.getTaxon()]++;
+            table.sampled_ancestor_counts[n.getTaxon()]++;
 
             mrca.insert( n.getTaxon() );
+            mrca_hash ^= taxon_mrca_keys[bit_index];
         }
     }
     else
@@ -911,39 +1021,137 @@ TreeSummary::Split TreeSummary::collectTreeSample(const TopologyNode& n, RbBitSe
         {
             const TopologyNode &child_node = n.getChild(i);
 
-            child_splits.push_back( collectTreeSample(child_node, taxa, newick, cladeCountMap) );
+            SplitHash child_hash;
+            bool child_contains_first = false;
+            child_splits.push_back( collectTreeSample(child_node, table, child_hash, child_contains_first, tree_splits) );
+
+            split_hash     ^= child_hash;
+            contains_first |= child_contains_first;
 
             if ( rooted && child_node.isSampledAncestor() )
             {
                 mrca.insert(child_node.getTaxon());
+                mrca_hash ^= taxon_mrca_keys[ taxon_bit_indices.at( child_node.getTaxon().getName() ) ];
             }
         }
     }
 
-    intaxa |= taxa;
+    // unrooted splits are stored such that they do not contain the first taxon
+    SplitHash key = split_hash;
+    if ( rooted == false && contains_first == true )
+    {
+        key ^= all_taxa_split_key;
+    }
+    key ^= mrca_hash;
+
+    size_t index = table.splits.getIndex( key );
+    if ( index == table.splits.size() )
+    {
+        // this is a new split, so we need its bitset once
+        // (we do not use the taxon bitset map of the tree because it is built lazily and the trees are shared among threads)
+        std::vector<Taxon> split_taxa;
+        n.getTaxa( split_taxa );
+        RbBitSet taxa( taxon_split_keys.size() );
+        for (size_t i = 0; i < split_taxa.size(); ++i)
+        {
+            taxa.set( taxon_bit_indices.at( split_taxa[i].getName() ) );
+        }
+        index = table.splits.insert( key, SplitRecord( Split(taxa, mrca, rooted) ) );
+    }
+
+    SplitRecord& record = table.splits.getValue( index );
+
+    // store the age for this split and increment the split count
+    record.ages.push_back( age );
+    record.count++;
+
+    // add conditional clade ages
+    for (std::vector<size_t>::iterator child=child_splits.begin(); child !=child_splits.end(); ++child )
+    {
+        // inserts new entries if doesn't already exist
+        record.conditional_ages[*child].push_back( table.splits.getValue(*child).ages.back() );
+    }
+
+    // store the age for this split, conditional on the tree topology
+    tree_splits.push_back( std::pair<size_t, double>(index, age) );
+
+    return index;
+}
+
+
+/**
+ * Compute the hash of a split as it would have been computed when collecting the samples.
+ */
+TreeSummary::SplitHash TreeSummary::computeSplitHash(const Split &s) const
+{
+    SplitHash hash;
+
+    const RbBitSet &taxa = s.first;
+    for (size_t i = taxa.find_first(); i != RbBitSet::npos; i = taxa.find_next(i))
+    {
+        hash ^= taxon_split_keys[i];
+    }
+
+    for (std::set<Taxon>::const_iterator it = s.second.begin(); it != s.second.end(); ++it)
+    {
+        hash ^= taxon_mrca_keys[ taxon_bit_indices.at( it->getName() ) ];
+    }
+
+    return hash;
+}
 
-    Split parent_split(taxa, mrca, rooted);
 
-    if ( taxa.size() > 0 )
+/**
+ * Compute a canonical hash of the topology below this node.
+ * Two subtrees have the same hash exactly if they have the same plain newick representation
+ * (up to hash collisions), so the rules here need to match TopologyNode::computePlainNewick.
+ * The hashes of the children are combined by a sum, which does not depend on the order of the children.
+ */
+TreeSummary::SplitHash TreeSummary::computeTopologyHash(const TopologyNode &n) const
+{
+
+    if ( n.isTip() == true )
     {
-        // store the age for this split
-        clade_ages[parent_split].push_back( age );
+        return taxon_split_keys[ taxon_bit_indices.at( n.getTaxon().getName() ) ];
+    }
 
-        // increment split count
-        cladeCountMap[parent_split]++;
+    bool collapse_sampled_ancestors = RbSettings::userSettings().getCollapseSampledAncestors();
 
-        // add conditional clade ages
-        for (std::vector<Split>::iterator child=child_splits.begin(); child !=child_splits.end(); ++child )
+    SplitHash sum;
+    std::string fossil = "";
+    SplitHash fossil_hash;
+    for (size_t i = 0; i < n.getNumberOfChildren(); ++i)
+    {
+        const TopologyNode& child = n.getChild( i );
+        if ( collapse_sampled_ancestors == true && child.isSampledAncestor() && (child.getName() < fossil || fossil == "") )
         {
-            // inserts new entries if doesn't already exist
-            conditional_clade_ages[parent_split][*child].push_back( clade_ages[*child].back() );
+            fossil = child.getName();
+            fossil_hash = taxon_mrca_keys[ taxon_bit_indices.at( fossil ) ];
+        }
+        else
+        {
+            SplitHash child_hash = computeTopologyHash( child );
+            sum.first  += child_hash.first;
+            sum.second += child_hash.second;
         }
-
-        // store the age for this split, conditional on the tree topology
-        tree_clade_ages[newick][parent_split].push_back( age );
     }
 
-    return parent_split;
+    // mix the children with the fossil label and a marker for internal nodes
+    uint64_t a = mixBits( sum.first  ^ mixBits( fossil_hash.first  + 0x2545f4914f6cdd1dULL ) );
+    uint64_t b = mixBits( sum.second ^ mixBits( fossil_hash.second + 0x9e6c63d0676a9a99ULL ) );
+
+    return SplitHash( mixBits( a ^ (b << 1) ), mixBits( b ^ (a >> 1) ) );
+}
+
+
+/**
+ * Find the index of the split record of this split.
+ *
+ * \return The index or the number of split records if the split was not sampled.
+ */
+size_t TreeSummary::findSplit(const Split &s) const
+{
+    return split_records.getIndex( computeSplitHash( s ) );
 }
 
 
@@ -1043,12 +1251,86 @@ double TreeSummary::computeEntropy( double credible_interval_size, int num_taxa,
 
 
 std::vector<double> TreeSummary::computePairwiseRFDistance( double credible_interval_size, bool verbose )
+{
+    std::vector<long> sample_count;
+    std::vector<std::vector<unsigned int> > unique_distances;
+    computeUniqueTreeRFDistances( credible_interval_size, sample_count, unique_distances, verbose );
+
+    std::vector<double> rf_distances;
+    for (size_t i=0; i<sample_count.size(); ++i)
+    {
+        // The unique tree occurs sample_count[i] times.
+        // Here we are treating them as coming in one continuous block, which is annoying.
+
+        for(int rep = 0;rep<sample_count[i];rep++)
+        {
+            // first we need to compare the tree to subsequent copies of itself
+            for (size_t k=rep+1; k<sample_count[i]; ++k )
+            {
+                rf_distances.push_back( 0.0 );
+            }
+
+            // then we compare it to copies of other trees
+            for (size_t j=i+1; j<sample_count.size(); ++j)
+            {
+                double rf = unique_distances[i][j-i-1];
+
+                for (size_t k=0; k<sample_count[j]; ++k )
+                    rf_distances.push_back( rf );
+            }
+        }
+    }
+
+    return rf_distances;
+}
+
+
+/**
+ * Compute the histogram of the pairwise RF distances between the sampled trees in the credible set.
+ * This is the compressed form of computePairwiseRFDistance: element d holds the number of pairs of samples
+ * with distance d, so the memory does not grow with the square of the number of samples.
+ */
+std::vector<long> TreeSummary::computePairwiseRFDistanceHistogram( double credible_interval_size, bool verbose )
+{
+    std::vector<long> sample_count;
+    std::vector<std::vector<unsigned int> > unique_distances;
+    computeUniqueTreeRFDistances( credible_interval_size, sample_count, unique_distances, verbose );
+
+    std::vector<long> histogram( 1, 0 );
+    for (size_t i=0; i<sample_count.size(); ++i)
+    {
+        // the pairs of copies of the same tree
+        histogram[0] += sample_count[i] * (sample_count[i]-1) / 2;
+
+        // the pairs with copies of other trees
+        for (size_t j=i+1; j<sample_count.size(); ++j)
+        {
+            unsigned int rf = unique_distances[i][j-i-1];
+            if ( rf >= histogram.size() )
+            {
+                histogram.resize( rf + 1, 0 );
+            }
+            histogram[rf] += sample_count[i] * sample_count[j];
+        }
+    }
+
+    return histogram;
+}
+
+
+/**
+ * Compute the RF distances between the unique trees in the credible set.
+ * The splits of every tree are packed and sorted once, and the rows of the distance matrix are computed in parallel.
+ *
+ * \param[out]    sample_counts   The number of samples of each unique tree.
+ * \param[out]    distances       The distance between unique trees i and j>i is distances[i][j-i-1].
+ */
+void TreeSummary::computeUniqueTreeRFDistances( double credible_interval_size, std::vector<long>& sample_counts, std::vector<std::vector<unsigned int> >& distances, bool verbose )
 {
     summarize( verbose );
-    std::vector<Tree*> unique_trees;
-    std::vector< std::vector<RbBitSet>* > unique_trees_bs;
-    std::vector<size_t> sample_count;
-    NewickConverter converter;
+
+    std::vector<const std::string*> unique_newicks;
+    sample_counts.clear();
     double total_prob = 0;
     double total_samples = sampleSize(true);
     for (std::set<Sample<std::string> >::const_reverse_iterator it = tree_samples.rbegin(); it != tree_samples.rend(); ++it)
@@ -1057,59 +1339,70 @@ std::vector<double> TreeSummary::computePairwiseRFDistance( double credible_inte
         double p = freq/total_samples;
         total_prob += p;
 
-        sample_count.push_back( freq );
+        sample_counts.push_back( freq );
+        unique_newicks.push_back( &it->first );
 
-        Tree* current_tree = converter.convertFromNewick( it->first );
-        unique_trees.push_back( current_tree );
-        
-        std::vector<RbBitSet>* this_clade_bs = new std::vector<RbBitSet>();
-        current_tree->getRoot().getAllClades(*this_clade_bs, current_tree->getNumberOfTips(), true);
-        unique_trees_bs.push_back( this_clade_bs );
-        
         if ( total_prob >= credible_interval_size )
         {
             break;
         }
 
     }
-    
-    std::vector<double> rf_distances;
-    for (size_t i=0; i<unique_trees.size(); ++i)
-    {
-        // The unique tree occurs sample_count[i] times.
-        // Here we are treating them as coming in one continuous block, which is annoying.
 
-        for(int rep = 0;rep<sample_count[i];rep++)
+    size_t num_trees = unique_newicks.size();
+    std::vector<std::vector<uint64_t> > packed_splits( num_trees );
+    size_t num_words = 0;
+
+    ThreadPool& pool = ThreadPool::threadPoolInstance();
+    size_t num_blocks = std::min( num_trees, 4 * pool.getNumberOfThreads() );
+
+    // convert the trees and pack their splits
+    std::vector< std::function<void(void)> > tasks;
+    for (size_t b = 0; b < num_blocks; ++b)
+    {
+        tasks.push_back( [&, b]()
         {
-            // first we need to compare the tree to subsequent copies of itself
-            for (size_t k=rep+1; k<sample_count[i]; ++k )
+            NewickConverter converter;
+            for (size_t i = b; i < num_trees; i += num_blocks)
             {
-                rf_distances.push_back( 0.0 );
-            }
+                Tree* current_tree = converter.convertFromNewick( *unique_newicks[i] );
 
-            // then we compare it to copies of other trees
-            for (size_t j=i+1; j<unique_trees.size(); ++j)
-            {
-                std::vector<RbBitSet>* a = unique_trees_bs[i];
-                std::vector<RbBitSet>* b = unique_trees_bs[j];
-                double rf = TreeUtilities::computeRobinsonFouldDistance(*a, *b, true);
+                std::vector<RbBitSet> clades;
+                size_t num_tips = current_tree->getNumberOfTips();
+                current_tree->getRoot().getAllClades(clades, num_tips, true);
+                packed_splits[i] = TreeUtilities::packSplits( clades, num_tips );
 
-                for (size_t k=0; k<sample_count[j]; ++k )
-                    rf_distances.push_back( rf );
+                delete current_tree;
             }
-        }
+        });
     }
+    pool.run( tasks );
 
-    for (size_t i=0; i<unique_trees.size(); ++i)
+    if ( num_trees > 0 )
     {
-        Tree* tmp = unique_trees[i];
-        std::vector<RbBitSet>* this_clade_bs = unique_trees_bs[i];
+        num_words = (traces.front()->objectAt(0).getNumberOfTips() + 63) / 64;
+    }
 
-        delete tmp;
-        delete this_clade_bs;
+    // compute the rows of the upper triangle of the distance matrix, interleaved among the blocks to balance the work
+    distances.assign( num_trees, std::vector<unsigned int>() );
+    tasks.clear();
+    for (size_t b = 0; b < num_blocks; ++b)
+    {
+        tasks.push_back( [&, b]()
+        {
+            for (size_t i = b; i < num_trees; i += num_blocks)
+            {
+                std::vector<unsigned int>& row = distances[i];
+                row.resize( num_trees - i - 1 );
+                for (size_t j = i+1; j < num_trees; ++j)
+                {
+                    row[j-i-1] = (unsigned int)TreeUtilities::computeRobinsonFouldDistance( packed_splits[i], packed_splits[j], num_words, true );
+                }
+            }
+        });
     }
+    pool.run( tasks );
 
-    return rf_distances;
 }
 
 
@@ -1152,11 +1445,11 @@ void TreeSummary::enforceNonnegativeBranchLengths(TopologyNode& node) const
 long TreeSummary::splitFrequency(const Split &n) const
 {
 
-    std::set<Sample<Split> >::const_iterator it = find_if (clade_samples.begin(), clade_samples.end(), n );
+    size_t index = findSplit( n );
 
-    if ( it != clade_samples.end() )
+    if ( index < split_records.size() )
     {
-        return it->second;
+        return split_records.getValue( index ).count;
     }
 
     throw RbException("Couldn't find split in set of samples");
@@ -1259,21 +1552,12 @@ int TreeSummary::getTopologyFrequency(const RevBayesCore::Tree &tree, bool verbo
         }
     }
 
-    std::string newick = t.getPlainNewickRepresentation();
-
     double freq = 0;
 
-    for (std::set<Sample<std::string> >::const_reverse_iterator it = tree_samples.rbegin(); it != tree_samples.rend(); ++it)
+    const TopologyRecord* record = topology_records.find( computeTopologyHash( t.getRoot() ) );
+    if ( record != NULL )
     {
-
-        if ( newick == it->first )
-        {
-            freq = it->second;
-
-            // now we found it
-            break;
-        }
-
+        freq = record->count;
     }
 
     return freq;
@@ -1414,6 +1698,32 @@ bool TreeSummary::isCoveredInInterval(const Tree &tree, double ci_size, bool ver
 }
 
 
+/**
+ * Draw the keys of the taxa for the split hashes.
+ * The keys are a fixed function of the index of the taxon in the (alphabetically ordered) bitset,
+ * so all traces with the same taxa use the same keys.
+ */
+void TreeSummary::initializeSplitHashes( void )
+{
+    const std::map<std::string, size_t>& bit_indices = traces.front()->objectAt(0).getTaxonBitSetMap();
+
+    size_t num_taxa = bit_indices.size();
+
+    taxon_bit_indices = std::unordered_map<std::string, size_t>( bit_indices.begin(), bit_indices.end() );
+    taxon_split_keys.resize( num_taxa );
+    taxon_mrca_keys.resize( num_taxa );
+    all_taxa_split_key = SplitHash();
+
+    for (size_t i = 0; i < num_taxa; ++i)
+    {
+        uint64_t seed = 4*uint64_t(i);
+        taxon_split_keys[i] = SplitHash( mixBits(seed), mixBits(seed+1) );
+        taxon_mrca_keys[i]  = SplitHash( mixBits(seed+2), mixBits(seed+3) );
+        all_taxa_split_key ^= taxon_split_keys[i];
+    }
+}
+
+
 bool TreeSummary::isClock(void) const
 {
     return clock;
@@ -1439,19 +1749,23 @@ double TreeSummary::maxdiff( bool verbose )
         throw RbException("At least 2 traces are required to compute maxdiff");
     }
 
-    std::set<Sample<Split> > splits_union;
+    // all traces have the same taxa, so they use the same split hashes
+    RbHashMap<SplitHash, bool, SplitHashFunction> splits_union;
 
     for (std::vector<TraceTree* >::const_iterator trace = traces.begin(); trace != traces.end(); trace++)
     {
         (*trace)->summarize(verbose);
 
-        splits_union.insert((*trace)->clade_samples.begin(), (*trace)->clade_samples.end());
+        for (size_t i = 0; i < (*trace)->split_records.size(); ++i)
+        {
+            splits_union.insert( (*trace)->split_records.getKey(i), true );
+        }
     }
 
 
     double maxdiff = 0;
 
-    for (std::set<Sample<Split> >::const_iterator split = splits_union.begin(); split != splits_union.end(); ++split)
+    for (size_t split = 0; split < splits_union.size(); ++split)
     {
         std::vector<double> split_freqs;
 
@@ -1459,13 +1773,13 @@ double TreeSummary::maxdiff( bool verbose )
         {
             double total_samples = (*trace)->size(true);
 
-            std::set<Sample<Split> >::const_iterator it = find_if((*trace)->clade_samples.begin(), (*trace)->clade_samples.end(), split->first );
+            const SplitRecord* record = (*trace)->split_records.find( splits_union.getKey(split) );
 
             double freq = 0;
 
-            if ( it != (*trace)->clade_samples.end() )
+            if ( record != NULL )
             {
-                freq = it->second/total_samples;
+                freq = record->count/total_samples;
             }
 
             split_freqs.push_back(freq);
@@ -1544,8 +1858,9 @@ Tree* TreeSummary::mccTree( AnnotationReport report, bool verbose )
 
         // find the product of the clade frequencies
         double cc = 0;
-        for (auto& clade: tree_clade_ages.at(newick))
-            cc += log( splitFrequency(clade.first) );
+        const TopologyRecord& record = topology_records.getValue( topology_indices.at(newick) );
+        for (auto& clade: record.split_ages)
+            cc += log( split_records.getValue(clade.first).count );
 
         if (cc > max_cc)
         {
@@ -1578,6 +1893,81 @@ Tree* TreeSummary::mccTree( AnnotationReport report, bool verbose )
 }
 
 
+/**
+ * Merge a table of split and topology samples into the summary.
+ * The split indices of the table are translated into the indices of the summary,
+ * and the ages are appended, so merging the tables in the order of the samples keeps the order of the ages.
+ * The table is left empty.
+ */
+void TreeSummary::mergeSampleTable(SampleTable &table)
+{
+    std::vector<size_t> split_indices( table.splits.size() );
+
+    for (size_t i = 0; i < table.splits.size(); ++i)
+    {
+        SplitRecord& local = table.splits.getValue(i);
+
+        size_t index = split_records.getIndex( table.splits.getKey(i) );
+        if ( index == split_records.size() )
+        {
+            index = split_records.insert( table.splits.getKey(i), SplitRecord( local.split ) );
+        }
+        split_indices[i] = index;
+
+        SplitRecord& record = split_records.getValue( index );
+        record.count += local.count;
+        if ( record.ages.empty() == true )
+        {
+            record.ages.swap( local.ages );
+        }
+        else
+        {
+            record.ages.insert( record.ages.end(), local.ages.begin(), local.ages.end() );
+        }
+    }
+
+    // the conditional ages refer to other splits, so we can only translate them once all splits are known
+    for (size_t i = 0; i < table.splits.size(); ++i)
+    {
+        SplitRecord& record = split_records.getValue( split_indices[i] );
+        std::map<size_t, std::vector<double> >& local_ages = table.splits.getValue(i).conditional_ages;
+        for (std::map<size_t, std::vector<double> >::iterator it = local_ages.begin(); it != local_ages.end(); ++it)
+        {
+            std::vector<double>& ages = record.conditional_ages[ split_indices[it->first] ];
+            ages.insert( ages.end(), it->second.begin(), it->second.end() );
+        }
+    }
+
+    for (size_t i = 0; i < table.topologies.size(); ++i)
+    {
+        TopologyRecord& local = table.topologies.getValue(i);
+
+        size_t index = topology_records.getIndex( table.topologies.getKey(i) );
+        if ( index == topology_records.size() )
+        {
+            index = topology_records.insert( table.topologies.getKey(i), TopologyRecord( local.newick ) );
+        }
+
+        TopologyRecord& record = topology_records.getValue( index );
+        record.count += local.count;
+        for (std::map<size_t, std::vector<double> >::iterator it = local.split_ages.begin(); it != local.split_ages.end(); ++it)
+        {
+            std::vector<double>& ages = record.split_ages[ split_indices[it->first] ];
+            ages.insert( ages.end(), it->second.begin(), it->second.end() );
+        }
+    }
+
+    for (std::map<Taxon, long>::iterator it = table.sampled_ancestor_counts.begin(); it != table.sampled_ancestor_counts.end(); ++it)
+    {
+        sampled_ancestor_counts[it->first] += it->second;
+    }
+
+    table.splits.clear();
+    table.topologies.clear();
+    table.sampled_ancestor_counts.clear();
+}
+
+
 Tree* TreeSummary::mrTree(AnnotationReport report, double cutoff, bool verbose)
 {
     if (cutoff < 0.0 || cutoff > 1.0) cutoff = 0.5;
@@ -1913,13 +2303,30 @@ void TreeSummary::summarize( bool verbose )
 
     sampled_ancestor_counts.clear();
 
-    clade_ages.clear();
-    conditional_clade_ages.clear();
-    tree_clade_ages.clear();
+    split_records.clear();
+    topology_records.clear();
+    topology_indices.clear();
 
-    std::map<Split, long>       clade_counts;
-    std::map<std::string, long> tree_counts;
+    initializeSplitHashes();
+
+    std::vector<const Tree*> samples;
+    for (std::vector<TraceTree* >::iterator trace = traces.begin(); trace != traces.end(); ++trace)
+    {
+        for (size_t i = (*trace)->getBurnin(); i < (*trace)->size(); ++i)
+        {
+            samples.push_back( &(*trace)->objectAt(i) );
+        }
+    }
 
+    // we split the samples into contiguous blocks and collect the splits of each block in its own table,
+    // so that the threads never share a table
+    ThreadPool& pool = ThreadPool::threadPoolInstance();
+    size_t num_blocks = std::min( samples.size(), 4 * pool.getNumberOfThreads() );
+    if ( pool.getNumberOfThreads() == 1 || num_blocks == 0 )
+    {
+        num_blocks = 1;
+    }
+    std::vector<SampleTable> tables( num_blocks );
 
     ProgressBar progress = ProgressBar(sampleSize(true));
 
@@ -1929,57 +2336,53 @@ void TreeSummary::summarize( bool verbose )
         progress.start();
     }
 
+    std::mutex progress_mutex;
     size_t count = 0;
 
-    for (std::vector<TraceTree* >::iterator trace = traces.begin(); trace != traces.end(); ++trace)
+    std::vector< std::function<void(void)> > tasks;
+    for (size_t b = 0; b < num_blocks; ++b)
     {
-        for (size_t i = (*trace)->getBurnin(); i < (*trace)->size(); ++i)
-        {
-            if ( verbose )
-            {
-                progress.update(count);
-                count++;
-            }
-
-            Tree tree = (*trace)->objectAt(i);
+        size_t begin = b * samples.size() / num_blocks;
+        size_t end   = (b+1) * samples.size() / num_blocks;
+        SampleTable& table = tables[b];
 
-            if ( rooted == false )
+        tasks.push_back( [&, begin, end]()
+        {
+            for (size_t i = begin; i < end; ++i)
             {
-                if ( outgroup )
-                {
-                    tree.reroot( *outgroup, false, true );
-                }
-                else
+                if ( verbose )
                 {
-                    tree.reroot( this_outgroup, false, true );
+                    std::lock_guard<std::mutex> lock( progress_mutex );
+                    progress.update(count);
+                    count++;
                 }
-            }
 
-            std::string newick = tree.getPlainNewickRepresentation();
+                collectTree( *samples[i], this_outgroup, table );
+            }
+        });
+    }
 
-            tree_counts[newick]++;
+    pool.run( tasks );
 
-            // get the clades for this tree
-            RbBitSet b( tree.getNumberOfTips(), false );
-            collectTreeSample(tree.getRoot(), b, newick, clade_counts);
-        }
+    // merge the tables in the order of the samples, so that the result is identical to a serial run
+    for (size_t b = 0; b < num_blocks; ++b)
+    {
+        mergeSampleTable( tables[b] );
     }
 
     // sort the clade samples in ascending frequency
-    for (std::map<Split, long>::iterator it = clade_counts.begin(); it != clade_counts.end(); ++it)
+    for (size_t i = 0; i < split_records.size(); ++i)
     {
-//        if ( it->first.first.count() > 0 )
-//        if ( it->first.first.count() > 0 && it->first.first.count() < (num_taxa-1) )
-        {
-            clade_samples.insert( Sample<Split>(it->first, it->second) );
-        }
-
+        const SplitRecord& record = split_records.getValue(i);
+        clade_samples.insert( Sample<Split>(record.split, record.count) );
     }
 
     // sort the tree samples in ascending frequency
-    for (std::map<std::string, long>::iterator it = tree_counts.begin(); it != tree_counts.end(); ++it)
+    for (size_t i = 0; i < topology_records.size(); ++i)
     {
-        tree_samples.insert( Sample<std::string>(it->first, it->second) );
+        const TopologyRecord& record = topology_records.getValue(i);
+        tree_samples.insert( Sample<std::string>(record.newick, record.count) );
+        topology_indices[record.newick] = i;
     }
 
     // finish progress bar
@@ -2,9 +2,13 @@
 #define TreeSummary_H
 
 #include "Clade.h"
+#include "RbHashMap.h"
 #include "Trace.h"
 #include "Tree.h"
 
+#include <stdint.h>
+#include <unordered_map>
+
 namespace RevBayesCore {
 
     class MatrixReal;
@@ -42,6 +46,65 @@ namespace RevBayesCore {
             }
         };
 
+        /*
+         * This struct represents a 128-bit hash of a split or of a tree topology
+         */
+        struct SplitHash : public std::pair<uint64_t, uint64_t>
+        {
+            SplitHash( uint64_t a = 0, uint64_t b = 0) : std::pair<uint64_t, uint64_t>(a,b) {}
+
+            inline SplitHash& operator^=(const SplitHash& h)
+            {
+                this->first  ^= h.first;
+                this->second ^= h.second;
+                return *this;
+            }
+        };
+
+        struct SplitHashFunction
+        {
+            inline size_t operator()(const SplitHash& h) const
+            {
+                return size_t(h.first);
+            }
+        };
+
+        /*
+         * This struct holds the samples collected for one split
+         */
+        struct SplitRecord
+        {
+            SplitRecord( const Split &s ) : split(s), count(0) {}
+
+            Split                                   split;
+            long                                    count;
+            std::vector<double>                     ages;
+            std::map<size_t, std::vector<double> >  conditional_ages;                   // the ages of the child splits (by index) conditional on this split
+        };
+
+        /*
+         * This struct holds the samples collected for one tree topology
+         */
+        struct TopologyRecord
+        {
+            TopologyRecord( const std::string &n ) : newick(n), count(0) {}
+
+            std::string                             newick;
+            long                                    count;
+            std::map<size_t, std::vector<double> >  split_ages;                         // the ages of the splits (by index) conditional on this topology
+        };
+
+        /*
+         * This struct holds the splits and topologies collected from a block of tree samples.
+         * Each thread fills its own table, and the tables are merged in the order of the samples.
+         */
+        struct SampleTable
+        {
+            RbHashMap<SplitHash, SplitRecord, SplitHashFunction>        splits;
+            RbHashMap<SplitHash, TopologyRecord, SplitHashFunction>     topologies;
+            std::map<Taxon, long >                                      sampled_ancestor_counts;
+        };
+
     public:
 
         /*
@@ -76,6 +139,7 @@ namespace RevBayesCore {
         MatrixReal                                 computeConnectivity( double credible_interval_size, const std::string& m, bool verbose );
         double                                     computeEntropy( double credible_interval_size, int num_taxa, bool verbose );
         std::vector<double>                        computePairwiseRFDistance( double credible_interval_size, bool verbose );
+        std::vector<long>                          computePairwiseRFDistanceHistogram( double credible_interval_size, bool verbose );
         std::vector<double>                        computeTreeLengths(void);
         std::vector<Clade>                         getUniqueClades(double ci=0.95, bool non_trivial_only=true, bool verbose=true);
         std::vector<Tree>                          getUniqueTrees(double ci=0.95, bool verbose=true);
@@ -95,7 +159,14 @@ namespace RevBayesCore {
 
     protected:
 
-        Split                                      collectTreeSample(const TopologyNode&, RbBitSet&, std::string, std::map<Split, long>&);
+        size_t                                     collectTreeSample(const TopologyNode&, SampleTable&, SplitHash&, bool&, std::vector<std::pair<size_t, double> >&) const;
+        void                                       collectTree(const Tree&, const std::string&, SampleTable&) const;
+        void                                       computeUniqueTreeRFDistances(double, std::vector<long>&, std::vector<std::vector<unsigned int> >&, bool);
+        void                                       mergeSampleTable(SampleTable&);
+        SplitHash                                  computeSplitHash(const Split &s) const;
+        SplitHash                                  computeTopologyHash(const TopologyNode &n) const;
+        size_t                                     findSplit(const Split &s) const;
+        void                                       initializeSplitHashes(void);
         void                                       enforceNonnegativeBranchLengths(TopologyNode& tree) const;
         long                                       splitFrequency(const Split &n) const;
         TopologyNode*                              findParentNode(TopologyNode&, const Split &, std::vector<TopologyNode*>&, RbBitSet& ) const;
@@ -113,9 +184,15 @@ namespace RevBayesCore {
         std::map<Taxon, long >                     sampled_ancestor_counts;
         std::set<Sample<std::string> >             tree_samples;
 
-        std::map<Split, std::vector<double> >                           clade_ages;
-        std::map<Split, std::map<Split, std::vector<double> > >         conditional_clade_ages;
-        std::map<std::string, std::map<Split, std::vector<double> > >   tree_clade_ages;
+        // the splits and topologies are identified by 128-bit hashes, so we never compare bitsets or newick strings while collecting the samples
+        RbHashMap<SplitHash, SplitRecord, SplitHashFunction>        split_records;
+        RbHashMap<SplitHash, TopologyRecord, SplitHashFunction>     topology_records;
+        std::unordered_map<std::string, size_t>                     topology_indices;           // the index of the topology record for each newick string in tree_samples
+
+        std::unordered_map<std::string, size_t>    taxon_bit_indices;
+        std::vector<SplitHash>                     taxon_split_keys;
+        std::vector<SplitHash>                     taxon_mrca_keys;
+        SplitHash                                  all_taxa_split_key;
 
         boost::optional<Clade>                     outgroup;
     };
@@ -3,7 +3,10 @@
 
 #include "AbstractConvergenceStoppingRule.h"
 #include "BurninEstimatorContinuous.h"
+#include "MonitorSampleSink.h"
 #include "StoppingRule.h"
+#include "StringUtilities.h"
+#include "TraceContinuousReader.h"
 
 
 using namespace RevBayesCore;
@@ -69,6 +72,46 @@ bool AbstractConvergenceStoppingRule::checkAtIteration(size_t g) const
 }
 
 
+/**
+ * Get the name of the file to which the i-th replicate writes its samples.
+ */
+path AbstractConvergenceStoppingRule::getReplicateFileName(size_t i) const
+{
+    
+    path fn = filename;
+    if ( numReplicates > 1 )
+    {
+        fn = appendToStem(filename, "_run_" + StringUtilities::to_string(i));
+    }
+    
+    return fn;
+}
+
+
+/**
+ * Get the samples of the i-th replicate.
+ * Usually the monitor of the replicate passed its samples to the sample sink while writing them,
+ * so we can use the traces in memory instead of reading and parsing the whole file again at every check.
+ * Otherwise, e.g., if the samples were written by another process, we read the file into the given vector.
+ */
+std::vector<TraceNumeric>& AbstractConvergenceStoppingRule::getTraces(size_t i, std::vector<TraceNumeric> &file_traces) const
+{
+    
+    path fn = getReplicateFileName( i );
+    
+    std::vector<TraceNumeric>* traces = MonitorSampleSink::monitorSampleSinkInstance().getTraces( fn );
+    if ( traces != NULL )
+    {
+        return *traces;
+    }
+    
+    TraceContinuousReader reader = TraceContinuousReader( fn );
+    file_traces.swap( reader.getTraces() );
+    
+    return file_traces;
+}
+
+
 /**
  * Is this a stopping rule? Yes!
  */
@@ -78,6 +121,21 @@ bool AbstractConvergenceStoppingRule::isConvergenceRule( void ) const
 }
 
 
+/**
+ * The run just ended. The monitors do not write to the files of the replicates anymore,
+ * so we tell the sample sink to stop collecting their samples and to free the traces.
+ */
+void AbstractConvergenceStoppingRule::runEnded( void )
+{
+    
+    for ( size_t i = 1; i <= numReplicates; ++i)
+    {
+        MonitorSampleSink::monitorSampleSinkInstance().unsubscribe( getReplicateFileName( i ) );
+    }
+    
+}
+
+
 /**
  * The run just started. For this rule we do not need to do anything.
  */
@@ -90,8 +148,15 @@ void AbstractConvergenceStoppingRule::runStarted( void )
 /**
  * Set the number of runs/replicates.
  * Here we need to adjust the files from which we read in.
+ * We also ask the monitors to pass the samples written to these files to the sample sink.
+ * This needs to happen before the monitors write their headers.
  */
 void AbstractConvergenceStoppingRule::setNumberOfRuns(size_t n)
 {
     numReplicates = n;
+    
+    for ( size_t i = 1; i <= numReplicates; ++i)
+    {
+        MonitorSampleSink::monitorSampleSinkInstance().subscribe( getReplicateFileName( i ) );
+    }
 }
@@ -4,6 +4,7 @@
 #include "BurninEstimatorContinuous.h"
 #include "StoppingRule.h"
 #include "RbFileManager.h"
+#include "TraceNumeric.h"
 
 #include <vector>
 
@@ -33,6 +34,7 @@ namespace RevBayesCore {
         // public methods
         virtual bool                                        checkAtIteration(size_t g) const;                           //!< Should we check for convergence at the given iteration?
         virtual bool                                        isConvergenceRule(void) const;                              //!< No, this is a threshold rule.
+        virtual void                                        runEnded(void);                                             //!< The run just ended. We stop collecting the samples.
         virtual void                                        runStarted(void);                                           //!< The run just started. Here we do not need to do anything.
         virtual void                                        setNumberOfRuns(size_t n);                                  //!< Set how many runs/replicates there are.
 
@@ -41,6 +43,9 @@ namespace RevBayesCore {
         
     protected:
         
+        path                                                getReplicateFileName(size_t i) const;                       //!< The file of the i-th replicate (starting at 1)
+        std::vector<TraceNumeric>&                          getTraces(size_t i, std::vector<TraceNumeric> &file_traces) const;     //!< The samples of the i-th replicate (starting at 1)
+        
         BurninEstimatorContinuous*                          burninEst;                                                  //!< The method for estimating the burnin
         size_t                                              checkFrequency;                                             //!< The frequency for checking for convergence
         path                                                filename;                                                   //!< The filename from which to read in the data
@@ -53,6 +53,15 @@ bool MaxIterationStoppingRule::isConvergenceRule( void ) const
 }
 
 
+/**
+ * The run just ended. For this rule we do not need to do anything.
+ */
+void MaxIterationStoppingRule::runEnded( void )
+{
+    // nothing to do
+}
+
+
 /**
  * The run just started. For this rule we don't need to do anything.
  */
@@ -52,6 +52,15 @@ bool MaxTimeStoppingRule::isConvergenceRule( void ) const
 }
 
 
+/**
+ * The run just ended. For this rule we do not need to do anything.
+ */
+void MaxTimeStoppingRule::runEnded( void )
+{
+    // nothing to do
+}
+
+
 /**
  * The run just started. For this rule we need to store the current time.
  */
@@ -31,6 +31,7 @@ namespace RevBayesCore {
         bool                                                checkAtIteration(size_t g) const;                           //!< Should we check for convergence at the given iteration?
         MaxTimeStoppingRule*                                clone(void) const;                                          //!< Clone function. This is similar to the copy constructor but useful in inheritance.
         bool                                                isConvergenceRule(void) const;                              //!< No, this is a threshold rule.
+        void                                                runEnded(void);                                             //!< The run just ended. Here we do not need to do anything.
         void                                                runStarted(void);                                           //!< The run just started. Here we do not need to do anything.
         void                                                setNumberOfRuns(size_t n);                                  //!< Set how many runs/replicates there are.
         bool                                                stop(size_t g);                                             //!< Should we stop now?
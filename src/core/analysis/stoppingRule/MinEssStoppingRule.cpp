@@ -1,13 +1,13 @@
 #include <stddef.h>
+#include <algorithm>
 #include <iosfwd>
 #include <string>
 #include <vector>
 
+#include "EssAccumulator.h"
 #include "EssTest.h"
 #include "MinEssStoppingRule.h"
 #include "RbFileManager.h"
-#include "StringUtilities.h"
-#include "TraceContinuousReader.h"
 #include "AbstractConvergenceStoppingRule.h"
 #include "BurninEstimatorContinuous.h"
 #include "Cloner.h"
@@ -18,7 +18,18 @@ using namespace RevBayesCore;
 
 
 MinEssStoppingRule::MinEssStoppingRule(double m, const path &fn, size_t f, BurninEstimatorContinuous *be) : AbstractConvergenceStoppingRule(fn, f, be),
-    minEss( m )
+    minEss( m ),
+    useFixedBurnin( false ),
+    fixedBurnin( 0 )
+{
+    
+}
+
+
+MinEssStoppingRule::MinEssStoppingRule(double m, const path &fn, size_t f, BurninEstimatorContinuous *be, size_t b) : AbstractConvergenceStoppingRule(fn, f, be),
+    minEss( m ),
+    useFixedBurnin( true ),
+    fixedBurnin( b )
 {
     
 }
@@ -44,6 +55,22 @@ MinEssStoppingRule* MinEssStoppingRule::clone( void ) const
 }
 
 
+/**
+ * Set the number of runs/replicates.
+ * We start new accumulators for the samples of the new runs.
+ */
+void MinEssStoppingRule::setNumberOfRuns(size_t n)
+{
+    
+    AbstractConvergenceStoppingRule::setNumberOfRuns( n );
+    
+    accumulators.clear();
+    accumulators.resize( numReplicates );
+    numAccumulated.clear();
+    numAccumulated.resize( numReplicates, 0 );
+}
+
+
 /**
  * Should we stop now?
  * Yes, if the minimum ESS is larger than the provided threshold.
@@ -51,44 +78,87 @@ MinEssStoppingRule* MinEssStoppingRule::clone( void ) const
 bool MinEssStoppingRule::stop( size_t g )
 {
     
+    if ( useFixedBurnin == true )
+    {
+        return stopWithFixedBurnin();
+    }
+    
     bool passed = true;
     
     for ( size_t i = 1; i <= numReplicates; ++i)
     {
-        path fn = filename;
-        if ( numReplicates > 1 )
-            fn = appendToStem(filename, "_run_" + StringUtilities::to_string(i));
-        
-        TraceContinuousReader reader = TraceContinuousReader( fn );
-    
-        // get the vector of traces from the reader
-        std::vector<TraceNumeric> &data = reader.getTraces();
-    
-        size_t maxBurnin = 0;
+        // get the samples of the replicate, from memory if the monitor passed them to the sample sink
+        std::vector<TraceNumeric> file_traces;
+        std::vector<TraceNumeric> &data = getTraces( i, file_traces );
     
         // find the max burnin
-        for ( size_t j = 0; j < data.size(); ++j)
-        {
-            size_t b = burninEst->estimateBurnin( data[j] );
-
-            if ( maxBurnin < b )
-            {
-                maxBurnin = b;
-            }
-        }
+        size_t maxBurnin = burninEst->estimateMaximumBurnin( data );
     
         EssTest essTest = EssTest( minEss );
         
-        // set the burnins and conduct the tests
+        // set the burnins and compute the ESS of all parameters at once
         for ( size_t j = 0; j < data.size(); ++j)
         {
             data[j].setBurnin( maxBurnin );
+        }
+        TraceNumeric::computeCorrelationStatistics( data );
         
+        // conduct the tests
+        for ( size_t j = 0; j < data.size(); ++j)
+        {
             passed &= essTest.assessConvergence( data[j] );
         }
         
     }
     
     
+    return passed;
+}
+
+
+/**
+ * Check the ESS for a fixed burnin.
+ * We only pass the samples written since the previous check to the accumulators of the parameters,
+ * so a check costs the same regardless of how many samples have been taken already.
+ */
+bool MinEssStoppingRule::stopWithFixedBurnin( void )
+{
+    
+    bool passed = true;
+    
+    for ( size_t i = 1; i <= numReplicates; ++i)
+    {
+        std::vector<TraceNumeric> file_traces;
+        std::vector<TraceNumeric> &data = getTraces( i, file_traces );
+        
+        std::vector<EssAccumulator> &acc = accumulators[i-1];
+        size_t num_samples = ( data.empty() ? 0 : data[0].size() );
+        
+        // start over if the replicate started a new file
+        if ( acc.size() != data.size() || num_samples < numAccumulated[i-1] )
+        {
+            acc.clear();
+            acc.resize( data.size() );
+            numAccumulated[i-1] = 0;
+        }
+        
+        size_t first = std::max( numAccumulated[i-1], fixedBurnin );
+        for ( size_t j = 0; j < data.size(); ++j)
+        {
+            const std::vector<double> &values = data[j].getValues();
+            for ( size_t k = first; k < num_samples; ++k)
+            {
+                acc[j].addValue( values[k] );
+            }
+            
+            passed &= ( acc[j].getESS() > minEss );
+        }
+        numAccumulated[i-1] = num_samples;
+        
+        // we cannot assess a replicate without samples after the burnin
+        passed &= ( num_samples > fixedBurnin );
+    }
+    
+    
     return passed;
 }
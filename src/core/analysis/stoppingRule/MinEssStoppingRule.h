@@ -2,6 +2,7 @@
 #define MinEssStoppingRule_H
 
 #include "AbstractConvergenceStoppingRule.h"
+#include "EssAccumulator.h"
 
 #include <vector>
 
@@ -12,6 +13,9 @@ namespace RevBayesCore {
      *
      * This stopping rule returns true when the minimum effective sample size (ESS) has been reached.
      * This rule is most useful if you want to guarantee that you have sufficiently many (effective) samples.
+     * If a fixed burnin is given, the ESS is accumulated while the samples arrive, so that each check only
+     * processes the samples written since the previous check. Otherwise the burnin is estimated and the ESS
+     * is recomputed from all samples at every check.
      *
      *
      * @copyright Copyright 2009-
@@ -23,15 +27,23 @@ namespace RevBayesCore {
         
     public:
         MinEssStoppingRule(double m, const path &fn, size_t fq, BurninEstimatorContinuous *be);
+        MinEssStoppingRule(double m, const path &fn, size_t fq, BurninEstimatorContinuous *be, size_t b);
         virtual                                            ~MinEssStoppingRule(void);                                   //!< Virtual destructor
         
         // public methods
         MinEssStoppingRule*                                 clone(void) const;                                          //!< Clone function. This is similar to the copy constructor but useful in inheritance.
+        void                                                setNumberOfRuns(size_t n);                                  //!< Set how many runs/replicates there are.
         bool                                                stop(size_t g);                                             //!< Should we stop now?
         
     private:
         
+        bool                                                stopWithFixedBurnin(void);                                  //!< Check the running ESS after the fixed burnin
+        
         double                                              minEss;                                                     //!< The minimum ESS threshold
+        bool                                                useFixedBurnin;                                             //!< Do we discard a fixed number of samples instead of estimating the burnin?
+        size_t                                              fixedBurnin;                                                //!< The fixed number of samples discarded as burnin
+        std::vector< std::vector<EssAccumulator> >          accumulators;                                               //!< The running ESS of each parameter of each replicate
+        std::vector<size_t>                                 numAccumulated;                                             //!< The number of samples of each replicate passed to the accumulators
         
     };
     
@@ -7,8 +7,6 @@
 #include "StationarityStoppingRule.h"
 #include "RbException.h"
 #include "RbFileManager.h"
-#include "StringUtilities.h"
-#include "TraceContinuousReader.h"
 #include "AbstractConvergenceStoppingRule.h"
 #include "BurninEstimatorContinuous.h"
 #include "Cloner.h"
@@ -76,27 +74,12 @@ bool StationarityStoppingRule::stop( size_t g )
     std::vector<std::vector<size_t> > burnins;
     for ( size_t i = 1; i <= numReplicates; ++i)
     {
-        path fn = filename;
-        if ( numReplicates > 1 )
-            fn = appendToStem(filename, "_run_" + StringUtilities::to_string(i));
-        
-        TraceContinuousReader reader = TraceContinuousReader( fn );
-        
-        // get the vector of traces from the reader
-        std::vector<TraceNumeric> &data = reader.getTraces();
-        
-        size_t maxBurnin = 0;
+        // get the samples of the replicate, from memory if the monitor passed them to the sample sink
+        std::vector<TraceNumeric> file_traces;
+        std::vector<TraceNumeric> &data = getTraces( i, file_traces );
         
         // find the max burnin
-        for ( size_t j = 0; j < data.size(); ++j)
-        {
-            size_t b = burninEst->estimateBurnin( data[j] );
-
-            if ( maxBurnin < b )
-            {
-                maxBurnin = b;
-            }
-        }
+        size_t maxBurnin = burninEst->estimateMaximumBurnin( data );
         
         // set the burnins
         for ( size_t j = 0; j < data.size(); ++j)
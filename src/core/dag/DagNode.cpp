@@ -617,6 +617,29 @@ bool DagNode::isHidden( void ) const
 }
 
 
+/**
+ * Can independent copies of this DAG node be updated on different threads at the same time?
+ * This is true unless the node depends on shared global state, e.g., the Rev workspace.
+ */
+bool DagNode::isThreadSafe( void ) const
+{
+
+    return true;
+}
+
+
+/**
+ * Does reading the value of this DAG node update it?
+ * Only deterministic nodes evaluate their function lazily (or on every access if they force updates),
+ * so the value of all other nodes can be read concurrently.
+ */
+bool DagNode::isUpdatedOnAccess( void ) const
+{
+
+    return false;
+}
+
+
 bool DagNode::isIntegratedOut( void ) const
 {
     return false;
@@ -99,6 +99,8 @@ template <class valueType> class RbOrderedSet;
         virtual bool                                                isIntegratedOut(void) const;
         virtual bool                                                isSimpleNumeric(void) const;                                                                //!< Is this variable a simple numeric variable? Currently only integer and real number are.
         virtual bool                                                isStochastic(void) const;                                                                   //!< Is this DAG node stochastic?
+        virtual bool                                                isThreadSafe(void) const;                                                                   //!< Can independent copies of this DAG node be updated on different threads at the same time?
+        virtual bool                                                isUpdatedOnAccess(void) const;                                                              //!< Does reading the value of this DAG node update it (lazy or forced evaluation)?
         void                                                        keep(void);
         virtual void                                                keepAffected(void);                                                                         //!< Keep value of affected nodes
         void                                                        keepVector(std::vector<DagNode *>& nodes);
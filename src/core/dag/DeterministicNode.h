@@ -27,6 +27,7 @@ namespace RevBayesCore {
         valueType&                                          getValue(void);
         const valueType&                                    getValue(void) const;
         bool                                                isConstant(void) const;                                                     //!< Is this DAG node constant?
+        bool                                                isUpdatedOnAccess(void) const;                                              //!< Does reading our value call the function (lazy or forced evaluation)?
         virtual void                                        printStructureInfo(std::ostream &o, bool verbose=false) const;              //!< Print the structural information (e.g. name, value-type, distribution/function, children, parents, etc.)
         void                                                redraw(SimulationCondition c = SimulationCondition::MCMC);
         void                                                reInitializeMe(void);                                                       //!< The DAG was re-initialized so maybe you want to reset some stuff (delegate to distribution)
@@ -50,6 +51,7 @@ namespace RevBayesCore {
         TypedFunction<valueType>*                           function;
         mutable bool                                        needs_update;
         bool                                                force_update;
+        bool                                                all_elements_touched;                                                       //!< Did a touch change all elements since the last keep/restore?
     };
 
 }
@@ -63,7 +65,8 @@ RevBayesCore::DeterministicNode<valueType>::DeterministicNode( const std::string
     DynamicNode<valueType>( n ),
     function( f ),
     needs_update( true ),
-    force_update( f->forceUpdates() )
+    force_update( f->forceUpdates() ),
+    all_elements_touched( false )
 {
     this->type = DagNode::DETERMINISTIC;
 
@@ -88,7 +91,8 @@ RevBayesCore::DeterministicNode<valueType>::DeterministicNode( const Determinist
     DynamicNode<valueType>( n ),
     function( n.function->clone() ),
     needs_update( true ),
-    force_update( n.function->forceUpdates() )
+    force_update( n.function->forceUpdates() ),
+    all_elements_touched( false )
 {
     this->type = DagNode::DETERMINISTIC;
 
@@ -315,6 +319,18 @@ bool RevBayesCore::DeterministicNode<valueType>::isConstant( void ) const
 }
 
 
+/**
+ * Does reading our value call the function?
+ * This is the case if we are dirty or if the function forces updates (e.g., Rev member functions).
+ */
+template<class valueType>
+bool RevBayesCore::DeterministicNode<valueType>::isUpdatedOnAccess( void ) const
+{
+
+    return needs_update == true || force_update == true;
+}
+
+
 /**
  * Keep the current value of the node.
  * At this point, we just delegate to the children.
@@ -335,6 +351,7 @@ void RevBayesCore::DeterministicNode<valueType>::keepMe( const DagNode* affecter
 
     // clear the list of touched element indices
     this->touched_elements.clear();
+    all_elements_touched = false;
 
 }
 
@@ -402,6 +419,7 @@ void RevBayesCore::DeterministicNode<valueType>::restoreMe( const DagNode *resto
 
     // clear the list of touched element indices
     this->touched_elements.clear();
+    all_elements_touched = false;
 
     // delegate call
     this->restoreAffected();
@@ -485,6 +503,28 @@ void RevBayesCore::DeterministicNode<valueType>::touchMe( const DagNode *toucher
     DynamicNode<valueType>::touchMe( toucher, touchAll );
 
 
+    // collect the indices of the elements that changed, so that our children only need to recompute what depends on these elements
+    // an empty set of touched indices means that all elements may have changed
+    if ( was_touched == false )
+    {
+        this->touched_elements.clear();
+        all_elements_touched = false;
+    }
+    if ( all_elements_touched == false )
+    {
+        std::set<size_t> indices;
+        if ( touchAll == false && toucher != this && function->getAffectedElementIndices( toucher, indices ) == true && indices.empty() == false )
+        {
+            this->touched_elements.insert( indices.begin(), indices.end() );
+        }
+        else
+        {
+            this->touched_elements.clear();
+            all_elements_touched = true;
+        }
+    }
+
+
     // We need to touch the function always because of specialized touch functionality in some functions, like vector functions.
     // In principle, it would sufficient to do the touch once for each toucher, but we do not keep track of the touchers here.
     // call for potential specialized handling (e.g. internal flags), we might have been touched already by someone else, so we need to delegate regardless
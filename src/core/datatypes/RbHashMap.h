@@ -0,0 +1,228 @@
+#ifndef RbHashMap_H
+#define RbHashMap_H
+
+#include <cstddef>
+#include <vector>
+
+namespace RevBayesCore {
+
+    /**
+     * @brief Hash map with open addressing.
+     *
+     * The entries are stored contiguously in insertion order and the hash table
+     * only holds their indices, which are probed linearly. This keeps lookups
+     * cache friendly and avoids one heap allocation per entry, which matters
+     * for maps with millions of small entries (e.g. split counts of tree samples).
+     * Entries cannot be erased individually.
+     *
+     * The hash function object must map a key to a size_t. The lower bits are used
+     * to find the slot, so the hash values should be well mixed.
+     */
+    template <class keyType, class valueType, class hashType>
+    class RbHashMap {
+
+    public:
+        // constructor(s)
+        RbHashMap(size_t n = 16);
+        virtual                                            ~RbHashMap(void);
+
+        // operators
+        valueType&                                          operator[](const keyType &k);                       //!< Get the value of this key (inserts a default value if the key is missing)
+
+        // public member functions
+        void                                                clear(void);
+        bool                                                contains(const keyType &k) const;
+        valueType*                                          find(const keyType &k);                             //!< Get the value of this key or NULL if the key is missing
+        const valueType*                                    find(const keyType &k) const;                       //!< Get the value of this key or NULL if the key is missing
+        size_t                                              getIndex(const keyType &k) const;                   //!< Get the insertion index of this key or size() if the key is missing
+        const keyType&                                      getKey(size_t i) const;                             //!< Get the i-th inserted key
+        valueType&                                          getValue(size_t i);                                 //!< Get the value of the i-th inserted key
+        const valueType&                                    getValue(size_t i) const;                           //!< Get the value of the i-th inserted key
+        size_t                                              insert(const keyType &k, const valueType &v);       //!< Insert the key if missing and return its insertion index
+        size_t                                              size(void) const;
+
+    private:
+
+        size_t                                              findSlot(const keyType &k) const;
+        void                                                rehash(size_t n);
+
+        std::vector<size_t>                                 slots;                                              //!< Index+1 of the entry in each slot, 0 for an empty slot
+        std::vector<keyType>                                keys;
+        std::vector<valueType>                              values;
+        hashType                                            hash_function;
+
+    };
+
+}
+
+
+template <class keyType, class valueType, class hashType>
+RevBayesCore::RbHashMap<keyType, valueType, hashType>::RbHashMap(size_t n)
+{
+
+    // the number of slots is a power of two and at least twice the number of entries
+    size_t num_slots = 16;
+    while ( num_slots < 2*n )
+    {
+        num_slots *= 2;
+    }
+    slots.resize( num_slots, 0 );
+
+}
+
+
+template <class keyType, class valueType, class hashType>
+RevBayesCore::RbHashMap<keyType, valueType, hashType>::~RbHashMap( void )
+{
+
+}
+
+
+template <class keyType, class valueType, class hashType>
+valueType& RevBayesCore::RbHashMap<keyType, valueType, hashType>::operator[](const keyType &k)
+{
+
+    return values[ insert(k, valueType()) ];
+}
+
+
+template <class keyType, class valueType, class hashType>
+void RevBayesCore::RbHashMap<keyType, valueType, hashType>::clear( void )
+{
+
+    keys.clear();
+    values.clear();
+    slots.assign( slots.size(), 0 );
+
+}
+
+
+template <class keyType, class valueType, class hashType>
+bool RevBayesCore::RbHashMap<keyType, valueType, hashType>::contains(const keyType &k) const
+{
+
+    return slots[ findSlot(k) ] != 0;
+}
+
+
+template <class keyType, class valueType, class hashType>
+valueType* RevBayesCore::RbHashMap<keyType, valueType, hashType>::find(const keyType &k)
+{
+
+    size_t entry = slots[ findSlot(k) ];
+
+    return ( entry == 0 ? NULL : &values[entry-1] );
+}
+
+
+template <class keyType, class valueType, class hashType>
+const valueType* RevBayesCore::RbHashMap<keyType, valueType, hashType>::find(const keyType &k) const
+{
+
+    size_t entry = slots[ findSlot(k) ];
+
+    return ( entry == 0 ? NULL : &values[entry-1] );
+}
+
+
+/**
+ * Find the slot of this key by linear probing.
+ * This is either the slot holding the key or the empty slot where the key would be inserted.
+ */
+template <class keyType, class valueType, class hashType>
+size_t RevBayesCore::RbHashMap<keyType, valueType, hashType>::findSlot(const keyType &k) const
+{
+
+    size_t mask = slots.size() - 1;
+    size_t slot = hash_function( k ) & mask;
+    while ( slots[slot] != 0 && !(keys[slots[slot]-1] == k) )
+    {
+        slot = (slot + 1) & mask;
+    }
+
+    return slot;
+}
+
+
+template <class keyType, class valueType, class hashType>
+size_t RevBayesCore::RbHashMap<keyType, valueType, hashType>::getIndex(const keyType &k) const
+{
+
+    size_t entry = slots[ findSlot(k) ];
+
+    return ( entry == 0 ? keys.size() : entry-1 );
+}
+
+
+template <class keyType, class valueType, class hashType>
+const keyType& RevBayesCore::RbHashMap<keyType, valueType, hashType>::getKey(size_t i) const
+{
+
+    return keys[i];
+}
+
+
+template <class keyType, class valueType, class hashType>
+valueType& RevBayesCore::RbHashMap<keyType, valueType, hashType>::getValue(size_t i)
+{
+
+    return values[i];
+}
+
+
+template <class keyType, class valueType, class hashType>
+const valueType& RevBayesCore::RbHashMap<keyType, valueType, hashType>::getValue(size_t i) const
+{
+
+    return values[i];
+}
+
+
+template <class keyType, class valueType, class hashType>
+size_t RevBayesCore::RbHashMap<keyType, valueType, hashType>::insert(const keyType &k, const valueType &v)
+{
+
+    size_t slot = findSlot( k );
+    if ( slots[slot] != 0 )
+    {
+        return slots[slot] - 1;
+    }
+
+    keys.push_back( k );
+    values.push_back( v );
+    slots[slot] = keys.size();
+
+    // we keep the load factor below 1/2 so that the probe sequences stay short
+    if ( 2*keys.size() > slots.size() )
+    {
+        rehash( 2*slots.size() );
+    }
+
+    return keys.size() - 1;
+}
+
+
+template <class keyType, class valueType, class hashType>
+void RevBayesCore::RbHashMap<keyType, valueType, hashType>::rehash(size_t n)
+{
+
+    slots.assign( n, 0 );
+    for (size_t i = 0; i < keys.size(); ++i)
+    {
+        slots[ findSlot(keys[i]) ] = i + 1;
+    }
+
+}
+
+
+template <class keyType, class valueType, class hashType>
+size_t RevBayesCore::RbHashMap<keyType, valueType, hashType>::size( void ) const
+{
+
+    return keys.size();
+}
+
+
+
+#endif
+
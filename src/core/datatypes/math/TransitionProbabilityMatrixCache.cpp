@@ -0,0 +1,177 @@
+#include "TransitionProbabilityMatrixCache.h"
+
+#include <atomic>
+#include <cstring>
+#include <stdint.h>
+
+using namespace RevBayesCore;
+
+
+TransitionProbabilityMatrixCache::TransitionProbabilityMatrixCache(size_t n) :
+    capacity( n ),
+    num_hits( 0 ),
+    num_misses( 0 )
+{
+
+}
+
+
+TransitionProbabilityMatrixCache::TransitionProbabilityMatrixCache(const TransitionProbabilityMatrixCache &c) :
+    capacity( c.capacity ),
+    num_hits( 0 ),
+    num_misses( 0 )
+{
+
+}
+
+
+TransitionProbabilityMatrixCache& TransitionProbabilityMatrixCache::operator=(const TransitionProbabilityMatrixCache &c)
+{
+
+    if ( this != &c )
+    {
+        clear();
+        capacity = c.capacity;
+    }
+
+    return *this;
+}
+
+
+void TransitionProbabilityMatrixCache::clear( void )
+{
+
+    index.clear();
+    entries.clear();
+    num_hits = 0;
+    num_misses = 0;
+
+}
+
+
+/**
+ * Look up the matrix for this rate matrix version, rate matrix index and scaled time.
+ * If we find it, we copy it into P and mark it as the most recently used matrix.
+ */
+bool TransitionProbabilityMatrixCache::find(size_t v, size_t i, double t, TransitionProbabilityMatrix &P)
+{
+
+    Key k = { v, i, t };
+    std::unordered_map<Key, std::list<Entry>::iterator, KeyHash>::const_iterator it = index.find( k );
+    if ( it == index.end() )
+    {
+        ++num_misses;
+        return false;
+    }
+
+    // move the entry to the front without invalidating any iterator
+    entries.splice( entries.begin(), entries, it->second );
+    P = it->second->matrix;
+
+    ++num_hits;
+    return true;
+}
+
+
+size_t TransitionProbabilityMatrixCache::getCapacity( void ) const
+{
+    return capacity;
+}
+
+
+size_t TransitionProbabilityMatrixCache::getNumberOfHits( void ) const
+{
+    return num_hits;
+}
+
+
+size_t TransitionProbabilityMatrixCache::getNumberOfMisses( void ) const
+{
+    return num_misses;
+}
+
+
+void TransitionProbabilityMatrixCache::insert(size_t v, size_t i, double t, const TransitionProbabilityMatrix &P)
+{
+
+    if ( capacity == 0 )
+    {
+        return;
+    }
+
+    Key k = { v, i, t };
+    std::unordered_map<Key, std::list<Entry>::iterator, KeyHash>::iterator it = index.find( k );
+    if ( it != index.end() )
+    {
+        it->second->matrix = P;
+        entries.splice( entries.begin(), entries, it->second );
+        return;
+    }
+
+    if ( entries.size() >= capacity )
+    {
+        // reuse the least recently used entry instead of allocating a new matrix
+        std::list<Entry>::iterator last = --entries.end();
+        index.erase( last->key );
+        last->key    = k;
+        last->matrix = P;
+        entries.splice( entries.begin(), entries, last );
+    }
+    else
+    {
+        entries.push_front( Entry(k, P) );
+    }
+
+    index[k] = entries.begin();
+
+}
+
+
+/**
+ * Get a new version number. The numbers are unique over all caches and threads,
+ * so a version never refers to two different rate matrices.
+ */
+size_t TransitionProbabilityMatrixCache::nextVersion( void )
+{
+
+    static std::atomic<size_t> version( 0 );
+
+    return ++version;
+}
+
+
+void TransitionProbabilityMatrixCache::setCapacity(size_t n)
+{
+
+    capacity = n;
+    while ( entries.size() > capacity )
+    {
+        index.erase( entries.back().key );
+        entries.pop_back();
+    }
+
+}
+
+
+size_t TransitionProbabilityMatrixCache::size( void ) const
+{
+    return entries.size();
+}
+
+
+size_t TransitionProbabilityMatrixCache::KeyHash::operator()(const Key &k) const
+{
+
+    // 0.0 and -0.0 are equal keys and need the same hash
+    double time = ( k.time == 0.0 ? 0.0 : k.time );
+    uint64_t t = 0;
+    std::memcpy( &t, &time, sizeof(double) );
+
+    // splitmix64 finalizer over the combined fields
+    uint64_t h = t ^ (uint64_t(k.version) * 0x9E3779B97F4A7C15ULL) ^ (uint64_t(k.index) * 0xC2B2AE3D27D4EB4FULL);
+    h = (h ^ (h >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    h = (h ^ (h >> 27)) * 0x94D049BB133111EBULL;
+    h =  h ^ (h >> 31);
+
+    return size_t(h);
+}
@@ -0,0 +1,75 @@
+#ifndef TransitionProbabilityMatrixCache_H
+#define TransitionProbabilityMatrixCache_H
+
+#include "TransitionProbabilityMatrix.h"
+
+#include <cstddef>
+#include <list>
+#include <unordered_map>
+
+namespace RevBayesCore {
+
+    /**
+     * @brief Bounded cache of transition probability matrices.
+     *
+     * The matrices are keyed by the version of the rate matrix that computed them,
+     * the index of the rate matrix (e.g., for mixtures over rate matrices), and the scaled time (rate * branch length).
+     * Whoever owns the cache draws a new version from nextVersion() whenever the rate matrix changes,
+     * so that stale matrices are never found. Old versions are not removed explicitly
+     * but are evicted once they are the least recently used entries.
+     * Lookup, insertion and eviction all take constant time.
+     *
+     * Copies of a cache start empty, because the copy usually belongs to a copy of the model
+     * whose rate matrices are new objects.
+     */
+    class TransitionProbabilityMatrixCache {
+
+    public:
+        TransitionProbabilityMatrixCache(size_t n = 1024);                                                      //!< Construct a cache with up to n matrices
+        TransitionProbabilityMatrixCache(const TransitionProbabilityMatrixCache &c);                            //!< Copy constructor (the copy is empty)
+
+        TransitionProbabilityMatrixCache&           operator=(const TransitionProbabilityMatrixCache &c);       //!< Assignment operator (the copy is empty)
+
+        void                                        clear(void);                                                //!< Remove all matrices
+        bool                                        find(size_t v, size_t i, double t, TransitionProbabilityMatrix &P);                     //!< Copy the cached matrix into P if there is one
+        size_t                                      getCapacity(void) const;
+        size_t                                      getNumberOfHits(void) const;
+        size_t                                      getNumberOfMisses(void) const;
+        void                                        insert(size_t v, size_t i, double t, const TransitionProbabilityMatrix &P);             //!< Add a matrix, evicting the least recently used one if the cache is full
+        void                                        setCapacity(size_t n);
+        size_t                                      size(void) const;
+
+        static size_t                               nextVersion(void);                                          //!< Get a new, globally unique rate matrix version
+
+    private:
+
+        struct Key {
+            size_t                                  version;
+            size_t                                  index;
+            double                                  time;
+
+            bool operator==(const Key &k) const { return version == k.version && index == k.index && time == k.time; }
+        };
+
+        struct KeyHash {
+            size_t operator()(const Key &k) const;
+        };
+
+        struct Entry {
+            Entry(const Key &k, const TransitionProbabilityMatrix &P) : key(k), matrix(P) {}
+
+            Key                                     key;
+            TransitionProbabilityMatrix             matrix;
+        };
+
+        size_t                                                              capacity;
+        std::list<Entry>                                                    entries;                            //!< The entries, most recently used first
+        std::unordered_map<Key, std::list<Entry>::iterator, KeyHash>        index;
+        size_t                                                              num_hits;
+        size_t                                                              num_misses;
+
+    };
+
+}
+
+#endif
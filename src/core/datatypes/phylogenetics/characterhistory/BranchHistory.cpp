@@ -63,7 +63,7 @@ BranchHistory::~BranchHistory(void)
     for (size_t i = 0; i < child_characters.size(); i++)
         delete child_characters[i];
     
-//    std::multiset<CharacterEvent*,CharacterEventCompare>::iterator it;
+//    CharacterEventList::iterator it;
 
 }
 
@@ -122,7 +122,7 @@ bool BranchHistory::areEventTimesValid(const TopologyNode &node) const
     double lower_boundary = node.getAge();
     double upper_boundary = lower_boundary + node.getBranchLength();
     double event_age;
-    std::multiset<CharacterEvent*,CharacterEventCompare>::iterator it;
+    CharacterEventList::const_iterator it;
     for (it = history.begin(); it != history.end(); it++)
     {
         event_age = (*it)->getAge();
@@ -147,12 +147,12 @@ std::vector<CharacterEvent*>& BranchHistory::getChildCharacters(void)
 }
 
 
-std::multiset<CharacterEvent*,CharacterEventCompare>& BranchHistory::getHistory(void)
+CharacterEventList& BranchHistory::getHistory(void)
 {
     return history;
 }
 
-const std::multiset<CharacterEvent*,CharacterEventCompare>& BranchHistory::getHistory(void) const
+const CharacterEventList& BranchHistory::getHistory(void) const
 {
     return history;
 }
@@ -188,36 +188,20 @@ void BranchHistory::clearEvents(void)
 void BranchHistory::clearEvents(const std::set<size_t>& indexSet)
 {
     
-    std::set<size_t>::iterator it_idx;
-    std::multiset<CharacterEvent*,CharacterEventCompare>::iterator it_h, it_tmp;
-    std::set<CharacterEvent*> to_be_deleted;
-    
-    // for each event in history, delete if index matches indexSet
-    for (it_h = history.begin(); it_h != history.end(); it_h++)
+    // for each event in history, remove it if its index matches indexSet
+    // keeping the remaining events in their (sorted) order
+    CharacterEventList::iterator it_keep = history.begin();
+    for (CharacterEventList::iterator it_h = history.begin(); it_h != history.end(); ++it_h)
     {
-        if ( indexSet.find( (*it_h)->getSiteIndex() ) != indexSet.end() )
+        if ( indexSet.find( (*it_h)->getSiteIndex() ) == indexSet.end() )
         {
-            to_be_deleted.insert(*it_h);
+            *it_keep = *it_h;
+            ++it_keep;
         }
     }
     
-    std::set<CharacterEvent*>::iterator it_d;
-    for (it_d = to_be_deleted.begin(); it_d != to_be_deleted.end(); it_d++)
-    {
-        history.erase(*it_d);
-    }
-
-//            it_tmp = it_h;
-//            ++it_tmp;
-//            history.erase(it_h);
-//            //delete *it_h;
-//            it_h = it_tmp;
-//        }
-//        else
-//        {
-//            ++it_h;
-//        }
-//    }
+    history.erase( it_keep, history.end() );
+    
 }
 
 void BranchHistory::removeEvent(CharacterEvent* evt)
@@ -227,7 +211,7 @@ void BranchHistory::removeEvent(CharacterEvent* evt)
 
 }
 
-void BranchHistory::updateHistory(const std::multiset<CharacterEvent*,CharacterEventCompare>& updateSet, const std::set<CharacterEvent*>& parentSet, const std::set<CharacterEvent*>& childSet, const std::set<size_t>& indexSet)
+void BranchHistory::updateHistory(const CharacterEventList& updateSet, const std::set<CharacterEvent*>& parentSet, const std::set<CharacterEvent*>& childSet, const std::set<size_t>& indexSet)
 {
 
     /*
@@ -235,7 +219,7 @@ void BranchHistory::updateHistory(const std::multiset<CharacterEvent*,CharacterE
     clearEvents(indexSet);
 
     // insert elements into history
-    std::multiset<CharacterEvent*,CharacterEventCompare>::iterator it_h;
+    CharacterEventList::iterator it_h;
     for (it_h = updateSet.begin(); it_h != updateSet.end(); it_h++)
         history.insert(*it_h);
     */
@@ -251,31 +235,20 @@ void BranchHistory::updateHistory(const std::multiset<CharacterEvent*,CharacterE
 
 }
 
-void BranchHistory::updateHistory(const std::multiset<CharacterEvent*,CharacterEventCompare>& updateSet, const std::set<size_t>& indexSet)
+void BranchHistory::updateHistory(const CharacterEventList& updateSet, const std::set<size_t>& indexSet)
 {
     // erase events on branchHistory for indices in indexSet
     clearEvents(indexSet);
 
     // insert elements into history
-    std::multiset<CharacterEvent*,CharacterEventCompare>::iterator it_h;
-    for (it_h = updateSet.begin(); it_h != updateSet.end(); it_h++)
-    {
-        history.insert(*it_h);
-    }
+    history.insert(updateSet.begin(), updateSet.end());
 
 }
 
-void BranchHistory::updateHistory(const std::multiset<CharacterEvent*,CharacterEventCompare>& updateSet)
+void BranchHistory::updateHistory(const CharacterEventList& updateSet)
 {
-    // erase events on branchHistory for indices in indexSet
-    clearEvents();
-
-    // insert elements into history
-    std::multiset<CharacterEvent*,CharacterEventCompare>::iterator it_h;
-    for (it_h = updateSet.begin(); it_h != updateSet.end(); it_h++)
-    {
-        history.insert(*it_h);
-    }
+    // replace all events on branchHistory
+    history = updateSet;
 
 }
 
@@ -323,14 +296,11 @@ void BranchHistory::setParentCharacters(const std::set<CharacterEvent*>& s)
 void BranchHistory::setHistory(const std::set<CharacterEvent*,CharacterEventCompare>& s)
 {
     history.clear();
-    for (std::set<CharacterEvent*,CharacterEventCompare>::iterator it = s.begin(); it != s.end(); it++)
-    {
-        history.insert(*it);
-    }
+    history.insert(s.begin(), s.end());
 
 }
 
-void BranchHistory::setHistory(const std::multiset<CharacterEvent*,CharacterEventCompare>& s)
+void BranchHistory::setHistory(const CharacterEventList& s)
 {
     history = s;
 }
@@ -339,7 +309,7 @@ void BranchHistory::setHistory(const std::multiset<CharacterEvent*,CharacterEven
 void BranchHistory::print(const TopologyNode* nd) const
 {
     
-    std::set<CharacterEvent*,CharacterEventCompare>::iterator it_h;
+    CharacterEventList::const_iterator it_h;
     std::vector<CharacterEvent*>::iterator it_v;
 
     double start_age=0.0;
@@ -429,13 +399,7 @@ const size_t BranchHistory::getBranchIndex(void) const
 
 CharacterEvent* BranchHistory::getEvent(size_t i)
 {
-    std::multiset<CharacterEvent*,CharacterEventCompare>::iterator it = history.begin();
-    for (size_t j=0; j<i; ++j)
-    {
-        ++it;
-    }
-
-    return (*it);
+    return history.begin()[i];
 }
 
 
@@ -7,6 +7,7 @@
 #include <vector>
 
 #include "CharacterEventCompare.h"
+#include "CharacterEventList.h"
 #include "Cloneable.h"
 #include "TopologyNode.h"
 
@@ -42,8 +43,8 @@ class CharacterEvent;
         const std::vector<CharacterEvent*>&                             getParentCharacters(void) const;
         std::vector<CharacterEvent*>&                                   getChildCharacters(void);
         const std::vector<CharacterEvent*>&                             getChildCharacters(void) const;
-        std::multiset<CharacterEvent*,CharacterEventCompare>&           getHistory(void);
-        const std::multiset<CharacterEvent*,CharacterEventCompare>&     getHistory(void) const;
+        CharacterEventList&                                             getHistory(void);
+        const CharacterEventList&                                       getHistory(void) const;
 
         void                                                            print(const TopologyNode* nd=NULL) const;
 
@@ -53,12 +54,12 @@ class CharacterEvent;
         void                                                            setChildCharacters(const std::set<CharacterEvent*>& s);
         void                                                            setChildCharacters(const std::vector<CharacterEvent*>& s);
         void                                                            setHistory(const std::set<CharacterEvent*,CharacterEventCompare>& s);
-        void                                                            setHistory(const std::multiset<CharacterEvent*,CharacterEventCompare>& s);
+        void                                                            setHistory(const CharacterEventList& s);
 
         void                                                            removeEvent(CharacterEvent* evt);
-        void                                                            updateHistory(const std::multiset<CharacterEvent*,CharacterEventCompare>& updateSet, const std::set<CharacterEvent*>& parentSet, const std::set<CharacterEvent*>& childSet, const std::set<size_t>& indexSet);
-        void                                                            updateHistory(const std::multiset<CharacterEvent*,CharacterEventCompare>& updateSet, const std::set<size_t>& indexSet);
-        void                                                            updateHistory(const std::multiset<CharacterEvent*,CharacterEventCompare>& updateSet);
+        void                                                            updateHistory(const CharacterEventList& updateSet, const std::set<CharacterEvent*>& parentSet, const std::set<CharacterEvent*>& childSet, const std::set<size_t>& indexSet);
+        void                                                            updateHistory(const CharacterEventList& updateSet, const std::set<size_t>& indexSet);
+        void                                                            updateHistory(const CharacterEventList& updateSet);
 
         
 
@@ -73,7 +74,7 @@ class CharacterEvent;
         size_t                                                          branch_index;
 
         // containers
-        mutable std::multiset<CharacterEvent*,CharacterEventCompare>    history;
+        mutable CharacterEventList    history;
         mutable std::vector<CharacterEvent*>                            parent_characters;
         mutable std::vector<CharacterEvent*>                            child_characters;
 
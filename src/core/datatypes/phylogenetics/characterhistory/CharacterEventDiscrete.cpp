@@ -1,6 +1,10 @@
 #include "CharacterEventDiscrete.h"
 
+#include <atomic>
+#include <cstddef>
+#include <new>
 #include <sstream> // IWYU pragma: keep
+#include <vector>
 
 #include "Cloneable.h"
 
@@ -29,6 +33,139 @@ CharacterEventDiscrete::~CharacterEventDiscrete(void)
 
 }
 
+namespace {
+
+    // the number of events we allocate at once when the pool is empty
+    const size_t EVENT_POOL_CHUNK_SIZE = 1024;
+
+    struct EventChunk;
+
+    // every event remembers the chunk it was allocated from
+    struct EventSlot {
+        EventChunk*                         chunk;
+        alignas(CharacterEventDiscrete) char event[sizeof(CharacterEventDiscrete)];
+    };
+
+    // a contiguous chunk of events, so that the events of a history end up close to each other in memory
+    struct EventChunk {
+        std::atomic<size_t>                 num_unreleased;                     //!< The number of slots that are in use or in the free list of a running thread
+        EventSlot                           slots[EVENT_POOL_CHUNK_SIZE];
+    };
+
+    /**
+     * Give up a slot for good. Once all slots of a chunk are released, nobody can hand them out anymore and we free the chunk.
+     * The slots may be released by different threads, so the count is atomic.
+     */
+    void releaseEventSlot(EventSlot* slot)
+    {
+        EventChunk* chunk = slot->chunk;
+        if ( --chunk->num_unreleased == 0 )
+        {
+            delete chunk;
+        }
+    }
+
+    EventChunk* newEventChunk(void)
+    {
+        EventChunk* chunk = new EventChunk;
+        chunk->num_unreleased = EVENT_POOL_CHUNK_SIZE;
+        for (size_t i = 0; i < EVENT_POOL_CHUNK_SIZE; ++i)
+        {
+            chunk->slots[i].chunk = chunk;
+        }
+        return chunk;
+    }
+
+    /**
+     * The freed events of one thread, ready to be reused.
+     * Events may be freed by another thread than the one that allocated them, so a free list can hold slots of any chunk.
+     * When the thread ends we release the slots in our free list; the events still in use release theirs when they are deleted.
+     */
+    struct EventPool {
+
+        ~EventPool()
+        {
+            for (size_t i = 0; i < free_slots.size(); ++i)
+            {
+                releaseEventSlot( free_slots[i] );
+            }
+            destroyed = true;
+        }
+
+        std::vector<EventSlot*>             free_slots;
+        static thread_local bool            destroyed;                          //!< Events deleted after the pool of this thread is gone are released directly
+    };
+
+    thread_local bool EventPool::destroyed = false;
+    thread_local EventPool event_pool;
+
+}
+
+
+void* CharacterEventDiscrete::operator new(size_t size)
+{
+
+    // derived classes are not pooled
+    if ( size != sizeof(CharacterEventDiscrete) )
+    {
+        return ::operator new(size);
+    }
+
+    if ( EventPool::destroyed == true )
+    {
+        // we cannot keep the other slots, so we hand out the first one and release the rest
+        EventChunk* chunk = newEventChunk();
+        for (size_t i = 1; i < EVENT_POOL_CHUNK_SIZE; ++i)
+        {
+            releaseEventSlot( &chunk->slots[i] );
+        }
+        return chunk->slots[0].event;
+    }
+
+    std::vector<EventSlot*> &free_slots = event_pool.free_slots;
+    if ( free_slots.empty() == true )
+    {
+        EventChunk* chunk = newEventChunk();
+        free_slots.reserve( free_slots.size() + EVENT_POOL_CHUNK_SIZE );
+        for (size_t i = EVENT_POOL_CHUNK_SIZE; i > 0; --i)
+        {
+            free_slots.push_back( &chunk->slots[i-1] );
+        }
+    }
+
+    EventSlot* slot = free_slots.back();
+    free_slots.pop_back();
+
+    return slot->event;
+}
+
+
+void CharacterEventDiscrete::operator delete(void* p, size_t size)
+{
+
+    if ( p == NULL )
+    {
+        return;
+    }
+
+    if ( size != sizeof(CharacterEventDiscrete) )
+    {
+        ::operator delete(p);
+        return;
+    }
+
+    EventSlot* slot = reinterpret_cast<EventSlot*>( static_cast<char*>(p) - offsetof(EventSlot, event) );
+    if ( EventPool::destroyed == true )
+    {
+        releaseEventSlot( slot );
+    }
+    else
+    {
+        event_pool.free_slots.push_back( slot );
+    }
+}
+
+
 CharacterEventDiscrete* CharacterEventDiscrete::clone( void ) const
 {
     return new CharacterEventDiscrete( *this );
@@ -0,0 +1,93 @@
+#include "CharacterEventList.h"
+
+#include "CharacterEvent.h"
+
+using namespace RevBayesCore;
+
+
+CharacterEventList::CharacterEventList(void)
+{
+
+}
+
+
+void CharacterEventList::clear(void)
+{
+    events.clear();
+}
+
+
+bool CharacterEventList::empty(void) const
+{
+    return events.empty();
+}
+
+
+size_t CharacterEventList::erase(CharacterEvent* e)
+{
+
+    iterator it = find(e);
+    if ( it == events.end() )
+    {
+        return 0;
+    }
+
+    events.erase(it);
+
+    return 1;
+}
+
+
+CharacterEventList::iterator CharacterEventList::erase(iterator it)
+{
+    return events.erase(it);
+}
+
+
+CharacterEventList::iterator CharacterEventList::erase(iterator first, iterator last)
+{
+    return events.erase(first, last);
+}
+
+
+CharacterEventList::iterator CharacterEventList::find(CharacterEvent* e)
+{
+
+    // first look among the events of the same age
+    std::pair<iterator, iterator> range = std::equal_range(events.begin(), events.end(), e, CharacterEventCompare());
+    iterator it = std::find(range.first, range.second, e);
+    if ( it != range.second )
+    {
+        return it;
+    }
+
+    // the age of the event might have been changed after it was inserted
+    return std::find(events.begin(), events.end(), e);
+}
+
+
+CharacterEventList::iterator CharacterEventList::insert(CharacterEvent* e)
+{
+
+    iterator pos = std::upper_bound(events.begin(), events.end(), e, CharacterEventCompare());
+
+    return events.insert(pos, e);
+}
+
+
+void CharacterEventList::reserve(size_t n)
+{
+    events.reserve(n);
+}
+
+
+size_t CharacterEventList::size(void) const
+{
+    return events.size();
+}
+
+
+void CharacterEventList::swap(CharacterEventList &l)
+{
+    events.swap(l.events);
+}
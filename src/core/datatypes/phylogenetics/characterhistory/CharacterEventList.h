@@ -0,0 +1,80 @@
+#ifndef CharacterEventList_H
+#define CharacterEventList_H
+
+#include <stddef.h>
+#include <algorithm>
+#include <vector>
+
+#include "CharacterEventCompare.h"
+
+namespace RevBayesCore {
+class CharacterEvent;
+
+    /**
+     * @brief Flat list of the character events on a branch, sorted by age.
+     *
+     * The events of a branch history are kept as one contiguous array of event pointers
+     * sorted by age (youngest first) instead of a std::multiset, which needed one tree node
+     * allocation per event and scattered the events over the heap. The list offers the part
+     * of the multiset interface used by the histories, moves and monitors, so that the likelihood
+     * can walk a branch linearly and storing a history before a proposal is a single copy of the pointers.
+     * Events with the same age keep their insertion order, as in the multiset.
+     */
+    class CharacterEventList {
+
+    public:
+        typedef std::vector<CharacterEvent*>::iterator                  iterator;
+        typedef std::vector<CharacterEvent*>::const_iterator            const_iterator;
+        typedef std::vector<CharacterEvent*>::reverse_iterator          reverse_iterator;
+        typedef std::vector<CharacterEvent*>::const_reverse_iterator    const_reverse_iterator;
+
+        CharacterEventList(void);
+
+        iterator                                                        begin(void)                 { return events.begin(); }
+        const_iterator                                                  begin(void) const           { return events.begin(); }
+        iterator                                                        end(void)                   { return events.end(); }
+        const_iterator                                                  end(void) const             { return events.end(); }
+        reverse_iterator                                                rbegin(void)                { return events.rbegin(); }
+        const_reverse_iterator                                          rbegin(void) const          { return events.rbegin(); }
+        reverse_iterator                                                rend(void)                  { return events.rend(); }
+        const_reverse_iterator                                          rend(void) const            { return events.rend(); }
+
+        void                                                            clear(void);
+        bool                                                            empty(void) const;
+        size_t                                                          erase(CharacterEvent* e);                       //!< Remove this event (not all events of the same age), returns the number of removed events
+        iterator                                                        erase(iterator it);
+        iterator                                                        erase(iterator first, iterator last);
+        iterator                                                        find(CharacterEvent* e);
+        iterator                                                        insert(CharacterEvent* e);                      //!< Insert after all events of the same age
+        template <class InputIterator>
+        void                                                            insert(InputIterator first, InputIterator last);
+        void                                                            reserve(size_t n);
+        size_t                                                          size(void) const;
+        void                                                            swap(CharacterEventList &l);
+
+    private:
+
+        std::vector<CharacterEvent*>                                    events;
+
+    };
+
+}
+
+
+/**
+ * Insert a range of events. We append them all and merge the sorted tail into the list,
+ * which is cheaper than inserting them one by one into the middle of the array.
+ */
+template <class InputIterator>
+void RevBayesCore::CharacterEventList::insert(InputIterator first, InputIterator last)
+{
+
+    size_t old_size = events.size();
+    events.insert(events.end(), first, last);
+
+    std::stable_sort(events.begin() + old_size, events.end(), CharacterEventCompare());
+    std::inplace_merge(events.begin(), events.begin() + old_size, events.end(), CharacterEventCompare());
+
+}
+
+#endif
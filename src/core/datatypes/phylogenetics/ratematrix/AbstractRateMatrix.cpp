@@ -4,6 +4,7 @@
 #include <fstream>
 #include <algorithm>
 #include <cstddef>
+#include <vector>
 
 #include "MatrixReal.h"
 #include "RandomNumberGenerator.h"
@@ -23,7 +24,9 @@ using namespace RevBayesCore;
 /** Construct rate matrix with n states */
 AbstractRateMatrix::AbstractRateMatrix(size_t n) : RateMatrix(n),
     the_rate_matrix( new MatrixReal(num_states, num_states, 1.0) ),
-    needs_update( true )
+    needs_update( true ),
+    num_non_zero_rates( num_states * num_states ),
+    sparse( false )
 {
 
     // I cannot call a pure virtual function from the constructor (Sebastian)
@@ -35,7 +38,9 @@ AbstractRateMatrix::AbstractRateMatrix(size_t n) : RateMatrix(n),
 /** Copy constructor */
 AbstractRateMatrix::AbstractRateMatrix(const AbstractRateMatrix& m) : RateMatrix(m),
     the_rate_matrix( new MatrixReal(*m.the_rate_matrix) ),
-    needs_update( true )
+    needs_update( true ),
+    num_non_zero_rates( m.num_non_zero_rates ),
+    sparse( m.sparse )
 {
 
 }
@@ -61,6 +66,8 @@ AbstractRateMatrix& AbstractRateMatrix::operator=(const AbstractRateMatrix &r)
 
         the_rate_matrix       = new MatrixReal( *r.the_rate_matrix );
         needs_update         = true;
+        num_non_zero_rates   = r.num_non_zero_rates;
+        sparse               = r.sparse;
 
     }
 
@@ -496,9 +503,12 @@ bool AbstractRateMatrix::simulateStochasticMapping(double startAge, double endAg
     }
 
     // sample event times
-    for (size_t i = 0; i < num_events; i++)
+    size_t first_event = transition_times.size();
+    transition_times.resize( first_event + num_events );
+    GLOBAL_RNG->uniform01( transition_times.data() + first_event, num_events );
+    for (size_t i = first_event; i < transition_times.size(); i++)
     {
-        transition_times.push_back(GLOBAL_RNG->uniform01() * branch_length);
+        transition_times[i] *= branch_length;
     }
     transition_times.push_back(0.0);
     std::sort( transition_times.begin(), transition_times.end() );
@@ -651,6 +661,199 @@ void AbstractRateMatrix::exponentiateMatrixByScalingAndSquaring(double t,  Trans
     }
 }
 
+/**
+ * Compute P = exp(Q t) using only the non-zero rates of Q.
+ *
+ * Large rate matrices (e.g., DEC with many areas, chromosome counts or PoMo) have only a few non-zero rates per row,
+ * but scaling and squaring multiplies dense matrices, which costs O(N^3) per squaring.
+ * Here we store Q in compressed sparse row (CSR) format and accumulate the truncated Taylor series of exp(A)
+ * for A = (Q - mu I) t / s directly on the rows of P, so each term costs O(N * nnz(Q)) instead of O(N^3).
+ * Following Al-Mohy and Higham (2011), we shift Q by the mean diagonal mu to reduce its norm,
+ * and choose the truncation order m and the number of steps s = ceil(||A||_1 / theta_m) that minimize m * s.
+ * Each Taylor series stops early once two consecutive terms are negligible.
+ *
+ * The number of steps still grows linearly with ||Q t||_1, whereas scaling and squaring only needs log2(||Q t||_1) squarings.
+ * Thus, we fall back to scaling and squaring for long branches where the dense products are cheaper.
+ *
+ * Al-Mohy, A. H., & Higham, N. J. 2011. Computing the action of the matrix exponential,
+ * with an application to exponential integrators. SIAM Journal on Scientific Computing, 33(2), 488-511.
+ */
+void AbstractRateMatrix::exponentiateSparseMatrix(double t, TransitionProbabilityMatrix& p) const
+{
+    assert(t >= 0);
+
+    const MatrixReal& q = *the_rate_matrix;
+
+    // shift the diagonal by its mean; we multiply by exp(mu t) again at the end of each step
+    double mu = 0.0;
+    for ( size_t i = 0; i < num_states; i++ )
+    {
+        mu += q[i][i];
+    }
+    mu /= num_states;
+
+    // store the shifted matrix in CSR format
+    std::vector<size_t> row_offsets( num_states + 1, 0 );
+    std::vector<size_t> columns;
+    std::vector<double> values;
+    std::vector<double> column_sums( num_states, 0.0 );
+    std::vector<double> unshifted_column_sums( num_states, 0.0 );
+    columns.reserve( num_non_zero_rates );
+    values.reserve( num_non_zero_rates );
+    for ( size_t i = 0; i < num_states; i++ )
+    {
+        for ( size_t j = 0; j < num_states; j++ )
+        {
+            double a = ( i == j ? q[i][j] - mu : q[i][j] ) * t;
+            if ( a != 0.0 )
+            {
+                columns.push_back( j );
+                values.push_back( a );
+                column_sums[j] += std::fabs( a );
+            }
+            unshifted_column_sums[j] += std::fabs( q[i][j] * t );
+        }
+        row_offsets[i+1] = columns.size();
+    }
+
+    // choose the truncation order and the number of steps (Al-Mohy and Higham 2011, Table 3.1, for double precision)
+    static const size_t num_orders = 11;
+    static const size_t orders[num_orders] = { 5, 10, 15, 20, 25, 30, 35, 40, 45, 50, 55 };
+    static const double thetas[num_orders] = { 2.40e-3, 1.44e-1, 6.45e-1, 1.44, 2.35, 3.36, 4.46, 5.62, 6.83, 8.07, 9.33 };
+
+    double norm = *std::max_element( column_sums.begin(), column_sums.end() );
+    size_t max_num_terms = orders[num_orders-1];
+    size_t num_steps = std::max( size_t(1), size_t( std::ceil( norm / thetas[num_orders-1] ) ) );
+    for ( size_t k = 0; k < num_orders; k++ )
+    {
+        size_t s = std::max( size_t(1), size_t( std::ceil( norm / thetas[k] ) ) );
+        if ( orders[k] * s < max_num_terms * num_steps )
+        {
+            max_num_terms = orders[k];
+            num_steps     = s;
+        }
+    }
+
+    // compare the cost with scaling and squaring, which needs about 10 + log2(||Q t||_1) dense products
+    double unshifted_norm = *std::max_element( unshifted_column_sums.begin(), unshifted_column_sums.end() );
+    int num_squarings = 0;
+    std::frexp( unshifted_norm, &num_squarings );
+    num_squarings = std::max( 10 + num_squarings, 0 );
+    double sparse_cost = double(num_steps) * double(max_num_terms) * double(values.size());
+    double dense_cost  = double(num_squarings + 3) * double(num_states) * double(num_states);
+    if ( sparse_cost > dense_cost )
+    {
+        exponentiateMatrixByScalingAndSquaring(t, p);
+        return;
+    }
+
+    for ( size_t k = 0; k < values.size(); k++ )
+    {
+        values[k] /= num_steps;
+    }
+    double step_shift = std::exp( mu * t / num_steps );
+
+    // we propagate the rows of P, starting with the identity matrix
+    std::vector<double> result( num_states * num_states, 0.0 );
+    for ( size_t i = 0; i < num_states; i++ )
+    {
+        result[i * num_states + i] = 1.0;
+    }
+    std::vector<double> term( num_states * num_states );
+    std::vector<double> next( num_states * num_states );
+
+    const double tolerance = std::pow( 2.0, -53 );
+    for ( size_t step = 0; step < num_steps; step++ )
+    {
+        term = result;
+
+        double result_norm = 0.0;
+        for ( size_t i = 0; i < num_states; i++ )
+        {
+            double row_norm = 0.0;
+            for ( size_t j = 0; j < num_states; j++ )
+            {
+                row_norm += std::fabs( result[i * num_states + j] );
+            }
+            result_norm = std::max( result_norm, row_norm );
+        }
+
+        double previous_term_norm = RbConstants::Double::inf;
+        for ( size_t k = 1; k <= max_num_terms; k++ )
+        {
+            // next = term * A / k, visiting only the non-zero entries of term and A
+            std::fill( next.begin(), next.end(), 0.0 );
+            for ( size_t i = 0; i < num_states; i++ )
+            {
+                const double* term_row = &term[i * num_states];
+                double*       next_row = &next[i * num_states];
+                for ( size_t j = 0; j < num_states; j++ )
+                {
+                    double x = term_row[j];
+                    if ( x != 0.0 )
+                    {
+                        x /= k;
+                        for ( size_t e = row_offsets[j]; e < row_offsets[j+1]; e++ )
+                        {
+                            next_row[ columns[e] ] += x * values[e];
+                        }
+                    }
+                }
+            }
+            term.swap( next );
+
+            double term_norm = 0.0;
+            for ( size_t i = 0; i < num_states; i++ )
+            {
+                double row_norm = 0.0;
+                for ( size_t j = 0; j < num_states; j++ )
+                {
+                    double x = term[i * num_states + j];
+                    result[i * num_states + j] += x;
+                    row_norm += std::fabs( x );
+                }
+                term_norm = std::max( term_norm, row_norm );
+            }
+
+            if ( term_norm + previous_term_norm <= tolerance * result_norm )
+            {
+                break;
+            }
+            previous_term_norm = term_norm;
+        }
+
+        for ( size_t i = 0; i < result.size(); i++ )
+        {
+            result[i] *= step_shift;
+        }
+    }
+
+    for ( size_t i = 0; i < num_states; i++ )
+    {
+        for ( size_t j = 0; j < num_states; j++ )
+        {
+            p[i][j] = result[i * num_states + j];
+        }
+    }
+
+    // handle roundoff-error as for scaling and squaring
+    ensure_nonnegative(p);
+    normalize_rows(p);
+}
+
+
+/**
+ * Is it worth computing the transition probabilities with the sparse representation of the rate matrix?
+ * This is the case for larger matrices where at most one in eight rates is non-zero.
+ * The answer is computed by updateSparsity() when the rate matrix is updated.
+ */
+bool AbstractRateMatrix::isSparse( void ) const
+{
+
+    return sparse;
+}
+
+
 /** Set the diagonal of the rate matrix such that each row sums to zero */
 void AbstractRateMatrix::setDiagonal(void)
 {
@@ -674,6 +877,30 @@ void AbstractRateMatrix::setDiagonal(void)
     needs_update = true;
 }
 
+
+/**
+ * Count the non-zero rates and decide whether the rate matrix is sparse.
+ * Derived classes that use isSparse() call this whenever they have rebuilt their rates,
+ * so that we do not scan all N^2 rates for every branch.
+ */
+void AbstractRateMatrix::updateSparsity( void )
+{
+
+    num_non_zero_rates = 0;
+    for ( size_t i = 0; i < num_states; i++ )
+    {
+        for ( size_t j = 0; j < num_states; j++ )
+        {
+            if ( (*the_rate_matrix)[i][j] != 0.0 )
+            {
+                num_non_zero_rates++;
+            }
+        }
+    }
+
+    sparse = ( num_states >= 32 && 8 * num_non_zero_rates <= num_states * num_states );
+}
+
 std::vector<int> AbstractRateMatrix::get_emitted_letters() const
 {
     std::vector<int> emit(num_states);
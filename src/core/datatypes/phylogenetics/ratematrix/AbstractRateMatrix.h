@@ -73,10 +73,15 @@ namespace RevBayesCore {
         virtual void                        computeStochasticMatrix(size_t n);
         virtual void                        computeDominatingRate(void);
         void                                exponentiateMatrixByScalingAndSquaring(double t,  TransitionProbabilityMatrix& p) const;
+        void                                exponentiateSparseMatrix(double t,  TransitionProbabilityMatrix& p) const;                  //!< Compute exp(Q t) from the non-zero rates only
+        bool                                isSparse(void) const;                                                                       //!< Are few enough rates non-zero to use exponentiateSparseMatrix?
+        void                                updateSparsity(void);                                                                       //!< Count the non-zero rates (call after rebuilding the rates)
         
         // protected members available for derived classes
         MatrixReal*                         the_rate_matrix;                                                                            //!< Holds the rate matrix
         bool                                needs_update;
+        size_t                              num_non_zero_rates;                                                                         //!< The number of non-zero rates when updateSparsity() was last called
+        bool                                sparse;                                                                                     //!< Are few enough rates non-zero to use exponentiateSparseMatrix?
         
         // stochastic matrix
         double                              dominating_rate;
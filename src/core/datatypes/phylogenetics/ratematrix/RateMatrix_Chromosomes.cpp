@@ -97,7 +97,15 @@ void RateMatrix_Chromosomes::calculateTransitionProbabilities(double startAge, d
     // We use repeated squaring to quickly obtain exponentials, as in Poujol and Lartillot, Bioinformatics 2014.
 	// Mayrose et al. 2010 also used this method for chromosome evolution (named the squaring and scaling method in Moler and Van Loan 2003).
     double t = rate * (startAge - endAge);
-    exponentiateMatrixByScalingAndSquaring(t, P);
+    if ( isSparse() == true )
+    {
+        // only gains, losses, polyploidization and demi-polyploidization have non-zero rates
+        exponentiateSparseMatrix(t, P);
+    }
+    else
+    {
+        exponentiateMatrixByScalingAndSquaring(t, P);
+    }
     
 }
 
@@ -175,6 +183,7 @@ void RateMatrix_Chromosomes::update( void ) {
     if ( needs_update )
     {
         buildRateMatrix();
+        updateSparsity();
         // clean flags
         needs_update = false;
     }
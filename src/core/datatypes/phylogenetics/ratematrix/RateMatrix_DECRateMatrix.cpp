@@ -10,9 +10,9 @@
 
 #include <stddef.h>
 #include <cmath>
-#include <list>
 #include <complex>
 #include <map>
+#include <mutex>
 #include <ostream>
 #include <utility>
 #include <vector>
@@ -47,8 +47,7 @@ RateMatrix_DECRateMatrix::RateMatrix_DECRateMatrix(size_t ns, size_t nc, bool cs
     rescaleMatrix(false),
     maxRangeSize(mrs),
     stationaryMatrix( TransitionProbabilityMatrix(num_states) ),
-    accessedTransitionProbabilities( std::list<double>() ),
-    maxSizeStoredTransitionProbabilites(1e3),
+    storedTransitionProbabilities( 1000 ),
     useStoredTransitionProbabilities(true)
 {
 
@@ -103,8 +102,6 @@ RateMatrix_DECRateMatrix::RateMatrix_DECRateMatrix(const RateMatrix_DECRateMatri
     rescaleMatrix        = m.rescaleMatrix;
     scalingFactor        = m.scalingFactor;
     storedTransitionProbabilities = m.storedTransitionProbabilities;
-    accessedTransitionProbabilities = m.accessedTransitionProbabilities;
-    maxSizeStoredTransitionProbabilites = m.maxSizeStoredTransitionProbabilites;
     useStoredTransitionProbabilities = m.useStoredTransitionProbabilities;
     changedAreas = m.changedAreas;
     affectingAreas = m.affectingAreas;
@@ -156,8 +153,6 @@ RateMatrix_DECRateMatrix& RateMatrix_DECRateMatrix::operator=(const RateMatrix_D
         rescaleMatrix        = r.rescaleMatrix;
         scalingFactor        = r.scalingFactor;
         storedTransitionProbabilities = r.storedTransitionProbabilities;
-        accessedTransitionProbabilities = r.accessedTransitionProbabilities;
-        maxSizeStoredTransitionProbabilites = r.maxSizeStoredTransitionProbabilites;
         useStoredTransitionProbabilities = r.useStoredTransitionProbabilities;
         changedAreas = r.changedAreas;
         affectingAreas = r.affectingAreas;
@@ -347,20 +342,23 @@ void RateMatrix_DECRateMatrix::calculateTransitionProbabilities(double startAge,
     
     
     // Do we already have P(t)?
-    std::map<double, TransitionProbabilityMatrix>::const_iterator it = storedTransitionProbabilities.find(t);
-    bool found = it != storedTransitionProbabilities.end();
-    if (found) {
-        
-        // update the transition probs
-        P = it->second;
-        
-        // this time was most recently accessed
-        accessedTransitionProbabilities.remove(it->first);
-        accessedTransitionProbabilities.push_front(it->first);
+    // The stored matrices are cleared whenever the rate matrix is updated, so we only need a single version.
+    // Several nodes sharing this rate matrix may be computed concurrently, so we lock the cache while we use it.
+    bool found = false;
+    if (useStoredTransitionProbabilities)
+    {
+        std::lock_guard<std::mutex> lock( storedTransitionProbabilitiesMutex );
+        found = storedTransitionProbabilities.find(0, 0, t, P);
     }
-    else {
+    if (found == false)
+    {
         
-        if ( useSquaring || true )
+        if ( isSparse() == true )
+        {
+            // with many areas most ranges differ by more than one area, so most rates are zero
+            exponentiateSparseMatrix(t, P);
+        }
+        else if ( useSquaring || true )
         {
             //We use repeated squaring to quickly obtain exponentials, as in Poujol and Lartillot, Bioinformatics 2014.
             exponentiateMatrixByScalingAndSquaring(t, P);
@@ -396,15 +394,10 @@ void RateMatrix_DECRateMatrix::calculateTransitionProbabilities(double startAge,
             P[0][0] = 1.0;
         }
 
-        if (useStoredTransitionProbabilities) {
-            storedTransitionProbabilities.insert( std::pair<double, TransitionProbabilityMatrix>(t, P) );
-            accessedTransitionProbabilities.push_front(t);
-        }
-        if (accessedTransitionProbabilities.size() > maxSizeStoredTransitionProbabilites)
+        if (useStoredTransitionProbabilities)
         {
-            double rem_time = accessedTransitionProbabilities.back();
-            storedTransitionProbabilities.erase(rem_time);
-            accessedTransitionProbabilities.pop_back();
+            std::lock_guard<std::mutex> lock( storedTransitionProbabilitiesMutex );
+            storedTransitionProbabilities.insert(0, 0, t, P);
         }
 //        std::cout << storedTransitionProbabilities.size() << "\n";
     }
@@ -425,8 +418,15 @@ void RateMatrix_DECRateMatrix::calculateTransitionProbabilitiesForStochasticMapp
 {
     double t = scalingFactor * rate * (startAge - endAge);
     
-    //We use repeated squaring to quickly obtain exponentials, as in Poujol and Lartillot, Bioinformatics 2014.
-    exponentiateMatrixByScalingAndSquaring(t, P);
+    if ( isSparse() == true )
+    {
+        exponentiateSparseMatrix(t, P);
+    }
+    else
+    {
+        //We use repeated squaring to quickly obtain exponentials, as in Poujol and Lartillot, Bioinformatics 2014.
+        exponentiateMatrixByScalingAndSquaring(t, P);
+    }
     
 }
 
@@ -738,6 +738,7 @@ void RateMatrix_DECRateMatrix::update( void ) {
     {
         // assign all rate matrix elements
         fillRateMatrix();
+        updateSparsity();
         
         // rescale
         scalingFactor = 1.0;
@@ -751,7 +752,6 @@ void RateMatrix_DECRateMatrix::update( void ) {
         // clear the stored transition probabilities
 //        std::cout << "Clearing " << storedTransitionProbabilities.size() << "\n";
         storedTransitionProbabilities.clear();
-        accessedTransitionProbabilities = std::list<double>();
         
         // clean flags
         needs_update = false;
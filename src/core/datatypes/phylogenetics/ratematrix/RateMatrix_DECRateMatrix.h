@@ -3,10 +3,11 @@
 
 #include "GeneralRateMatrix.h"
 #include "TransitionProbabilityMatrix.h"
+#include "TransitionProbabilityMatrixCache.h"
 #include <complex>
 #include <vector>
 #include <map>
-#include <list>
+#include <mutex>
 
 
 namespace RevBayesCore {
@@ -90,9 +91,8 @@ namespace RevBayesCore {
         size_t                                              maxRangeSize;
         TransitionProbabilityMatrix                         stationaryMatrix;
         
-        mutable std::map<double,TransitionProbabilityMatrix>  storedTransitionProbabilities;
-        mutable std::list<double>                             accessedTransitionProbabilities;
-        unsigned                                              maxSizeStoredTransitionProbabilites;
+        mutable TransitionProbabilityMatrixCache              storedTransitionProbabilities;
+        mutable std::mutex                                    storedTransitionProbabilitiesMutex;     //!< Guards the stored matrices, which are filled in the const calculateTransitionProbabilities
         bool                                                  useStoredTransitionProbabilities;
     };
     
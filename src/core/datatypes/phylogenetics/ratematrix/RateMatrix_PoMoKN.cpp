@@ -266,7 +266,15 @@ void RateMatrix_PoMoKN::calculateTransitionProbabilities(double startAge, double
   // We use repeated squaring to quickly obtain exponentials, as in Poujol and Lartillot, Bioinformatics 2014.
   // Mayrose et al. 2010 also used this method for chromosome evolution (named the squaring and scaling method in Moler and Van Loan 2003).
   double t = rate * (startAge - endAge);
-  exponentiateMatrixByScalingAndSquaring(t, P );
+  if ( isSparse() == true )
+  {
+    // only mutations and drift by one individual have non-zero rates
+    exponentiateSparseMatrix(t, P );
+  }
+  else
+  {
+    exponentiateMatrixByScalingAndSquaring(t, P );
+  }
 
   return;
 }
@@ -329,6 +337,7 @@ void RateMatrix_PoMoKN::update( void )
     {
 
         buildRateMatrix();
+        updateSparsity();
 
         // rescale: not useful, same loglk.
         //rescaleToAverageRate( 1.0 );
@@ -130,6 +130,16 @@ void Distribution::getAffected(RbOrderedSet<DagNode *> &affected, const DagNode*
 }
 
 
+/**
+ * Get an estimate of the cost of computing the probability of this distribution, e.g., the size of its partial likelihoods.
+ * The likelihood scheduler starts the most expensive computations first. Cheap distributions do not need to override this.
+ */
+double Distribution::getComputationCost(void) const
+{
+    return 0.0;
+}
+
+
 
 std::vector<double> Distribution::getMixtureProbabilities(void) const
 {
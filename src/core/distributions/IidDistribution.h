@@ -1,6 +1,9 @@
 #ifndef IidDistribution_H
 #define IidDistribution_H
 
+#include <set>
+#include <vector>
+
 #include "RbVector.h"
 #include "TypedDagNode.h"
 #include "TypedDistribution.h"
@@ -17,6 +20,11 @@ namespace RevBayesCore {
      * The values are already of the correct mixture type. You may want to apply a mixture allocation move
      * to change between the current value. The values themselves change automatically when the input parameters change.
      *
+     * We cache the ln probability of each element. If a move changed only some elements and marked them
+     * as touched in the DAG node, only these elements are recomputed, and the old values are restored if the move is rejected.
+     * For continuous priors (e.g., normal, lognormal, gamma or exponential), we assign the element to the value of the prior
+     * instead of handing a new clone to the prior for every element.
+     *
      * @copyright Copyright 2009-
      * @author The RevBayes Development Core Team (Sebastian Hoehna)
      * @since 2014-11-18, version 1.0
@@ -28,25 +36,41 @@ namespace RevBayesCore {
         // constructor(s)
         IidDistribution(long n, TypedDistribution<valueType> *vp);
         IidDistribution(const IidDistribution<valueType> &d);
+        virtual                                            ~IidDistribution(void);
+
+        IidDistribution&                                    operator=(const IidDistribution<valueType> &d);
 
         // public member functions
         IidDistribution*                                    clone(void) const;                                                                                  //!< Create an independent clone
         double                                              computeLnProbability(void);
         void                                                redrawValue(void);
+        void                                                setValue(RbVector<valueType> *v, bool f=false);                                         //!< Set the current value, e.g. attach an observation (clamp)
         
     protected:
         // Parameter management functions
+        void                                                keepSpecialization(const DagNode* affecter);
+        void                                                restoreSpecialization(const DagNode *restorer);
         void                                                swapParameterInternal(const DagNode *oldP, const DagNode *newP);                        //!< Swap a parameter
+        void                                                touchSpecialization(const DagNode *toucher, bool touchAll);
         
         
     private:
         
         // helper methods
+        double                                              computeElementLnProbability(size_t i);
         void                                                simulate();
         
         // private members
         long                                                n_samples;
         TypedDistribution<valueType>*                       value_prior;
+        bool                                                assign_in_place;                                                                    //!< Can we assign the elements to the value of the prior?
+        
+        std::vector<double>                                 ln_probs;                                                                           //!< The ln probability of each element
+        std::vector<double>                                 stored_ln_probs;                                                                    //!< The ln probabilities before all of them were recomputed
+        std::vector< std::pair<size_t, double> >            changed_ln_probs;                                                                   //!< The old ln probabilities of the elements recomputed since the last keep
+        bool                                                stored_all;                                                                         //!< Did we recompute all elements since the last keep?
+        bool                                                all_dirty;
+        std::set<size_t>                                    dirty_elements;
         
     };
     
@@ -54,15 +78,20 @@ namespace RevBayesCore {
 
 #include "Assign.h"
 #include "Assignable.h"
+#include "ContinuousDistribution.h"
 #include "RandomNumberFactory.h"
 #include "RandomNumberGenerator.h"
+#include "StochasticNode.h"
 
 #include <cmath>
 
 template <class valueType>
 RevBayesCore::IidDistribution<valueType>::IidDistribution(long n, TypedDistribution<valueType> *vp) : TypedDistribution< RbVector<valueType> >( new RbVector<valueType>() ),
     n_samples( n ),
-    value_prior( vp )
+    value_prior( vp ),
+    assign_in_place( dynamic_cast<ContinuousDistribution*>( vp ) != NULL ),
+    stored_all( false ),
+    all_dirty( true )
 {
     // add the parameters to our set (in the base class)
     // in that way other class can easily access the set of our parameters
@@ -82,7 +111,14 @@ RevBayesCore::IidDistribution<valueType>::IidDistribution(long n, TypedDistribut
 template <class valueType>
 RevBayesCore::IidDistribution<valueType>::IidDistribution( const IidDistribution<valueType> &d ) : TypedDistribution< RbVector<valueType> >(d),
     n_samples( d.n_samples ),
-    value_prior( d.value_prior->clone() )
+    value_prior( d.value_prior->clone() ),
+    assign_in_place( d.assign_in_place ),
+    ln_probs( d.ln_probs ),
+    stored_ln_probs( d.stored_ln_probs ),
+    changed_ln_probs( d.changed_ln_probs ),
+    stored_all( d.stored_all ),
+    all_dirty( d.all_dirty ),
+    dirty_elements( d.dirty_elements )
 {
     
     // add the parameters of the distribution
@@ -96,6 +132,40 @@ RevBayesCore::IidDistribution<valueType>::IidDistribution( const IidDistribution
 }
 
 
+template <class valueType>
+RevBayesCore::IidDistribution<valueType>::~IidDistribution( void )
+{
+    
+    delete value_prior;
+    
+}
+
+
+template <class valueType>
+RevBayesCore::IidDistribution<valueType>& RevBayesCore::IidDistribution<valueType>::operator=( const IidDistribution<valueType> &d )
+{
+    
+    if ( this != &d )
+    {
+        TypedDistribution< RbVector<valueType> >::operator=( d );
+        
+        delete value_prior;
+        
+        n_samples           = d.n_samples;
+        value_prior         = d.value_prior->clone();
+        assign_in_place     = d.assign_in_place;
+        ln_probs            = d.ln_probs;
+        stored_ln_probs     = d.stored_ln_probs;
+        changed_ln_probs    = d.changed_ln_probs;
+        stored_all          = d.stored_all;
+        all_dirty           = d.all_dirty;
+        dirty_elements      = d.dirty_elements;
+    }
+    
+    return *this;
+}
+
+
 
 template <class valueType>
 RevBayesCore::IidDistribution<valueType>* RevBayesCore::IidDistribution<valueType>::clone( void ) const
@@ -106,25 +176,125 @@ RevBayesCore::IidDistribution<valueType>* RevBayesCore::IidDistribution<valueTyp
 
 
 
+/**
+ * Compute the ln probability of all elements.
+ * We only recompute the elements that have been touched since the last computation and store their old ln probabilities,
+ * so that a rejected move can restore them.
+ */
 template <class valueType>
 double RevBayesCore::IidDistribution<valueType>::computeLnProbability( void )
 {
     
-    double ln_prob = 0.0;
+    size_t num_elements = this->value->size();
+    if ( ln_probs.size() != num_elements )
+    {
+        // we have no valid ln probabilities that could be restored, so a restore will recompute all elements
+        ln_probs.assign( num_elements, 0.0 );
+        stored_ln_probs.clear();
+        changed_ln_probs.clear();
+        stored_all = true;
+        all_dirty = true;
+    }
     
-    for (int i = 0; i < n_samples; ++i)
+    if ( all_dirty == true )
     {
+        // we only need to store the ln probabilities the first time since the last keep
+        if ( stored_all == false )
+        {
+            // the elements recomputed before are overwritten now, so we roll them back before we store all values
+            for (std::vector< std::pair<size_t, double> >::reverse_iterator it = changed_ln_probs.rbegin(); it != changed_ln_probs.rend(); ++it)
+            {
+                std::swap( ln_probs[it->first], it->second );
+            }
+            stored_ln_probs = ln_probs;
+            changed_ln_probs.clear();
+            stored_all = true;
+        }
         
-        // we also need to multiply with the probability of the value for this table
-        value_prior->setValue( Cloner<valueType, IsDerivedFrom<valueType, Cloneable>::Is >::createClone( this->value->operator[](i) ) );
-        ln_prob += value_prior->computeLnProbability();
-        
+        for (size_t i = 0; i < num_elements; ++i)
+        {
+            ln_probs[i] = computeElementLnProbability( i );
+        }
+    }
+    else
+    {
+        for (std::set<size_t>::const_iterator it = dirty_elements.begin(); it != dirty_elements.end(); ++it)
+        {
+            if ( stored_all == false )
+            {
+                changed_ln_probs.push_back( std::make_pair( *it, ln_probs[*it] ) );
+            }
+            ln_probs[*it] = computeElementLnProbability( *it );
+        }
+    }
+    
+    all_dirty = false;
+    dirty_elements.clear();
+    
+    double ln_prob = 0.0;
+    for (size_t i = 0; i < num_elements; ++i)
+    {
+        ln_prob += ln_probs[i];
     }
     
     return ln_prob;
 }
 
 
+template <class valueType>
+double RevBayesCore::IidDistribution<valueType>::computeElementLnProbability( size_t i )
+{
+    
+    if ( assign_in_place == true )
+    {
+        value_prior->getValue() = this->value->operator[](i);
+    }
+    else
+    {
+        value_prior->setValue( Cloner<valueType, IsDerivedFrom<valueType, Cloneable>::Is >::createClone( this->value->operator[](i) ) );
+    }
+    
+    return value_prior->computeLnProbability();
+}
+
+
+template <class valueType>
+void RevBayesCore::IidDistribution<valueType>::keepSpecialization( const DagNode* affecter )
+{
+    
+    stored_ln_probs.clear();
+    changed_ln_probs.clear();
+    stored_all = false;
+    
+}
+
+
+template <class valueType>
+void RevBayesCore::IidDistribution<valueType>::restoreSpecialization( const DagNode *restorer )
+{
+    
+    if ( stored_all == true )
+    {
+        ln_probs.swap( stored_ln_probs );
+    }
+    else
+    {
+        // undo the changes in reverse order, so that each element gets the value it had at the last keep
+        for (std::vector< std::pair<size_t, double> >::reverse_iterator it = changed_ln_probs.rbegin(); it != changed_ln_probs.rend(); ++it)
+        {
+            ln_probs[it->first] = it->second;
+        }
+    }
+    
+    stored_ln_probs.clear();
+    changed_ln_probs.clear();
+    stored_all = false;
+    dirty_elements.clear();
+    all_dirty = ( ln_probs.size() != this->value->size() );
+    
+}
+
+
 template <class valueType>
 void RevBayesCore::IidDistribution<valueType>::simulate()
 {
@@ -149,6 +319,19 @@ void RevBayesCore::IidDistribution<valueType>::redrawValue( void )
     
     simulate();
     
+    all_dirty = true;
+    
+}
+
+
+template <class valueType>
+void RevBayesCore::IidDistribution<valueType>::setValue( RbVector<valueType> *v, bool force )
+{
+    
+    TypedDistribution< RbVector<valueType> >::setValue( v, force );
+    
+    all_dirty = true;
+    
 }
 
 
@@ -161,5 +344,35 @@ void RevBayesCore::IidDistribution<valueType>::swapParameterInternal( const DagN
     
 }
 
+
+/**
+ * Mark the elements for recomputation. If our own value has been touched and the move told us which elements it changed,
+ * only these elements need to be recomputed. Otherwise, e.g., if a parameter of the prior changed, we recompute all elements.
+ */
+template <class valueType>
+void RevBayesCore::IidDistribution<valueType>::touchSpecialization( const DagNode *toucher, bool touchAll )
+{
+    
+    if ( toucher == this->dag_node && touchAll == false && this->dag_node != NULL )
+    {
+        const std::set<size_t> &indices = this->dag_node->getTouchedElementIndices();
+        
+        // maybe all of them have been touched or the flags haven't been set properly
+        if ( indices.size() == 0 )
+        {
+            all_dirty = true;
+        }
+        else
+        {
+            dirty_elements.insert( indices.begin(), indices.end() );
+        }
+    }
+    else
+    {
+        all_dirty = true;
+    }
+    
+}
+
 #endif
 
@@ -201,7 +201,7 @@ double RevBayesCore::GeneralTreeHistoryCtmc<charType>::computeRootLikelihood(con
     double lnP = 0.0;
     
     BranchHistory* bh = this->histories[n.getIndex()];
-    const std::vector<CharacterEvent*> rootState = bh->getParentCharacters();
+    const std::vector<CharacterEvent*>& rootState = bh->getParentCharacters();
     
     // get counts per state
     std::vector<int> counts(this->num_states, 0);
@@ -235,7 +235,7 @@ double RevBayesCore::GeneralTreeHistoryCtmc<charType>::computeInternalNodeLikeli
     // get the branch history
     BranchHistory* bh = this->histories[node_index];
     std::vector<CharacterEvent*> curr_state = bh->getParentCharacters();
-    std::vector<CharacterEvent*> end_state  = bh->getChildCharacters();
+    const std::vector<CharacterEvent*>& end_state  = bh->getChildCharacters();
 
     // check that node ages are consistent with character event ages
     if ( bh->areEventTimesValid(node) == false )
@@ -251,7 +251,7 @@ double RevBayesCore::GeneralTreeHistoryCtmc<charType>::computeInternalNodeLikeli
             const TopologyNode &child = node.getChild(i);
             size_t child_index = child.getIndex();
             BranchHistory* child_bh = this->histories[child_index];
-            std::vector<CharacterEvent*> child_state = child_bh->getParentCharacters();
+            const std::vector<CharacterEvent*>& child_state = child_bh->getParentCharacters();
             for (size_t j = 0; j < this->num_sites; ++j)
             {
                 if (static_cast<CharacterEventDiscrete*>(end_state[j])->getState() != static_cast<CharacterEventDiscrete*>(child_state[j])->getState() )
@@ -265,9 +265,9 @@ double RevBayesCore::GeneralTreeHistoryCtmc<charType>::computeInternalNodeLikeli
     // we need the counts for faster computation
     std::vector<std::set<size_t> > sites_with_states = computeSitesWithStates(curr_state);
     
-    // get branch history set and iterator
-    const std::multiset<CharacterEvent*,CharacterEventCompare>& history = bh->getHistory();
-    std::multiset<CharacterEvent*,CharacterEventCompare>::reverse_iterator it_h;
+    // get branch history, the events are stored contiguously and sorted by age
+    const CharacterEventList& history = bh->getHistory();
+    CharacterEventList::const_reverse_iterator it_h;
     
     // stepwise events
     double lnL = 0.0;
@@ -225,8 +225,8 @@ double RevBayesCore::GeneralTreeHistoryCtmcSiteIID<charType>::computeInternalNod
     // we need the counts for faster computation
     std::vector<size_t> counts = computeCounts(curr_state);
 
-    const std::multiset<CharacterEvent*,CharacterEventCompare>& history = bh->getHistory();
-    std::multiset<CharacterEvent*,CharacterEventCompare>::reverse_iterator it_h;
+    const CharacterEventList& history = bh->getHistory();
+    CharacterEventList::const_reverse_iterator it_h;
 
     // stepwise events
     double lnL = 0.0;
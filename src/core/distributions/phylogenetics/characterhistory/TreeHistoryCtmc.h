@@ -306,9 +306,9 @@ void RevBayesCore::TreeHistoryCtmc<charType>::executeMethod(const std::string &n
         int index = (int)static_cast<const TypedDagNode<long>* >( args[0] )->getValue() - 1;
 
         //        const BranchHistory& bh = branch_histories[ index ];
-        const std::multiset<CharacterEvent*,CharacterEventCompare> &states = this->histories[index]->getHistory();
+        const CharacterEventList &states = this->histories[index]->getHistory();
 
-        std::multiset<CharacterEvent*,CharacterEventCompare>::const_iterator it;
+        CharacterEventList::const_iterator it;
         for (it = states.begin(); it != states.end(); ++it)
         {
             size_t s = (*it)->getSiteIndex();
@@ -367,8 +367,8 @@ void RevBayesCore::TreeHistoryCtmc<charType>::executeMethod(const std::string &n
 
         size_t current_state = static_cast<CharacterEventDiscrete*>(states[site_index])->getState();
         double previous_age = tau->getValue().getNode(node_index).getParent().getAge();
-        const std::multiset<CharacterEvent*,CharacterEventCompare> &events = this->histories[node_index]->getHistory();
-        std::multiset<CharacterEvent*,CharacterEventCompare>::const_iterator it;
+        const CharacterEventList &events = this->histories[node_index]->getHistory();
+        CharacterEventList::const_iterator it;
         for (it = events.begin(); it != events.end(); ++it)
         {
             CharacterEventDiscrete *event = static_cast<CharacterEventDiscrete*>(*it);
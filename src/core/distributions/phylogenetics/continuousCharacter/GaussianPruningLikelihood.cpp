@@ -0,0 +1,336 @@
+#include "GaussianPruningLikelihood.h"
+
+#include <cmath>
+
+#include "RbConstants.h"
+#include "RbMathLogic.h"
+#include "TopologyNode.h"
+
+using namespace RevBayesCore;
+
+
+GaussianPruningLikelihood::GaussianPruningLikelihood(size_t nn, size_t ns) :
+    num_nodes( 0 ),
+    num_sites( 0 )
+{
+
+    resize( nn, ns );
+
+}
+
+
+/**
+ * Compute the canonical form of the likelihood of the data below this node,
+ * seen as a function of the state at the parent of this node.
+ * The branch leading to the node has the transition X_node | X_parent ~ N( e*X_parent + k, v*site_variance[site] ).
+ * The forms of the children need to be up-to-date already.
+ */
+void GaussianPruningLikelihood::computeBranchForm(const TopologyNode &node, double e, double k, double v, const std::vector<std::vector<double> > &obs, const std::vector<double> &site_variance)
+{
+
+    size_t node_index = node.getIndex();
+
+    std::vector<double> &a_node = precisions[active_form[node_index]][node_index];
+    std::vector<double> &b_node = linear_terms[active_form[node_index]][node_index];
+    std::vector<double> &c_node = ln_scalers[active_form[node_index]][node_index];
+
+    std::vector<double> &x_node = fixed_states[active_form[node_index]][node_index];
+
+    if ( node.isTip() == true )
+    {
+
+        for (size_t site = 0; site < num_sites; ++site)
+        {
+            double y = obs[site][node_index];
+
+            // missing data does not constrain the parent
+            if ( RbMath::isFinite(y) == false )
+            {
+                a_node[site] = 0.0;
+                b_node[site] = 0.0;
+                c_node[site] = 0.0;
+                x_node[site] = RbConstants::Double::nan;
+            }
+            else
+            {
+                c_node[site] = 0.0;
+                computeFixedBranchForm(y, e, k, v * site_variance[site], a_node[site], b_node[site], c_node[site], x_node[site]);
+            }
+        }
+
+    }
+    else
+    {
+
+        sumChildForms(node, a_node, b_node, c_node, x_node);
+
+        // now integrate the state of this node out over the branch
+        for (size_t site = 0; site < num_sites; ++site)
+        {
+            double var = v * site_variance[site];
+
+            // a zero-length branch below fixed the state of this node, so there is nothing to integrate
+            if ( RbMath::isNan( x_node[site] ) == false )
+            {
+                computeFixedBranchForm(x_node[site], e, k, var, a_node[site], b_node[site], c_node[site], x_node[site]);
+                continue;
+            }
+
+            double a = a_node[site];
+            double b = b_node[site];
+            double d = 1.0 + var * a;
+
+            a_node[site] = a * e * e / d;
+            b_node[site] = e * (b - a * k) / d;
+            c_node[site] += - 0.5 * std::log(d) + (- 0.5 * a * k * k + b * k + 0.5 * var * b * b) / d;
+        }
+
+    }
+
+    // mark as computed
+    dirty_nodes[node_index] = false;
+
+}
+
+
+/**
+ * Compute the form of a branch whose lower node has the known state x, e.g., an observed tip.
+ * The constant c already holds the log-likelihood of the data below the node given x.
+ * If the branch has variance zero, then the parent state is fixed to (x-k)/e as well,
+ * which we cannot write as a canonical form. Instead we pass the fixed state on to the parent
+ * and account for the Jacobian of the transformation.
+ */
+void GaussianPruningLikelihood::computeFixedBranchForm(double x, double e, double k, double var, double &a, double &b, double &c, double &fixed_state) const
+{
+
+    double x_shifted = x - k;
+
+    if ( var > 0.0 )
+    {
+        a = e * e / var;
+        b = e * x_shifted / var;
+        c += - RbConstants::LN_SQRT_2PI - 0.5 * std::log(var) - 0.5 * x_shifted * x_shifted / var;
+        fixed_state = RbConstants::Double::nan;
+    }
+    else if ( e != 0.0 )
+    {
+        a = 0.0;
+        b = 0.0;
+        c += - std::log( std::fabs(e) );
+        fixed_state = x_shifted / e;
+    }
+    else
+    {
+        // the state of the node does not depend on the parent and has no variance, so the data are (almost surely) impossible
+        a = 0.0;
+        b = 0.0;
+        c = RbConstants::Double::neginf;
+        fixed_state = RbConstants::Double::nan;
+    }
+
+}
+
+
+/**
+ * The form at the root is just the product of the likelihoods of all subtrees.
+ */
+void GaussianPruningLikelihood::computeRootForm(const TopologyNode &root)
+{
+
+    size_t root_index = root.getIndex();
+
+    sumChildForms(root, precisions[active_form[root_index]][root_index], linear_terms[active_form[root_index]][root_index], ln_scalers[active_form[root_index]][root_index], fixed_states[active_form[root_index]][root_index]);
+
+    // mark as computed
+    dirty_nodes[root_index] = false;
+
+}
+
+
+double GaussianPruningLikelihood::computeRootLnProbability(size_t root_index, const std::vector<double> &root_states) const
+{
+
+    const std::vector<double> &a_root = precisions[active_form[root_index]][root_index];
+    const std::vector<double> &b_root = linear_terms[active_form[root_index]][root_index];
+    const std::vector<double> &c_root = ln_scalers[active_form[root_index]][root_index];
+    const std::vector<double> &x_root = fixed_states[active_form[root_index]][root_index];
+
+    double ln_prob = 0.0;
+    for (size_t site = 0; site < num_sites; ++site)
+    {
+        // a tip on a zero-length branch below the root fixes the root state,
+        // so any other root state has probability zero
+        if ( RbMath::isNan( x_root[site] ) == false )
+        {
+            return RbConstants::Double::neginf;
+        }
+
+        double x = root_states[site];
+        ln_prob += - 0.5 * a_root[site] * x * x + b_root[site] * x + c_root[site];
+    }
+
+    return ln_prob;
+}
+
+
+void GaussianPruningLikelihood::flagAllDirty( void )
+{
+
+    for (size_t index = 0; index < num_nodes; ++index)
+    {
+        dirty_nodes[index] = true;
+
+        // flip the active form only once between keep/restore
+        if ( changed_nodes[index] == false )
+        {
+            active_form[index] = (active_form[index] == 0 ? 1 : 0);
+            changed_nodes[index] = true;
+        }
+    }
+
+}
+
+
+void GaussianPruningLikelihood::flagNodeDirty( const TopologyNode &n )
+{
+
+    // we need to flag this node and all ancestral nodes for recomputation
+    size_t index = n.getIndex();
+
+    // if this node is already dirty, then also all the ancestral nodes must have been flagged as dirty
+    if ( dirty_nodes[index] == false )
+    {
+        // the root doesn't have an ancestor
+        if ( n.isRoot() == false )
+        {
+            flagNodeDirty( n.getParent() );
+        }
+
+        // set the flag
+        dirty_nodes[index] = true;
+
+        // if we previously haven't touched this node, then we need to change the active form
+        if ( changed_nodes[index] == false )
+        {
+            active_form[index] = (active_form[index] == 0 ? 1 : 0);
+            changed_nodes[index] = true;
+        }
+
+    }
+
+}
+
+
+bool GaussianPruningLikelihood::isDirty(size_t node_index) const
+{
+
+    return dirty_nodes[node_index];
+}
+
+
+void GaussianPruningLikelihood::keep( void )
+{
+
+    // reset all flags
+    for (size_t index = 0; index < num_nodes; ++index)
+    {
+        dirty_nodes[index] = false;
+        changed_nodes[index] = false;
+    }
+
+}
+
+
+void GaussianPruningLikelihood::resize(size_t nn, size_t ns)
+{
+
+    // keep the stored forms so that a restore still finds them
+    if ( nn == num_nodes && ns == num_sites )
+    {
+        flagAllDirty();
+        return;
+    }
+
+    num_nodes = nn;
+    num_sites = ns;
+
+    precisions      = std::vector<std::vector<std::vector<double> > >(2, std::vector<std::vector<double> >(num_nodes, std::vector<double>(num_sites, 0.0) ) );
+    linear_terms    = std::vector<std::vector<std::vector<double> > >(2, std::vector<std::vector<double> >(num_nodes, std::vector<double>(num_sites, 0.0) ) );
+    ln_scalers      = std::vector<std::vector<std::vector<double> > >(2, std::vector<std::vector<double> >(num_nodes, std::vector<double>(num_sites, 0.0) ) );
+    fixed_states    = std::vector<std::vector<std::vector<double> > >(2, std::vector<std::vector<double> >(num_nodes, std::vector<double>(num_sites, RbConstants::Double::nan) ) );
+    active_form     = std::vector<size_t>(num_nodes, 0);
+    changed_nodes   = std::vector<bool>(num_nodes, false);
+    dirty_nodes     = std::vector<bool>(num_nodes, true);
+
+}
+
+
+void GaussianPruningLikelihood::restore( void )
+{
+
+    for (size_t index = 0; index < num_nodes; ++index)
+    {
+        // we have to restore, that means if we have changed the active form
+        // then we need to revert this change
+        if ( changed_nodes[index] == true )
+        {
+            active_form[index] = (active_form[index] == 0 ? 1 : 0);
+        }
+
+        dirty_nodes[index] = false;
+        changed_nodes[index] = false;
+    }
+
+}
+
+
+void GaussianPruningLikelihood::sumChildForms(const TopologyNode &node, std::vector<double> &a, std::vector<double> &b, std::vector<double> &c, std::vector<double> &x) const
+{
+
+    for (size_t site = 0; site < num_sites; ++site)
+    {
+        a[site] = 0.0;
+        b[site] = 0.0;
+        c[site] = 0.0;
+        x[site] = RbConstants::Double::nan;
+    }
+
+    // the children are conditionally independent given this node, so their forms add up
+    for (size_t i = 0; i < node.getNumberOfChildren(); ++i)
+    {
+        size_t child_index = node.getChild(i).getIndex();
+        const std::vector<double> &a_child = precisions[active_form[child_index]][child_index];
+        const std::vector<double> &b_child = linear_terms[active_form[child_index]][child_index];
+        const std::vector<double> &c_child = ln_scalers[active_form[child_index]][child_index];
+        const std::vector<double> &x_child = fixed_states[active_form[child_index]][child_index];
+
+        for (size_t site = 0; site < num_sites; ++site)
+        {
+            a[site] += a_child[site];
+            b[site] += b_child[site];
+            c[site] += c_child[site];
+
+            if ( RbMath::isNan( x_child[site] ) == false )
+            {
+                // two zero-length branches fixing the state of the same node have probability zero
+                if ( RbMath::isNan( x[site] ) == false )
+                {
+                    c[site] = RbConstants::Double::neginf;
+                }
+                x[site] = x_child[site];
+            }
+        }
+    }
+
+    // if the state of this node is fixed, then we evaluate the forms of the other children at that state
+    for (size_t site = 0; site < num_sites; ++site)
+    {
+        if ( RbMath::isNan( x[site] ) == false )
+        {
+            c[site] += - 0.5 * a[site] * x[site] * x[site] + b[site] * x[site];
+            a[site] = 0.0;
+            b[site] = 0.0;
+        }
+    }
+
+}
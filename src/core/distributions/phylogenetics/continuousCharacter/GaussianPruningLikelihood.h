@@ -0,0 +1,68 @@
+#ifndef GaussianPruningLikelihood_H
+#define GaussianPruningLikelihood_H
+
+#include <stddef.h>
+#include <vector>
+
+namespace RevBayesCore {
+class TopologyNode;
+
+    /**
+     * @brief Linear-time likelihood of a Gaussian trait process by pruning along the tree.
+     *
+     * Every process where the state of a child is normally distributed around an affine function
+     * of the state of its parent, X_c | X_p ~ N( e*X_p + k, v ), can be integrated over all
+     * internal node states in a single postorder traversal instead of building and inverting the
+     * num_tips x num_tips covariance matrix. Brownian motion is the special case e=1 and k=0,
+     * the Ornstein-Uhlenbeck process uses e=exp(-alpha*t), k=theta*(1-e) and v=sigma^2/(2 alpha)*(1-e^2).
+     *
+     * The density of the data below a branch is kept as a function of the state at the top of the branch
+     * in canonical form, ln L(x) = -A*x^2/2 + B*x + C. Summing the forms of the children is the product of
+     * their likelihoods and a missing tip is simply the flat form A=B=C=0. At the root the form is evaluated
+     * at the root state, which gives exactly the multivariate normal density of the tip values.
+     *
+     * A tip on a branch with variance zero (e.g., a sampled ancestor) fixes the state of its parent,
+     * which has no canonical form. Such forms instead store the fixed parent state, and the other children
+     * are evaluated at that state. If the root state is fixed this way, the density is zero.
+     *
+     * The forms are double buffered per node and only the nodes flagged dirty since the last keep or restore
+     * are recomputed, in the same way as for the REML processes.
+     */
+    class GaussianPruningLikelihood {
+
+    public:
+        GaussianPruningLikelihood(size_t num_nodes = 0, size_t num_sites = 0);
+
+        void                                                                computeBranchForm(const TopologyNode &node, double e, double k, double v, const std::vector<std::vector<double> > &obs, const std::vector<double> &site_variance);
+        void                                                                computeRootForm(const TopologyNode &root);
+        double                                                              computeRootLnProbability(size_t root_index, const std::vector<double> &root_states) const;
+        void                                                                flagAllDirty(void);
+        void                                                                flagNodeDirty(const TopologyNode &n);
+        bool                                                                isDirty(size_t node_index) const;
+        void                                                                keep(void);
+        void                                                                resize(size_t num_nodes, size_t num_sites);
+        void                                                                restore(void);
+
+    private:
+
+        void                                                                computeFixedBranchForm(double x, double e, double k, double var, double &a, double &b, double &c, double &fixed_state) const;
+        void                                                                sumChildForms(const TopologyNode &node, std::vector<double> &a, std::vector<double> &b, std::vector<double> &c, std::vector<double> &x) const;
+
+        size_t                                                              num_nodes;
+        size_t                                                              num_sites;
+
+        // the canonical forms per node and site, double buffered
+        std::vector<std::vector<std::vector<double> > >                     precisions;
+        std::vector<std::vector<std::vector<double> > >                     linear_terms;
+        std::vector<std::vector<std::vector<double> > >                     ln_scalers;
+        std::vector<std::vector<std::vector<double> > >                     fixed_states;                                   //!< The state of the parent if a zero-length branch fixes it, NaN otherwise
+        std::vector<size_t>                                                 active_form;
+
+        std::vector<bool>                                                   changed_nodes;
+        std::vector<bool>                                                   dirty_nodes;
+
+    };
+
+}
+
+#endif
@@ -18,6 +18,7 @@
 #include "RbVectorImpl.h"
 #include "StringUtilities.h"
 #include "Tree.h"
+#include "TreeChangeEventHandler.h"
 #include "TypedDagNode.h"
 
 namespace RevBayesCore { class DagNode; }
@@ -33,7 +34,8 @@ PhyloBrownianProcessMVN::PhyloBrownianProcessMVN(const TypedDagNode<Tree> *t, si
     inverse_phylogenetic_covariance_matrix( num_tips, num_tips ),
     changed_covariance(false),
     needs_covariance_recomputation( true ),
-    needs_scale_recomputation( true )
+    needs_scale_recomputation( true ),
+    use_pruning( false )
 {
     homogeneous_root_state      = new ConstantNode<double>("", new double(0.0) );
     heterogeneous_root_state    = NULL;
@@ -57,7 +59,9 @@ PhyloBrownianProcessMVN::PhyloBrownianProcessMVN(const PhyloBrownianProcessMVN &
     inverse_phylogenetic_covariance_matrix( p.inverse_phylogenetic_covariance_matrix ),
     changed_covariance( p.changed_covariance ),
     needs_covariance_recomputation( p.needs_covariance_recomputation ),
-    needs_scale_recomputation( p.needs_scale_recomputation )
+    needs_scale_recomputation( p.needs_scale_recomputation ),
+    use_pruning( p.use_pruning ),
+    pruning_likelihood( p.pruning_likelihood )
 {
     
 }
@@ -74,6 +78,12 @@ PhyloBrownianProcessMVN::~PhyloBrownianProcessMVN( void )
     delete phylogenetic_covariance_matrix;
     delete stored_phylogenetic_covariance_matrix;
     
+    // remove myself from the tree listeners
+    if ( tau != NULL )
+    {
+        tau->getValue().getTreeChangeEventHandler().removeListener( this );
+    }
+    
 }
 
 
@@ -99,6 +109,8 @@ PhyloBrownianProcessMVN& PhyloBrownianProcessMVN::operator=(const PhyloBrownianP
         changed_covariance                          = p.changed_covariance;
         needs_covariance_recomputation              = p.needs_covariance_recomputation;
         needs_scale_recomputation                   = p.needs_scale_recomputation;
+        use_pruning                                 = p.use_pruning;
+        pruning_likelihood                          = p.pruning_likelihood;
     }
     
     return *this;
@@ -122,6 +134,38 @@ double PhyloBrownianProcessMVN::computeLnProbability( void )
     // we start with the root and then traverse down the tree
     size_t rootIndex = root.getIndex();
     
+    if ( use_pruning == true )
+    {
+        // we need to check here if we still are listining to this tree for change events
+        // the tree could have been replaced without telling us
+        if ( tau->getValue().getTreeChangeEventHandler().isListening( this ) == false )
+        {
+            tau->getValue().getTreeChangeEventHandler().addListener( this );
+            pruning_likelihood.flagAllDirty();
+        }
+        
+        // the site rates scale the variance of every branch
+        std::vector<double> site_variances = std::vector<double>(this->num_sites, 1.0);
+        std::vector<double> root_states = std::vector<double>(this->num_sites, 0.0);
+        for (size_t site = 0; site < this->num_sites; ++site)
+        {
+            double sr = this->computeSiteRate(site);
+            site_variances[site] = sr * sr;
+            root_states[site] = computeRootState(site);
+        }
+        
+        // only the nodes on the paths from the changed branches to the root are recomputed
+        if ( pruning_likelihood.isDirty( rootIndex ) == true )
+        {
+            recursiveComputePruningForms(root, rootIndex, site_variances);
+        }
+        
+        // the root states only enter at the very end, so they never require a traversal
+        this->ln_prob = pruning_likelihood.computeRootLnProbability(rootIndex, root_states);
+        
+        return this->ln_prob;
+    }
+    
     if ( needs_covariance_recomputation == true )
     {
         // perhaps there is a more efficient way to reset the matrix to 0.
@@ -161,6 +205,18 @@ double PhyloBrownianProcessMVN::computeRootState(size_t siteIdx)
 
 
 
+void PhyloBrownianProcessMVN::fireTreeChangeEvent( const TopologyNode &n, const unsigned& m )
+{
+    
+    // call a recursive flagging of all node above (closer to the root) and including this node
+    if ( use_pruning == true )
+    {
+        pruning_likelihood.flagNodeDirty( n );
+    }
+    
+}
+
+
 void PhyloBrownianProcessMVN::keepSpecialization( const DagNode* affecter )
 {
     
@@ -168,6 +224,11 @@ void PhyloBrownianProcessMVN::keepSpecialization( const DagNode* affecter )
     changed_covariance = false;
     needs_covariance_recomputation = false;
     
+    if ( use_pruning == true )
+    {
+        pruning_likelihood.keep();
+    }
+    
 }
 
 
@@ -214,6 +275,11 @@ void PhyloBrownianProcessMVN::resetValue( void )
     needs_covariance_recomputation = true;
     needs_scale_recomputation = true;
     
+    if ( use_pruning == true )
+    {
+        pruning_likelihood.resize( this->num_nodes, this->num_sites );
+    }
+    
 }
 
 
@@ -274,6 +340,34 @@ std::set<size_t> PhyloBrownianProcessMVN::recursiveComputeCovarianceMatrix(Matri
 }
 
 
+void PhyloBrownianProcessMVN::recursiveComputePruningForms(const TopologyNode &node, size_t node_index, const std::vector<double> &site_variances)
+{
+    
+    // the children need to be up-to-date first
+    for (size_t i = 0; i < node.getNumberOfChildren(); ++i)
+    {
+        const TopologyNode &child = node.getChild(i);
+        size_t child_index = child.getIndex();
+        if ( pruning_likelihood.isDirty( child_index ) == true )
+        {
+            recursiveComputePruningForms(child, child_index, site_variances);
+        }
+    }
+    
+    if ( node.isRoot() == true )
+    {
+        pruning_likelihood.computeRootForm( node );
+    }
+    else
+    {
+        // Brownian motion keeps the mean and adds the scaled branch length to the variance
+        double v = this->computeBranchTime(node_index, node.getBranchLength() );
+        pruning_likelihood.computeBranchForm(node, 1.0, 0.0, v, obs, site_variances);
+    }
+    
+}
+
+
 
 void PhyloBrownianProcessMVN::restoreSpecialization( const DagNode* affecter )
 {
@@ -290,6 +384,11 @@ void PhyloBrownianProcessMVN::restoreSpecialization( const DagNode* affecter )
         
     }
     
+    if ( use_pruning == true )
+    {
+        pruning_likelihood.restore();
+    }
+    
 }
 
 
@@ -343,6 +442,25 @@ void PhyloBrownianProcessMVN::setRootState(const TypedDagNode<RbVector<double> >
 }
 
 
+void PhyloBrownianProcessMVN::setUsePruning(bool tf)
+{
+    
+    use_pruning = tf;
+    
+    if ( use_pruning == true )
+    {
+        pruning_likelihood.resize( this->num_nodes, this->num_sites );
+        tau->getValue().getTreeChangeEventHandler().addListener( this );
+    }
+    else
+    {
+        pruning_likelihood.resize( 0, 0 );
+        tau->getValue().getTreeChangeEventHandler().removeListener( this );
+    }
+    
+}
+
+
 std::vector<double> PhyloBrownianProcessMVN::simulateRootCharacters(size_t n)
 {
     
@@ -428,6 +546,29 @@ void PhyloBrownianProcessMVN::touchSpecialization( const DagNode* affecter, bool
         touchAll = true;
     }
     
+    if ( use_pruning == true )
+    {
+        if ( affecter == homogeneous_root_state || affecter == heterogeneous_root_state )
+        {
+            // the root states are only used after the traversal
+        }
+        else if ( affecter == this->heterogeneous_clock_rates && this->heterogeneous_clock_rates->getTouchedElementIndices().size() > 0 )
+        {
+            // only the paths from the branches with a new rate to the root need to be recomputed
+            const std::set<size_t> &indices = this->heterogeneous_clock_rates->getTouchedElementIndices();
+            const std::vector<TopologyNode *> &nodes = this->tau->getValue().getNodes();
+            for (std::set<size_t>::const_iterator it = indices.begin(); it != indices.end(); ++it)
+            {
+                pruning_likelihood.flagNodeDirty( *nodes[*it] );
+            }
+        }
+        else if ( affecter != this->tau || touchAll == true )
+        {
+            // the tree fires change events for the branches it changed itself
+            pruning_likelihood.flagAllDirty();
+        }
+    }
+    
 }
 
 
@@ -443,6 +584,12 @@ void PhyloBrownianProcessMVN::swapParameterInternal(const DagNode *oldP, const D
     {
         heterogeneous_root_state = static_cast<const TypedDagNode< RbVector< double > >* >( newP );
     }
+    else if (oldP == this->tau && use_pruning == true)
+    {
+        this->tau->getValue().getTreeChangeEventHandler().removeListener( this );
+        AbstractPhyloBrownianProcess::swapParameterInternal(oldP, newP);
+        this->tau->getValue().getTreeChangeEventHandler().addListener( this );
+    }
     else
     {
         AbstractPhyloBrownianProcess::swapParameterInternal(oldP, newP);
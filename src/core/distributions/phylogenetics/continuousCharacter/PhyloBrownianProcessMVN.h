@@ -2,7 +2,9 @@
 #define PhyloBrownianProcessMVN_H
 
 #include "AbstractPhyloBrownianProcess.h"
+#include "GaussianPruningLikelihood.h"
 #include "MatrixReal.h"
+#include "TreeChangeEventListener.h"
 
 #include <vector>
 
@@ -11,13 +13,16 @@ namespace RevBayesCore {
     /**
      * @brief Homogeneous distribution of character state evolution along a tree class (PhyloCTMC).
      *
-     *
+     * By default the likelihood is the multivariate normal density with the phylogenetic covariance matrix,
+     * which needs O(n^3) time and O(n^2) memory for n tips. With setUsePruning(true) the same density is instead
+     * computed by pruning along the tree (see GaussianPruningLikelihood), which takes linear time, allows missing data
+     * and only recomputes the nodes on the path from a changed branch to the root.
      *
      * @copyright Copyright 2009-
      * @author The RevBayes Development Core Team (Sebastian Hoehna)
      * @since 2015-01-23, version 1.0
      */
-    class PhyloBrownianProcessMVN : public AbstractPhyloBrownianProcess {
+    class PhyloBrownianProcessMVN : public AbstractPhyloBrownianProcess, public TreeChangeEventListener {
         
     public:
         // Note, we need the size of the alignment in the constructor to correctly simulate an initial state
@@ -34,8 +39,10 @@ namespace RevBayesCore {
         
         // non-virtual
         double                                                              computeLnProbability(void);
+        void                                                                fireTreeChangeEvent(const TopologyNode &n, const unsigned& m=0);                                             //!< The tree has changed and we want to know which part.
         void                                                                setRootState(const TypedDagNode< double >* s);
         void                                                                setRootState(const TypedDagNode< RbVector< double > >* s);
+        void                                                                setUsePruning(bool tf);                                                                 //!< Compute the likelihood by pruning instead of the covariance matrix
         
     protected:
         // virtual methods that may be overwritten, but then the derived class should call this methods
@@ -53,6 +60,7 @@ namespace RevBayesCore {
     private:
         double                                                              computeRootState(size_t siteIdx);
         std::set<size_t>                                                    recursiveComputeCovarianceMatrix( MatrixReal &m, const TopologyNode &node, size_t node_index );
+        void                                                                recursiveComputePruningForms( const TopologyNode &node, size_t node_index, const std::vector<double> &site_variances );
         
         const TypedDagNode< double >*                                       homogeneous_root_state;
         const TypedDagNode< RbVector< double > >*                           heterogeneous_root_state;
@@ -65,6 +73,9 @@ namespace RevBayesCore {
         bool                                                                changed_covariance;
         bool                                                                needs_covariance_recomputation;
         bool                                                                needs_scale_recomputation;
+        
+        bool                                                                use_pruning;
+        GaussianPruningLikelihood                                           pruning_likelihood;
     };
     
 }
@@ -19,6 +19,7 @@
 #include "RbVector.h"
 #include "RbVectorImpl.h"
 #include "Tree.h"
+#include "TreeChangeEventHandler.h"
 #include "TypedDagNode.h"
 
 namespace RevBayesCore { class DagNode; }
@@ -35,7 +36,8 @@ PhyloOrnsteinUhlenbeckProcessEVE::PhyloOrnsteinUhlenbeckProcessEVE(const TypedDa
     inverse_phylogenetic_covariance_matrix( num_species, num_species ),
     changed_covariance(false),
     needs_covariance_recomputation( true ),
-    needs_scale_recomputation( true )
+    needs_scale_recomputation( true ),
+    use_pruning( false )
 {
     // initialize default parameters
     root_state                  = new ConstantNode<double>("", new double(0.0) );
@@ -75,7 +77,9 @@ PhyloOrnsteinUhlenbeckProcessEVE::PhyloOrnsteinUhlenbeckProcessEVE(const PhyloOr
     inverse_phylogenetic_covariance_matrix( p.inverse_phylogenetic_covariance_matrix ),
     changed_covariance( p.changed_covariance ),
     needs_covariance_recomputation( p.needs_covariance_recomputation ),
-    needs_scale_recomputation( p.needs_scale_recomputation )
+    needs_scale_recomputation( p.needs_scale_recomputation ),
+    use_pruning( p.use_pruning ),
+    pruning_likelihood( p.pruning_likelihood )
 {
     
 }
@@ -92,6 +96,12 @@ PhyloOrnsteinUhlenbeckProcessEVE::~PhyloOrnsteinUhlenbeckProcessEVE( void )
     delete means;
     delete phylogenetic_covariance_matrix;
     
+    // remove myself from the tree listeners
+    if ( tau != NULL )
+    {
+        tau->getValue().getTreeChangeEventHandler().removeListener( this );
+    }
+    
 }
 
 
@@ -121,6 +131,8 @@ PhyloOrnsteinUhlenbeckProcessEVE& PhyloOrnsteinUhlenbeckProcessEVE::operator=(co
         changed_covariance                      = p.changed_covariance;
         needs_covariance_recomputation          = p.needs_covariance_recomputation;
         needs_scale_recomputation               = p.needs_scale_recomputation;
+        use_pruning                             = p.use_pruning;
+        pruning_likelihood                      = p.pruning_likelihood;
     }
 
     return *this;
@@ -303,6 +315,31 @@ void PhyloOrnsteinUhlenbeckProcessEVE::computeVarianceRecursive(const TopologyNo
 
 double PhyloOrnsteinUhlenbeckProcessEVE::computeLnProbability( void )
 {
+    
+    if ( use_pruning == true )
+    {
+        // we need to check here if we still are listining to this tree for change events
+        // the tree could have been replaced without telling us
+        if ( tau->getValue().getTreeChangeEventHandler().isListening( this ) == false )
+        {
+            tau->getValue().getTreeChangeEventHandler().addListener( this );
+            pruning_likelihood.flagAllDirty();
+        }
+        
+        const TopologyNode &root = this->tau->getValue().getRoot();
+        size_t root_index = root.getIndex();
+        
+        // only the nodes on the paths from the changed branches to the root are recomputed
+        if ( pruning_likelihood.isDirty( root_index ) == true )
+        {
+            recursiveComputePruningForms(root, root_index);
+        }
+        
+        // the root state only enters at the very end, so it never requires a traversal
+        this->ln_prob = pruning_likelihood.computeRootLnProbability(root_index, std::vector<double>(this->num_sites, computeRootState()) );
+        
+        return this->ln_prob;
+    }
 
     // first, compute the expectations for all tips and the variance-covariance matrix
     computeExpectation( *means );
@@ -384,6 +421,18 @@ double PhyloOrnsteinUhlenbeckProcessEVE::computeRootState( void ) const
 }
 
 
+void PhyloOrnsteinUhlenbeckProcessEVE::fireTreeChangeEvent( const TopologyNode &n, const unsigned& m )
+{
+    
+    // call a recursive flagging of all node above (closer to the root) and including this node
+    if ( use_pruning == true )
+    {
+        pruning_likelihood.flagNodeDirty( n );
+    }
+    
+}
+
+
 void PhyloOrnsteinUhlenbeckProcessEVE::keepSpecialization( const DagNode* affecter )
 {
     
@@ -391,6 +440,11 @@ void PhyloOrnsteinUhlenbeckProcessEVE::keepSpecialization( const DagNode* affect
     changed_covariance = false;
     needs_covariance_recomputation = false;
     
+    if ( use_pruning == true )
+    {
+        pruning_likelihood.keep();
+    }
+    
 }
 
 
@@ -442,6 +496,11 @@ void PhyloOrnsteinUhlenbeckProcessEVE::resetValue( void )
     needs_covariance_recomputation = true;
     needs_scale_recomputation = true;
     
+    if ( use_pruning == true )
+    {
+        pruning_likelihood.resize( this->num_nodes, this->num_sites );
+    }
+    
 }
 
 
@@ -542,6 +601,49 @@ std::set<size_t> PhyloOrnsteinUhlenbeckProcessEVE::recursiveComputeDistanceMatri
 }
 
 
+void PhyloOrnsteinUhlenbeckProcessEVE::recursiveComputePruningForms(const TopologyNode &node, size_t node_index)
+{
+    
+    // the children need to be up-to-date first
+    for (size_t i = 0; i < node.getNumberOfChildren(); ++i)
+    {
+        const TopologyNode &child = node.getChild(i);
+        size_t child_index = child.getIndex();
+        if ( pruning_likelihood.isDirty( child_index ) == true )
+        {
+            recursiveComputePruningForms(child, child_index);
+        }
+    }
+    
+    if ( node.isRoot() == true )
+    {
+        pruning_likelihood.computeRootForm( node );
+    }
+    else
+    {
+        // the same branch transition as used for the expectations and variances above
+        double alpha            = computeBranchAlpha(node_index);
+        double sigma            = computeBranchSigma(node_index);
+        double theta            = computeBranchTheta(node_index);
+        double bl               = node.getBranchLength();
+        
+        double eAT = exp(-1.0 * alpha * bl);
+        double v = 0.0;
+        if ( alpha > 1E-10 )
+        {
+            v = (sigma * sigma / (2.0*alpha)) * (1.0 - eAT*eAT);
+        }
+        else
+        {
+            v = sigma * sigma * bl;
+        }
+        
+        pruning_likelihood.computeBranchForm(node, eAT, theta*(1.0-eAT), v, obs, std::vector<double>(this->num_sites, 1.0) );
+    }
+    
+}
+
+
 
 void PhyloOrnsteinUhlenbeckProcessEVE::restoreSpecialization( const DagNode* affecter )
 {
@@ -554,6 +656,11 @@ void PhyloOrnsteinUhlenbeckProcessEVE::restoreSpecialization( const DagNode* aff
         
     }
     
+    if ( use_pruning == true )
+    {
+        pruning_likelihood.restore();
+    }
+    
 }
 
 
@@ -726,6 +833,25 @@ void PhyloOrnsteinUhlenbeckProcessEVE::setTheta(const TypedDagNode<RbVector<doub
 }
 
 
+void PhyloOrnsteinUhlenbeckProcessEVE::setUsePruning(bool tf)
+{
+    
+    use_pruning = tf;
+    
+    if ( use_pruning == true )
+    {
+        pruning_likelihood.resize( this->num_nodes, this->num_sites );
+        tau->getValue().getTreeChangeEventHandler().addListener( this );
+    }
+    else
+    {
+        pruning_likelihood.resize( 0, 0 );
+        tau->getValue().getTreeChangeEventHandler().removeListener( this );
+    }
+    
+}
+
+
 void PhyloOrnsteinUhlenbeckProcessEVE::simulateRecursively( const TopologyNode &node, std::vector< ContinuousTaxonData > &taxa)
 {
     
@@ -867,7 +993,16 @@ void PhyloOrnsteinUhlenbeckProcessEVE::swapParameterInternal(const DagNode *oldP
         heterogeneous_theta = static_cast<const TypedDagNode< RbVector< double > >* >( newP );
     }
     
-    this->AbstractPhyloContinuousCharacterProcess::swapParameterInternal(oldP, newP);
+    if (oldP == this->tau && use_pruning == true)
+    {
+        this->tau->getValue().getTreeChangeEventHandler().removeListener( this );
+        this->AbstractPhyloContinuousCharacterProcess::swapParameterInternal(oldP, newP);
+        this->tau->getValue().getTreeChangeEventHandler().addListener( this );
+    }
+    else
+    {
+        this->AbstractPhyloContinuousCharacterProcess::swapParameterInternal(oldP, newP);
+    }
     
 }
 
@@ -898,6 +1033,29 @@ void PhyloOrnsteinUhlenbeckProcessEVE::touchSpecialization( const DagNode* affec
     //        touchAll = true;
     //    }
     
+    if ( use_pruning == true )
+    {
+        if ( affecter == root_state )
+        {
+            // the root state is only used after the traversal
+        }
+        else if ( (affecter == heterogeneous_alpha || affecter == heterogeneous_sigma || affecter == heterogeneous_theta) && affecter->getTouchedElementIndices().size() > 0 )
+        {
+            // only the paths from the branches with new parameters to the root need to be recomputed
+            const std::set<size_t> &indices = affecter->getTouchedElementIndices();
+            const std::vector<TopologyNode *> &nodes = this->tau->getValue().getNodes();
+            for (std::set<size_t>::const_iterator it = indices.begin(); it != indices.end(); ++it)
+            {
+                pruning_likelihood.flagNodeDirty( *nodes[*it] );
+            }
+        }
+        else if ( affecter != this->tau || touchAll == true )
+        {
+            // the tree fires change events for the branches it changed itself
+            pruning_likelihood.flagAllDirty();
+        }
+    }
+    
 }
 
 
@@ -6,8 +6,10 @@
 #include <set>
 
 #include "AbstractPhyloContinuousCharacterProcess.h"
+#include "GaussianPruningLikelihood.h"
 #include "MatrixReal.h"
 #include "TopologyNode.h"
+#include "TreeChangeEventListener.h"
 
 namespace RevBayesCore {
 class ContinuousTaxonData;
@@ -19,13 +21,15 @@ template <class valueType> class TypedDagNode;
     /**
      * @brief Homogeneous distribution of character state evolution along a tree class (PhyloCTMC).
      *
-     *
+     * By default the likelihood is the multivariate normal density with the phylogenetic covariance matrix.
+     * With setUsePruning(true) the same density is computed in linear time by pruning along the tree
+     * (see GaussianPruningLikelihood), which also allows missing data.
      *
      * @copyright Copyright 2009-
      * @author The RevBayes Development Core Team (Sebastian Hoehna)
      * @since 2015-01-23, version 1.0
      */
-    class PhyloOrnsteinUhlenbeckProcessEVE : public AbstractPhyloContinuousCharacterProcess {
+    class PhyloOrnsteinUhlenbeckProcessEVE : public AbstractPhyloContinuousCharacterProcess, public TreeChangeEventListener {
         
     public:
         // Note, we need the size of the alignment in the constructor to correctly simulate an initial state
@@ -43,6 +47,7 @@ template <class valueType> class TypedDagNode;
         
         // non-virtual
         double                                                              computeLnProbability(void);
+        void                                                                fireTreeChangeEvent(const TopologyNode &n, const unsigned& m=0);                                             //!< The tree has changed and we want to know which part.
         void                                                                setAlpha(const TypedDagNode< double >* a);
         void                                                                setAlpha(const TypedDagNode< RbVector< double > >* a);
         void                                                                setRootState(const TypedDagNode< double >* s);
@@ -50,6 +55,7 @@ template <class valueType> class TypedDagNode;
         void                                                                setSigma(const TypedDagNode< RbVector< double > >* s);
         void                                                                setTheta(const TypedDagNode< double >* t);
         void                                                                setTheta(const TypedDagNode< RbVector< double > >* t);
+        void                                                                setUsePruning(bool tf);                                                                 //!< Compute the likelihood by pruning instead of the covariance matrix
         
         
     protected:
@@ -79,6 +85,7 @@ template <class valueType> class TypedDagNode;
         double                                                              computeBranchTheta(size_t idx) const;
         void                                                                recursiveComputeRootToTipDistance( std::vector<double> &m, double v, const TopologyNode &n, size_t ni );
         std::set<size_t>                                                    recursiveComputeDistanceMatrix( MatrixReal &m, const TopologyNode &node, size_t node_index );
+        void                                                                recursiveComputePruningForms( const TopologyNode &node, size_t node_index );
         
         const TypedDagNode< double >*                                       root_state;
         const TypedDagNode< double >*                                       homogeneous_alpha;
@@ -97,6 +104,9 @@ template <class valueType> class TypedDagNode;
         bool                                                                needs_covariance_recomputation;
         bool                                                                needs_scale_recomputation;
         
+        bool                                                                use_pruning;
+        GaussianPruningLikelihood                                           pruning_likelihood;
+        
     };
     
 }
@@ -5,6 +5,7 @@
 #include "ConstantNode.h"
 #include "DiscreteTaxonData.h"
 #include "DnaState.h"
+#include "LikelihoodScheduler.h"
 #include "MatrixReal.h"
 #include "MemberObject.h"
 #include "RbConstants.h"
@@ -15,6 +16,7 @@
 #include "Simplex.h"
 #include "TopologyNode.h"
 #include "TransitionProbabilityMatrix.h"
+#include "TransitionProbabilityMatrixCache.h"
 #include "Tree.h"
 #include "TreeChangeEventListener.h"
 #include "TypedDistribution.h"
@@ -42,7 +44,10 @@ namespace RevBayesCore {
      *
      *
      * The data are stored for convenience in this class in a matrix (std::vector<std::vector< unsigned > >) and can
-     * be compressed.
+     * be compressed. Each tip state is stored as a compact integer code: the codes 0 to num_chars-1 are the single states,
+     * the code num_chars is a gap, and the remaining codes refer to the distinct ambiguous states in tip_state_sets.
+     * The tip likelihoods of a branch are then looked up per code in a table computed once from the transition probabilities
+     * (see computeTipStateLikelihoods), instead of scanning the observed states at every site.
      *
      * The partial likelihoods are stored in a c-style array called partialLikelihoods. The dimension are
      * partialLikelihoods[active][node_index][siteRateIndex][siteIndex][charIndex], however, since this is a one-dimensional c-style array,
@@ -59,6 +64,9 @@ namespace RevBayesCore {
      * siteOffset                  =  num_chars;
      * This gives the more convenient access via
      * partialLikelihoods[active*activeLikelihoodOffset + node_index*nodeOffset + siteRateIndex*mixtureOffset + siteIndex*siteOffset + charIndex]
+     * If the user option "padStates" is set and the derived class supports it, siteOffset is num_chars rounded up
+     * to the SIMD vector width (see PhyloCTMCKernels). The tip likelihoods and the kernels write zeros into the padded states,
+     * so derived classes that support padding must fill the padding of their tips too.
      *
      * Our implementation of the partial likelihoods means that we can store the partial likelihood of a node, but not for site rates.
      * We also use twice as much memory because we store the partial likelihood along each branch and not only for each internal node.
@@ -76,6 +84,15 @@ namespace RevBayesCore {
      * This gives the more convenient access via
      * pmatrices[active * activePmatrixOffset + node_index * nodeOffset + site_mixture_index]
      *
+     * If the user setting "numThreads" is larger than one, the patterns of this process are further split into blocks,
+     * one per thread, in the same way as the patterns are split among MPI processes. Each block is owned by a pattern block worker,
+     * which is a clone of this distribution that only holds the data and the partial likelihoods of its block. We compute the transition
+     * probability matrices only once and copy them to the workers, then the workers compute their likelihoods concurrently
+     * on the global thread pool, and we sum the per-block log-likelihoods in a fixed order.
+     *
+     * Each distribution registers with the process-wide likelihood scheduler with a cost proportional to the size of its
+     * partial likelihoods. The scheduler starts the most expensive likelihoods first when many of them (e.g., one per locus)
+     * are recomputed concurrently after a move, and it records the time spent in each of them.
      */
     template<class charType>
     class AbstractPhyloCTMCSiteHomogeneous : public TypedDistribution< AbstractHomologousDiscreteCharacterData >, public MemberObject< RbVector<double> >, public MemberObject < MatrixReal >, public TreeChangeEventListener {
@@ -100,6 +117,7 @@ namespace RevBayesCore {
         void                                                                executeMethod(const std::string &n, const std::vector<const DagNode*> &args, RbVector<double> &rv) const;     //!< Map the member methods to internal function calls
         void                                                                executeMethod(const std::string &n, const std::vector<const DagNode*> &args, MatrixReal &rv) const;     //!< Map the member methods to internal function calls
         void                                                                fireTreeChangeEvent(const TopologyNode &n, const unsigned& m=0);                                                 //!< The tree has changed and we want to know which part.
+        double                                                              getComputationCost(void) const;                                                             //!< The size of our partial likelihoods
         virtual void                                                        recursivelyDrawJointConditionalAncestralStates(const TopologyNode &node, std::vector<std::vector<charType> >& startStates, std::vector<std::vector<charType> >& endStates, const std::vector<size_t>& sampledSiteRates); //!< Simulate the ancestral states for a given node, conditional on its ancestor's state and the tip data
         virtual bool                                                        recursivelyDrawStochasticCharacterMap(const TopologyNode &node, std::vector<std::string>& character_histories, std::vector<std::vector<charType> >& start_states, std::vector<std::vector<charType> >& end_states, size_t site, bool use_simmap_default); //!< Simulate the history of evolution for a given site on a given branch, conditional on start and end states
         virtual void                                                        redrawValue(void);
@@ -129,8 +147,11 @@ namespace RevBayesCore {
     protected:
 
         // helper method for this and derived classes
+        void                                                                calculateTransitionProbabilities(const RateGenerator &rm, size_t matrix_index, double start_age, double end_age, double rate, TransitionProbabilityMatrix &P);   //!< Compute P or look it up in the cache
         void                                                                recursivelyFlagNodeDirty(const TopologyNode& n);
         void                                                                flagNodeDirtyPmatrix(size_t node_idx);
+        void                                                                computeLnProbabilitySerially(void) const;                                                  //!< Compute the likelihood without the pattern block workers, so that our own partial likelihoods are up-to-date
+        double                                                              reduceLnProbabilityOverProcesses(double ln_prob) const;                                     //!< Sum the log-likelihood over all MPI processes
         virtual void                                                        resizeLikelihoodVectors(void);
         virtual void                                                        setActivePIDSpecialized(size_t i, size_t n);                                                          //!< Set the number of processes for this distribution.
         virtual void                                                        updateTransitionProbabilities(size_t node_idx);
@@ -139,6 +160,8 @@ namespace RevBayesCore {
         virtual void                                                        getRootFrequencies( std::vector<std::vector<double> >& ) const;
         virtual std::vector<double>                                         getMixtureProbs( void ) const;
         virtual double                                                      getPInv(void) const;
+        virtual bool                                                        supportsPatternBlockThreads(void) const;                                                    //!< Can the patterns be split among several threads?
+        virtual bool                                                        supportsStatePadding(void) const;                                                           //!< Can the states of each site be padded to the SIMD vector width?
 
 
         // Parameter management functions.
@@ -168,6 +191,10 @@ namespace RevBayesCore {
         virtual double                                                      sumRootLikelihood( void );
         virtual std::vector<size_t>                                         getIncludedSiteIndices();
 
+        // helper methods for the compact tip states
+        void                                                                computeTipStateLikelihoods(const double *tp);                                               //!< Fill the lookup table of the tip likelihoods of each state code for this transition probability matrix
+        bool                                                                isGapTipState(size_t code) const;                                                           //!< Is this state code the gap code?
+
         // members
         double                                                              lnProb;
         double                                                              storedLnProb;
@@ -184,6 +211,9 @@ namespace RevBayesCore {
         std::vector<size_t>                                                 active_pmatrices;
         std::vector<bool>                                                   pmat_changed_nodes;
         mutable std::vector<bool>                                           pmat_dirty_nodes;
+        TransitionProbabilityMatrixCache                                    transition_probability_cache;                   //!< Recently computed transition probability matrices
+        size_t                                                              rate_matrix_version;                            //!< Changes whenever the rate matrices change
+        size_t                                                              stored_rate_matrix_version;
         
         // offsets for nodes
         size_t                                                              activePmatrixOffset;
@@ -197,9 +227,9 @@ namespace RevBayesCore {
         std::vector< std::vector< std::vector<double> > >                   perNodeSiteLogScalingFactors;
 
         // the data
-        std::vector<std::vector<RbBitSet> >                                 ambiguous_char_matrix;
-        std::vector<std::vector<unsigned long> >                            char_matrix;
-        std::vector<std::vector<bool> >                                     gap_matrix;
+        std::vector<std::vector<unsigned int> >                             tip_states;                                                                                 //!< The state code of each tip and pattern
+        std::vector<RbBitSet>                                               tip_state_sets;                                                                             //!< The observed states of each state code
+        std::vector<double>                                                 tip_state_likelihoods;                                                                      //!< The tip likelihoods of each state code for the current branch
         std::vector<size_t>                                                 pattern_counts;
         std::vector<bool>                                                   site_invariant;
         std::vector<std::vector<size_t> >                                   invariant_site_index;
@@ -251,6 +281,14 @@ namespace RevBayesCore {
         size_t                                                              pattern_block_end;
         size_t                                                              pattern_block_size;
 
+        // thread variables
+        std::vector<AbstractPhyloCTMCSiteHomogeneous<charType>*>            pattern_block_workers;                          //!< Clones that each own the patterns of one thread block
+        size_t                                                              pattern_thread_index;                           //!< The index of the thread block if this is a pattern block worker
+        size_t                                                              num_pattern_threads;                            //!< The number of thread blocks if this is a pattern block worker, 1 otherwise
+        mutable bool                                                        compute_serially;
+        bool                                                                registered_with_scheduler;                      //!< Are we registered with our current name at the likelihood scheduler?
+        LikelihoodScheduler::ComputationStatistics                          computation_statistics;                         //!< The number of our likelihood computations and the time spent in them
+
         bool                                                                store_internal_nodes;
         bool                                                                gap_match_clamped;
 
@@ -265,14 +303,20 @@ namespace RevBayesCore {
     private:
 
         // private methods
+        double                                                              computeLnProbabilityPatternBlocks(size_t n);
+        void                                                                createPatternBlockWorkers(size_t n);
+        void                                                                deletePatternBlockWorkers(void);
         void                                                                fillLikelihoodVector(const TopologyNode &n, size_t nIdx);
+        size_t                                                              getNumberOfPatternBlockThreads(void) const;
+        size_t                                                              getTransitionProbabilityCacheCapacity(void) const;
         void                                                                recursiveMarginalLikelihoodComputation(size_t nIdx);
         virtual void                                                        scale(size_t i);
         virtual void                                                        scale(size_t i, size_t l, size_t r);
         virtual void                                                        scale(size_t i, size_t l, size_t r, size_t m);
         virtual void                                                        simulate(const TopologyNode& node, std::vector< DiscreteTaxonData< charType > > &t, const std::vector<bool> &inv, const std::vector<size_t> &perSiteRates);
         virtual void                                                        updateTransitionProbabilityMatrix(size_t node_idx);
-        
+        void                                                                setPatternBlockThread(size_t i, size_t n);
+        bool                                                                updateParametersForPatternBlocks(void) const;
         
         
     };
@@ -283,12 +327,16 @@ namespace RevBayesCore {
 #include "DiscreteCharacterState.h"
 #include "DistributionExponential.h"
 #include "HomologousDiscreteCharacterData.h"
+#include "PhyloCTMCKernels.h"
 #include "RandomNumberFactory.h"
 #include "RandomNumberGenerator.h"
 #include "RateMatrix_JC.h"
 #include "StochasticNode.h"
+#include "ThreadPool.h"
 
+#include <algorithm>
 #include <cmath>
+#include <functional>
 
 #ifdef RB_MPI
 #include <mpi.h>
@@ -314,9 +362,9 @@ activeLikelihood( std::vector<size_t>(num_nodes, 0) ),
 //    marginalLikelihoods( new double[num_nodes*num_site_mixtures*num_sites*num_chars] ),
 marginalLikelihoods( NULL ),
 perNodeSiteLogScalingFactors( std::vector<std::vector< std::vector<double> > >(2, std::vector<std::vector<double> >(num_nodes, std::vector<double>(num_sites, 0.0) ) ) ),
-ambiguous_char_matrix(),
-char_matrix(),
-gap_matrix(),
+tip_states(),
+tip_state_sets(),
+tip_state_likelihoods(),
 pattern_counts(),
 site_invariant( num_sites, false ),
 invariant_site_index( num_sites ),
@@ -336,6 +384,11 @@ in_mcmc_mode( false ),
 pattern_block_start( 0 ),
 pattern_block_end( num_patterns ),
 pattern_block_size( num_patterns ),
+pattern_block_workers(),
+pattern_thread_index( 0 ),
+num_pattern_threads( 1 ),
+compute_serially( false ),
+registered_with_scheduler( false ),
 store_internal_nodes( internal ),
 gap_match_clamped( gapmatch ),
 template_state(),
@@ -376,6 +429,10 @@ sampled_site_matrix_component( 0 )
     pmat_dirty_nodes            =  std::vector<bool>(num_nodes, true);
     pmatrices                   =  std::vector<TransitionProbabilityMatrix>(activePmatrixOffset * 2, TransitionProbabilityMatrix(num_chars));
 
+    transition_probability_cache.setCapacity( getTransitionProbabilityCacheCapacity() );
+    rate_matrix_version         =  TransitionProbabilityMatrixCache::nextVersion();
+    stored_rate_matrix_version  =  rate_matrix_version;
+
 
     // add the parameters to our set (in the base class)
     // in that way other class can easily access the set of our parameters
@@ -416,9 +473,9 @@ activeLikelihood( n.activeLikelihood ),
 //    marginalLikelihoods( new double[num_nodes*num_site_mixtures*num_sites*num_chars] ),
 marginalLikelihoods( NULL ),
 perNodeSiteLogScalingFactors( n.perNodeSiteLogScalingFactors ),
-ambiguous_char_matrix( n.ambiguous_char_matrix ),
-char_matrix( n.char_matrix ),
-gap_matrix( n.gap_matrix ),
+tip_states( n.tip_states ),
+tip_state_sets( n.tip_state_sets ),
+tip_state_likelihoods(),
 pattern_counts( n.pattern_counts ),
 site_invariant( n.site_invariant ),
 invariant_site_index( n.invariant_site_index ),
@@ -438,6 +495,11 @@ in_mcmc_mode( n.in_mcmc_mode ),
 pattern_block_start( n.pattern_block_start ),
 pattern_block_end( n.pattern_block_end ),
 pattern_block_size( n.pattern_block_size ),
+pattern_block_workers(),
+pattern_thread_index( n.pattern_thread_index ),
+num_pattern_threads( n.num_pattern_threads ),
+compute_serially( false ),
+registered_with_scheduler( false ),
 store_internal_nodes( n.store_internal_nodes ),
 gap_match_clamped( n.gap_match_clamped ),
 template_state( n.template_state ),
@@ -469,6 +531,11 @@ sampled_site_matrix_component( n.sampled_site_matrix_component )
     pmat_dirty_nodes            =  n.pmat_dirty_nodes;
     pmatrices                   =  n.pmatrices;
 
+    // the copy may use new rate matrix objects, so we start with a new version
+    transition_probability_cache.setCapacity( n.transition_probability_cache.getCapacity() );
+    rate_matrix_version         =  TransitionProbabilityMatrixCache::nextVersion();
+    stored_rate_matrix_version  =  rate_matrix_version;
+
     // flags specifying which model variants we use
     branch_heterogeneous_clock_rates               = n.branch_heterogeneous_clock_rates;
     branch_heterogeneous_substitution_matrices     = n.branch_heterogeneous_substitution_matrices;
@@ -477,11 +544,17 @@ sampled_site_matrix_component( n.sampled_site_matrix_component )
     tau->getValue().getTreeChangeEventHandler().addListener( this );
 
     // copy the partial likelihoods if necessary
-    if ( in_mcmc_mode == true )
+    if ( in_mcmc_mode == true && n.partialLikelihoods != NULL )
     {
         partialLikelihoods = new double[2*activeLikelihoodOffset];
         memcpy(partialLikelihoods, n.partialLikelihoods, 2*activeLikelihoodOffset*sizeof(double));
     }
+    else if ( in_mcmc_mode == true )
+    {
+        // the pattern block workers of the original owned the partial likelihoods,
+        // so we allocate our own when we need them and have to recompute everything
+        dirty_nodes = std::vector<bool>(num_nodes, true);
+    }
 
     // copy the marginal likelihoods if necessary
     if ( useMarginalLikelihoods == true )
@@ -508,9 +581,16 @@ RevBayesCore::AbstractPhyloCTMCSiteHomogeneous<charType>::~AbstractPhyloCTMCSite
         tau->getValue().getTreeChangeEventHandler().removeListener( this );
     }
 
+    LikelihoodScheduler::likelihoodSchedulerInstance().unregisterInstance( this );
+
     // free the partial likelihoods
     delete [] partialLikelihoods;
     delete [] marginalLikelihoods;
+
+    for (size_t i = 0; i < pattern_block_workers.size(); ++i)
+    {
+        delete pattern_block_workers[i];
+    }
 }
 
 
@@ -635,17 +715,29 @@ void RevBayesCore::AbstractPhyloCTMCSiteHomogeneous<charType>::compress( void )
         return;
     }
 
-    ambiguous_char_matrix.clear();
-    char_matrix.clear();
-    gap_matrix.clear();
+    // the pattern blocks of the workers will change
+    deletePatternBlockWorkers();
+
+    tip_states.clear();
     pattern_counts.clear();
     num_patterns = 0;
 
     // resize the matrices
     size_t tips = tau->getValue().getNumberOfTips();
-    ambiguous_char_matrix.resize(tips);
-    char_matrix.resize(tips);
-    gap_matrix.resize(tips);
+    tip_states.resize(tips);
+
+    // the first codes are the single states followed by the gap, which could be any state
+    tip_state_sets.clear();
+    for (size_t i = 0; i < num_chars; ++i)
+    {
+        RbBitSet single_state = RbBitSet(num_chars);
+        single_state.set(i);
+        tip_state_sets.push_back( single_state );
+    }
+    RbBitSet all_states = RbBitSet(num_chars);
+    all_states.set();
+    tip_state_sets.push_back( all_states );
+    std::map<RbBitSet, unsigned int> ambiguous_state_codes;
 
     // create a vector with the correct site indices
     // some of the sites may have been excluded
@@ -743,6 +835,15 @@ void RevBayesCore::AbstractPhyloCTMCSiteHomogeneous<charType>::compress( void )
     // compute which block of the data this process needs to compute
     pattern_block_start = size_t(floor( (double(pid-active_PID)   / num_processes ) * num_patterns) );
     pattern_block_end   = size_t(floor( (double(pid+1-active_PID) / num_processes ) * num_patterns) );
+
+    // and which part of this block a pattern block worker needs to compute
+    if ( num_pattern_threads > 1 )
+    {
+        size_t process_block_start = pattern_block_start;
+        size_t process_block_size  = pattern_block_end - pattern_block_start;
+        pattern_block_start = process_block_start + size_t(floor( (double(pattern_thread_index)   / num_pattern_threads ) * process_block_size) );
+        pattern_block_end   = process_block_start + size_t(floor( (double(pattern_thread_index+1) / num_pattern_threads ) * process_block_size) );
+    }
     pattern_block_size  = pattern_block_end - pattern_block_start;
 
 
@@ -758,43 +859,52 @@ void RevBayesCore::AbstractPhyloCTMCSiteHomogeneous<charType>::compress( void )
             AbstractDiscreteTaxonData& taxon = value->getTaxonData( the_node->getName() );
 
             // resize the column
-            if ( using_ambiguous_characters == true )
-            {
-                ambiguous_char_matrix[node_index].resize(pattern_block_size);
-            }
-            else
-            {
-                char_matrix[node_index].resize(pattern_block_size);
-            }
-            gap_matrix[node_index].resize(pattern_block_size);
+            tip_states[node_index].resize(pattern_block_size);
             for (size_t patternIndex = 0; patternIndex < pattern_block_size; ++patternIndex)
             {
                 // set the counts for this patter
                 process_pattern_counts[patternIndex] = pattern_counts[patternIndex+pattern_block_start];
 
                 charType &c = static_cast<charType &>( taxon.getCharacter(site_indices[indexOfSitePattern[patternIndex+pattern_block_start]]) );
-                gap_matrix[node_index][patternIndex] = c.isGapState();
 
-                if ( using_ambiguous_characters == true )
+                unsigned int code = (unsigned int)num_chars;
+                if ( c.isGapState() == true )
                 {
-                    // we use the actual state
-                    ambiguous_char_matrix[node_index][patternIndex] = c.getState();
+                    // the gap code
                 }
-                else if ( c.isGapState() == false )
+                else if ( using_ambiguous_characters == true )
                 {
-                    // we use the index of the state
-                    char_matrix[node_index][patternIndex] = c.getStateIndex();
-                    if ( c.getStateIndex() >= this->num_chars )
+                    // we use the actual state, which gets its own code if it is ambiguous
+                    const RbBitSet &state = c.getState();
+                    if ( state.size() == num_chars && state.count() == 1 )
                     {
-                        throw RbException("Problem with state index in PhyloCTMC!");
+                        code = (unsigned int)state.find_first();
+                    }
+                    else
+                    {
+                        std::map<RbBitSet, unsigned int>::const_iterator it = ambiguous_state_codes.find( state );
+                        if ( it != ambiguous_state_codes.end() )
+                        {
+                            code = it->second;
+                        }
+                        else
+                        {
+                            code = (unsigned int)tip_state_sets.size();
+                            ambiguous_state_codes.insert( std::pair<RbBitSet, unsigned int>(state, code) );
+                            tip_state_sets.push_back( state );
+                        }
                     }
-                    
                 }
                 else
                 {
-                    // just to be safe
-                    char_matrix[node_index][patternIndex] = -1;
+                    // we use the index of the state
+                    code = (unsigned int)c.getStateIndex();
+                    if ( c.getStateIndex() >= this->num_chars )
+                    {
+                        throw RbException("Problem with state index in PhyloCTMC!");
+                    }
                 }
+                tip_states[node_index][patternIndex] = code;
 
             }
 
@@ -811,31 +921,32 @@ void RevBayesCore::AbstractPhyloCTMCSiteHomogeneous<charType>::compress( void )
     site_invariant.resize( pattern_block_size );
     invariant_site_index.clear();
     invariant_site_index.resize( pattern_block_size );
-    size_t length = char_matrix.size();
+    size_t length = tip_states.size();
         
     for (size_t i=0; i<pattern_block_size; ++i)
     {
         bool inv = true;
         size_t taxon_index = 0;
 
-        while ( taxon_index<(length-1) && gap_matrix[taxon_index][i] == true  )
+        while ( taxon_index<(length-1) && isGapTipState( tip_states[taxon_index][i] ) == true  )
         {
             ++taxon_index;
         }
 
         if ( using_ambiguous_characters == true )
         {
-            RbBitSet val = ambiguous_char_matrix[taxon_index][i];
+            RbBitSet val = tip_state_sets[ tip_states[taxon_index][i] ];
 
             for (; taxon_index<length; ++taxon_index)
             {
-                if ( gap_matrix[taxon_index][i] == false )
+                bool is_gap = isGapTipState( tip_states[taxon_index][i] );
+                if ( is_gap == false )
                 {
-                    val &= ambiguous_char_matrix[taxon_index][i];
+                    val &= tip_state_sets[ tip_states[taxon_index][i] ];
                 }
 
-                if (   ( allow_ambiguous_as_invariant == true  &&  val.count() == 0 && gap_matrix[taxon_index][i] == false)
-                    || ( allow_ambiguous_as_invariant == false && (val.count() == 0 || gap_matrix[taxon_index][i] == true ) ) )
+                if (   ( allow_ambiguous_as_invariant == true  &&  val.count() == 0 && is_gap == false)
+                    || ( allow_ambiguous_as_invariant == false && (val.count() == 0 || is_gap == true ) ) )
                 {
                     inv = false;
                     break;
@@ -852,13 +963,16 @@ void RevBayesCore::AbstractPhyloCTMCSiteHomogeneous<charType>::compress( void )
         }
         else
         {
-            unsigned long c = char_matrix[taxon_index][i];
+            // a site with only gaps has no valid state
+            unsigned long c = ( isGapTipState( tip_states[taxon_index][i] ) ? -1 : tip_states[taxon_index][i] );
             invariant_site_index[i].push_back(c);
 
             for (; taxon_index<length; ++taxon_index)
             {
-                if (   ( allow_ambiguous_as_invariant == true  &&  c != char_matrix[taxon_index][i] && gap_matrix[taxon_index][i] == false)
-                    || ( allow_ambiguous_as_invariant == false && (c != char_matrix[taxon_index][i] || gap_matrix[taxon_index][i] == true ) ) )
+                unsigned int code = tip_states[taxon_index][i];
+                bool is_gap = isGapTipState( code );
+                if (   ( allow_ambiguous_as_invariant == true  &&  c != code && is_gap == false)
+                    || ( allow_ambiguous_as_invariant == false && (c != code || is_gap == true ) ) )
                 {
                     inv = false;
                     break;
@@ -879,22 +993,44 @@ void RevBayesCore::AbstractPhyloCTMCSiteHomogeneous<charType>::compress( void )
 template<class charType>
 double RevBayesCore::AbstractPhyloCTMCSiteHomogeneous<charType>::computeLnProbability( void )
 {
-    // @todo: #thread
-    // This part should be done on several threads if possible
-    // That means we should probabily call this function as a job,
-    // where a job is defined as computing the lnProbability for a subset of the data (block)
     // Sebastian: this call is very slow; a lot of work happens in nextCycle()
     
+    // register with the likelihood scheduler, so that we are balanced against the other likelihoods and timed
+    // pattern block workers are part of our own computation
+    if ( registered_with_scheduler == false && num_pattern_threads == 1 )
+    {
+        std::string name = ( this->dag_node != NULL ? this->dag_node->getName() : "" );
+        LikelihoodScheduler::likelihoodSchedulerInstance().registerInstance( this, name, &computation_statistics );
+        registered_with_scheduler = true;
+    }
+    LikelihoodScheduler::ComputationTimer timer( registered_with_scheduler == true ? &computation_statistics : NULL );
 
     // we need to check here if we still are listining to this tree for change events
     // the tree could have been replaced without telling us
-    if ( tau->getValue().getTreeChangeEventHandler().isListening( this ) == false )
+    // pattern block workers are registered by their owner before they run concurrently
+    if ( num_pattern_threads == 1 && tau->getValue().getTreeChangeEventHandler().isListening( this ) == false )
     {
         tau->getValue().getTreeChangeEventHandler().addListener( this );
         dirty_nodes = std::vector<bool>(num_nodes, true);
         pmat_dirty_nodes = std::vector<bool>(num_nodes, true);
     }
 
+    // split the patterns among several threads if we can
+    size_t num_threads = ( compute_serially == true ? 1 : getNumberOfPatternBlockThreads() );
+    if ( num_threads > 1 && updateParametersForPatternBlocks() == true )
+    {
+        this->lnProb = computeLnProbabilityPatternBlocks( num_threads );
+
+        // set the ancestral states as stale
+        has_ancestral_states = false;
+
+        return this->lnProb;
+    }
+    else if ( compute_serially == false )
+    {
+        deletePatternBlockWorkers();
+    }
+
     // update transition probability matrices
     this->updateTransitionProbabilityMatrices();
 
@@ -903,6 +1039,11 @@ double RevBayesCore::AbstractPhyloCTMCSiteHomogeneous<charType>::computeLnProbab
     {
         partialLikelihoods = new double[2*activeLikelihoodOffset];
     }
+    else if ( partialLikelihoods == NULL )
+    {
+        // the pattern block workers owned the partial likelihoods so far
+        partialLikelihoods = new double[2*activeLikelihoodOffset];
+    }
 
     // compute the ln probability by recursively calling the probability calculation for each node
     const TopologyNode &root = tau->getValue().getRoot();
@@ -969,6 +1110,140 @@ double RevBayesCore::AbstractPhyloCTMCSiteHomogeneous<charType>::computeLnProbab
 }
 
 
+/**
+ * Compute the likelihood by letting each pattern block worker compute the likelihood of its block on the thread pool.
+ * We update the transition probability matrices only once here and copy the changed ones to the workers.
+ */
+template<class charType>
+double RevBayesCore::AbstractPhyloCTMCSiteHomogeneous<charType>::computeLnProbabilityPatternBlocks( size_t n )
+{
+
+    bool new_workers = ( pattern_block_workers.size() != n );
+    if ( new_workers == true )
+    {
+        createPatternBlockWorkers( n );
+    }
+
+    // update the transition probability matrices and remember which ones changed
+    std::vector<bool> updated_pmatrices = pmat_dirty_nodes;
+    this->updateTransitionProbabilityMatrices();
+
+    // make sure that the values derived from the parameters are up-to-date before the workers read them concurrently
+    std::vector<std::vector<double> > ff;
+    this->getRootFrequencies( ff );
+    this->getMixtureProbs();
+    this->getPInv();
+
+    TreeChangeEventHandler& tree_change_handler = tau->getValue().getTreeChangeEventHandler();
+    std::vector<double> block_ln_probs = std::vector<double>(pattern_block_workers.size(), 0.0);
+    std::vector< std::function<void(void)> > tasks;
+    for (size_t i = 0; i < pattern_block_workers.size(); ++i)
+    {
+        AbstractPhyloCTMCSiteHomogeneous<charType>* worker = pattern_block_workers[i];
+
+        // the tree could have been replaced without telling the worker
+        bool copy_all_pmatrices = new_workers;
+        if ( tree_change_handler.isListening( worker ) == false )
+        {
+            tree_change_handler.addListener( worker );
+            worker->dirty_nodes = std::vector<bool>(num_nodes, true);
+            copy_all_pmatrices = true;
+        }
+
+        if ( copy_all_pmatrices == true )
+        {
+            worker->pmatrices        = pmatrices;
+            worker->active_pmatrices = active_pmatrices;
+        }
+        else
+        {
+            for (size_t node_index = 0; node_index < num_nodes; ++node_index)
+            {
+                if ( updated_pmatrices[node_index] == true )
+                {
+                    size_t offset        = active_pmatrices[node_index] * activePmatrixOffset + node_index * pmatNodeOffset;
+                    size_t worker_offset = worker->active_pmatrices[node_index] * activePmatrixOffset + node_index * pmatNodeOffset;
+                    for (size_t mixture = 0; mixture < pmatNodeOffset; ++mixture)
+                    {
+                        worker->pmatrices[worker_offset + mixture] = pmatrices[offset + mixture];
+                    }
+                }
+            }
+        }
+        worker->pmat_dirty_nodes = std::vector<bool>(num_nodes, false);
+
+        tasks.push_back( [worker, &block_ln_probs, i]{ block_ln_probs[i] = worker->computeLnProbability(); } );
+    }
+
+    ThreadPool::threadPoolInstance().run( tasks );
+
+    // sum up in a fixed order so that the result does not depend on the scheduling of the threads
+    double ln_prob = 0.0;
+    for (size_t i = 0; i < block_ln_probs.size(); ++i)
+    {
+        ln_prob += block_ln_probs[i];
+    }
+
+    return reduceLnProbabilityOverProcesses( ln_prob );
+}
+
+
+/**
+ * Compute the transition probabilities of a branch, or copy them from the cache if we computed them before.
+ * The matrices of a rate matrix (i.e., a time-homogeneous rate generator) only depend on the scaled time,
+ * so they are cached by the rate matrix version, the index of the rate matrix, and rate * (start_age - end_age).
+ * Other rate generators (e.g., epochs) depend on the ages themselves and are never cached.
+ */
+template<class charType>
+void RevBayesCore::AbstractPhyloCTMCSiteHomogeneous<charType>::calculateTransitionProbabilities(const RateGenerator &rm, size_t matrix_index, double start_age, double end_age, double rate, TransitionProbabilityMatrix &P)
+{
+
+    if ( dynamic_cast<const RateMatrix*>( &rm ) == NULL )
+    {
+        rm.calculateTransitionProbabilities( start_age, end_age, rate, P );
+        return;
+    }
+
+    double t = rate * (start_age - end_age);
+    if ( transition_probability_cache.find( rate_matrix_version, matrix_index, t, P ) == false )
+    {
+        rm.calculateTransitionProbabilities( start_age, end_age, rate, P );
+        transition_probability_cache.insert( rate_matrix_version, matrix_index, t, P );
+    }
+
+}
+
+
+/**
+ * Compute the likelihood ourselves instead of using the pattern block workers.
+ * The workers do not update our own partial likelihoods, so methods that need the partial likelihoods of all patterns
+ * (e.g., ancestral states or site likelihoods) call this function first.
+ */
+template<class charType>
+void RevBayesCore::AbstractPhyloCTMCSiteHomogeneous<charType>::computeLnProbabilitySerially( void ) const
+{
+
+    if ( pattern_block_workers.empty() == false )
+    {
+        // our own partial likelihoods are stale
+        dirty_nodes = std::vector<bool>(num_nodes, true);
+    }
+
+    compute_serially = true;
+    try
+    {
+        const_cast<AbstractPhyloCTMCSiteHomogeneous<charType> *>( this )->computeLnProbability();
+    }
+    catch (...)
+    {
+        compute_serially = false;
+        throw;
+    }
+    compute_serially = false;
+
+}
+
+
 template<class charType>
 void RevBayesCore::AbstractPhyloCTMCSiteHomogeneous<charType>::computeMarginalNodeLikelihood( size_t node_index, size_t parentnode_index )
 {
@@ -1104,6 +1379,144 @@ void RevBayesCore::AbstractPhyloCTMCSiteHomogeneous<charType>::computeMarginalRo
 }
 
 
+/**
+ * Fill the lookup table of the tip likelihoods for each tip state code, i.e., the probability
+ * of the observed (possibly ambiguous) states at the end of the branch given each starting state.
+ * Single states pick a column of the transition probability matrix and gaps could have been any state.
+ * The table has one row of num_chars likelihoods per code.
+ */
+template<class charType>
+void RevBayesCore::AbstractPhyloCTMCSiteHomogeneous<charType>::computeTipStateLikelihoods( const double *tp )
+{
+
+    size_t num_codes = tip_state_sets.size();
+    tip_state_likelihoods.resize( num_codes * num_chars );
+    double* p_code = tip_state_likelihoods.data();
+
+    for (size_t code = 0; code < num_codes; ++code)
+    {
+
+        if ( code < num_chars )
+        {
+            // a single observed state
+            for (size_t c1 = 0; c1 < num_chars; ++c1)
+            {
+                p_code[c1] = tp[c1*num_chars+code];
+            }
+        }
+        else if ( isGapTipState( code ) == true )
+        {
+            // since this is a gap we need to assume that the actual state could have been any state
+            for (size_t c1 = 0; c1 < num_chars; ++c1)
+            {
+                p_code[c1] = 1.0;
+            }
+        }
+        else
+        {
+            // sum over all observed states of this ambiguous state
+            const RbBitSet &val = tip_state_sets[code];
+            size_t n = std::min( val.size(), num_chars );
+            for (size_t c1 = 0; c1 < num_chars; ++c1)
+            {
+                const double* d = tp + c1*num_chars;
+                double tmp = 0.0;
+                for (size_t i = 0; i < n; ++i)
+                {
+                    if ( val.test(i) == true )
+                    {
+                        tmp += d[i];
+                    }
+                }
+                p_code[c1] = tmp;
+            }
+        }
+
+        p_code += num_chars;
+    }
+
+}
+
+
+/**
+ * Evaluate all parameters before the pattern block workers read them concurrently.
+ * Reading a deterministic parameter may call its function, so every lazy parameter is updated here on the calling thread.
+ * Parameters that update on every access (e.g., Rev member functions) cannot be read concurrently,
+ * in which case we return false and the likelihood is computed serially.
+ */
+template<class charType>
+bool RevBayesCore::AbstractPhyloCTMCSiteHomogeneous<charType>::updateParametersForPatternBlocks( void ) const
+{
+
+    tau->getValue();
+    if ( homogeneous_clock_rate != NULL )       homogeneous_clock_rate->getValue();
+    if ( heterogeneous_clock_rates != NULL )    heterogeneous_clock_rates->getValue();
+    if ( homogeneous_rate_matrix != NULL )      homogeneous_rate_matrix->getValue();
+    if ( heterogeneous_rate_matrices != NULL )  heterogeneous_rate_matrices->getValue();
+    if ( root_frequencies != NULL )             root_frequencies->getValue();
+    if ( site_rates != NULL )                   site_rates->getValue();
+    if ( site_matrix_probs != NULL )            site_matrix_probs->getValue();
+    if ( site_rates_probs != NULL )             site_rates_probs->getValue();
+    if ( p_inv != NULL )                        p_inv->getValue();
+
+    const std::vector<const DagNode*>& parameters = this->getParameters();
+    for (size_t i = 0; i < parameters.size(); ++i)
+    {
+        if ( parameters[i]->isUpdatedOnAccess() == true )
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+
+/**
+ * Create the pattern block workers. Each worker is a clone of this distribution that only holds the patterns of its thread block.
+ * The workers own the partial likelihoods during MCMC, so we free our own.
+ */
+template<class charType>
+void RevBayesCore::AbstractPhyloCTMCSiteHomogeneous<charType>::createPatternBlockWorkers( size_t n )
+{
+
+    deletePatternBlockWorkers();
+
+    delete [] partialLikelihoods;
+    partialLikelihoods = NULL;
+
+    for (size_t i = 0; i < n; ++i)
+    {
+        AbstractPhyloCTMCSiteHomogeneous<charType>* worker = this->clone();
+        worker->setPatternBlockThread( i, n );
+        worker->dirty_nodes = std::vector<bool>(num_nodes, true);
+        pattern_block_workers.push_back( worker );
+    }
+
+}
+
+
+template<class charType>
+void RevBayesCore::AbstractPhyloCTMCSiteHomogeneous<charType>::deletePatternBlockWorkers( void )
+{
+
+    if ( pattern_block_workers.empty() == true )
+    {
+        return;
+    }
+
+    for (size_t i = 0; i < pattern_block_workers.size(); ++i)
+    {
+        delete pattern_block_workers[i];
+    }
+    pattern_block_workers.clear();
+
+    // our own partial likelihoods are stale (or not even allocated anymore)
+    dirty_nodes = std::vector<bool>(num_nodes, true);
+
+}
+
+
 /**
  * Draw a vector of ancestral states from the marginal distribution (non-conditional of the other ancestral states).
  * Here we assume that the marginal likelihoods have been updated.
@@ -1210,6 +1623,12 @@ void RevBayesCore::AbstractPhyloCTMCSiteHomogeneous<charType>::drawJointConditio
 //		return;
 //    }
     
+    // the pattern block workers do not update our own partial likelihoods
+    if ( pattern_block_workers.empty() == false )
+    {
+        computeLnProbabilitySerially();
+    }
+
     RandomNumberGenerator* rng = GLOBAL_RNG;
 
     // get working variables
@@ -1332,6 +1751,12 @@ template<class charType>
 void RevBayesCore::AbstractPhyloCTMCSiteHomogeneous<charType>::drawSiteMixtureAllocations()
 {
 
+    // the pattern block workers do not update our own partial likelihoods
+    if ( pattern_block_workers.empty() == false )
+    {
+        computeLnProbabilitySerially();
+    }
+
     RandomNumberGenerator* rng = GLOBAL_RNG;
 
     // get working variables
@@ -1658,7 +2083,7 @@ void RevBayesCore::AbstractPhyloCTMCSiteHomogeneous<charType>::executeMethod(con
         }
 
         // make sure the likelihoods are updated
-        const_cast<AbstractPhyloCTMCSiteHomogeneous<charType> *>( this )->computeLnProbability();
+        computeLnProbabilitySerially();
 
         // get the per site likelihood
         RbVector<double> tmp = RbVector<double>(num_patterns, 0.0);
@@ -1709,7 +2134,7 @@ void RevBayesCore::AbstractPhyloCTMCSiteHomogeneous<charType>::executeMethod(con
         }
 
         // make sure the likelihoods are updated
-        const_cast<AbstractPhyloCTMCSiteHomogeneous<charType> *>( this )->computeLnProbability();
+        computeLnProbabilitySerially();
 
         // get the site rates
         std::vector<double> r;
@@ -1837,7 +2262,7 @@ void RevBayesCore::AbstractPhyloCTMCSiteHomogeneous<charType>::executeMethod(con
         }
 
         // make sure the likelihoods are updated
-        const_cast<AbstractPhyloCTMCSiteHomogeneous<charType> *>( this )->computeLnProbability();
+        computeLnProbabilitySerially();
 
         // get the per site rate likelihood
         size_t num_site_rates_withInv = num_site_rates;
@@ -1891,7 +2316,7 @@ void RevBayesCore::AbstractPhyloCTMCSiteHomogeneous<charType>::executeMethod(con
         }
 
         // make sure the likelihoods are updated
-        const_cast<AbstractPhyloCTMCSiteHomogeneous<charType> *>( this )->computeLnProbability();
+        computeLnProbabilitySerially();
 
         // get the per site rate likelihood
         size_t num_site_mixture_withInv = num_site_mixtures;
@@ -2302,6 +2727,56 @@ std::vector<double> RevBayesCore::AbstractPhyloCTMCSiteHomogeneous<charType>::ge
 }
 
 
+/**
+ * Get the number of threads among which we split our patterns.
+ * Each thread should get a block of patterns that is large enough to be worth the synchronization.
+ */
+template<class charType>
+size_t RevBayesCore::AbstractPhyloCTMCSiteHomogeneous<charType>::getNumberOfPatternBlockThreads( void ) const
+{
+
+    // pattern block workers do not split their patterns any further
+    if ( num_pattern_threads > 1 || supportsPatternBlockThreads() == false )
+    {
+        return 1;
+    }
+
+    const size_t min_patterns_per_thread = 128;
+    size_t n = RbSettings::userSettings().getNumThreads();
+    n = std::min( n, pattern_block_size / min_patterns_per_thread );
+
+    return std::max( n, size_t(1) );
+}
+
+
+/**
+ * Get the number of transition probability matrices we keep in our cache.
+ * The cache needs to hold the matrices of every branch and mixture, once for the current and once for the stored rate matrices,
+ * so that a rejected move finds its old matrices again. We never use more than about 2MB per distribution though,
+ * because there may be many of us (e.g., one per locus).
+ */
+template<class charType>
+size_t RevBayesCore::AbstractPhyloCTMCSiteHomogeneous<charType>::getTransitionProbabilityCacheCapacity( void ) const
+{
+
+    size_t num_branches = ( num_nodes > 1 ? num_nodes - 1 : 1 );
+    size_t max_capacity = size_t(1 << 18) / (num_chars * num_chars);
+
+    return std::max( size_t(16), std::min( max_capacity, 2 * num_branches * num_site_mixtures ) );
+}
+
+
+/**
+ * Get the cost of computing our likelihood for the likelihood scheduler, which is the size of our partial likelihoods.
+ */
+template<class charType>
+double RevBayesCore::AbstractPhyloCTMCSiteHomogeneous<charType>::getComputationCost( void ) const
+{
+
+    return double(pattern_block_size) * num_nodes * num_site_mixtures * num_chars;
+}
+
+
 template<class charType>
 double RevBayesCore::AbstractPhyloCTMCSiteHomogeneous<charType>::getPInv( void ) const
 {
@@ -2318,6 +2793,13 @@ double RevBayesCore::AbstractPhyloCTMCSiteHomogeneous<charType>::getPInv( void )
 }
 
 
+template<class charType>
+bool RevBayesCore::AbstractPhyloCTMCSiteHomogeneous<charType>::isGapTipState( size_t code ) const
+{
+    return code == num_chars;
+}
+
+
 template<class charType>
 void RevBayesCore::AbstractPhyloCTMCSiteHomogeneous<charType>::keepSpecialization( const DagNode* affecter )
 {
@@ -2349,6 +2831,11 @@ void RevBayesCore::AbstractPhyloCTMCSiteHomogeneous<charType>::keepSpecializatio
         (*it) = false;
     }
 
+    for (size_t i = 0; i < pattern_block_workers.size(); ++i)
+    {
+        pattern_block_workers[i]->keepSpecialization( affecter );
+    }
+
 }
 
 
@@ -2407,6 +2894,63 @@ void RevBayesCore::AbstractPhyloCTMCSiteHomogeneous<charType>::recursiveMarginal
 
 
 
+/**
+ * Sum the log-likelihood of this process with the log-likelihoods of all other processes.
+ * All processes receive the combined log-likelihood.
+ */
+template<class charType>
+double RevBayesCore::AbstractPhyloCTMCSiteHomogeneous<charType>::reduceLnProbabilityOverProcesses( double ln_prob ) const
+{
+
+    double sum_partial_probs = ln_prob;
+
+#ifdef RB_MPI
+
+    // we only need to send message if there is more than one process
+    if ( num_processes > 1 )
+    {
+
+        // send the likelihood from the helpers to the master
+        if ( process_active == false )
+        {
+            // send from the workers the log-likelihood to the master
+            MPI_Send(&sum_partial_probs, 1, MPI_DOUBLE, active_PID, 0, MPI_COMM_WORLD);
+        }
+
+        // receive the likelihoods from the helpers
+        if ( process_active == true )
+        {
+            for (size_t i=active_PID+1; i<active_PID+num_processes; ++i)
+            {
+                double tmp = 0;
+                MPI_Status status;
+                MPI_Recv(&tmp, 1, MPI_DOUBLE, int(i), 0, MPI_COMM_WORLD, &status);
+                sum_partial_probs += tmp;
+            }
+        }
+
+        // now send back the combined likelihood to the helpers
+        if ( process_active == true )
+        {
+            for (size_t i=active_PID+1; i<active_PID+num_processes; ++i)
+            {
+                MPI_Send(&sum_partial_probs, 1, MPI_DOUBLE, int(i), 0, MPI_COMM_WORLD);
+            }
+        }
+        else
+        {
+            MPI_Status status;
+            MPI_Recv(&sum_partial_probs, 1, MPI_DOUBLE, active_PID, 0, MPI_COMM_WORLD, &status);
+        }
+
+    }
+
+#endif
+
+    return sum_partial_probs;
+}
+
+
 template<class charType>
 void RevBayesCore::AbstractPhyloCTMCSiteHomogeneous<charType>::redrawValue( void )
 {
@@ -2592,6 +3136,13 @@ void RevBayesCore::AbstractPhyloCTMCSiteHomogeneous<charType>::reInitialized( vo
 template<class charType>
 void RevBayesCore::AbstractPhyloCTMCSiteHomogeneous<charType>::resizeLikelihoodVectors( void )
 {
+
+    // the pattern block workers are created again when we need them
+    deletePatternBlockWorkers();
+
+    // we register again with the likelihood scheduler, because our name may have changed
+    registered_with_scheduler = false;
+
     if (this->branch_heterogeneous_substitution_matrices == false)
     {
         this->num_site_mixtures = this->num_site_rates * this->num_matrices;
@@ -2603,6 +3154,10 @@ void RevBayesCore::AbstractPhyloCTMCSiteHomogeneous<charType>::resizeLikelihoodV
 
     // set the offsets for easier iteration through the likelihood vector
     siteOffset                  =  num_chars;
+    if ( RbSettings::userSettings().getPadStates() == true && supportsStatePadding() == true )
+    {
+        siteOffset              =  PhyloCTMCKernels::getPaddedNumberOfStates( num_chars );
+    }
     mixtureOffset               =  pattern_block_size*siteOffset;
     nodeOffset                  =  num_site_mixtures*mixtureOffset;
     activeLikelihoodOffset      =  num_nodes*nodeOffset;
@@ -2644,6 +3199,7 @@ void RevBayesCore::AbstractPhyloCTMCSiteHomogeneous<charType>::resizeLikelihoodV
     activePmatrixOffset         =  num_nodes * num_site_mixtures;
     pmatNodeOffset              =  num_site_mixtures;
     pmatrices                   =  std::vector<TransitionProbabilityMatrix>(activePmatrixOffset * 2, TransitionProbabilityMatrix(num_chars));
+    transition_probability_cache.setCapacity( getTransitionProbabilityCacheCapacity() );
 
     transition_prob_matrices = std::vector<TransitionProbabilityMatrix>(num_site_mixtures, TransitionProbabilityMatrix(num_chars) );
 
@@ -2660,6 +3216,9 @@ void RevBayesCore::AbstractPhyloCTMCSiteHomogeneous<charType>::restoreSpecializa
     // reset the ln probability
     this->lnProb = this->storedLnProb;
 
+    // the rate matrices have their old values again, so the cached matrices of the old version are valid again
+    rate_matrix_version = stored_rate_matrix_version;
+
     // reset the flags
     for (std::vector<bool>::iterator it = dirty_nodes.begin(); it != dirty_nodes.end(); ++it)
     {
@@ -2697,6 +3256,11 @@ void RevBayesCore::AbstractPhyloCTMCSiteHomogeneous<charType>::restoreSpecializa
         }
     }
 
+    for (size_t i = 0; i < pattern_block_workers.size(); ++i)
+    {
+        pattern_block_workers[i]->restoreSpecialization( affecter );
+    }
+
 }
 
 template<class charType>
@@ -2912,6 +3476,21 @@ void RevBayesCore::AbstractPhyloCTMCSiteHomogeneous<charType>::setActivePIDSpeci
 }
 
 
+/**
+ * Make this distribution a pattern block worker that only computes the i-th of n thread blocks of the patterns of this process.
+ */
+template <class charType>
+void RevBayesCore::AbstractPhyloCTMCSiteHomogeneous<charType>::setPatternBlockThread(size_t i, size_t n)
+{
+
+    pattern_thread_index = i;
+    num_pattern_threads  = n;
+
+    // we need to recompress the data
+    this->compress();
+}
+
+
 template<class charType>
 void RevBayesCore::AbstractPhyloCTMCSiteHomogeneous<charType>::setValue(AbstractHomologousDiscreteCharacterData *v, bool force)
 {
@@ -3116,6 +3695,9 @@ template<class charType>
 void RevBayesCore::AbstractPhyloCTMCSiteHomogeneous<charType>::setMcmcMode(bool tf)
 {
 
+    // the pattern block workers are created again when we need them
+    deletePatternBlockWorkers();
+
     // free old memory
     if ( in_mcmc_mode == true )
     {
@@ -3179,6 +3761,7 @@ void RevBayesCore::AbstractPhyloCTMCSiteHomogeneous<charType>::setRateMatrix(con
     // set the value
     homogeneous_rate_matrix = rm;
     num_matrices = 1;
+    rate_matrix_version = TransitionProbabilityMatrixCache::nextVersion();
 
     this->resizeLikelihoodVectors();
 
@@ -3220,6 +3803,7 @@ void RevBayesCore::AbstractPhyloCTMCSiteHomogeneous<charType>::setRateMatrix(con
     // set the value
     heterogeneous_rate_matrices = rm;
     num_matrices = rm == NULL ? 1 : rm->getValue().size();
+    rate_matrix_version = TransitionProbabilityMatrixCache::nextVersion();
 
     this->resizeLikelihoodVectors();
 
@@ -3902,50 +4486,35 @@ double RevBayesCore::AbstractPhyloCTMCSiteHomogeneous<charType>::sumRootLikeliho
         sum_partial_probs += site_likelihoods[site];
     }
 
-#ifdef RB_MPI
-
-    // we only need to send message if there is more than one process
-    if ( num_processes > 1 )
+    // pattern block workers leave the sum over processes to the distribution that owns them
+    if ( num_pattern_threads > 1 )
     {
+        return sum_partial_probs;
+    }
 
-        // send the likelihood from the helpers to the master
-        if ( process_active == false )
-        {
-            // send from the workers the log-likelihood to the master
-            MPI_Send(&sum_partial_probs, 1, MPI_DOUBLE, active_PID, 0, MPI_COMM_WORLD);
-        }
-
-        // receive the likelihoods from the helpers
-        if ( process_active == true )
-        {
-            for (size_t i=active_PID+1; i<active_PID+num_processes; ++i)
-            {
-                double tmp = 0;
-                MPI_Status status;
-                MPI_Recv(&tmp, 1, MPI_DOUBLE, int(i), 0, MPI_COMM_WORLD, &status);
-                sum_partial_probs += tmp;
-            }
-        }
+    return reduceLnProbabilityOverProcesses( sum_partial_probs );
+}
 
-        // now send back the combined likelihood to the helpers
-        if ( process_active == true )
-        {
-            for (size_t i=active_PID+1; i<active_PID+num_processes; ++i)
-            {
-                MPI_Send(&sum_partial_probs, 1, MPI_DOUBLE, int(i), 0, MPI_COMM_WORLD);
-            }
-        }
-        else
-        {
-            MPI_Status status;
-            MPI_Recv(&sum_partial_probs, 1, MPI_DOUBLE, active_PID, 0, MPI_COMM_WORLD, &status);
-        }
 
-    }
+/**
+ * Derived classes that need all patterns at once (e.g., to compute a correction over all patterns)
+ * have to overwrite this function and return false.
+ */
+template<class charType>
+bool RevBayesCore::AbstractPhyloCTMCSiteHomogeneous<charType>::supportsPatternBlockThreads( void ) const
+{
+    return true;
+}
 
-#endif
 
-    return sum_partial_probs;
+/**
+ * Derived classes whose likelihood functions iterate over the sites using siteOffset
+ * (and never assume that it equals num_chars) can overwrite this function and return true.
+ */
+template<class charType>
+bool RevBayesCore::AbstractPhyloCTMCSiteHomogeneous<charType>::supportsStatePadding( void ) const
+{
+    return false;
 }
 
 
@@ -3957,6 +4526,11 @@ void RevBayesCore::AbstractPhyloCTMCSiteHomogeneous<charType>::swap_taxon_name_2
     size_t index2 = taxon_name_2_tip_index_map[tip2];
     taxon_name_2_tip_index_map[tip1] = index2;
     taxon_name_2_tip_index_map[tip2] = index1;
+
+    for (size_t i = 0; i < pattern_block_workers.size(); ++i)
+    {
+        pattern_block_workers[i]->swap_taxon_name_2_tip_index( tip1, tip2 );
+    }
 }
 
 /** Swap a parameter of the distribution */
@@ -3964,6 +4538,10 @@ template<class charType>
 void RevBayesCore::AbstractPhyloCTMCSiteHomogeneous<charType>::swapParameterInternal(const DagNode *oldP, const DagNode *newP)
 {
 
+    // the pattern block workers still use the old parameter
+    deletePatternBlockWorkers();
+    rate_matrix_version = TransitionProbabilityMatrixCache::nextVersion();
+
     if (oldP == homogeneous_clock_rate)
     {
         homogeneous_clock_rate = static_cast<const TypedDagNode< double >* >( newP );
@@ -4017,10 +4595,24 @@ template<class charType>
 void RevBayesCore::AbstractPhyloCTMCSiteHomogeneous<charType>::touchSpecialization( const DagNode* affecter, bool touch_all )
 {
 
+    // the pattern block workers need to flag the same nodes as we do
+    for (size_t i = 0; i < pattern_block_workers.size(); ++i)
+    {
+        pattern_block_workers[i]->touchSpecialization( affecter, touch_all );
+    }
+
     if ( touched == false )
     {
         touched = true;
         this->storedLnProb = this->lnProb;
+        stored_rate_matrix_version = rate_matrix_version;
+    }
+
+    // any change that is not known to leave the rate matrices unchanged gives them a new version
+    if ( affecter != tau && affecter != homogeneous_clock_rate && affecter != heterogeneous_clock_rates && affecter != root_frequencies &&
+         affecter != site_rates && affecter != site_rates_probs && affecter != site_matrix_probs && affecter != p_inv )
+    {
+        rate_matrix_version = TransitionProbabilityMatrixCache::nextVersion();
     }
 
 
@@ -4124,6 +4716,12 @@ template<class charType>
 void RevBayesCore::AbstractPhyloCTMCSiteHomogeneous<charType>::updateMarginalNodeLikelihoods( void )
 {
 
+    // the pattern block workers do not update our own partial likelihoods
+    if ( pattern_block_workers.empty() == false )
+    {
+        computeLnProbabilitySerially();
+    }
+
     // calculate the root marginal likelihood, then start the recursive call down the tree
     this->computeMarginalRootLikelihood();
 
@@ -4206,7 +4804,7 @@ void RevBayesCore::AbstractPhyloCTMCSiteHomogeneous<charType>::updateTransitionP
                     r = this->site_rates->getValue()[j];
                 }
 
-                rm->calculateTransitionProbabilities( start_age, end_age,  rate * r, this->transition_prob_matrices[j*this->num_matrices + matrix] );
+                calculateTransitionProbabilities( *rm, matrix, start_age, end_age,  rate * r, this->transition_prob_matrices[j*this->num_matrices + matrix] );
             }
         }
     }
@@ -4227,6 +4825,9 @@ void RevBayesCore::AbstractPhyloCTMCSiteHomogeneous<charType>::updateTransitionP
             rm = &jc;
         }
 
+        // a single rate matrix is shared by all branches
+        size_t matrix_index = ( this->heterogeneous_rate_matrices != NULL ? node_idx : 0 );
+
         for (size_t j = 0; j < this->num_site_rates; ++j)
         {
             double r = 1.0;
@@ -4235,7 +4836,7 @@ void RevBayesCore::AbstractPhyloCTMCSiteHomogeneous<charType>::updateTransitionP
                 r = this->site_rates->getValue()[j];
             }
 
-            rm->calculateTransitionProbabilities( start_age, end_age,  rate * r, this->transition_prob_matrices[j] );
+            calculateTransitionProbabilities( *rm, matrix_index, start_age, end_age,  rate * r, this->transition_prob_matrices[j] );
         }
     }
 }
@@ -4302,7 +4903,7 @@ void RevBayesCore::AbstractPhyloCTMCSiteHomogeneous<charType>::updateTransitionP
                     r = this->site_rates->getValue()[j];
                 }
                 
-                rm->calculateTransitionProbabilities( start_age, end_age,  rate * r, this->pmatrices[pmat_offset + j * this->num_matrices + matrix] );
+                calculateTransitionProbabilities( *rm, matrix, start_age, end_age,  rate * r, this->pmatrices[pmat_offset + j * this->num_matrices + matrix] );
             }
         }
     }
@@ -4317,6 +4918,9 @@ void RevBayesCore::AbstractPhyloCTMCSiteHomogeneous<charType>::updateTransitionP
             rm = &this->homogeneous_rate_matrix->getValue();
         }
         
+        // a single rate matrix is shared by all branches
+        size_t matrix_index = ( this->heterogeneous_rate_matrices != NULL ? node_idx : 0 );
+        
         for (size_t j = 0; j < this->num_site_rates; ++j)
         {
             double r = 1.0;
@@ -4325,7 +4929,7 @@ void RevBayesCore::AbstractPhyloCTMCSiteHomogeneous<charType>::updateTransitionP
                 r = this->site_rates->getValue()[j];
             }
             
-            rm->calculateTransitionProbabilities( start_age, end_age,  rate * r, this->pmatrices[pmat_offset + j] );
+            calculateTransitionProbabilities( *rm, matrix_index, start_age, end_age,  rate * r, this->pmatrices[pmat_offset + j] );
         }
     }
 }
@@ -60,6 +60,7 @@ namespace RevBayesCore {
         virtual std::vector< std::vector< double > >*       sumMarginalLikelihoods(size_t node_index);
         
         virtual void                                        swapParameterInternal(const DagNode *oldP, const DagNode *newP);            //!< Swap a parameter
+        virtual bool                                        supportsPatternBlockThreads(void) const;                                    //!< The cladogenetic partials are not split into pattern blocks
 
         // the likelihoods
         double*                                             cladoPartialLikelihoods;
@@ -640,9 +641,7 @@ void RevBayesCore::PhyloCTMCClado<charType>::computeTipLikelihood(const Topology
     
     // get the current correct tip index in case the whole tree change (after performing an empiricalTree Proposal)
     size_t data_tip_index = this->taxon_name_2_tip_index_map[ node.getName() ];
-    const std::vector<bool> &gap_node = this->gap_matrix[data_tip_index];
-    const std::vector<unsigned long> &char_node = this->char_matrix[data_tip_index];
-    const std::vector<RbBitSet> &amb_char_node = this->ambiguous_char_matrix[data_tip_index];
+    const std::vector<unsigned int> &tip_states_node = this->tip_states[data_tip_index];
 
     // compute the transition probabilities
     this->updateTransitionProbabilities( node_index );
@@ -655,97 +654,63 @@ void RevBayesCore::PhyloCTMCClado<charType>::computeTipLikelihood(const Topology
         // the transition probability matrix for this mixture category
         const double*                       tp_begin    = this->transition_prob_matrices[mixture].theMatrix;
 
+        // compute the tip likelihoods of each state code once for this branch
+        if ( this->using_weighted_characters == false )
+        {
+            this->computeTipStateLikelihoods( tp_begin );
+        }
+
         // get the pointer to the likelihoods for this site and mixture category
         double*     p_site_mixture      = p_mixture;
         
         // iterate over all sites
         for (size_t site = 0; site != this->pattern_block_size; ++site)
         {
-            // is this site a gap?
-            if ( gap_node[site] )
+            if ( this->using_weighted_characters == false )
+            {
+                // look up the likelihoods of the observed (possibly ambiguous) state
+                const double* p_state = this->tip_state_likelihoods.data() + tip_states_node[site]*this->num_chars;
+                for (size_t c1 = 0; c1 < this->num_chars; ++c1)
+                {
+                    p_site_mixture[c1] = p_state[c1];
+                }
+            }
+            else if ( this->isGapTipState( tip_states_node[site] ) == true )
             {
                 // since this is a gap we need to assume that the actual state could have been any state
-                
-                // iterate over all initial states for the transitions
                 for (size_t c1 = 0; c1 < this->num_chars; ++c1)
                 {
-                    
-                    // store the likelihood
                     p_site_mixture[c1] = 1.0;
-                    
                 }
             }
-            else // we have observed a character
+            else // we have observed a weighted character
             {
-                
+                // note, the observed state could be ambiguous!
+                const RbBitSet &val = this->tip_state_sets[ tip_states_node[site] ];
+                std::vector< double > weights = this->value->getCharacter(node_index, site).getWeights();
+
                 // iterate over all possible initial states
                 for (size_t c1 = 0; c1 < this->num_chars; ++c1)
                 {
+                    // get the pointer to the transition probabilities for the terminal states
+                    const double* d  = tp_begin+(this->num_chars*c1);
                     
-                    if ( this->using_ambiguous_characters == true && this->using_weighted_characters == false)
+                    double tmp = 0.0;
+                    for ( size_t i=0; i<val.size(); ++i )
                     {
-                        // compute the likelihood that we had a transition from state c1 to the observed state org_val
-                        // note, the observed state could be ambiguous!
-                        const RbBitSet &val = amb_char_node[site];
-                        
-                        // get the pointer to the transition probabilities for the terminal states
-                        const double* d  = tp_begin+(this->num_chars*c1);
-                        
-                        double tmp = 0.0;
-                        
-                        for ( size_t i=0; i<val.size(); ++i )
+                        // check whether we observed this state
+                        if ( val.test(i) == true )
                         {
-                            // check whether we observed this state
-                            if ( val.test(i) == true )
-                            {
-                                // add the probability
-                                tmp += *d;
-                            }
-                            
-                            // increment the pointer to the next transition probability
-                            ++d;
-                        } // end-while over all observed states for this character
+                            // add the probability
+                            tmp += *d * weights[i] ;
+                        }
                         
-                        // store the likelihood
-                        p_site_mixture[c1] = tmp;
-                        
-                    }
-                    else if ( this->using_weighted_characters == true )
-                    {
-                        // compute the likelihood that we had a transition from state c1 to the observed state org_val
-                        // note, the observed state could be ambiguous!
-                        const RbBitSet &val = amb_char_node[site];
-                        
-                        // get the pointer to the transition probabilities for the terminal states
-                        const double* d  = tp_begin+(this->num_chars*c1);
-                        
-                        double tmp = 0.0;
-                        std::vector< double > weights = this->value->getCharacter(node_index, site).getWeights();
-                        for ( size_t i=0; i<val.size(); ++i )
-                        {
-                            // check whether we observed this state
-                            if ( val.test(i) == true )
-                            {
-                                // add the probability
-                                tmp += *d * weights[i] ;
-                            }
-                            
-                            // increment the pointer to the next transition probability
-                            ++d;
-                        } // end-while over all observed states for this character
-                        
-                        // store the likelihood
-                        p_site_mixture[c1] = tmp;
-                        
-                    }
-                    else // no ambiguous characters in use
-                    {
-                        unsigned long org_val = char_node[site];
-                        
-                        // store the likelihood
-                        p_site_mixture[c1] = tp_begin[c1*this->num_chars+org_val];
-                        
-                    }
+                        // increment the pointer to the next transition probability
+                        ++d;
+                    } // end-while over all observed states for this character
+                    
+                    // store the likelihood
+                    p_site_mixture[c1] = tmp;
                     
                 } // end-for over all possible initial character for the branch
                 
@@ -1415,6 +1380,13 @@ std::vector< std::vector<double> >* RevBayesCore::PhyloCTMCClado<charType>::sumM
 }
 
 
+template<class charType>
+bool RevBayesCore::PhyloCTMCClado<charType>::supportsPatternBlockThreads( void ) const
+{
+    return false;
+}
+
+
 template<class charType>
 double RevBayesCore::PhyloCTMCClado<charType>::sumRootLikelihood( void )
 {
@@ -1632,7 +1604,7 @@ void RevBayesCore::PhyloCTMCClado<charType>::updateTransitionProbabilities(size_
         // get history information
         const CharacterHistory &tree_history = dist->getCharacterHistory();
         const BranchHistory &branch_history = tree_history[node_idx];
-        const std::multiset<CharacterEvent*,CharacterEventCompare>& events = branch_history.getHistory();
+        const CharacterEventList& events = branch_history.getHistory();
         
         if (events.size() == 0)
         {
@@ -1667,7 +1639,7 @@ void RevBayesCore::PhyloCTMCClado<charType>::updateTransitionProbabilities(size_
             double dt = 0.0;
             double event_age = startAge;
             bool first_event = true;
-            std::multiset<CharacterEvent*,CharacterEventCompare>::reverse_iterator it;
+            CharacterEventList::const_reverse_iterator it;
             for (it = events.rbegin(); it != events.rend(); it++)
             {
                 t += dt;
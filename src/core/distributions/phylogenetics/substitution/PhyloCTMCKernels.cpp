@@ -0,0 +1,628 @@
+#include "PhyloCTMCKernels.h"
+
+#include <algorithm>
+
+#if ( defined (__x86_64__) || defined (__i386__) ) && ( defined (__GNUC__) || defined (__clang__) ) && !defined (RB_ARM)
+#define RB_X86_KERNELS
+#include <immintrin.h>
+#define RB_TARGET_SSE2      __attribute__((target("sse2")))
+#define RB_TARGET_AVX2      __attribute__((target("avx2,fma")))
+#define RB_TARGET_AVX512    __attribute__((target("avx512f")))
+#endif
+
+using namespace RevBayesCore;
+
+
+namespace {
+
+    // the largest number of states handled by the vector kernels (codon models have 61 states)
+    const size_t MAX_STATES = 64;
+
+    // the largest number of vectors of output states accumulated at the same time (we have at least 16 vector registers)
+    const size_t MAX_GROUP = 8;
+
+
+    PhyloCTMCKernels::SimdLevel detectSimdLevel( void )
+    {
+
+#if defined (RB_X86_KERNELS)
+        __builtin_cpu_init();
+        if ( __builtin_cpu_supports("avx512f") )
+        {
+            return PhyloCTMCKernels::SIMD_AVX512;
+        }
+        if ( __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma") )
+        {
+            return PhyloCTMCKernels::SIMD_AVX2;
+        }
+        if ( __builtin_cpu_supports("sse2") )
+        {
+            return PhyloCTMCKernels::SIMD_SSE2;
+        }
+#endif
+
+        return PhyloCTMCKernels::SIMD_SCALAR;
+    }
+
+
+    /**
+     * The number of doubles per vector that we use for this number of states.
+     * AVX-512 vectors would be half empty for nucleotides, so we use AVX2 for them.
+     */
+    size_t getVectorWidth(PhyloCTMCKernels::SimdLevel level, size_t num_chars)
+    {
+
+        if ( num_chars > MAX_STATES )
+        {
+            return 1;
+        }
+
+        switch ( level )
+        {
+            case PhyloCTMCKernels::SIMD_AVX512:     return ( num_chars > 4 ? 8 : 4 );
+            case PhyloCTMCKernels::SIMD_AVX2:       return 4;
+            case PhyloCTMCKernels::SIMD_SSE2:       return 2;
+            default:                                return 1;
+        }
+
+    }
+
+
+    /**
+     * Plain scalar kernel for nodes with any number of children.
+     * This is used if there are no vector units or too many states.
+     */
+    void computeInternalNodeScalar(const double *tp, const double* const* children, size_t num_children, double *p_node, size_t num_sites, size_t num_chars, size_t site_offset)
+    {
+
+        for (size_t site = 0; site < num_sites; ++site)
+        {
+            size_t offset = site*site_offset;
+
+            const double* tp_a = tp;
+            for (size_t c1 = 0; c1 < num_chars; ++c1)
+            {
+                double sum = 0.0;
+                for (size_t c2 = 0; c2 < num_chars; ++c2)
+                {
+                    double p = tp_a[c2];
+                    for (size_t k = 0; k < num_children; ++k)
+                    {
+                        p *= children[k][offset+c2];
+                    }
+                    sum += p;
+                }
+                p_node[offset+c1] = sum;
+
+                tp_a += num_chars;
+            }
+
+        }
+
+    }
+
+
+    void computeRootScalar(const double *f, const double* const* children, size_t num_children, double *p_root, size_t num_sites, size_t num_chars, size_t site_offset)
+    {
+
+        for (size_t site = 0; site < num_sites; ++site)
+        {
+            size_t offset = site*site_offset;
+            for (size_t c = 0; c < num_chars; ++c)
+            {
+                double p = f[c];
+                for (size_t k = 0; k < num_children; ++k)
+                {
+                    p *= children[k][offset+c];
+                }
+                p_root[offset+c] = p;
+            }
+        }
+
+    }
+
+
+#if defined (RB_X86_KERNELS)
+
+    /**
+     * Copy the transposed transition probability matrix into a buffer whose rows are padded with zeros to the vector width.
+     * Row c2 of the buffer then holds the probabilities of all starting states to end in c2, so that the partial likelihoods
+     * of a site are a sum of these rows weighted by the product of the child likelihoods for c2.
+     */
+    void transposeMatrix(const double *tp, size_t num_chars, size_t stride, double *tp_t)
+    {
+
+        for (size_t c2 = 0; c2 < num_chars; ++c2)
+        {
+            double *row = tp_t + c2*stride;
+            for (size_t c1 = 0; c1 < num_chars; ++c1)
+            {
+                row[c1] = tp[c1*num_chars+c2];
+            }
+            for (size_t c1 = num_chars; c1 < stride; ++c1)
+            {
+                row[c1] = 0.0;
+            }
+        }
+
+    }
+
+
+    // dispatch the groups of output vectors to the kernel instantiated for that group size
+#   define RB_COMPUTE_STATE_GROUPS( KERNEL, WIDTH )                                                                         \
+        size_t num_vectors = (num_out + WIDTH - 1) / WIDTH;                                                                 \
+        for (size_t v = 0; v < num_vectors; v += MAX_GROUP)                                                                 \
+        {                                                                                                                   \
+            size_t o = v*WIDTH;                                                                                             \
+            switch ( std::min(num_vectors - v, MAX_GROUP) )                                                                 \
+            {                                                                                                               \
+                case 8:     KERNEL<8>(prod, tp_t + o, stride, num_chars, out + o, num_out - o);    break;                   \
+                case 7:     KERNEL<7>(prod, tp_t + o, stride, num_chars, out + o, num_out - o);    break;                   \
+                case 6:     KERNEL<6>(prod, tp_t + o, stride, num_chars, out + o, num_out - o);    break;                   \
+                case 5:     KERNEL<5>(prod, tp_t + o, stride, num_chars, out + o, num_out - o);    break;                   \
+                case 4:     KERNEL<4>(prod, tp_t + o, stride, num_chars, out + o, num_out - o);    break;                   \
+                case 3:     KERNEL<3>(prod, tp_t + o, stride, num_chars, out + o, num_out - o);    break;                   \
+                case 2:     KERNEL<2>(prod, tp_t + o, stride, num_chars, out + o, num_out - o);    break;                   \
+                default:    KERNEL<1>(prod, tp_t + o, stride, num_chars, out + o, num_out - o);    break;                   \
+            }                                                                                                               \
+        }
+
+
+    /* SSE2 kernels (2 doubles per vector) */
+
+    template <size_t G>
+    RB_TARGET_SSE2 inline void computeStateGroupSSE2(const double *prod, const double *tp_t, size_t stride, size_t num_chars, double *out, size_t num_out)
+    {
+
+        __m128d acc[G];
+        for (size_t g = 0; g < G; ++g)
+        {
+            acc[g] = _mm_setzero_pd();
+        }
+
+        for (size_t c2 = 0; c2 < num_chars; ++c2)
+        {
+            __m128d p = _mm_set1_pd( prod[c2] );
+            const double *row = tp_t + c2*stride;
+            for (size_t g = 0; g < G; ++g)
+            {
+                acc[g] = _mm_add_pd( acc[g], _mm_mul_pd( p, _mm_load_pd(row + 2*g) ) );
+            }
+        }
+
+        for (size_t g = 0; g < G; ++g)
+        {
+            if ( num_out - 2*g >= 2 )
+            {
+                _mm_storeu_pd( out + 2*g, acc[g] );
+            }
+            else
+            {
+                _mm_store_sd( out + 2*g, acc[g] );
+            }
+        }
+
+    }
+
+
+    RB_TARGET_SSE2 void computeStatesSSE2(const double *prod, const double *tp_t, size_t stride, size_t num_chars, double *out, size_t num_out)
+    {
+        RB_COMPUTE_STATE_GROUPS( computeStateGroupSSE2, 2 )
+    }
+
+
+    RB_TARGET_SSE2 inline void multiplyChildrenSSE2(const double *first, const double* const* children, size_t num_children, size_t offset, size_t num, double *prod)
+    {
+
+        size_t c = 0;
+        for (; c + 2 <= num; c += 2)
+        {
+            __m128d p = _mm_loadu_pd( first + c );
+            for (size_t k = 0; k < num_children; ++k)
+            {
+                p = _mm_mul_pd( p, _mm_loadu_pd( children[k] + offset + c ) );
+            }
+            _mm_storeu_pd( prod + c, p );
+        }
+        for (; c < num; ++c)
+        {
+            double p = first[c];
+            for (size_t k = 0; k < num_children; ++k)
+            {
+                p *= children[k][offset+c];
+            }
+            prod[c] = p;
+        }
+
+    }
+
+
+    RB_TARGET_SSE2 void computeInternalNodeSSE2(const double *tp_t, size_t stride, const double* const* children, size_t num_children, double *p_node, size_t num_sites, size_t num_chars, size_t site_offset)
+    {
+
+        alignas(64) double prod[MAX_STATES];
+        size_t num_out = ( site_offset >= stride ? stride : num_chars );
+
+        for (size_t site = 0; site < num_sites; ++site)
+        {
+            size_t offset = site*site_offset;
+            multiplyChildrenSSE2( children[0] + offset, children + 1, num_children - 1, offset, num_chars, prod );
+            computeStatesSSE2( prod, tp_t, stride, num_chars, p_node + offset, num_out );
+        }
+
+    }
+
+
+    RB_TARGET_SSE2 void computeRootSSE2(const double *f, size_t stride, const double* const* children, size_t num_children, double *p_root, size_t num_sites, size_t num_chars, size_t site_offset)
+    {
+
+        size_t num_out = ( site_offset >= stride ? stride : num_chars );
+        for (size_t site = 0; site < num_sites; ++site)
+        {
+            size_t offset = site*site_offset;
+            multiplyChildrenSSE2( f, children, num_children, offset, num_out, p_root + offset );
+        }
+
+    }
+
+
+    /* AVX2 kernels (4 doubles per vector, fused multiply-add) */
+
+    template <size_t G>
+    RB_TARGET_AVX2 inline void computeStateGroupAVX2(const double *prod, const double *tp_t, size_t stride, size_t num_chars, double *out, size_t num_out)
+    {
+
+        __m256d acc[G];
+        for (size_t g = 0; g < G; ++g)
+        {
+            acc[g] = _mm256_setzero_pd();
+        }
+
+        for (size_t c2 = 0; c2 < num_chars; ++c2)
+        {
+            __m256d p = _mm256_broadcast_sd( prod + c2 );
+            const double *row = tp_t + c2*stride;
+            for (size_t g = 0; g < G; ++g)
+            {
+                acc[g] = _mm256_fmadd_pd( p, _mm256_load_pd(row + 4*g), acc[g] );
+            }
+        }
+
+        for (size_t g = 0; g < G; ++g)
+        {
+            size_t remaining = num_out - 4*g;
+            if ( remaining >= 4 )
+            {
+                _mm256_storeu_pd( out + 4*g, acc[g] );
+            }
+            else
+            {
+                __m256i mask = _mm256_cmpgt_epi64( _mm256_set1_epi64x( (long long)remaining ), _mm256_setr_epi64x(0, 1, 2, 3) );
+                _mm256_maskstore_pd( out + 4*g, mask, acc[g] );
+            }
+        }
+
+    }
+
+
+    RB_TARGET_AVX2 void computeStatesAVX2(const double *prod, const double *tp_t, size_t stride, size_t num_chars, double *out, size_t num_out)
+    {
+        RB_COMPUTE_STATE_GROUPS( computeStateGroupAVX2, 4 )
+    }
+
+
+    RB_TARGET_AVX2 inline void multiplyChildrenAVX2(const double *first, const double* const* children, size_t num_children, size_t offset, size_t num, double *prod)
+    {
+
+        size_t c = 0;
+        for (; c + 4 <= num; c += 4)
+        {
+            __m256d p = _mm256_loadu_pd( first + c );
+            for (size_t k = 0; k < num_children; ++k)
+            {
+                p = _mm256_mul_pd( p, _mm256_loadu_pd( children[k] + offset + c ) );
+            }
+            _mm256_storeu_pd( prod + c, p );
+        }
+        for (; c < num; ++c)
+        {
+            double p = first[c];
+            for (size_t k = 0; k < num_children; ++k)
+            {
+                p *= children[k][offset+c];
+            }
+            prod[c] = p;
+        }
+
+    }
+
+
+    /**
+     * Nucleotide kernel: one vector holds all four states of a site, so the transition probabilities
+     * stay in registers and the states of the product are broadcast by permutation within the vector.
+     */
+    RB_TARGET_AVX2 void computeInternalNodeAVX2FourStates(const double *tp_t, const double* const* children, size_t num_children, double *p_node, size_t num_sites, size_t site_offset)
+    {
+
+        __m256d tp_0 = _mm256_load_pd( tp_t );
+        __m256d tp_1 = _mm256_load_pd( tp_t + 4 );
+        __m256d tp_2 = _mm256_load_pd( tp_t + 8 );
+        __m256d tp_3 = _mm256_load_pd( tp_t + 12 );
+
+        for (size_t site = 0; site < num_sites; ++site)
+        {
+            size_t offset = site*site_offset;
+
+            __m256d p = _mm256_loadu_pd( children[0] + offset );
+            for (size_t k = 1; k < num_children; ++k)
+            {
+                p = _mm256_mul_pd( p, _mm256_loadu_pd( children[k] + offset ) );
+            }
+
+            __m256d sum = _mm256_mul_pd( _mm256_permute4x64_pd( p, 0x00 ), tp_0 );
+            sum = _mm256_fmadd_pd( _mm256_permute4x64_pd( p, 0x55 ), tp_1, sum );
+            sum = _mm256_fmadd_pd( _mm256_permute4x64_pd( p, 0xAA ), tp_2, sum );
+            sum = _mm256_fmadd_pd( _mm256_permute4x64_pd( p, 0xFF ), tp_3, sum );
+
+            _mm256_storeu_pd( p_node + offset, sum );
+        }
+
+    }
+
+
+    RB_TARGET_AVX2 void computeInternalNodeAVX2(const double *tp_t, size_t stride, const double* const* children, size_t num_children, double *p_node, size_t num_sites, size_t num_chars, size_t site_offset)
+    {
+
+        if ( num_chars == 4 )
+        {
+            computeInternalNodeAVX2FourStates( tp_t, children, num_children, p_node, num_sites, site_offset );
+            return;
+        }
+
+        alignas(64) double prod[MAX_STATES];
+        size_t num_out = ( site_offset >= stride ? stride : num_chars );
+
+        for (size_t site = 0; site < num_sites; ++site)
+        {
+            size_t offset = site*site_offset;
+            multiplyChildrenAVX2( children[0] + offset, children + 1, num_children - 1, offset, num_chars, prod );
+            computeStatesAVX2( prod, tp_t, stride, num_chars, p_node + offset, num_out );
+        }
+
+    }
+
+
+    RB_TARGET_AVX2 void computeRootAVX2(const double *f, size_t stride, const double* const* children, size_t num_children, double *p_root, size_t num_sites, size_t num_chars, size_t site_offset)
+    {
+
+        size_t num_out = ( site_offset >= stride ? stride : num_chars );
+        for (size_t site = 0; site < num_sites; ++site)
+        {
+            size_t offset = site*site_offset;
+            multiplyChildrenAVX2( f, children, num_children, offset, num_out, p_root + offset );
+        }
+
+    }
+
+
+    /* AVX-512 kernels (8 doubles per vector, masked tails) */
+
+    template <size_t G>
+    RB_TARGET_AVX512 inline void computeStateGroupAVX512(const double *prod, const double *tp_t, size_t stride, size_t num_chars, double *out, size_t num_out)
+    {
+
+        __m512d acc[G];
+        for (size_t g = 0; g < G; ++g)
+        {
+            acc[g] = _mm512_setzero_pd();
+        }
+
+        for (size_t c2 = 0; c2 < num_chars; ++c2)
+        {
+            __m512d p = _mm512_set1_pd( prod[c2] );
+            const double *row = tp_t + c2*stride;
+            for (size_t g = 0; g < G; ++g)
+            {
+                acc[g] = _mm512_fmadd_pd( p, _mm512_load_pd(row + 8*g), acc[g] );
+            }
+        }
+
+        for (size_t g = 0; g < G; ++g)
+        {
+            size_t remaining = num_out - 8*g;
+            if ( remaining >= 8 )
+            {
+                _mm512_storeu_pd( out + 8*g, acc[g] );
+            }
+            else
+            {
+                _mm512_mask_storeu_pd( out + 8*g, (__mmask8)((1u << remaining) - 1), acc[g] );
+            }
+        }
+
+    }
+
+
+    RB_TARGET_AVX512 void computeStatesAVX512(const double *prod, const double *tp_t, size_t stride, size_t num_chars, double *out, size_t num_out)
+    {
+        RB_COMPUTE_STATE_GROUPS( computeStateGroupAVX512, 8 )
+    }
+
+
+    RB_TARGET_AVX512 inline void multiplyChildrenAVX512(const double *first, const double* const* children, size_t num_children, size_t offset, size_t num, double *prod)
+    {
+
+        for (size_t c = 0; c < num; c += 8)
+        {
+            __mmask8 mask = ( num - c >= 8 ? (__mmask8)0xFF : (__mmask8)((1u << (num - c)) - 1) );
+            __m512d p = _mm512_maskz_loadu_pd( mask, first + c );
+            for (size_t k = 0; k < num_children; ++k)
+            {
+                p = _mm512_mul_pd( p, _mm512_maskz_loadu_pd( mask, children[k] + offset + c ) );
+            }
+            _mm512_mask_storeu_pd( prod + c, mask, p );
+        }
+
+    }
+
+
+    RB_TARGET_AVX512 void computeInternalNodeAVX512(const double *tp_t, size_t stride, const double* const* children, size_t num_children, double *p_node, size_t num_sites, size_t num_chars, size_t site_offset)
+    {
+
+        alignas(64) double prod[MAX_STATES];
+        size_t num_out = ( site_offset >= stride ? stride : num_chars );
+
+        for (size_t site = 0; site < num_sites; ++site)
+        {
+            size_t offset = site*site_offset;
+            multiplyChildrenAVX512( children[0] + offset, children + 1, num_children - 1, offset, num_chars, prod );
+            computeStatesAVX512( prod, tp_t, stride, num_chars, p_node + offset, num_out );
+        }
+
+    }
+
+
+    RB_TARGET_AVX512 void computeRootAVX512(const double *f, size_t stride, const double* const* children, size_t num_children, double *p_root, size_t num_sites, size_t num_chars, size_t site_offset)
+    {
+
+        size_t num_out = ( site_offset >= stride ? stride : num_chars );
+        for (size_t site = 0; site < num_sites; ++site)
+        {
+            size_t offset = site*site_offset;
+            multiplyChildrenAVX512( f, children, num_children, offset, num_out, p_root + offset );
+        }
+
+    }
+
+#   undef RB_COMPUTE_STATE_GROUPS
+
+#endif
+
+
+    void computeInternalNode(const double *tp, const double* const* children, size_t num_children, double *p_node, size_t num_sites, size_t num_chars, size_t site_offset)
+    {
+
+#if defined (RB_X86_KERNELS)
+        PhyloCTMCKernels::SimdLevel level = PhyloCTMCKernels::getSimdLevel();
+        size_t width = getVectorWidth( level, num_chars );
+        if ( width > 1 )
+        {
+            size_t stride = PhyloCTMCKernels::getPaddedNumberOfStates( num_chars );
+            alignas(64) double tp_t[MAX_STATES*MAX_STATES];
+            transposeMatrix( tp, num_chars, stride, tp_t );
+
+            if ( width == 8 )
+            {
+                computeInternalNodeAVX512( tp_t, stride, children, num_children, p_node, num_sites, num_chars, site_offset );
+            }
+            else if ( level >= PhyloCTMCKernels::SIMD_AVX2 )
+            {
+                computeInternalNodeAVX2( tp_t, stride, children, num_children, p_node, num_sites, num_chars, site_offset );
+            }
+            else
+            {
+                computeInternalNodeSSE2( tp_t, stride, children, num_children, p_node, num_sites, num_chars, site_offset );
+            }
+            return;
+        }
+#endif
+
+        computeInternalNodeScalar( tp, children, num_children, p_node, num_sites, num_chars, site_offset );
+    }
+
+
+    void computeRoot(const double *f, const double* const* children, size_t num_children, double *p_root, size_t num_sites, size_t num_chars, size_t site_offset)
+    {
+
+#if defined (RB_X86_KERNELS)
+        PhyloCTMCKernels::SimdLevel level = PhyloCTMCKernels::getSimdLevel();
+        size_t width = getVectorWidth( level, num_chars );
+        if ( width > 1 )
+        {
+            // the padded states have a root frequency of 0
+            size_t stride = PhyloCTMCKernels::getPaddedNumberOfStates( num_chars );
+            alignas(64) double f_padded[MAX_STATES];
+            std::copy( f, f + num_chars, f_padded );
+            std::fill( f_padded + num_chars, f_padded + stride, 0.0 );
+
+            if ( width == 8 )
+            {
+                computeRootAVX512( f_padded, stride, children, num_children, p_root, num_sites, num_chars, site_offset );
+            }
+            else if ( level >= PhyloCTMCKernels::SIMD_AVX2 )
+            {
+                computeRootAVX2( f_padded, stride, children, num_children, p_root, num_sites, num_chars, site_offset );
+            }
+            else
+            {
+                computeRootSSE2( f_padded, stride, children, num_children, p_root, num_sites, num_chars, site_offset );
+            }
+            return;
+        }
+#endif
+
+        computeRootScalar( f, children, num_children, p_root, num_sites, num_chars, site_offset );
+    }
+
+}
+
+
+/**
+ * Compute the partial likelihoods of a node with two children for all sites of one mixture category.
+ *
+ * \param[in]    tp             The row-major transition probability matrix of the branch leading to the node.
+ * \param[in]    p_left         The partial likelihoods of the left child.
+ * \param[in]    p_right        The partial likelihoods of the right child.
+ * \param[out]   p_node         The partial likelihoods of the node.
+ * \param[in]    num_sites      The number of sites (patterns).
+ * \param[in]    num_chars      The number of states.
+ * \param[in]    site_offset    The distance between two sites in the partial likelihood vectors.
+ */
+void PhyloCTMCKernels::computeInternalNodeLikelihood(const double *tp, const double *p_left, const double *p_right, double *p_node, size_t num_sites, size_t num_chars, size_t site_offset)
+{
+    const double* children[2] = { p_left, p_right };
+    computeInternalNode( tp, children, 2, p_node, num_sites, num_chars, site_offset );
+}
+
+
+void PhyloCTMCKernels::computeInternalNodeLikelihood(const double *tp, const double *p_left, const double *p_right, const double *p_middle, double *p_node, size_t num_sites, size_t num_chars, size_t site_offset)
+{
+    const double* children[3] = { p_left, p_middle, p_right };
+    computeInternalNode( tp, children, 3, p_node, num_sites, num_chars, site_offset );
+}
+
+
+/**
+ * Compute the per site and state likelihoods at the root, i.e., the product of the child likelihoods
+ * and the root frequencies, for all sites of one mixture category.
+ */
+void PhyloCTMCKernels::computeRootLikelihood(const double *f, const double *p_left, const double *p_right, double *p_root, size_t num_sites, size_t num_chars, size_t site_offset)
+{
+    const double* children[2] = { p_left, p_right };
+    computeRoot( f, children, 2, p_root, num_sites, num_chars, site_offset );
+}
+
+
+void PhyloCTMCKernels::computeRootLikelihood(const double *f, const double *p_left, const double *p_right, const double *p_middle, double *p_root, size_t num_sites, size_t num_chars, size_t site_offset)
+{
+    const double* children[3] = { p_left, p_middle, p_right };
+    computeRoot( f, children, 3, p_root, num_sites, num_chars, site_offset );
+}
+
+
+/**
+ * The number of states rounded up to a multiple of the vector width that the kernels use for this number of states.
+ * A site offset of this size lets the kernels store whole vectors for every site.
+ */
+size_t PhyloCTMCKernels::getPaddedNumberOfStates(size_t num_chars)
+{
+    size_t width = getVectorWidth( getSimdLevel(), num_chars );
+    return ( (num_chars + width - 1) / width ) * width;
+}
+
+
+PhyloCTMCKernels::SimdLevel PhyloCTMCKernels::getSimdLevel( void )
+{
+    static const SimdLevel level = detectSimdLevel();
+    return level;
+}
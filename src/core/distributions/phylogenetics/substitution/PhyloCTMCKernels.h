@@ -0,0 +1,47 @@
+/**
+ * @file PhyloCTMCKernels
+ * This file contains the vectorized pruning kernels of the site-homogeneous phylogenetic CTMC.
+ *
+ * @brief Vectorized kernels for the partial likelihoods of one mixture category.
+ *
+ * The kernels compute the partial likelihoods of an internal node or the root for all sites
+ * of one mixture category. Tips are stored as partial likelihood vectors too, so the tip-tip,
+ * tip-internal and internal-internal cases all go through the same internal node kernel.
+ * The instruction set (AVX-512, AVX2+FMA, SSE2 or plain scalar code) is chosen once at runtime
+ * from the capabilities of the CPU, so a single binary runs everywhere and still uses the
+ * widest available vector units.
+ *
+ * All kernels expect the layout of AbstractPhyloCTMCSiteHomogeneous: site i of a mixture
+ * category starts at i*site_offset and holds num_chars values. If the site offset is padded
+ * (see getPaddedNumberOfStates) the padded entries are written as zeros and whole vectors
+ * can be stored without a scalar tail.
+ *
+ * (c) Copyright 2009- under GPL version 3
+ * @author The RevBayes core development team
+ * @license GPL version 3
+ * @since 2026-10-16, version 1.2.2
+ */
+
+
+#ifndef PhyloCTMCKernels_H
+#define PhyloCTMCKernels_H
+
+#include <stddef.h>
+
+namespace RevBayesCore {
+
+    namespace PhyloCTMCKernels {
+
+        enum SimdLevel { SIMD_SCALAR, SIMD_SSE2, SIMD_AVX2, SIMD_AVX512 };
+
+        void                        computeInternalNodeLikelihood(const double *tp, const double *p_left, const double *p_right, double *p_node, size_t num_sites, size_t num_chars, size_t site_offset);                          //!< Partial likelihoods of a node with two children for one mixture category
+        void                        computeInternalNodeLikelihood(const double *tp, const double *p_left, const double *p_right, const double *p_middle, double *p_node, size_t num_sites, size_t num_chars, size_t site_offset);  //!< Partial likelihoods of a node with three children for one mixture category
+        void                        computeRootLikelihood(const double *f, const double *p_left, const double *p_right, double *p_root, size_t num_sites, size_t num_chars, size_t site_offset);                                    //!< Root likelihoods (with two children) for one mixture category
+        void                        computeRootLikelihood(const double *f, const double *p_left, const double *p_right, const double *p_middle, double *p_root, size_t num_sites, size_t num_chars, size_t site_offset);            //!< Root likelihoods (with three children) for one mixture category
+        size_t                      getPaddedNumberOfStates(size_t num_chars);                                          //!< The number of states rounded up to the vector width used for this number of states
+        SimdLevel                   getSimdLevel(void);                                                                 //!< The instruction set used by the kernels (detected once)
+    }
+
+}
+
+#endif
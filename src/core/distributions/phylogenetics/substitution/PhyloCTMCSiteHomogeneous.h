@@ -30,6 +30,7 @@ namespace RevBayesCore {
         virtual void                                        computeInternalNodeLikelihood(const TopologyNode &n, size_t nIdx, size_t l, size_t r);
         virtual void                                        computeInternalNodeLikelihood(const TopologyNode &n, size_t nIdx, size_t l, size_t r, size_t m);
         virtual void                                        computeTipLikelihood(const TopologyNode &node, size_t nIdx);
+        virtual bool                                        supportsStatePadding(void) const;                           //!< All likelihood functions iterate over the sites with the site offset
 
 
     private:
@@ -43,6 +44,7 @@ namespace RevBayesCore {
 
 #include "ConstantNode.h"
 #include "DiscreteCharacterState.h"
+#include "PhyloCTMCKernels.h"
 #include "RateMatrix_JC.h"
 #include "RandomNumberFactory.h"
 
@@ -82,15 +84,6 @@ void RevBayesCore::PhyloCTMCSiteHomogeneous<charType>::computeRootLikelihood( si
     const double* p_left   = this->partialLikelihoods + this->activeLikelihood[left]  * this->activeLikelihoodOffset + left  * this->nodeOffset;
     const double* p_right  = this->partialLikelihoods + this->activeLikelihood[right] * this->activeLikelihoodOffset + right * this->nodeOffset;
 
-    // create a vector for the per mixture likelihoods
-    // we need this vector to sum over the different mixture likelihoods
-    std::vector<double> per_mixture_Likelihoods = std::vector<double>(this->num_patterns,0.0);
-
-    // get pointers the likelihood for both subtrees
-          double*   p_mixture          = p;
-    const double*   p_mixture_left     = p_left;
-    const double*   p_mixture_right    = p_right;
-
     // get the root frequencies
     std::vector<std::vector<double> >   ff;
     this->getRootFrequencies(ff);
@@ -99,47 +92,15 @@ void RevBayesCore::PhyloCTMCSiteHomogeneous<charType>::computeRootLikelihood( si
     for (size_t mixture = 0; mixture < this->num_site_mixtures; ++mixture)
     {
         // get the root frequencies
-        const std::vector<double> &f                    = ff[mixture % ff.size()];
+        const std::vector<double> &f = ff[mixture % ff.size()];
         assert(f.size() == this->num_chars);
-        std::vector<double>::const_iterator f_end       = f.end();
-        std::vector<double>::const_iterator f_begin     = f.begin();
-
-        // get pointers to the likelihood for this mixture category
-              double*   p_site_mixture          = p_mixture;
-        const double*   p_site_mixture_left     = p_mixture_left;
-        const double*   p_site_mixture_right    = p_mixture_right;
-        // iterate over all sites
-        for (size_t site = 0; site < this->pattern_block_size; ++site)
-        {
-            // get the pointer to the stationary frequencies
-            std::vector<double>::const_iterator f_j             = f_begin;
-            // get the pointers to the likelihoods for this site and mixture category
-                  double* p_site_j        = p_site_mixture;
-            const double* p_site_left_j   = p_site_mixture_left;
-            const double* p_site_right_j  = p_site_mixture_right;
-            // iterate over all starting states
-            for (; f_j != f_end; ++f_j)
-            {
-                // add the probability of starting from this state
-                *p_site_j = *p_site_left_j * *p_site_right_j * *f_j;
-
-                assert(isnan(*p_site_j) || (0.0 <= *p_site_j and *p_site_j <= 1.00000000001));
-
-                // increment pointers
-                ++p_site_j; ++p_site_left_j; ++p_site_right_j;
-            }
-
-            // increment the pointers to the next site
-            p_site_mixture+=this->siteOffset; p_site_mixture_left+=this->siteOffset; p_site_mixture_right+=this->siteOffset;
 
-        } // end-for over all sites (=patterns)
-
-        // increment the pointers to the next mixture category
-        p_mixture+=this->mixtureOffset; p_mixture_left+=this->mixtureOffset; p_mixture_right+=this->mixtureOffset;
+        // compute the per site and state probabilities with the vectorized kernel
+        size_t offset = mixture*this->mixtureOffset;
+        PhyloCTMCKernels::computeRootLikelihood( &f[0], p_left + offset, p_right + offset, p + offset, this->pattern_block_size, this->num_chars, this->siteOffset );
 
     } // end-for over all mixtures (=rate categories)
 
-
 }
 
 
@@ -153,12 +114,6 @@ void RevBayesCore::PhyloCTMCSiteHomogeneous<charType>::computeRootLikelihood( si
     const double* p_right  = this->partialLikelihoods + this->activeLikelihood[right]  * this->activeLikelihoodOffset + right  * this->nodeOffset;
     const double* p_middle = this->partialLikelihoods + this->activeLikelihood[middle] * this->activeLikelihoodOffset + middle * this->nodeOffset;
 
-    // get pointers the likelihood for both subtrees
-          double*   p_mixture          = p;
-    const double*   p_mixture_left     = p_left;
-    const double*   p_mixture_right    = p_right;
-    const double*   p_mixture_middle   = p_middle;
-
     // get the root frequencies
     std::vector<std::vector<double> >   ff;
     this->getRootFrequencies(ff);
@@ -166,48 +121,13 @@ void RevBayesCore::PhyloCTMCSiteHomogeneous<charType>::computeRootLikelihood( si
     // iterate over all mixture categories
     for (size_t mixture = 0; mixture < this->num_site_mixtures; ++mixture)
     {
-        
         // get the root frequencies
-        const std::vector<double> &f                    = ff[mixture % ff.size()];
+        const std::vector<double> &f = ff[mixture % ff.size()];
         assert(f.size() == this->num_chars);
-        std::vector<double>::const_iterator f_end       = f.end();
-        std::vector<double>::const_iterator f_begin     = f.begin();
-
-        // get pointers to the likelihood for this mixture category
-              double*   p_site_mixture          = p_mixture;
-        const double*   p_site_mixture_left     = p_mixture_left;
-        const double*   p_site_mixture_right    = p_mixture_right;
-        const double*   p_site_mixture_middle   = p_mixture_middle;
-        // iterate over all sites
-        for (size_t site = 0; site < this->pattern_block_size; ++site)
-        {
-
-            // get the pointer to the stationary frequencies
-            std::vector<double>::const_iterator f_j = f_begin;
-            // get the pointers to the likelihoods for this site and mixture category
-                  double* p_site_j        = p_site_mixture;
-            const double* p_site_left_j   = p_site_mixture_left;
-            const double* p_site_right_j  = p_site_mixture_right;
-            const double* p_site_middle_j = p_site_mixture_middle;
-            // iterate over all starting states
-            for (; f_j != f_end; ++f_j)
-            {
-                // add the probability of starting from this state
-                *p_site_j = *p_site_left_j * *p_site_right_j * *p_site_middle_j * *f_j;
-
-                assert(isnan(*p_site_j) || (0.0 <= *p_site_j and *p_site_j <= 1.00000000001));
 
-                // increment pointers
-                ++p_site_j; ++p_site_left_j; ++p_site_right_j; ++p_site_middle_j;
-            }
-
-            // increment the pointers to the next site
-            p_site_mixture+=this->siteOffset; p_site_mixture_left+=this->siteOffset; p_site_mixture_right+=this->siteOffset; p_site_mixture_middle+=this->siteOffset;
-
-        } // end-for over all sites (=patterns)
-
-        // increment the pointers to the next mixture category
-        p_mixture+=this->mixtureOffset; p_mixture_left+=this->mixtureOffset; p_mixture_right+=this->mixtureOffset; p_mixture_middle+=this->mixtureOffset;
+        // compute the per site and state probabilities with the vectorized kernel
+        size_t offset = mixture*this->mixtureOffset;
+        PhyloCTMCKernels::computeRootLikelihood( &f[0], p_left + offset, p_right + offset, p_middle + offset, p + offset, this->pattern_block_size, this->num_chars, this->siteOffset );
 
     } // end-for over all mixtures (=rate categories)
 
@@ -219,7 +139,6 @@ void RevBayesCore::PhyloCTMCSiteHomogeneous<charType>::computeInternalNodeLikeli
 {
 
     // compute the transition probability matrix
-//    this->updateTransitionProbabilities( node_index );
     size_t pmat_offset = this->active_pmatrices[node_index] * this->activePmatrixOffset + node_index * this->pmatNodeOffset;
 
     // get the pointers to the partial likelihoods for this node and the two descendant subtrees
@@ -231,47 +150,11 @@ void RevBayesCore::PhyloCTMCSiteHomogeneous<charType>::computeInternalNodeLikeli
     for (size_t mixture = 0; mixture < this->num_site_mixtures; ++mixture)
     {
         // the transition probability matrix for this mixture category
-//        const double*    tp_begin                = this->transition_prob_matrices[mixture].theMatrix;
         const double* tp_begin = this->pmatrices[pmat_offset + mixture].theMatrix;
 
-        // get the pointers to the likelihood for this mixture category
+        // compute the per site probabilities with the vectorized kernel
         size_t offset = mixture*this->mixtureOffset;
-        double*          p_site_mixture          = p_node + offset;
-        const double*    p_site_mixture_left     = p_left + offset;
-        const double*    p_site_mixture_right    = p_right + offset;
-        // compute the per site probabilities
-        for (size_t site = 0; site < this->pattern_block_size ; ++site)
-        {
-
-            // get the pointers for this mixture category and this site
-            const double*       tp_a    = tp_begin;
-            // iterate over the possible starting states
-            for (size_t c1 = 0; c1 < this->num_chars; ++c1)
-            {
-                // temporary variable
-                double sum = 0.0;
-
-                // iterate over all possible terminal states
-                for (size_t c2 = 0; c2 < this->num_chars; ++c2 )
-                {
-                    sum += p_site_mixture_left[c2] * p_site_mixture_right[c2] * tp_a[c2];
-
-                } // end-for over all distination character
-
-                // store the likelihood for this starting state
-                p_site_mixture[c1] = sum;
-
-                assert(isnan(sum) || (0 <= sum and sum <= 1.00000000001));
-
-                // increment the pointers to the next starting state
-                tp_a+=this->num_chars;
-
-            } // end-for over all initial characters
-
-            // increment the pointers to the next site
-            p_site_mixture_left+=this->siteOffset; p_site_mixture_right+=this->siteOffset; p_site_mixture+=this->siteOffset;
-
-        } // end-for over all sites (=patterns)
+        PhyloCTMCKernels::computeInternalNodeLikelihood( tp_begin, p_left + offset, p_right + offset, p_node + offset, this->pattern_block_size, this->num_chars, this->siteOffset );
 
     } // end-for over all mixtures (=rate-categories)
 
@@ -283,10 +166,9 @@ void RevBayesCore::PhyloCTMCSiteHomogeneous<charType>::computeInternalNodeLikeli
 {
 
     // compute the transition probability matrix
-//    this->updateTransitionProbabilities( node_index );
     size_t pmat_offset = this->active_pmatrices[node_index] * this->activePmatrixOffset + node_index * this->pmatNodeOffset;
 
-    // get the pointers to the partial likelihoods for this node and the two descendant subtrees
+    // get the pointers to the partial likelihoods for this node and the three descendant subtrees
     const double*   p_left      = this->partialLikelihoods + this->activeLikelihood[left]*this->activeLikelihoodOffset + left*this->nodeOffset;
     const double*   p_middle    = this->partialLikelihoods + this->activeLikelihood[middle]*this->activeLikelihoodOffset + middle*this->nodeOffset;
     const double*   p_right     = this->partialLikelihoods + this->activeLikelihood[right]*this->activeLikelihoodOffset + right*this->nodeOffset;
@@ -296,56 +178,26 @@ void RevBayesCore::PhyloCTMCSiteHomogeneous<charType>::computeInternalNodeLikeli
     for (size_t mixture = 0; mixture < this->num_site_mixtures; ++mixture)
     {
         // the transition probability matrix for this mixture category
-//        const double*    tp_begin                = this->transition_prob_matrices[mixture].theMatrix;
         const double* tp_begin = this->pmatrices[pmat_offset + mixture].theMatrix;
 
-        // get the pointers to the likelihood for this mixture category
+        // compute the per site probabilities with the vectorized kernel
         size_t offset = mixture*this->mixtureOffset;
-        double*          p_site_mixture          = p_node + offset;
-        const double*    p_site_mixture_left     = p_left + offset;
-        const double*    p_site_mixture_middle   = p_middle + offset;
-        const double*    p_site_mixture_right    = p_right + offset;
-        // compute the per site probabilities
-        for (size_t site = 0; site < this->pattern_block_size ; ++site)
-        {
-
-            // get the pointers for this mixture category and this site
-            const double*       tp_a    = tp_begin;
-            // iterate over the possible starting states
-            for (size_t c1 = 0; c1 < this->num_chars; ++c1)
-            {
-                // temporary variable
-                double sum = 0.0;
-
-                // iterate over all possible terminal states
-                for (size_t c2 = 0; c2 < this->num_chars; ++c2 )
-                {
-                    sum += p_site_mixture_left[c2] * p_site_mixture_middle[c2] * p_site_mixture_right[c2] * tp_a[c2];
-
-                } // end-for over all distination character
-
-                assert(isnan(sum) || (0 <= sum and sum <= 1.00000000001));
-
-                // store the likelihood for this starting state
-                p_site_mixture[c1] = sum;
+        PhyloCTMCKernels::computeInternalNodeLikelihood( tp_begin, p_left + offset, p_right + offset, p_middle + offset, p_node + offset, this->pattern_block_size, this->num_chars, this->siteOffset );
 
-                // increment the pointers to the next starting state
-                tp_a+=this->num_chars;
+    } // end-for over all mixtures (=rate-categories)
 
-            } // end-for over all initial characters
+}
 
-            // increment the pointers to the next site
-            p_site_mixture_left+=this->siteOffset; p_site_mixture_middle+=this->siteOffset; p_site_mixture_right+=this->siteOffset; p_site_mixture+=this->siteOffset;
 
-        } // end-for over all sites (=patterns)
 
-    } // end-for over all mixtures (=rate-categories)
 
+template<class charType>
+bool RevBayesCore::PhyloCTMCSiteHomogeneous<charType>::supportsStatePadding( void ) const
+{
+    return true;
 }
 
 
-
-
 template<class charType>
 void RevBayesCore::PhyloCTMCSiteHomogeneous<charType>::computeTipLikelihood(const TopologyNode &node, size_t node_index)
 {
@@ -354,9 +206,7 @@ void RevBayesCore::PhyloCTMCSiteHomogeneous<charType>::computeTipLikelihood(cons
     
     // get the current correct tip index in case the whole tree change (after performing an empiricalTree Proposal)
     size_t data_tip_index = this->taxon_name_2_tip_index_map[ node.getName() ];
-    const std::vector<bool> &gap_node = this->gap_matrix[data_tip_index];
-    const std::vector<unsigned long> &char_node = this->char_matrix[data_tip_index];
-    const std::vector<RbBitSet> &amb_char_node = this->ambiguous_char_matrix[data_tip_index];
+    const std::vector<unsigned int> &tip_states_node = this->tip_states[data_tip_index];
 
     size_t char_data_node_index = this->value->indexOfTaxonWithName(node.getName());
     std::vector<size_t> site_indices;
@@ -376,6 +226,12 @@ void RevBayesCore::PhyloCTMCSiteHomogeneous<charType>::computeTipLikelihood(cons
 //         const double* tp_begin = this->transition_prob_matrices[mixture].theMatrix;
         const double* tp_begin = this->pmatrices[pmat_offset + mixture].theMatrix;
 
+        // compute the tip likelihoods of each state code once for this branch
+        if ( this->using_weighted_characters == false )
+        {
+            this->computeTipStateLikelihoods( tp_begin );
+        }
+
         // get the pointer to the likelihoods for this site and mixture category
         double* p_site_mixture = p_mixture;
 
@@ -383,98 +239,65 @@ void RevBayesCore::PhyloCTMCSiteHomogeneous<charType>::computeTipLikelihood(cons
         for (size_t site = 0; site != this->pattern_block_size; ++site)
         {
 
-            // is this site a gap?
-            if ( gap_node[site] )
+            if ( this->using_weighted_characters == false )
+            {
+                // look up the likelihoods of the observed (possibly ambiguous) state
+                const double* p_state = this->tip_state_likelihoods.data() + tip_states_node[site]*this->num_chars;
+                for (size_t c1 = 0; c1 < this->num_chars; ++c1)
+                {
+                    p_site_mixture[c1] = p_state[c1];
+                }
+            }
+            else if ( this->isGapTipState( tip_states_node[site] ) == true )
             {
                 // since this is a gap we need to assume that the actual state could have been any state
-
-                // iterate over all initial states for the transitions
                 for (size_t c1 = 0; c1 < this->num_chars; ++c1)
                 {
-
-                    // store the likelihood
                     p_site_mixture[c1] = 1.0;
-
                 }
             }
-            else // we have observed a character
+            else // we have observed a weighted character
             {
+                size_t this_site_index = site_indices[site];
+                const RbBitSet &val = this->value->getCharacter(char_data_node_index, this_site_index).getState();
+                const std::vector< double >& weights = this->value->getCharacter(char_data_node_index, this_site_index).getWeights();
 
                 // iterate over all possible initial states
                 for (size_t c1 = 0; c1 < this->num_chars; ++c1)
                 {
+                    // compute the likelihood that we had a transition from state c1 to the observed state org_val
+                    // note, the observed state could be ambiguous!
 
-                    if ( this->using_ambiguous_characters == true && this->using_weighted_characters == false)
-                    {
-                        // compute the likelihood that we had a transition from state c1 to the observed state org_val
-                        // note, the observed state could be ambiguous!
-                        const RbBitSet &val = amb_char_node[site];
-
-                        // get the pointer to the transition probabilities for the terminal states
-                        const double* d  = tp_begin+(this->num_chars*c1);
-
-                        double tmp = 0.0;
+                    // get the pointer to the transition probabilities for the terminal states
+                    const double* d = tp_begin+(this->num_chars*c1);
 
-                        for ( size_t i=0; i<this->num_chars; ++i )
-                        {
-                            // check whether we observed this state
-                            if ( val.test(i) == true )
-                            {
-                                // add the probability
-                                tmp += *d;
-                            }
-
-                            // increment the pointer to the next transition probability
-                            ++d;
-                        } // end-while over all observed states for this character
-
-                        // store the likelihood
-                        p_site_mixture[c1] = tmp;
-                        
-                    }
-                    else if ( this->using_weighted_characters == true )
+                    double tmp = 0.0;
+                    for ( size_t i=0; i<this->num_chars; ++i )
                     {
-                        // compute the likelihood that we had a transition from state c1 to the observed state org_val
-                        // note, the observed state could be ambiguous!
-//                        const RbBitSet &val = amb_char_node[site];
-                        size_t this_site_index = site_indices[site];
-                        const RbBitSet &val = this->value->getCharacter(char_data_node_index, this_site_index).getState();
-
-                        // get the pointer to the transition probabilities for the terminal states
-                        const double* d = tp_begin+(this->num_chars*c1);
-
-                        double tmp = 0.0;
-                        const std::vector< double >& weights = this->value->getCharacter(char_data_node_index, this_site_index).getWeights();
-                        for ( size_t i=0; i<this->num_chars; ++i )
+                        // check whether we observed this state
+                        if ( val.test(i) == true )
                         {
-                            // check whether we observed this state
-                            if ( val.test(i) == true )
-                            {
-                                // add the probability
-                                tmp += *d * weights[i] ;
-                            }
-
-                            // increment the pointer to the next transition probability
-                            ++d;
-                        } // end-while over all observed states for this character
-
-                        // store the likelihood
-                        p_site_mixture[c1] = tmp;
-                        
-                    }
-                    else // no ambiguous characters in use
-                    {
-                        unsigned long org_val = char_node[site];
+                            // add the probability
+                            tmp += *d * weights[i] ;
+                        }
 
-                        // store the likelihood
-                        p_site_mixture[c1] = tp_begin[c1*this->num_chars+org_val];
+                        // increment the pointer to the next transition probability
+                        ++d;
+                    } // end-while over all observed states for this character
 
-                    }
+                    // store the likelihood
+                    p_site_mixture[c1] = tmp;
 
                 } // end-for over all possible initial character for the branch
 
             } // end-if a gap state
 
+            // the padded states must hold zeros because the kernels multiply them with the zero padding of the matrices
+            for (size_t c1 = this->num_chars; c1 < this->siteOffset; ++c1)
+            {
+                p_site_mixture[c1] = 0.0;
+            }
+
             // increment the pointers to next site
             p_site_mixture+=this->siteOffset;
 
@@ -68,6 +68,8 @@ namespace RevBayesCore {
         std::vector<double>                                 perMaskMixtureCorrections;
 
         virtual double                                      sumRootLikelihood( void );
+        virtual bool                                        supportsPatternBlockThreads( void ) const;                  //!< The correction needs all patterns at once
+        virtual bool                                        supportsStatePadding( void ) const;                         //!< The correction likelihoods are not padded
         virtual bool                                        isSitePatternCompatible( std::map<size_t, size_t> );
         virtual bool                                        isSitePatternCompatible( std::map<RbBitSet, size_t> );
         std::vector<size_t>                                 getIncludedSiteIndices( void );
@@ -806,6 +808,20 @@ void RevBayesCore::PhyloCTMCSiteHomogeneousConditional<charType>::computeRootCor
     }
 }
 
+template<class charType>
+bool RevBayesCore::PhyloCTMCSiteHomogeneousConditional<charType>::supportsPatternBlockThreads( void ) const
+{
+    return false;
+}
+
+
+template<class charType>
+bool RevBayesCore::PhyloCTMCSiteHomogeneousConditional<charType>::supportsStatePadding( void ) const
+{
+    return false;
+}
+
+
 template<class charType>
 double RevBayesCore::PhyloCTMCSiteHomogeneousConditional<charType>::sumRootLikelihood( void )
 {
@@ -597,9 +597,7 @@ void RevBayesCore::PhyloCTMCSiteHomogeneousDollo::computeTipLikelihood(const Top
 
     
     size_t data_tip_index = this->taxon_name_2_tip_index_map[ node.getName() ];
-    const std::vector<bool> &gap_node = this->gap_matrix[data_tip_index];
-    const std::vector<unsigned long> &char_node = this->char_matrix[data_tip_index];
-    const std::vector<RbBitSet> &amb_char_node = this->ambiguous_char_matrix[data_tip_index];
+    const std::vector<unsigned int> &tip_states_node = this->tip_states[data_tip_index];
     
     // compute the transition probabilities
     updateTransitionProbabilities( node_index );
@@ -627,7 +625,7 @@ void RevBayesCore::PhyloCTMCSiteHomogeneousDollo::computeTipLikelihood(const Top
         {
 
             // is this site a gap?
-            if ( gap_node[site] )
+            if ( isGapTipState( tip_states_node[site] ) == true )
             {
                 for (size_t c = 0; c < dim + 1; c++)
                 {
@@ -643,7 +641,7 @@ void RevBayesCore::PhyloCTMCSiteHomogeneousDollo::computeTipLikelihood(const Top
                 {
                     // compute the likelihood that we had a transition from state c1 to the observed state org_val
                     // note, the observed state could be ambiguous!
-                    const RbBitSet &val = amb_char_node[site];
+                    const RbBitSet &val = this->tip_state_sets[ tip_states_node[site] ];
 
                     for (size_t c = 0; c < dim + 1; c++)
                     {
@@ -680,7 +678,7 @@ void RevBayesCore::PhyloCTMCSiteHomogeneousDollo::computeTipLikelihood(const Top
                 {
                     // get the original character
                     // shift the characters so that a zero state is the (n-1)th state
-                    unsigned long org_val = char_node[site] == 0 ? dim : char_node[site] - 1;
+                    unsigned long org_val = tip_states_node[site] == 0 ? dim : tip_states_node[site] - 1;
 
                     // store the branch likelihoods and integrated node likelihood
                     for (size_t c = 0; c < dim + 1; c++)
@@ -39,22 +39,13 @@ namespace RevBayesCore {
 
 #include "ConstantNode.h"
 #include "DiscreteCharacterState.h"
+#include "PhyloCTMCKernels.h"
 #include "RateMatrix_JC.h"
 #include "RandomNumberFactory.h"
 #include "RbMathLogic.h"
 
 #include <cmath>
 #include <cstring>
-#if defined (SSE_ENABLED)
-#include <xmmintrin.h>
-#include <emmintrin.h>
-#include <pmmintrin.h>
-#elif defined ( AVX_ENABLED )
-#include <xmmintrin.h>
-#include <emmintrin.h>
-#include <pmmintrin.h>
-#include <immintrin.h>
-#endif
 
 template<class charType>
 RevBayesCore::PhyloCTMCSiteHomogeneousNucleotide<charType>::PhyloCTMCSiteHomogeneousNucleotide(const TypedDagNode<Tree> *t, bool c, size_t nSites, bool amb, bool internal, bool gapmatch) : AbstractPhyloCTMCSiteHomogeneous<charType>(  t, 4, 1, c, nSites, amb, internal, gapmatch )
@@ -82,476 +73,125 @@ RevBayesCore::PhyloCTMCSiteHomogeneousNucleotide<charType>* RevBayesCore::PhyloC
 template<class charType>
 void RevBayesCore::PhyloCTMCSiteHomogeneousNucleotide<charType>::computeRootLikelihood( size_t root, size_t left, size_t right)
 {
-    
+
     // reset the likelihood
     this->lnProb = 0.0;
-    
+
+    // get the pointers to the partial likelihoods of the left and right subtree
+          double* p        = this->partialLikelihoods + this->activeLikelihood[root]  * this->activeLikelihoodOffset + root  * this->nodeOffset;
+    const double* p_left   = this->partialLikelihoods + this->activeLikelihood[left]  * this->activeLikelihoodOffset + left  * this->nodeOffset;
+    const double* p_right  = this->partialLikelihoods + this->activeLikelihood[right] * this->activeLikelihoodOffset + right * this->nodeOffset;
+
     // get the root frequencies
-    std::vector<std::vector<double> > ff;
+    std::vector<std::vector<double> >   ff;
     this->getRootFrequencies(ff);
-    
-    // get the pointers to the partial likelihoods of the left and right subtree
-          double* p        = this->partialLikelihoods + this->activeLikelihood[root]  *this->activeLikelihoodOffset + root   * this->nodeOffset;
-    const double* p_left   = this->partialLikelihoods + this->activeLikelihood[left]  *this->activeLikelihoodOffset + left   * this->nodeOffset;
-    const double* p_right  = this->partialLikelihoods + this->activeLikelihood[right] *this->activeLikelihoodOffset + right  * this->nodeOffset;
-    
-    // get pointers the likelihood for both subtrees
-          double*   p_mixture          = p;
-    const double*   p_mixture_left     = p_left;
-    const double*   p_mixture_right    = p_right;
+
     // iterate over all mixture categories
     for (size_t mixture = 0; mixture < this->num_site_mixtures; ++mixture)
     {
         // get the root frequencies
         const std::vector<double> &f = ff[mixture % ff.size()];
+        assert(f.size() == this->num_chars);
+
+        // compute the per site and state probabilities with the vectorized kernel
+        size_t offset = mixture*this->mixtureOffset;
+        PhyloCTMCKernels::computeRootLikelihood( &f[0], p_left + offset, p_right + offset, p + offset, this->pattern_block_size, this->num_chars, this->siteOffset );
 
-        // get pointers to the likelihood for this mixture category
-              double*   p_site_mixture          = p_mixture;
-        const double*   p_site_mixture_left     = p_mixture_left;
-        const double*   p_site_mixture_right    = p_mixture_right;
-        // iterate over all sites
-        for (size_t site = 0; site < this->pattern_block_size; ++site)
-        {
-            
-            p_site_mixture[0] = p_site_mixture_left[0] * p_site_mixture_right[0] * f[0];
-            p_site_mixture[1] = p_site_mixture_left[1] * p_site_mixture_right[1] * f[1];
-            p_site_mixture[2] = p_site_mixture_left[2] * p_site_mixture_right[2] * f[2];
-            p_site_mixture[3] = p_site_mixture_left[3] * p_site_mixture_right[3] * f[3];
-            
-            // increment the pointers to the next site
-            p_site_mixture+=this->siteOffset; p_site_mixture_left+=this->siteOffset; p_site_mixture_right+=this->siteOffset;
-            
-        } // end-for over all sites (=patterns)
-        
-        // increment the pointers to the next mixture category
-        p_mixture+=this->mixtureOffset; p_mixture_left+=this->mixtureOffset; p_mixture_right+=this->mixtureOffset;
-        
     } // end-for over all mixtures (=rate categories)
-    
+
 }
 
+
 template<class charType>
 void RevBayesCore::PhyloCTMCSiteHomogeneousNucleotide<charType>::computeRootLikelihood( size_t root, size_t left, size_t right, size_t middle)
 {
-    
+
     // reset the likelihood
     this->lnProb = 0.0;
-    
+
+    // get the pointers to the partial likelihoods of the left and right subtree
+          double* p        = this->partialLikelihoods + this->activeLikelihood[root]   * this->activeLikelihoodOffset + root   * this->nodeOffset;
+    const double* p_left   = this->partialLikelihoods + this->activeLikelihood[left]   * this->activeLikelihoodOffset + left   * this->nodeOffset;
+    const double* p_right  = this->partialLikelihoods + this->activeLikelihood[right]  * this->activeLikelihoodOffset + right  * this->nodeOffset;
+    const double* p_middle = this->partialLikelihoods + this->activeLikelihood[middle] * this->activeLikelihoodOffset + middle * this->nodeOffset;
+
     // get the root frequencies
-    std::vector<std::vector<double> > ff;
+    std::vector<std::vector<double> >   ff;
     this->getRootFrequencies(ff);
-    
-    // get the pointers to the partial likelihoods of the left and right subtree
-          double* p        = this->partialLikelihoods + this->activeLikelihood[root]  *this->activeLikelihoodOffset + root   * this->nodeOffset;
-    const double* p_left   = this->partialLikelihoods + this->activeLikelihood[left]  *this->activeLikelihoodOffset + left   * this->nodeOffset;
-    const double* p_right  = this->partialLikelihoods + this->activeLikelihood[right] *this->activeLikelihoodOffset + right  * this->nodeOffset;
-    const double* p_middle = this->partialLikelihoods + this->activeLikelihood[middle]*this->activeLikelihoodOffset + middle * this->nodeOffset;
-    
-    // get pointers the likelihood for both subtrees
-          double*   p_mixture          = p;
-    const double*   p_mixture_left     = p_left;
-    const double*   p_mixture_right    = p_right;
-    const double*   p_mixture_middle   = p_middle;
+
     // iterate over all mixture categories
     for (size_t mixture = 0; mixture < this->num_site_mixtures; ++mixture)
     {
         // get the root frequencies
         const std::vector<double> &f = ff[mixture % ff.size()];
+        assert(f.size() == this->num_chars);
+
+        // compute the per site and state probabilities with the vectorized kernel
+        size_t offset = mixture*this->mixtureOffset;
+        PhyloCTMCKernels::computeRootLikelihood( &f[0], p_left + offset, p_right + offset, p_middle + offset, p + offset, this->pattern_block_size, this->num_chars, this->siteOffset );
 
-        // get pointers to the likelihood for this mixture category
-              double*   p_site_mixture          = p_mixture;
-        const double*   p_site_mixture_left     = p_mixture_left;
-        const double*   p_site_mixture_right    = p_mixture_right;
-        const double*   p_site_mixture_middle   = p_mixture_middle;
-        // iterate over all sites
-        for (size_t site = 0; site < this->pattern_block_size; ++site)
-        {   
-            p_site_mixture[0] = p_site_mixture_left[0] * p_site_mixture_right[0] * p_site_mixture_middle[0] * f[0];
-            p_site_mixture[1] = p_site_mixture_left[1] * p_site_mixture_right[1] * p_site_mixture_middle[1] * f[1];
-            p_site_mixture[2] = p_site_mixture_left[2] * p_site_mixture_right[2] * p_site_mixture_middle[2] * f[2];
-            p_site_mixture[3] = p_site_mixture_left[3] * p_site_mixture_right[3] * p_site_mixture_middle[3] * f[3];
-            
-            // increment the pointers to the next site
-            p_site_mixture+=this->siteOffset; p_site_mixture_left+=this->siteOffset; p_site_mixture_right+=this->siteOffset; p_site_mixture_middle+=this->siteOffset;
-            
-        } // end-for over all sites (=patterns)
-        
-        // increment the pointers to the next mixture category
-        p_mixture+=this->mixtureOffset; p_mixture_left+=this->mixtureOffset; p_mixture_right+=this->mixtureOffset; p_mixture_middle+=this->mixtureOffset;
-        
     } // end-for over all mixtures (=rate categories)
-    
+
 }
 
 
 template<class charType>
-void RevBayesCore::PhyloCTMCSiteHomogeneousNucleotide<charType>::computeInternalNodeLikelihood(const TopologyNode &node, size_t node_index, size_t left, size_t right) 
-{   
-    
+void RevBayesCore::PhyloCTMCSiteHomogeneousNucleotide<charType>::computeInternalNodeLikelihood(const TopologyNode &node, size_t node_index, size_t left, size_t right)
+{
+
     // compute the transition probability matrix
-//    this->updateTransitionProbabilities( node_index );
     size_t pmat_offset = this->active_pmatrices[node_index] * this->activePmatrixOffset + node_index * this->pmatNodeOffset;
-    
-#   if defined ( SSE_ENABLED )
-    
-    double* p_left   = this->partialLikelihoods + this->activeLikelihood[left]*this->activeLikelihoodOffset + left*this->nodeOffset;
-    double* p_right  = this->partialLikelihoods + this->activeLikelihood[right]*this->activeLikelihoodOffset + right*this->nodeOffset;
-    double* p_node   = this->partialLikelihoods + this->activeLikelihood[node_index]*this->activeLikelihoodOffset + node_index*this->nodeOffset;
-    //    __m128d* p_left   = (__m128d *) this->partialLikelihoods + this->activeLikelihood[left]*this->activeLikelihoodOffset + left*this->nodeOffset;
-    //    __m128d* p_right  = (__m128d *) this->partialLikelihoods + this->activeLikelihood[right]*this->activeLikelihoodOffset + right*this->nodeOffset;
-    //    __m128d* p_node   = (__m128d *) this->partialLikelihoods + this->activeLikelihood[node_index]*this->activeLikelihoodOffset + node_index*this->nodeOffset;
-    
-#   elif defined ( AVX_ENABLED )
-
-    double* p_left   = this->partialLikelihoods + this->activeLikelihood[left]*this->activeLikelihoodOffset + left*this->nodeOffset;
-    double* p_right  = this->partialLikelihoods + this->activeLikelihood[right]*this->activeLikelihoodOffset + right*this->nodeOffset;
-    double* p_node   = this->partialLikelihoods + this->activeLikelihood[node_index]*this->activeLikelihoodOffset + node_index*this->nodeOffset;
-
-    double* tmp_ac = new double[4];
-    double* tmp_gt = new double[4];
-//    double tmp_ac[4];
-//    double tmp_gt[4];
-    
-    
-#   else
 
     // get the pointers to the partial likelihoods for this node and the two descendant subtrees
     const double*   p_left  = this->partialLikelihoods + this->activeLikelihood[left]*this->activeLikelihoodOffset + left*this->nodeOffset;
     const double*   p_right = this->partialLikelihoods + this->activeLikelihood[right]*this->activeLikelihoodOffset + right*this->nodeOffset;
     double*         p_node  = this->partialLikelihoods + this->activeLikelihood[node_index]*this->activeLikelihoodOffset + node_index*this->nodeOffset;
 
-#   endif
-    
     // iterate over all mixture categories
     for (size_t mixture = 0; mixture < this->num_site_mixtures; ++mixture)
     {
         // the transition probability matrix for this mixture category
-//         const double* tp_begin = this->transition_prob_matrices[mixture].theMatrix;
         const double* tp_begin = this->pmatrices[pmat_offset + mixture].theMatrix;
-        
-        // get the pointers to the likelihood for this mixture category
-        size_t offset = mixture*this->mixtureOffset;
-        
-#       if defined ( SSE_ENABLED )
-        
-        double*          p_site_mixture          = p_node + offset;
-        const double*    p_site_mixture_left     = p_left + offset;
-        const double*    p_site_mixture_right    = p_right + offset;
-        
-        __m128d tp_a_ac = _mm_load_pd(tp_begin);
-        __m128d tp_a_gt = _mm_load_pd(tp_begin+2);
-        __m128d tp_c_ac = _mm_load_pd(tp_begin+4);
-        __m128d tp_c_gt = _mm_load_pd(tp_begin+6);
-        __m128d tp_g_ac = _mm_load_pd(tp_begin+8);
-        __m128d tp_g_gt = _mm_load_pd(tp_begin+10);
-        __m128d tp_t_ac = _mm_load_pd(tp_begin+12);
-        __m128d tp_t_gt = _mm_load_pd(tp_begin+14);
-        
-#       elif defined ( AVX_ENABLED )
-        
-        double*          p_site_mixture          = p_node + offset;
-        const double*    p_site_mixture_left     = p_left + offset;
-        const double*    p_site_mixture_right    = p_right + offset;
-        
-        __m256d tp_a = _mm256_load_pd(tp_begin);
-        __m256d tp_c = _mm256_load_pd(tp_begin+4);
-        __m256d tp_g = _mm256_load_pd(tp_begin+8);
-        __m256d tp_t = _mm256_load_pd(tp_begin+12);
-        
-#       else
-
-        double*          p_site_mixture          = p_node + offset;
-        const double*    p_site_mixture_left     = p_left + offset;
-        const double*    p_site_mixture_right    = p_right + offset;
-
-#       endif
-
-        // compute the per site probabilities
-        for (size_t site = 0; site < this->pattern_block_size ; ++site)
-        {
-            
-#           if defined ( SSE_ENABLED )
-            
-            __m128d a01 = _mm_load_pd(p_site_mixture_left);
-            __m128d a23 = _mm_load_pd(p_site_mixture_left+2);
-            
-            __m128d b01 = _mm_load_pd(p_site_mixture_right);
-            __m128d b23 = _mm_load_pd(p_site_mixture_right+2);
-            
-            __m128d p01 = _mm_mul_pd(a01,b01);
-            __m128d p23 = _mm_mul_pd(a23,b23);
-            
-            __m128d a_ac = _mm_mul_pd(p01, tp_a_ac   );
-            __m128d a_gt = _mm_mul_pd(p23, tp_a_gt );
-            __m128d a_acgt = _mm_hadd_pd(a_ac,a_gt);
-            
-            __m128d c_ac = _mm_mul_pd(p01, tp_c_ac );
-            __m128d c_gt = _mm_mul_pd(p23, tp_c_gt );
-            __m128d c_acgt = _mm_hadd_pd(c_ac,c_gt);
-            
-            __m128d ac = _mm_hadd_pd(a_acgt,c_acgt);
-            _mm_store_pd(p_site_mixture,ac);
-            
-            
-            __m128d g_ac = _mm_mul_pd(p01, tp_g_ac  );
-            __m128d g_gt = _mm_mul_pd(p23, tp_g_gt );
-            __m128d g_acgt = _mm_hadd_pd(g_ac,g_gt);
-            
-            __m128d t_ac = _mm_mul_pd(p01, tp_t_ac );
-            __m128d t_gt = _mm_mul_pd(p23, tp_t_gt );
-            __m128d t_acgt = _mm_hadd_pd(t_ac,t_gt);
-            
-            __m128d gt = _mm_hadd_pd(g_acgt,t_acgt);
-            _mm_store_pd(p_site_mixture+2,gt);
- 
-#           elif defined ( AVX_ENABLED )
- 
-            __m256d a = _mm256_load_pd(p_site_mixture_left);
-            __m256d b = _mm256_load_pd(p_site_mixture_right);
-            __m256d p = _mm256_mul_pd(a,b);
-            
-            __m256d a_acgt = _mm256_mul_pd(p, tp_a );
-            __m256d c_acgt = _mm256_mul_pd(p, tp_c );
-            __m256d g_acgt = _mm256_mul_pd(p, tp_g );
-            __m256d t_acgt = _mm256_mul_pd(p, tp_t );
-            
-            __m256d ac   = _mm256_hadd_pd(a_acgt,c_acgt);
-            __m256d gt   = _mm256_hadd_pd(g_acgt,t_acgt);
-            
-            
-            _mm256_store_pd(tmp_ac,ac);
-            _mm256_store_pd(tmp_gt,gt);
-            
-            p_site_mixture[0] = tmp_ac[0] + tmp_ac[2];
-            p_site_mixture[1] = tmp_ac[1] + tmp_ac[3];
-            p_site_mixture[2] = tmp_gt[0] + tmp_gt[2];
-            p_site_mixture[3] = tmp_gt[1] + tmp_gt[3];
-
-#           else
-
-            double p0 = p_site_mixture_left[0] * p_site_mixture_right[0];
-            double p1 = p_site_mixture_left[1] * p_site_mixture_right[1];
-            double p2 = p_site_mixture_left[2] * p_site_mixture_right[2];
-            double p3 = p_site_mixture_left[3] * p_site_mixture_right[3];
-            
-            double sum = p0 * tp_begin[0];
-            sum += p1 * tp_begin[1];
-            sum += p2 * tp_begin[2];
-            sum += p3 * tp_begin[3];
-            
-            p_site_mixture[0] = sum;
-            
-            sum = p0 * tp_begin[4];
-            sum += p1 * tp_begin[5];
-            sum += p2 * tp_begin[6];
-            sum += p3 * tp_begin[7];
-            
-            p_site_mixture[1] = sum;
-            
-            sum = p0 * tp_begin[8];
-            sum += p1 * tp_begin[9];
-            sum += p2 * tp_begin[10];
-            sum += p3 * tp_begin[11];
-            
-            p_site_mixture[2] = sum;
-            
-            sum = p0 * tp_begin[12];
-            sum += p1 * tp_begin[13];
-            sum += p2 * tp_begin[14];
-            sum += p3 * tp_begin[15];
-            
-            p_site_mixture[3] = sum;
 
-#           endif
-            
-            // increment the pointers to the next site
-            p_site_mixture_left+=this->siteOffset; p_site_mixture_right+=this->siteOffset; p_site_mixture+=this->siteOffset;
+        // compute the per site probabilities with the vectorized kernel
+        size_t offset = mixture*this->mixtureOffset;
+        PhyloCTMCKernels::computeInternalNodeLikelihood( tp_begin, p_left + offset, p_right + offset, p_node + offset, this->pattern_block_size, this->num_chars, this->siteOffset );
 
-                        
-        } // end-for over all sites (=patterns)
-        
     } // end-for over all mixtures (=rate-categories)
 
-# if defined ( AVX_ENABLED )
-    delete[] tmp_ac;
-    delete[] tmp_gt;
-# endif
-    
 }
 
 
 template<class charType>
 void RevBayesCore::PhyloCTMCSiteHomogeneousNucleotide<charType>::computeInternalNodeLikelihood(const TopologyNode &node, size_t node_index, size_t left, size_t right, size_t middle)
 {
-    
+
     // compute the transition probability matrix
-//     this->updateTransitionProbabilities( node_index );
     size_t pmat_offset = this->active_pmatrices[node_index] * this->activePmatrixOffset + node_index * this->pmatNodeOffset;
-    
-    // get the pointers to the partial likelihoods for this node and the two descendant subtrees
+
+    // get the pointers to the partial likelihoods for this node and the three descendant subtrees
     const double*   p_left      = this->partialLikelihoods + this->activeLikelihood[left]*this->activeLikelihoodOffset + left*this->nodeOffset;
     const double*   p_middle    = this->partialLikelihoods + this->activeLikelihood[middle]*this->activeLikelihoodOffset + middle*this->nodeOffset;
     const double*   p_right     = this->partialLikelihoods + this->activeLikelihood[right]*this->activeLikelihoodOffset + right*this->nodeOffset;
     double*         p_node      = this->partialLikelihoods + this->activeLikelihood[node_index]*this->activeLikelihoodOffset + node_index*this->nodeOffset;
-    
+
     // iterate over all mixture categories
     for (size_t mixture = 0; mixture < this->num_site_mixtures; ++mixture)
     {
         // the transition probability matrix for this mixture category
-//         const double* tp_begin = this->transition_prob_matrices[mixture].theMatrix;
         const double* tp_begin = this->pmatrices[pmat_offset + mixture].theMatrix;
-        
-        // get the pointers to the likelihood for this mixture category
+
+        // compute the per site probabilities with the vectorized kernel
         size_t offset = mixture*this->mixtureOffset;
-        
-#       if defined ( SSE_ENABLED )
-        
-        double*          p_site_mixture          = p_node + offset;
-        const double*    p_site_mixture_left     = p_left + offset;
-        const double*    p_site_mixture_middle   = p_middle + offset;
-        const double*    p_site_mixture_right    = p_right + offset;
-        
-        __m128d tp_a_ac = _mm_load_pd(tp_begin);
-        __m128d tp_a_gt = _mm_load_pd(tp_begin+2);
-        __m128d tp_c_ac = _mm_load_pd(tp_begin+4);
-        __m128d tp_c_gt = _mm_load_pd(tp_begin+6);
-        __m128d tp_g_ac = _mm_load_pd(tp_begin+8);
-        __m128d tp_g_gt = _mm_load_pd(tp_begin+10);
-        __m128d tp_t_ac = _mm_load_pd(tp_begin+12);
-        __m128d tp_t_gt = _mm_load_pd(tp_begin+14);
-        
-#       elif defined ( AVX_ENABLED )
-        
-        double*          p_site_mixture          = p_node + offset;
-        const double*    p_site_mixture_left     = p_left + offset;
-        const double*    p_site_mixture_right    = p_right + offset;
-        
-        __m256d tp_a = _mm256_load_pd(tp_begin);
-        __m256d tp_c = _mm256_load_pd(tp_begin+4);
-        __m256d tp_g = _mm256_load_pd(tp_begin+8);
-        __m256d tp_t = _mm256_load_pd(tp_begin+12);
-        
-#       else
-        
-        double*          p_site_mixture          = p_node + offset;
-        const double*    p_site_mixture_left     = p_left + offset;
-        const double*    p_site_mixture_middle   = p_middle + offset;
-        const double*    p_site_mixture_right    = p_right + offset;
-        
-#       endif
-        
-        // compute the per site probabilities
-        for (size_t site = 0; site < this->pattern_block_size ; ++site)
-        {
-            
-#           if defined ( SSE_ENABLED )
-            
-            __m128d a01 = _mm_load_pd(p_site_mixture_left);
-            __m128d a23 = _mm_load_pd(p_site_mixture_left+2);
-            
-            __m128d b01 = _mm_load_pd(p_site_mixture_middle);
-            __m128d b23 = _mm_load_pd(p_site_mixture_middle+2);
-            
-            __m128d c01 = _mm_load_pd(p_site_mixture_right);
-            __m128d c23 = _mm_load_pd(p_site_mixture_right+2);
-            
-            __m128d tmp_p01 = _mm_mul_pd(a01,b01);
-            __m128d p01 = _mm_mul_pd(tmp_p01,c01);
-            __m128d tmp_p23 = _mm_mul_pd(a23,b23);
-            __m128d p23 = _mm_mul_pd(tmp_p23,c23);
-            
-            __m128d a_ac = _mm_mul_pd(p01, tp_a_ac   );
-            __m128d a_gt = _mm_mul_pd(p23, tp_a_gt );
-            __m128d a_acgt = _mm_hadd_pd(a_ac,a_gt);
-            
-            __m128d c_ac = _mm_mul_pd(p01, tp_c_ac );
-            __m128d c_gt = _mm_mul_pd(p23, tp_c_gt );
-            __m128d c_acgt = _mm_hadd_pd(c_ac,c_gt);
-            
+        PhyloCTMCKernels::computeInternalNodeLikelihood( tp_begin, p_left + offset, p_right + offset, p_middle + offset, p_node + offset, this->pattern_block_size, this->num_chars, this->siteOffset );
 
-            //            *p_site_mixture = _mm_hadd_pd(a_acgt,c_acgt);
-            __m128d ac = _mm_hadd_pd(a_acgt,c_acgt);
-            _mm_store_pd(p_site_mixture,ac);
-            
-            
-            __m128d g_ac = _mm_mul_pd(p01, tp_g_ac  );
-            __m128d g_gt = _mm_mul_pd(p23, tp_g_gt );
-            __m128d g_acgt = _mm_hadd_pd(g_ac,g_gt);
-            
-            __m128d t_ac = _mm_mul_pd(p01, tp_t_ac );
-            __m128d t_gt = _mm_mul_pd(p23, tp_t_gt );
-            __m128d t_acgt = _mm_hadd_pd(t_ac,t_gt);
-            
-            //            p_site_mixture[2] = _mm_hadd_pd(g_acgt,t_acgt);
-            __m128d gt = _mm_hadd_pd(g_acgt,t_acgt);
-            _mm_store_pd(p_site_mixture+2,gt);
-            
-#           elif defined ( AVX_ENABLED )
-            
-            __m256d a = _mm256_load_pd(p_site_mixture_left);
-            __m256d b = _mm256_load_pd(p_site_mixture_right);
-            __m256d p = _mm_mul_pd(a,b);
-            
-            __m256d a_acgt = _mm256_mul_pd(p, tp_a );
-            __m256d c_acgt = _mm256_mul_pd(p, tp_c );
-            __m256d g_acgt = _mm256_mul_pd(p, tp_g );
-            __m256d t_acgt = _mm256_mul_pd(p, tp_t );
-            
-            __m256d ac   = _mm256_hadd_pd(a_acgt,c_acgt);
-            __m256d gt   = _mm256_hadd_pd(g_acgt,t_acgt)
-            
-            __m256d acgt = _mm256_hadd_pd(ac,gt);
-            
-            _mm256_store_pd(p_site_mixture,acgt);
-            
-#           else
-            
-            double p0 = p_site_mixture_left[0] * p_site_mixture_middle[0] * p_site_mixture_right[0];
-            double p1 = p_site_mixture_left[1] * p_site_mixture_middle[1] * p_site_mixture_right[1];
-            double p2 = p_site_mixture_left[2] * p_site_mixture_middle[2] * p_site_mixture_right[2];
-            double p3 = p_site_mixture_left[3] * p_site_mixture_middle[3] * p_site_mixture_right[3];
-            
-            double sum = p0 * tp_begin[0];
-            sum += p1 * tp_begin[1];
-            sum += p2 * tp_begin[2];
-            sum += p3 * tp_begin[3];
-            
-            p_site_mixture[0] = sum;
-            
-            sum = p0 * tp_begin[4];
-            sum += p1 * tp_begin[5];
-            sum += p2 * tp_begin[6];
-            sum += p3 * tp_begin[7];
-            
-            p_site_mixture[1] = sum;
-            
-            sum = p0 * tp_begin[8];
-            sum += p1 * tp_begin[9];
-            sum += p2 * tp_begin[10];
-            sum += p3 * tp_begin[11];
-            
-            p_site_mixture[2] = sum;
-            
-            sum = p0 * tp_begin[12];
-            sum += p1 * tp_begin[13];
-            sum += p2 * tp_begin[14];
-            sum += p3 * tp_begin[15];
-            
-            p_site_mixture[3] = sum;
-            
-#           endif
-            
-            // increment the pointers to the next site
-            p_site_mixture_left+=this->siteOffset; p_site_mixture_middle+=this->siteOffset; p_site_mixture_right+=this->siteOffset; p_site_mixture+=this->siteOffset;
-            
-            
-        } // end-for over all sites (=patterns)
-        
     } // end-for over all mixtures (=rate-categories)
-    
+
 }
 
 
+
+
 template<class charType>
 void RevBayesCore::PhyloCTMCSiteHomogeneousNucleotide<charType>::computeTipLikelihood(const TopologyNode &node, size_t node_index) 
 {    
@@ -559,9 +199,7 @@ void RevBayesCore::PhyloCTMCSiteHomogeneousNucleotide<charType>::computeTipLikel
     double* p_node = this->partialLikelihoods + this->activeLikelihood[node_index]*this->activeLikelihoodOffset + node_index*this->nodeOffset;
     
     size_t data_tip_index = this->taxon_name_2_tip_index_map[ node.getName() ];
-    const std::vector<bool> &gap_node = this->gap_matrix[data_tip_index];
-    const std::vector<unsigned long> &char_node = this->char_matrix[data_tip_index];
-    const std::vector<RbBitSet> &amb_char_node = this->ambiguous_char_matrix[data_tip_index];
+    const std::vector<unsigned int> &tip_states_node = this->tip_states[data_tip_index];
     
     // compute the transition probabilities
 //     this->updateTransitionProbabilities( node_index );
@@ -576,6 +214,10 @@ void RevBayesCore::PhyloCTMCSiteHomogeneousNucleotide<charType>::computeTipLikel
 //         const double*       tp_begin    = this->transition_prob_matrices[mixture].theMatrix;
         const double*       tp_begin    = this->pmatrices[pmat_offset + mixture].theMatrix;
         
+        // compute the tip likelihoods of each state code (A, C, G, T, gap and the ambiguous states) once for this branch
+        this->computeTipStateLikelihoods( tp_begin );
+        const double*       p_states    = this->tip_state_likelihoods.data();
+        
         // get the pointer to the likelihoods for this site and mixture category
         double*     p_site_mixture      = p_mixture;
         
@@ -583,83 +225,12 @@ void RevBayesCore::PhyloCTMCSiteHomogeneousNucleotide<charType>::computeTipLikel
         for (size_t site = 0; site < this->pattern_block_size; ++site)
         {
             
-            // is this site a gap?
-            if ( gap_node[site] ) 
-            {
-                // since this is a gap we need to assume that the actual state could have been any state
-                p_site_mixture[0] = 1.0;
-                p_site_mixture[1] = 1.0;
-                p_site_mixture[2] = 1.0;
-                p_site_mixture[3] = 1.0;
-                
-            } 
-            else // we have observed a character
-            {
-                                    
-                if ( this->using_ambiguous_characters == true )
-                {
-                    // get the original character
-                    const RbBitSet &org_val = amb_char_node[site];
-                    
-                    double p0 = 0.0;
-                    double p1 = 0.0;
-                    double p2 = 0.0;
-                    double p3 = 0.0;
-                    
-                    if ( org_val.test(0) == true )
-                    {
-                        p0 = tp_begin[0];
-                        p1 = tp_begin[4];
-                        p2 = tp_begin[8];
-                        p3 = tp_begin[12];
-                    }
-                    
-                    if ( org_val.test(1) == true )
-                    {
-                        p0 += tp_begin[1];
-                        p1 += tp_begin[5];
-                        p2 += tp_begin[9];
-                        p3 += tp_begin[13];
-                    }
-                    
-                    if ( org_val.test(2) == true )
-                    {
-                        p0 += tp_begin[2];
-                        p1 += tp_begin[6];
-                        p2 += tp_begin[10];
-                        p3 += tp_begin[14];
-                    }
-                    
-                    if ( org_val.test(3) == true )
-                    {
-                        p0 += tp_begin[3];
-                        p1 += tp_begin[7];
-                        p2 += tp_begin[11];
-                        p3 += tp_begin[15];
-                    }
-                    
-                    p_site_mixture[0] = p0;
-                    p_site_mixture[1] = p1;
-                    p_site_mixture[2] = p2;
-                    p_site_mixture[3] = p3;
-                    
-                } 
-                else // no ambiguous characters in use
-                {
-                    
-                    // get the original character
-                    unsigned long org_val = char_node[site];
-                    
-                    // store the likelihood
-                    p_site_mixture[0] = tp_begin[org_val];
-                    p_site_mixture[1] = tp_begin[4+org_val];
-                    p_site_mixture[2] = tp_begin[8+org_val];
-                    p_site_mixture[3] = tp_begin[12+org_val];
-                        
-                }
-                
-            } // end-if a gap state
-            
+            // look up the likelihoods of the observed (possibly ambiguous) state
+            const double* p_state = p_states + 4*tip_states_node[site];
+            p_site_mixture[0] = p_state[0];
+            p_site_mixture[1] = p_state[1];
+            p_site_mixture[2] = p_state[2];
+            p_site_mixture[3] = p_state[3];
             
             // increment the pointers to next site
             p_site_mixture+=this->siteOffset; 
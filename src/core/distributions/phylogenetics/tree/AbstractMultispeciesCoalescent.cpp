@@ -1,5 +1,7 @@
 #include <stddef.h>
+#include <algorithm>
 #include <cmath>
+#include <functional>
 #include <iostream>
 #include <map>
 #include <set>
@@ -13,10 +15,12 @@
 #include "RandomNumberGenerator.h"
 #include "RbConstants.h"
 #include "RbMathCombinatorialFunctions.h"
+#include "StochasticNode.h"
 #include "TopologyNode.h"
 #include "RbException.h"
 #include "Taxon.h"
 #include "Tree.h"
+#include "TreeChangeEventHandler.h"
 #include "TypedDagNode.h"
 #include "TypedDistribution.h"
 
@@ -28,7 +32,10 @@ AbstractMultispeciesCoalescent::AbstractMultispeciesCoalescent(const TypedDagNod
     taxa(t),
     species_tree( sp ),
     num_taxa( taxa.size() ),
-    log_tree_topology_prob (0.0)
+    log_tree_topology_prob (0.0),
+    branch_ln_probabilities_changed( false ),
+    dirty_branch_probabilities( true ),
+    current_stamp( 0 )
 {
     // add the parameters to our set (in the base class)
     // in that way other class can easily access the set of our parameters
@@ -53,6 +60,17 @@ AbstractMultispeciesCoalescent::AbstractMultispeciesCoalescent(const TypedDagNod
 AbstractMultispeciesCoalescent::~AbstractMultispeciesCoalescent()
 {
     
+    // remove myself from the tree listeners
+    if ( species_tree != NULL )
+    {
+        species_tree->getValue().getTreeChangeEventHandler().removeListener( this );
+    }
+    
+    if ( value != NULL )
+    {
+        value->getTreeChangeEventHandler().removeListener( this );
+    }
+    
 }
 
 
@@ -129,17 +147,207 @@ void AbstractMultispeciesCoalescent::buildRandomBinaryTree(std::vector<TopologyN
 }
 
 
-double AbstractMultispeciesCoalescent::computeLnProbability( void )
+/**
+ * Walk the gene lineages through a species branch.
+ * The entering lineages are the gene tips of a species tip or the lineages leaving the child branches.
+ * We then process the coalescences in the order of their ages until we reach the age of the parent species,
+ * and store the coalescent times and the remaining lineages in the active buffer of this branch.
+ */
+void AbstractMultispeciesCoalescent::computeBranch( const TopologyNode &species_node )
 {
-    resetTipAllocations();
     
-    // variable declarations and initialization
-    double ln_prob_coal = 0;
+    size_t species_index = species_node.getIndex();
+    
+    // if we previously haven't touched this branch, then we need to change the active buffer
+    if ( changed_branches[species_index] == false )
+    {
+        active_branch[species_index] = (active_branch[species_index] == 0 ? 1 : 0);
+        changed_branches[species_index] = true;
+    }
+    size_t active = active_branch[species_index];
+    
+    std::vector<double> &coal_times = branch_coalescent_times[active][species_index];
+    std::vector<size_t> &outgoing_lineages = branch_outgoing_lineages[active][species_index];
+    coal_times.clear();
+    outgoing_lineages.clear();
+    
+    // collect the entering lineages
+    branch_lineages.clear();
+    if ( species_node.isTip() == true )
+    {
+        const std::vector<size_t> &individuals = individuals_per_branch[species_index];
+        branch_lineages.insert( branch_lineages.end(), individuals.begin(), individuals.end() );
+    }
+    else
+    {
+        for (size_t i=0; i<species_node.getNumberOfChildren(); ++i)
+        {
+            size_t child_index = species_node.getChild(i).getIndex();
+            const std::vector<size_t> &incoming = branch_outgoing_lineages[active_branch[child_index]][child_index];
+            branch_lineages.insert( branch_lineages.end(), incoming.begin(), incoming.end() );
+        }
+    }
+    size_t num_entering_lineages = branch_lineages.size();
+    
+    double parent_species_age = RbConstants::Double::inf;
+    if ( species_node.isRoot() == false )
+    {
+        parent_species_age = species_node.getParent().getAge();
+    }
+    
+    // a lineage is in this branch if its stamp is the current stamp
+    ++current_stamp;
+    
+    // the candidate coalescences are kept in a min-heap on their ages
+    const std::vector<TopologyNode*> &gene_nodes = value->getNodes();
+    coalescence_heap.clear();
+    for (size_t i=0; i<num_entering_lineages; ++i)
+    {
+        const TopologyNode *ind = gene_nodes[ branch_lineages[i] ];
+        lineage_stamps[ branch_lineages[i] ] = current_stamp;
+        if ( ind->isRoot() == false )
+        {
+            const TopologyNode &parent = ind->getParent();
+            coalescence_heap.push_back( std::pair<double, size_t>( parent.getAge(), parent.getIndex() ) );
+            std::push_heap( coalescence_heap.begin(), coalescence_heap.end(), std::greater< std::pair<double, size_t> >() );
+        }
+    }
+    
+    bool valid = true;
+    while ( coalescence_heap.empty() == false && coalescence_heap.front().first < parent_species_age )
+    {
+        double parent_age = coalescence_heap.front().first;
+        size_t parent_index = coalescence_heap.front().second;
+        std::pop_heap( coalescence_heap.begin(), coalescence_heap.end(), std::greater< std::pair<double, size_t> >() );
+        coalescence_heap.pop_back();
+        
+        // both children put the parent on the heap, so we might have seen this coalescence already
+        if ( lineage_stamps[parent_index] == current_stamp )
+        {
+            continue;
+        }
+        
+        // check that all children of the parent are in this species tree branch
+        const TopologyNode *parent = gene_nodes[parent_index];
+        for (size_t i=0; i<parent->getNumberOfChildren(); ++i)
+        {
+            if ( lineage_stamps[ parent->getChild(i).getIndex() ] != current_stamp )
+            {
+                valid = false;
+            }
+        }
+        
+        if ( valid == false )
+        {
+            // one of the children does not belong to this species tree branch
+            break;
+        }
+        
+        // we remove the coalesced lineages and insert the parent
+        for (size_t i=0; i<parent->getNumberOfChildren(); ++i)
+        {
+            lineage_stamps[ parent->getChild(i).getIndex() ] = 0;
+        }
+        lineage_stamps[parent_index] = current_stamp;
+        branch_lineages.push_back( parent_index );
+        gene_node_species_branch[parent_index] = species_index;
+        
+        if ( parent->isRoot() == false )
+        {
+            const TopologyNode &grand_parent = parent->getParent();
+            coalescence_heap.push_back( std::pair<double, size_t>( grand_parent.getAge(), grand_parent.getIndex() ) );
+            std::push_heap( coalescence_heap.begin(), coalescence_heap.end(), std::greater< std::pair<double, size_t> >() );
+        }
+        
+        coal_times.push_back( parent_age );
+    }
+    
+    // the lineages that are still in the branch go into the next species
+    for (size_t i=0; i<branch_lineages.size(); ++i)
+    {
+        if ( lineage_stamps[ branch_lineages[i] ] == current_stamp )
+        {
+            outgoing_lineages.push_back( branch_lineages[i] );
+        }
+    }
+    
+    // an impossible gene tree is flagged by an invalid number of lineages
+    branch_num_lineages[active][species_index] = ( valid == true ? num_entering_lineages : RbConstants::Size_t::max );
+    
+}
+
+
+/**
+ * Compute the contribution of a species branch from the cached walk through it.
+ */
+void AbstractMultispeciesCoalescent::computeBranchLnProbability( const TopologyNode &species_node )
+{
+    
+    size_t species_index = species_node.getIndex();
+    size_t active = active_branch[species_index];
+    size_t num_entering_lineages = branch_num_lineages[active][species_index];
+    
+    double ln_prob_coal = 0.0;
+    if ( num_entering_lineages == RbConstants::Size_t::max )
+    {
+        ln_prob_coal = RbConstants::Double::neginf;
+    }
+    else if ( num_entering_lineages > 1 )
+    {
+        double parent_species_age = RbConstants::Double::inf;
+        if ( species_node.isRoot() == false )
+        {
+            parent_species_age = species_node.getParent().getAge();
+        }
+        ln_prob_coal = computeLnCoalescentProbability(num_entering_lineages, branch_coalescent_times[active][species_index], species_node.getAge(), parent_species_age, species_index, species_node.isRoot() == false);
+    }
+    
+    branch_ln_probabilities[species_index] = ln_prob_coal;
+    
+}
+
+
+double AbstractMultispeciesCoalescent::computeLnProbability( void )
+{
     
     const Tree &sp = species_tree->getValue();
     
-    ln_prob_coal = recursivelyComputeLnProbability( sp.getRoot() );
+    // we need to check here if we still are listining to the trees for change events
+    // the trees could have been replaced without telling us
+    if ( sp.getTreeChangeEventHandler().isListening( this ) == false )
+    {
+        sp.getTreeChangeEventHandler().addListener( this );
+        resetTipAllocations();
+    }
+    if ( value->getTreeChangeEventHandler().isListening( this ) == false )
+    {
+        value->getTreeChangeEventHandler().addListener( this );
+        flagAllBranchesDirty();
+    }
+    
+    const TopologyNode &species_root = sp.getRoot();
+    bool independent = hasIndependentBranchProbabilities();
     
+    if ( dirty_branches[species_root.getIndex()] == true || dirty_branch_probabilities == true || independent == false )
+    {
+        storeBranchProbabilities();
+        
+        // walk only the species branches on the dirty paths
+        recursivelyComputeDirtyBranches( species_root );
+        
+        // the other parameters changed, so we need to re-evaluate the contribution of every branch
+        if ( dirty_branch_probabilities == true || independent == false )
+        {
+            recursivelyComputeBranchProbabilities( species_root );
+            dirty_branch_probabilities = false;
+        }
+    }
+    
+    double ln_prob_coal = 0;
+    for (size_t i=0; i<branch_ln_probabilities.size(); ++i)
+    {
+        ln_prob_coal += branch_ln_probabilities[i];
+    }
     
     return ln_prob_coal; // + logTreeTopologyProb;
     
@@ -153,114 +361,131 @@ double AbstractMultispeciesCoalescent::drawNe( size_t index )
 }
 
 
-double AbstractMultispeciesCoalescent::recursivelyComputeLnProbability( const RevBayesCore::TopologyNode &species_node )
+void AbstractMultispeciesCoalescent::fireTreeChangeEvent( const TopologyNode &n, const unsigned& m )
 {
-
-    double ln_prob_coal = 0;
-
-    if ( species_node.isTip() == false )
+    
+    const std::vector<TopologyNode*> &species_nodes = species_tree->getValue().getNodes();
+    size_t index = n.getIndex();
+    
+    if ( index < species_nodes.size() && species_nodes[index] == &n )
+    {
+        // the ages of this species node and of its children are used in the branches above
+        recursivelyFlagBranchDirty( n );
+    }
+    else
     {
-        individuals_per_branch[ species_node.getIndex() ].clear();
+        // this gene node coalesced in the species branch we cached, and any new position
+        // of it is on the path from one of its (also flagged) children to the root
+        size_t species_index = RbConstants::Size_t::max;
+        if ( index < gene_node_species_branch.size() )
+        {
+            species_index = ( n.isTip() == true ? tip_species_index[index] : gene_node_species_branch[index] );
+        }
         
-        for (size_t i=0; i<species_node.getNumberOfChildren(); ++i)
+        if ( species_index < species_nodes.size() )
+        {
+            recursivelyFlagBranchDirty( *species_nodes[species_index] );
+        }
+        else
         {
-            ln_prob_coal += recursivelyComputeLnProbability( species_node.getChild(i) );
+            flagAllBranchesDirty();
         }
     }
     
-//    const TopologyNode *species_parent_node = NULL;
-    double species_age = species_node.getAge();
-    double parent_species_age = RbConstants::Double::inf;
+}
+
+
+void AbstractMultispeciesCoalescent::flagAllBranchesDirty( void )
+{
     
-    //        double branchLength = RbConstants::Double::inf;
-    if ( species_node.isRoot() == false )
+    for (size_t i=0; i<dirty_branches.size(); ++i)
     {
-        const TopologyNode &species_parent_node = species_node.getParent();
-        parent_species_age = species_parent_node.getAge();
+        dirty_branches[i] = true;
     }
+    dirty_branch_probabilities = true;
     
-    // create a local copy of the individuals per branch
-    const std::set<const TopologyNode*> &initial_individuals = individuals_per_branch[species_node.getIndex()];
-    std::set<const TopologyNode*> remaining_individuals = initial_individuals;
+}
 
-    // get all coalescent events among the individuals
-    std::vector<double> coal_times;
+
+bool AbstractMultispeciesCoalescent::hasIndependentBranchProbabilities( void ) const
+{
     
+    return true;
+}
+
+
+void AbstractMultispeciesCoalescent::keepSpecialization( const DagNode* affecter )
+{
     
-    std::map<double, const TopologyNode *> coal_times_2_nodes;
-    for ( std::set<const TopologyNode*>::iterator it = remaining_individuals.begin(); it != remaining_individuals.end(); ++it)
+    // reset all flags
+    for (size_t i=0; i<dirty_branches.size(); ++i)
     {
-        const TopologyNode *ind = (*it);
-        if ( ind->isRoot() == false )
-        {
-            const TopologyNode &parent = ind->getParent();
-            double parent_age = parent.getAge();
-            coal_times_2_nodes[ parent_age ] = &parent;
-        }
+        dirty_branches[i] = false;
+        changed_branches[i] = false;
     }
+    branch_ln_probabilities_changed = false;
     
-    double current_time = species_age;
-    while ( current_time < parent_species_age && coal_times_2_nodes.size() > 0 )
+}
+
+
+void AbstractMultispeciesCoalescent::recursivelyComputeBranchProbabilities( const TopologyNode &species_node )
+{
+    
+    for (size_t i=0; i<species_node.getNumberOfChildren(); ++i)
     {
+        recursivelyComputeBranchProbabilities( species_node.getChild(i) );
+    }
+    
+    computeBranchLnProbability( species_node );
+    
+}
+
+
+void AbstractMultispeciesCoalescent::recursivelyComputeDirtyBranches( const TopologyNode &species_node )
+{
+    
+    size_t species_index = species_node.getIndex();
+    
+    if ( dirty_branches[species_index] == true )
+    {
+        // the lineages entering this branch need to be up-to-date first
+        for (size_t i=0; i<species_node.getNumberOfChildren(); ++i)
+        {
+            recursivelyComputeDirtyBranches( species_node.getChild(i) );
+        }
         
-        const TopologyNode *parent = coal_times_2_nodes.begin()->second;
-        double parent_age = parent->getAge();
-        current_time = parent_age;
+        computeBranch( species_node );
         
-        if ( parent_age < parent_species_age )
-        { //Coalescence in the species tree branch
-            
-            // get the left and right child of the parent
-            const TopologyNode *left = &parent->getChild( 0 );
-            const TopologyNode *right = &parent->getChild( 1 );
-            if ( remaining_individuals.find( left ) == remaining_individuals.end() || remaining_individuals.find( right ) == remaining_individuals.end() )
-            {
-                // one of the children does not belong to this species tree branch
-                return RbConstants::Double::neginf;
-            }
-            
-            //We remove the coalescent event and the coalesced lineages
-            coal_times_2_nodes.erase( coal_times_2_nodes.begin() );
-            remaining_individuals.erase( remaining_individuals.find( left ) );
-            remaining_individuals.erase( remaining_individuals.find( right ) );
-            
-            //We insert the parent in the vector of lineages in this branch
-            remaining_individuals.insert( parent );
-            if ( parent->isRoot() == false )
-            {
-                const TopologyNode *grand_parent = &parent->getParent();
-                coal_times_2_nodes[ grand_parent->getAge() ] = grand_parent;
-            }
-            
-            coal_times.push_back( parent_age );
-            
-            
-        } //End if coalescence in the species tree branch
-        else
-        { //No more coalescences in this species tree branch
-            
-            // jump out of the while loop
-            //                currentTime = speciesAge;
-            break;
+        // the contribution of an independent branch only depends on the walk through this branch
+        if ( hasIndependentBranchProbabilities() == true && dirty_branch_probabilities == false )
+        {
+            computeBranchLnProbability( species_node );
         }
         
-        
-    } // end of while loop
-    
-    if ( initial_individuals.size() > 1 )
-    {
-        ln_prob_coal += computeLnCoalescentProbability(initial_individuals.size(), coal_times, species_age, parent_species_age, species_node.getIndex(), species_node.isRoot() == false);
+        // mark as computed
+        dirty_branches[species_index] = false;
     }
     
+}
+
+
+void AbstractMultispeciesCoalescent::recursivelyFlagBranchDirty( const TopologyNode &species_node )
+{
     
-    // merge the two sets of individuals that go into the next species
-    if ( species_node.isRoot() == false )
+    size_t species_index = species_node.getIndex();
+    
+    // if this branch is already dirty, then also all the ancestral branches must have been flagged as dirty
+    if ( dirty_branches[species_index] == false )
     {
-        std::set<const TopologyNode *> &incoming_lineages = individuals_per_branch[ species_node.getParent().getIndex() ];
-        incoming_lineages.insert( remaining_individuals.begin(), remaining_individuals.end());
+        dirty_branches[species_index] = true;
+        
+        // the root doesn't have an ancestor
+        if ( species_node.isRoot() == false )
+        {
+            recursivelyFlagBranchDirty( species_node.getParent() );
+        }
     }
-
-    return ln_prob_coal;
+    
 }
 
 
@@ -298,18 +523,74 @@ void AbstractMultispeciesCoalescent::resetTipAllocations( void )
     }
     
     // create a map for the individuals to branches
-    individuals_per_branch = std::vector< std::set< const TopologyNode* > >(sp.getNumberOfNodes(), std::set< const TopologyNode* >() );
+    size_t num_species_nodes = sp.getNumberOfNodes();
+    individuals_per_branch = std::vector< std::vector<size_t> >(num_species_nodes, std::vector<size_t>() );
+    tip_species_index = std::vector<size_t>(num_taxa, RbConstants::Size_t::max);
     for (size_t i=0; i<num_taxa; ++i)
     {
-//        const std::string &tip_name = it->getName();
         const TopologyNode &n = value->getNode( i );
         const std::string &individual_name = n.getName();
         const std::string &species_name = individual_names_2_species_names[ individual_name ];
         
-        TopologyNode *species_node = species_names_2_species_nodes[species_name];
-        individuals_per_branch[ species_node->getIndex() ].insert( &n );
+        std::map<std::string, TopologyNode * >::const_iterator species_it = species_names_2_species_nodes.find( species_name );
+        if ( species_it == species_names_2_species_nodes.end() )
+        {
+            throw RbException("Could not find species '" + species_name + "' of individual '" + individual_name + "' in the species tree.");
+        }
+        
+        size_t species_index = species_it->second->getIndex();
+        individuals_per_branch[ species_index ].push_back( n.getIndex() );
+        tip_species_index[ n.getIndex() ] = species_index;
     }
+    
+    // allocate the cache of the species branches and the scratch buffers
+    size_t num_gene_nodes = value->getNumberOfNodes();
+    branch_coalescent_times         = std::vector< std::vector< std::vector<double> > >(2, std::vector< std::vector<double> >(num_species_nodes, std::vector<double>() ) );
+    branch_outgoing_lineages        = std::vector< std::vector< std::vector<size_t> > >(2, std::vector< std::vector<size_t> >(num_species_nodes, std::vector<size_t>() ) );
+    branch_num_lineages             = std::vector< std::vector<size_t> >(2, std::vector<size_t>(num_species_nodes, 0) );
+    active_branch                   = std::vector<size_t>(num_species_nodes, 0);
+    changed_branches                = std::vector<bool>(num_species_nodes, false);
+    dirty_branches                  = std::vector<bool>(num_species_nodes, true);
+    branch_ln_probabilities         = std::vector<double>(num_species_nodes, 0.0);
+    stored_branch_ln_probabilities  = std::vector<double>(num_species_nodes, 0.0);
+    gene_node_species_branch        = std::vector<size_t>(num_gene_nodes, RbConstants::Size_t::max);
+    stored_gene_node_species_branch = std::vector<size_t>(num_gene_nodes, RbConstants::Size_t::max);
+    branch_ln_probabilities_changed = false;
+    
+    coalescence_heap.reserve( num_gene_nodes );
+    branch_lineages.reserve( num_gene_nodes );
+    lineage_stamps = std::vector<size_t>(num_gene_nodes, 0);
+    current_stamp = 0;
+    
+    flagAllBranchesDirty();
+    
+}
 
+
+void AbstractMultispeciesCoalescent::restoreSpecialization( const DagNode *restorer )
+{
+    
+    for (size_t i=0; i<dirty_branches.size(); ++i)
+    {
+        // we have to restore, that means if we have changed the active buffer
+        // then we need to revert this change
+        if ( changed_branches[i] == true )
+        {
+            active_branch[i] = (active_branch[i] == 0 ? 1 : 0);
+        }
+        
+        // reset all flags
+        dirty_branches[i] = false;
+        changed_branches[i] = false;
+    }
+    
+    if ( branch_ln_probabilities_changed == true )
+    {
+        branch_ln_probabilities.swap( stored_branch_ln_probabilities );
+        gene_node_species_branch.swap( stored_gene_node_species_branch );
+        branch_ln_probabilities_changed = false;
+    }
+    dirty_branch_probabilities = false;
     
 }
 
@@ -487,7 +768,52 @@ void AbstractMultispeciesCoalescent::swapParameterInternal(const DagNode *oldP,
     
     if ( oldP == species_tree )
     {
+        species_tree->getValue().getTreeChangeEventHandler().removeListener( this );
         species_tree = static_cast<const TypedDagNode< Tree >* >( newP );
+        species_tree->getValue().getTreeChangeEventHandler().addListener( this );
+        
+        resetTipAllocations();
+    }
+    else
+    {
+        flagAllBranchesDirty();
+    }
+    
+}
+
+
+/**
+ * Remember the current contributions and gene node positions before we change them, so that we can restore them.
+ */
+void AbstractMultispeciesCoalescent::storeBranchProbabilities( void )
+{
+    
+    if ( branch_ln_probabilities_changed == false )
+    {
+        stored_branch_ln_probabilities = branch_ln_probabilities;
+        stored_gene_node_species_branch = gene_node_species_branch;
+        branch_ln_probabilities_changed = true;
+    }
+    
+}
+
+
+void AbstractMultispeciesCoalescent::touchSpecialization( const DagNode *affecter, bool touchAll )
+{
+    
+    if ( affecter == species_tree )
+    {
+        // the species tree fires change events for the nodes that have changed,
+        // but if the whole tree was replaced we need to start from scratch
+        if ( touchAll == true )
+        {
+            resetTipAllocations();
+        }
+    }
+    else if ( affecter != this->dag_node )
+    {
+        // the population sizes only change the contributions of the branches, not the coalescent times
+        dirty_branch_probabilities = true;
     }
     
 }
@@ -3,14 +3,28 @@
 
 #include "RbVector.h"
 #include "Tree.h"
+#include "TreeChangeEventListener.h"
 #include "TypedDagNode.h"
 #include "TypedDistribution.h"
 
+#include <utility>
+#include <vector>
+
 namespace RevBayesCore {
     
     class Clade;
     
-    class AbstractMultispeciesCoalescent : public TypedDistribution<Tree> {
+    /**
+     * @brief Base class of the multispecies coalescent distributions of a gene tree given a species tree.
+     *
+     * The probability is a sum of contributions of the species tree branches. For every species branch we cache
+     * the number of entering gene lineages, the coalescent times within the branch and the lineages leaving it.
+     * The class listens to the change events of the gene tree and of the species tree and only walks the species
+     * branches on the paths from a changed node to the root again. Other parameters (e.g., the population sizes)
+     * only require the contributions to be re-evaluated from the cached coalescent times.
+     * The walk itself uses flat scratch buffers that are reused between calls.
+     */
+    class AbstractMultispeciesCoalescent : public TypedDistribution<Tree>, public TreeChangeEventListener {
         
     public:
         AbstractMultispeciesCoalescent(const TypedDagNode<Tree> *st, const std::vector<Taxon> &t);
@@ -18,6 +32,7 @@ namespace RevBayesCore {
         
         // public member functions
         double                                              computeLnProbability(void);
+        void                                                fireTreeChangeEvent(const TopologyNode &n, const unsigned& m=0);                                    //!< The gene tree or the species tree has changed and we want to know which part.
         void                                                redrawValue(void);
         virtual void                                        setValue(Tree *v, bool f=false);                                                                    //!< Set the current value, e.g. attach an observation (clamp)
 
@@ -29,13 +44,25 @@ namespace RevBayesCore {
         void                                                swapParameterInternal(const DagNode *oldP, const DagNode *newP);            //!< Swap a parameter
         virtual double                                      computeLnCoalescentProbability(size_t k, const std::vector<double> &t, double a, double b, size_t index, bool f) = 0;
         virtual double                                      drawNe(size_t index);
+        virtual bool                                        hasIndependentBranchProbabilities(void) const;                              //!< Does the contribution of a species branch only depend on that branch?
+        
+        // virtual methods that may be overwritten, but then the derived class should call this methods
+        virtual void                                        keepSpecialization(const DagNode* affecter);
+        virtual void                                        restoreSpecialization(const DagNode *restorer);
+        virtual void                                        touchSpecialization(const DagNode *toucher, bool touchAll);
 
         // helper functions
         void                                                attachTimes(Tree *psi, std::vector<TopologyNode *> &tips, size_t index, const std::vector<double> &times);
         void                                                buildRandomBinaryTree(std::vector<TopologyNode *> &tips);
-        double                                              recursivelyComputeLnProbability(const TopologyNode &n);
+        void                                                computeBranch(const TopologyNode &n);
+        void                                                computeBranchLnProbability(const TopologyNode &n);
+        void                                                flagAllBranchesDirty(void);
+        void                                                recursivelyComputeBranchProbabilities(const TopologyNode &n);
+        void                                                recursivelyComputeDirtyBranches(const TopologyNode &n);
+        void                                                recursivelyFlagBranchDirty(const TopologyNode &n);
         void                                                resetTipAllocations(void);
         void                                                simulateTree(void);
+        void                                                storeBranchProbabilities(void);
         
         // members
         std::vector<Taxon>                                  taxa;
@@ -43,7 +70,30 @@ namespace RevBayesCore {
         size_t                                              num_taxa;
         double                                              log_tree_topology_prob;
         
-        std::vector< std::set< const TopologyNode* > >      individuals_per_branch;
+        std::vector< std::vector< size_t > >                individuals_per_branch;                                                     //!< The gene tips of each species tip
+        std::vector<size_t>                                 tip_species_index;                                                          //!< The species tip of each gene tip
+        
+        // the cached walk through each species branch, double buffered
+        std::vector< std::vector< std::vector<double> > >   branch_coalescent_times;
+        std::vector< std::vector< std::vector<size_t> > >   branch_outgoing_lineages;
+        std::vector< std::vector<size_t> >                  branch_num_lineages;
+        std::vector<size_t>                                 active_branch;
+        std::vector<bool>                                   changed_branches;
+        std::vector<bool>                                   dirty_branches;
+        
+        // the contributions of the species branches and the species branch in which each gene node coalesces
+        std::vector<double>                                 branch_ln_probabilities;
+        std::vector<double>                                 stored_branch_ln_probabilities;
+        std::vector<size_t>                                 gene_node_species_branch;
+        std::vector<size_t>                                 stored_gene_node_species_branch;
+        bool                                                branch_ln_probabilities_changed;
+        bool                                                dirty_branch_probabilities;
+        
+        // scratch buffers for the walk through a species branch
+        std::vector< std::pair<double, size_t> >            coalescence_heap;
+        std::vector<size_t>                                 lineage_stamps;
+        std::vector<size_t>                                 branch_lineages;
+        size_t                                              current_stamp;
 
     };
     
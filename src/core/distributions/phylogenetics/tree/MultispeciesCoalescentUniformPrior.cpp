@@ -199,6 +199,17 @@ void MultispeciesCoalescentUniformPrior::setMaxTheta(TypedDagNode<double>* m)
 }
 
 
+/**
+ * The contributions of the branches share the total of the coalescent rate integrals,
+ * so we always need to evaluate all branches in postorder.
+ */
+bool MultispeciesCoalescentUniformPrior::hasIndependentBranchProbabilities( void ) const
+{
+
+    return false;
+}
+
+
 void MultispeciesCoalescentUniformPrior::resetFn( void )
 {
 
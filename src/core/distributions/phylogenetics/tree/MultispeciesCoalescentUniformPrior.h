@@ -22,6 +22,7 @@ namespace RevBayesCore {
         void                                                swapParameterInternal(const DagNode *oldP, const DagNode *newP);            //!< Swap a parameter
         double                                              computeLnCoalescentProbability(size_t k, const std::vector<double> &t, double a, double b, size_t index, bool f);
         double                                              drawNe(size_t index);
+        bool                                                hasIndependentBranchProbabilities(void) const;                              //!< The integral over theta couples all branches
 
         double                                              recursiveIncompleteGamma(double a, double x);
         double                                              getNumberOfGeneCopies(void);
@@ -47,11 +47,14 @@ using namespace RevBayesCore;
 TopologyConstrainedTreeDistribution::TopologyConstrainedTreeDistribution(TypedDistribution<Tree>* base_dist, const std::vector<Clade> &c, Tree *t) : TypedDistribution<Tree>( NULL ),
 //    active_backbone_clades( base_dist->getValue().getNumberOfInteriorNodes(), RbBitSet() ),
     active_clades( base_dist->getValue().getNumberOfInteriorNodes(), RbBitSet() ),
+    active_fingerprints( base_dist->getValue().getNumberOfInteriorNodes(), 0 ),
     backbone_topology(NULL),
     backbone_topologies(NULL),
     base_distribution( base_dist ),
+    clades_touched( false ),
     dirty_nodes( base_dist->getValue().getNumberOfNodes(), true ),
     monophyly_constraints( c ),
+    num_violated_constraints( 0 ),
     num_backbones( 0 ),
     use_multiple_backbones( false ),
     starting_tree( t ),
@@ -87,16 +90,29 @@ TopologyConstrainedTreeDistribution::TopologyConstrainedTreeDistribution(TypedDi
  */
 TopologyConstrainedTreeDistribution::TopologyConstrainedTreeDistribution(const TopologyConstrainedTreeDistribution &d) : TypedDistribution<Tree>( d ),
     active_backbone_clades( d.active_backbone_clades ),
+    active_backbone_fingerprints( d.active_backbone_fingerprints ),
     active_clades( d.active_clades ),
+    active_fingerprints( d.active_fingerprints ),
     backbone_constraints( d.backbone_constraints ),
+    backbone_index( d.backbone_index ),
+    backbone_matches( d.backbone_matches ),
     backbone_mask( d.backbone_mask ),
+    backbone_num_found( d.backbone_num_found ),
     backbone_topology( d.backbone_topology ),
     backbone_topologies( d.backbone_topologies ),
     base_distribution( d.base_distribution->clone() ),
+    clade_changes( d.clade_changes ),
+    clades_touched( d.clades_touched ),
+    constraint_index( d.constraint_index ),
+    constraint_clades( d.constraint_clades ),
+    constraint_is_negative( d.constraint_is_negative ),
+    constraint_matches( d.constraint_matches ),
+    constraint_owner( d.constraint_owner ),
     dirty_nodes( d.dirty_nodes ),
     monophyly_constraints( d.monophyly_constraints ),
-    stored_backbone_clades( d.stored_backbone_clades ),
-    stored_clades( d.stored_clades ),
+    num_satisfied_options( d.num_satisfied_options ),
+    num_violated_constraints( d.num_violated_constraints ),
+    taxon_fingerprints( d.taxon_fingerprints ),
     num_backbones( d.num_backbones ),
     use_multiple_backbones( d.use_multiple_backbones ),
     starting_tree( (d.starting_tree==NULL ? NULL : d.starting_tree->clone()) ),
@@ -155,16 +171,29 @@ TopologyConstrainedTreeDistribution& TopologyConstrainedTreeDistribution::operat
         delete starting_tree;
         
         active_backbone_clades          = d.active_backbone_clades;
+        active_backbone_fingerprints    = d.active_backbone_fingerprints;
         active_clades                   = d.active_clades;
+        active_fingerprints             = d.active_fingerprints;
         backbone_constraints            = d.backbone_constraints;
+        backbone_index                  = d.backbone_index;
+        backbone_matches                = d.backbone_matches;
         backbone_mask                   = d.backbone_mask;
+        backbone_num_found              = d.backbone_num_found;
         backbone_topology               = d.backbone_topology;
         backbone_topologies             = d.backbone_topologies;
         base_distribution               = d.base_distribution->clone();
+        clade_changes                   = d.clade_changes;
+        clades_touched                  = d.clades_touched;
+        constraint_index                = d.constraint_index;
+        constraint_clades               = d.constraint_clades;
+        constraint_is_negative          = d.constraint_is_negative;
+        constraint_matches              = d.constraint_matches;
+        constraint_owner                = d.constraint_owner;
         dirty_nodes                     = d.dirty_nodes;
         monophyly_constraints           = d.monophyly_constraints;
-        stored_backbone_clades          = d.stored_backbone_clades;
-        stored_clades                   = d.stored_clades;
+        num_satisfied_options           = d.num_satisfied_options;
+        num_violated_constraints        = d.num_violated_constraints;
+        taxon_fingerprints              = d.taxon_fingerprints;
         num_backbones                   = d.num_backbones;
         use_multiple_backbones          = d.use_multiple_backbones;
         starting_tree                   = (d.starting_tree == NULL ? NULL : d.starting_tree->clone());
@@ -288,6 +317,41 @@ void TopologyConstrainedTreeDistribution::initializeBitSets(void)
         backbone_mask[0] |= recursivelyAddBackboneConstraints( backbone_topology->getValue().getRoot(), 0 );
     }
     
+    initializeCladeIndex();
+}
+
+
+/**
+ * Compute the fingerprint of a clade from the keys of its taxa.
+ */
+uint64_t TopologyConstrainedTreeDistribution::computeFingerprint(const RbBitSet &clade) const
+{
+    uint64_t fingerprint = 0;
+    for (size_t k = clade.find_first(); k != RbBitSet::npos; k = clade.find_next(k))
+    {
+        fingerprint ^= taxon_fingerprints[k];
+    }
+    
+    return fingerprint;
+}
+
+
+/**
+ * Get the fingerprint of the clade below a child node, which has been updated already.
+ * If a mask is given, only the taxa in the mask are part of the clade.
+ */
+uint64_t TopologyConstrainedTreeDistribution::getChildFingerprint(const TopologyNode &node, const std::vector<uint64_t> &fingerprints, const RbBitSet *mask) const
+{
+    if ( node.isTip() )
+    {
+        const std::map<std::string, size_t>& taxon_map = value->getTaxonBitSetMap();
+        std::map<std::string, size_t>::const_iterator it = taxon_map.find( node.getName() );
+        size_t k = it->second;
+        
+        return ( mask == NULL || mask->test(k) ? taxon_fingerprints[k] : 0 );
+    }
+    
+    return fingerprints[node.getIndex() - value->getNumberOfTips()];
 }
 
 
@@ -314,122 +378,151 @@ void TopologyConstrainedTreeDistribution::getAffected(RbOrderedSet<DagNode *> &a
 
 
 /**
- * We check here if all the constraints are satisfied.
- * These are hard constraints, that is, the clades must be monophyletic.
- *
- * \return     True if the constraints are matched, false otherwise.
+ * Index the constraint clades by their fingerprints and count how often each constraint clade
+ * occurs among the current active clades.
+ * The keys of the taxa are drawn from a fixed sequence (splitmix64) instead of the random number generator,
+ * so that the keys only depend on the position of the taxon and the simulations are not affected.
  */
-bool TopologyConstrainedTreeDistribution::matchesBackbone( void )
+void TopologyConstrainedTreeDistribution::initializeCladeIndex( void )
 {
+    size_t num_tips = value->getNumberOfTips();
     
-    // ensure that each backbone constraint is found in the corresponding active_backbone_clades
-    for (size_t i = 0; i < num_backbones; i++)
+    taxon_fingerprints.resize( num_tips );
+    uint64_t state = 0;
+    for (size_t k = 0; k < num_tips; ++k)
     {
-        bool is_negative_constraint = false;
-        if (backbone_topology != NULL)
+        state += 0x9E3779B97F4A7C15ULL;
+        uint64_t z = state;
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        taxon_fingerprints[k] = z ^ (z >> 31);
+    }
+    
+    // index the monophyly constraints and their optional clades
+    constraint_index.clear();
+    constraint_clades.clear();
+    constraint_is_negative.clear();
+    constraint_matches.clear();
+    constraint_owner.clear();
+    num_satisfied_options = std::vector<size_t>( monophyly_constraints.size(), 0 );
+    num_violated_constraints = 0;
+    for (size_t i = 0; i < monophyly_constraints.size(); i++)
+    {
+        std::vector<Clade> constraints;
+        if ( monophyly_constraints[i].isOptionalConstraint() == true )
         {
-            is_negative_constraint = backbone_topology->getValue().isNegativeConstraint();
+            constraints = monophyly_constraints[i].getOptionalConstraints();
         }
-        else if (backbone_topologies != NULL)
+        else
         {
-            is_negative_constraint = ( backbone_topologies->getValue() )[i].isNegativeConstraint();
+            constraints.push_back(monophyly_constraints[i]);
         }
         
-        std::vector<bool> negative_constraint_found( backbone_constraints[i].size(), false );
-        for (size_t j = 0; j < backbone_constraints[i].size(); j++)
+        for (size_t j = 0; j < constraints.size(); j++)
         {
-            std::vector<RbBitSet>::iterator it = std::find(active_backbone_clades[i].begin(), active_backbone_clades[i].end(), backbone_constraints[i][j] );
+            const RbBitSet &b = constraints[j].getBitRepresentation();
+            constraint_index.insert( std::make_pair( computeFingerprint( b ), constraint_clades.size() ) );
+            constraint_clades.push_back( b );
+            constraint_is_negative.push_back( constraints[j].isNegativeConstraint() );
+            constraint_matches.push_back( 0 );
+            constraint_owner.push_back( i );
             
-            // the search fails if the positive/negative backbone constraint is not satisfied
-            if (it == active_backbone_clades[i].end() && !is_negative_constraint )
+            // a negative constraint is satisfied as long as the clade is not found
+            if ( constraints[j].isNegativeConstraint() == true )
             {
-                // match fails if positive constraint is not found
-                return false;
-            }
-            else if (it != active_backbone_clades[i].end() && is_negative_constraint )
-            {
-                // match fails if negative constraint is found
-                negative_constraint_found[j] = true;
+                ++num_satisfied_options[i];
             }
         }
         
-        // match fails if all negative backbone clades are found
-        bool negative_constraint_failure = true;
-        for (size_t j = 0; j < negative_constraint_found.size(); j++)
+        if ( num_satisfied_options[i] == 0 )
         {
-            if (negative_constraint_found[j] == false)
-            {
-                negative_constraint_failure = false;
-            }
+            ++num_violated_constraints;
         }
-        if (negative_constraint_failure)
+    }
+    
+    // index the backbone clades
+    backbone_index = std::vector<std::unordered_multimap<uint64_t, size_t> >( num_backbones );
+    backbone_matches.resize( num_backbones );
+    backbone_num_found = std::vector<size_t>( num_backbones, 0 );
+    for (size_t i = 0; i < num_backbones; i++)
+    {
+        backbone_matches[i] = std::vector<size_t>( backbone_constraints[i].size(), 0 );
+        for (size_t j = 0; j < backbone_constraints[i].size(); j++)
         {
-            return false;
+            backbone_index[i].insert( std::make_pair( computeFingerprint( backbone_constraints[i][j] ), j ) );
+        }
+    }
+    
+    // count the current clades
+    for (size_t idx = 0; idx < active_clades.size(); idx++)
+    {
+        updateConstraintMatches( active_clades[idx], active_fingerprints[idx], true );
+    }
+    for (size_t i = 0; i < num_backbones; i++)
+    {
+        for (size_t idx = 0; idx < active_backbone_clades[i].size(); idx++)
+        {
+            updateBackboneMatches( i, active_backbone_clades[i][idx], active_backbone_fingerprints[i][idx], true );
         }
     }
     
-    // if no search has failed, then the match succeeds
-    return true;
 }
 
 
 /**
- * We check here if all the monophyly constraints are satisfied.
+ * We check here if all the constraints are satisfied.
+ * These are hard constraints, that is, the clades must be monophyletic.
  *
  * \return     True if the constraints are matched, false otherwise.
  */
-bool TopologyConstrainedTreeDistribution::matchesConstraints( void )
+bool TopologyConstrainedTreeDistribution::matchesBackbone( void )
 {
-    for (size_t i = 0; i < monophyly_constraints.size(); i++)
+    
+    // ensure that each backbone constraint is found in the corresponding active_backbone_clades
+    for (size_t i = 0; i < num_backbones; i++)
     {
-        
-        std::vector<Clade> constraints;
-        if ( monophyly_constraints[i].isOptionalConstraint() == true )
+        bool is_negative_constraint = false;
+        if (backbone_topology != NULL)
         {
-            constraints = monophyly_constraints[i].getOptionalConstraints();
+            is_negative_constraint = backbone_topology->getValue().isNegativeConstraint();
         }
-        else
+        else if (backbone_topologies != NULL)
         {
-            constraints.push_back(monophyly_constraints[i]);
+            is_negative_constraint = ( backbone_topologies->getValue() )[i].isNegativeConstraint();
         }
         
-        std::vector<bool> constraint_satisfied( constraints.size(), false );
-        for (size_t j = 0; j < constraints.size(); j++)
-        {
-            
-            std::vector<RbBitSet>::iterator it = std::find(active_clades.begin(), active_clades.end(), constraints[j].getBitRepresentation() );
-            
-            if (it != active_clades.end() && constraints[j].isNegativeConstraint() == false )
-            {
-                constraint_satisfied[j] = true;
-            }
-            else if (it == active_clades.end() && constraints[j].isNegativeConstraint() )
-            {
-                constraint_satisfied[j] = true;
-            }
-        }
+        size_t num_constraints = backbone_constraints[i].size();
         
-        // match fails if no optional positive or negative constraints satisfied
-        bool any_satisfied = false;
-        for (size_t j = 0; j < constraint_satisfied.size(); j++)
+        // match fails if a positive backbone clade is not found
+        if ( is_negative_constraint == false && backbone_num_found[i] < num_constraints )
         {
-            if ( constraint_satisfied[j] == true )
-            {
-                any_satisfied = true;
-                break;
-            }
+            return false;
         }
         
-        if ( any_satisfied == false )
+        // match fails if all negative backbone clades are found (or if there are no backbone clades at all)
+        if ( (is_negative_constraint == true || num_constraints == 0) && backbone_num_found[i] == num_constraints )
         {
             return false;
         }
     }
     
+    // if no search has failed, then the match succeeds
     return true;
 }
 
 
+/**
+ * We check here if all the monophyly constraints are satisfied.
+ *
+ * \return     True if the constraints are matched, false otherwise.
+ */
+bool TopologyConstrainedTreeDistribution::matchesConstraints( void )
+{
+    // a constraint is violated if none of its optional positive or negative clades is satisfied
+    return num_violated_constraints == 0;
+}
+
+
 void TopologyConstrainedTreeDistribution::recursivelyFlagNodesDirty(const TopologyNode& n)
 {
     
@@ -506,20 +599,59 @@ RbBitSet TopologyConstrainedTreeDistribution::recursivelyUpdateClades( const Top
         if ( dirty_nodes[node.getIndex()] == true )
         {
             RbBitSet tmp = RbBitSet( value->getNumberOfTips() );
+            uint64_t fingerprint = 0;
             for (size_t i = 0; i < node.getNumberOfChildren(); i++)
             {
                 tmp |= recursivelyUpdateClades( node.getChild(i) );
+                fingerprint ^= getChildFingerprint( node.getChild(i), active_fingerprints, NULL );
             }
             
-            // update the clade
             size_t idx = node.getIndex() - value->getNumberOfTips();
-            active_clades[idx] = tmp;
+            bool changed = ( fingerprint != active_fingerprints[idx] || tmp != active_clades[idx] );
             
+            std::vector<RbBitSet> backbone_clades( num_backbones );
+            std::vector<uint64_t> backbone_fingerprints( num_backbones, 0 );
             for (size_t i = 0; i < num_backbones; i++)
             {
-                active_backbone_clades[i][idx] = tmp & backbone_mask[i];
+                backbone_clades[i] = tmp & backbone_mask[i];
+                for (size_t j = 0; j < node.getNumberOfChildren(); j++)
+                {
+                    backbone_fingerprints[i] ^= getChildFingerprint( node.getChild(j), active_backbone_fingerprints[i], &backbone_mask[i] );
+                }
+                changed |= ( backbone_fingerprints[i] != active_backbone_fingerprints[i][idx] || backbone_clades[i] != active_backbone_clades[i][idx] );
             }
             
+            // only update the clade if it has changed
+            // many nodes on the dirty path, e.g., the ancestors of both the pruned and the regrafted subtree, keep their clade
+            if ( changed == true )
+            {
+                if ( clades_touched == true )
+                {
+                    CladeChange change;
+                    change.index        = idx;
+                    change.clade        = active_clades[idx];
+                    change.fingerprint  = active_fingerprints[idx];
+                    for (size_t i = 0; i < num_backbones; i++)
+                    {
+                        change.backbone_clades.push_back( active_backbone_clades[i][idx] );
+                        change.backbone_fingerprints.push_back( active_backbone_fingerprints[i][idx] );
+                    }
+                    clade_changes.push_back( change );
+                }
+                
+                updateConstraintMatches( active_clades[idx], active_fingerprints[idx], false );
+                active_clades[idx]       = tmp;
+                active_fingerprints[idx] = fingerprint;
+                updateConstraintMatches( active_clades[idx], active_fingerprints[idx], true );
+                
+                for (size_t i = 0; i < num_backbones; i++)
+                {
+                    updateBackboneMatches( i, active_backbone_clades[i][idx], active_backbone_fingerprints[i][idx], false );
+                    active_backbone_clades[i][idx].swap( backbone_clades[i] );
+                    active_backbone_fingerprints[i][idx] = backbone_fingerprints[i];
+                    updateBackboneMatches( i, active_backbone_clades[i][idx], active_backbone_fingerprints[i][idx], true );
+                }
+            }
             
             dirty_nodes[node.getIndex()] = false;
         }
@@ -577,11 +709,13 @@ void TopologyConstrainedTreeDistribution::redrawValue( void )
     // recompute the active clades
     dirty_nodes = std::vector<bool>( value->getNumberOfNodes(), true );
     active_clades = std::vector<RbBitSet>(value->getNumberOfInteriorNodes(), RbBitSet());
-
-    recursivelyUpdateClades( value->getRoot() );
+    active_fingerprints = std::vector<uint64_t>(value->getNumberOfInteriorNodes(), 0);
+    initializeCladeIndex();
+    
+    clade_changes.clear();
+    clades_touched = false;
     
-    stored_clades          = active_clades;
-    stored_backbone_clades = active_backbone_clades;
+    recursivelyUpdateClades( value->getRoot() );
 }
 
 
@@ -633,6 +767,7 @@ void TopologyConstrainedTreeDistribution::setBackbone(const TypedDagNode<Tree> *
         {
             std::vector<RbBitSet>v( base_distribution->getValue().getNumberOfInteriorNodes(), RbBitSet() );
             active_backbone_clades.push_back(v);
+            active_backbone_fingerprints.push_back( std::vector<uint64_t>( v.size(), 0 ) );
         }
         backbone_mask = std::vector<RbBitSet>( num_backbones, RbBitSet(base_distribution->getValue().getNumberOfInteriorNodes()) );
         
@@ -1199,13 +1334,13 @@ void TopologyConstrainedTreeDistribution::setValue(Tree *v, bool f )
     
     initializeBitSets();
     
+    clade_changes.clear();
+    clades_touched = false;
+    
     // recompute the active clades
     dirty_nodes = std::vector<bool>( value->getNumberOfNodes(), true );
     
     recursivelyUpdateClades( value->getRoot() );
-    
-    stored_clades          = active_clades;
-    stored_backbone_clades = active_backbone_clades;
 }
 
 
@@ -1241,8 +1376,8 @@ void TopologyConstrainedTreeDistribution::swapParameterInternal( const DagNode *
  */
 void TopologyConstrainedTreeDistribution::touchSpecialization(const DagNode *affecter, bool touchAll)
 {
-    stored_clades = active_clades;
-    stored_backbone_clades = active_backbone_clades;
+    // from now on we record the updates of the clades so that we can undo them
+    clades_touched = true;
     
     // if the root age wasn't the affecter, we'll set it in the base distribution here
     base_distribution->touch(affecter, touchAll);
@@ -1250,17 +1385,128 @@ void TopologyConstrainedTreeDistribution::touchSpecialization(const DagNode *aff
 
 void TopologyConstrainedTreeDistribution::keepSpecialization(const DagNode *affecter)
 {
-    stored_clades = active_clades;
-    stored_backbone_clades = active_backbone_clades;
+    clade_changes.clear();
+    clades_touched = false;
     
     base_distribution->keep(affecter);
 }
 
 void TopologyConstrainedTreeDistribution::restoreSpecialization(const DagNode *restorer)
 {
-    active_clades = stored_clades;
-    active_backbone_clades = stored_backbone_clades;
+    // undo the updates of the clades in reverse order
+    for (std::vector<CladeChange>::reverse_iterator it = clade_changes.rbegin(); it != clade_changes.rend(); ++it)
+    {
+        size_t idx = it->index;
+        
+        updateConstraintMatches( active_clades[idx], active_fingerprints[idx], false );
+        active_clades[idx].swap( it->clade );
+        active_fingerprints[idx] = it->fingerprint;
+        updateConstraintMatches( active_clades[idx], active_fingerprints[idx], true );
+        
+        for (size_t i = 0; i < it->backbone_clades.size(); i++)
+        {
+            updateBackboneMatches( i, active_backbone_clades[i][idx], active_backbone_fingerprints[i][idx], false );
+            active_backbone_clades[i][idx].swap( it->backbone_clades[i] );
+            active_backbone_fingerprints[i][idx] = it->backbone_fingerprints[i];
+            updateBackboneMatches( i, active_backbone_clades[i][idx], active_backbone_fingerprints[i][idx], true );
+        }
+    }
+    clade_changes.clear();
+    clades_touched = false;
     
     base_distribution->restore(restorer);
     
 }
+
+
+/**
+ * Add (or remove) an active clade to (from) the match counters of the backbone clades.
+ */
+void TopologyConstrainedTreeDistribution::updateBackboneMatches(size_t backbone_idx, const RbBitSet &clade, uint64_t fingerprint, bool add)
+{
+    typedef std::unordered_multimap<uint64_t, size_t>::const_iterator index_iterator;
+    std::pair<index_iterator, index_iterator> range = backbone_index[backbone_idx].equal_range( fingerprint );
+    for (index_iterator it = range.first; it != range.second; ++it)
+    {
+        size_t j = it->second;
+        
+        // the fingerprints may collide, so we compare the clades
+        if ( backbone_constraints[backbone_idx][j] != clade )
+        {
+            continue;
+        }
+        
+        size_t &matches = backbone_matches[backbone_idx][j];
+        if ( add == true )
+        {
+            if ( matches == 0 )
+            {
+                ++backbone_num_found[backbone_idx];
+            }
+            ++matches;
+        }
+        else
+        {
+            --matches;
+            if ( matches == 0 )
+            {
+                --backbone_num_found[backbone_idx];
+            }
+        }
+    }
+    
+}
+
+
+/**
+ * Add (or remove) an active clade to (from) the match counters of the monophyly constraints
+ * and update the number of violated constraints.
+ */
+void TopologyConstrainedTreeDistribution::updateConstraintMatches(const RbBitSet &clade, uint64_t fingerprint, bool add)
+{
+    typedef std::unordered_multimap<uint64_t, size_t>::const_iterator index_iterator;
+    std::pair<index_iterator, index_iterator> range = constraint_index.equal_range( fingerprint );
+    for (index_iterator it = range.first; it != range.second; ++it)
+    {
+        size_t k = it->second;
+        
+        // the fingerprints may collide, so we compare the clades
+        if ( constraint_clades[k] != clade )
+        {
+            continue;
+        }
+        
+        bool was_satisfied = ( (constraint_matches[k] > 0) != constraint_is_negative[k] );
+        if ( add == true )
+        {
+            ++constraint_matches[k];
+        }
+        else
+        {
+            --constraint_matches[k];
+        }
+        bool is_satisfied = ( (constraint_matches[k] > 0) != constraint_is_negative[k] );
+        
+        if ( was_satisfied != is_satisfied )
+        {
+            size_t &num_satisfied = num_satisfied_options[ constraint_owner[k] ];
+            if ( is_satisfied == true )
+            {
+                if ( num_satisfied == 0 )
+                {
+                    --num_violated_constraints;
+                }
+                ++num_satisfied;
+            }
+            else
+            {
+                --num_satisfied;
+                if ( num_satisfied == 0 )
+                {
+                    ++num_violated_constraints;
+                }
+            }
+        }
+    }
+    
+}
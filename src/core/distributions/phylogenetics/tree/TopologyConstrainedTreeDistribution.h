@@ -1,6 +1,9 @@
 #ifndef TopologyConstrainedTreeDistribution_H
 #define TopologyConstrainedTreeDistribution_H
 
+#include <cstdint>
+#include <unordered_map>
+
 #include "Clade.h"
 #include "RbVector.h"
 #include "Tree.h"
@@ -16,10 +19,12 @@ namespace RevBayesCore {
      *
      * @brief Declaration of the constant rate Birth-Death process class.
      *
+     * The clades carry 64-bit fingerprints, the XOR of fixed pseudo-random (splitmix64) keys of their taxa,
+     * and the constraints are indexed by fingerprint so that only the dirty clades are checked.
+     *
      * @copyright Copyright 2009-
      * @author The RevBayes Development Core Team (Sebastian Hoehna)
      * @since 2014-01-17, version 1.0
-     *
      */
     class TopologyConstrainedTreeDistribution : public TypedDistribution<Tree>, TreeChangeEventListener {
         
@@ -58,6 +63,9 @@ namespace RevBayesCore {
         
         
         // helper functions
+        uint64_t                                            computeFingerprint(const RbBitSet &clade) const;
+        uint64_t                                            getChildFingerprint(const TopologyNode& node, const std::vector<uint64_t> &fingerprints, const RbBitSet *mask) const;
+        void                                                initializeCladeIndex(void);
         bool                                                matchesBackbone(void);
         bool                                                matchesConstraints(void);
         RbBitSet                                            recursivelyAddBackboneConstraints(const TopologyNode& node, size_t backbone_idx);
@@ -65,22 +73,46 @@ namespace RevBayesCore {
         RbBitSet                                            recursivelyUpdateClades(const TopologyNode& node);
         Tree*                                               simulateRootedTree(void);
         Tree*                                               simulateUnrootedTree(void);
+        void                                                updateBackboneMatches(size_t backbone_idx, const RbBitSet &clade, uint64_t fingerprint, bool add);
+        void                                                updateConstraintMatches(const RbBitSet &clade, uint64_t fingerprint, bool add);
+
+        // a clade of an interior node before it was updated, so that we can undo the update on restore
+        struct CladeChange {
+            size_t                                          index;
+            RbBitSet                                        clade;
+            uint64_t                                        fingerprint;
+            std::vector<RbBitSet>                           backbone_clades;
+            std::vector<uint64_t>                           backbone_fingerprints;
+        };
 
 
         // members
         std::vector<std::vector<RbBitSet> >                 active_backbone_clades;
+        std::vector<std::vector<uint64_t> >                 active_backbone_fingerprints;
         std::vector<RbBitSet>                               active_clades;
+        std::vector<uint64_t>                               active_fingerprints;
         std::vector<std::vector<RbBitSet> >                 backbone_constraints;
+        std::vector<std::unordered_multimap<uint64_t, size_t> > backbone_index;                                                                             //!< Fingerprint to backbone clade, per backbone
+        std::vector<std::vector<size_t> >                   backbone_matches;                                                                                   //!< The number of active clades equal to the backbone clade
         std::vector<RbBitSet>                               backbone_mask;
+        std::vector<size_t>                                 backbone_num_found;                                                                                 //!< The number of backbone clades found, per backbone
         
         const TypedDagNode<Tree>*                           backbone_topology;
         const TypedDagNode<RbVector<Tree> >*                backbone_topologies;
         
         TypedDistribution<Tree>*                            base_distribution;
+        std::vector<CladeChange>                            clade_changes;                                                                                      //!< The updates of the clades since the touch
+        bool                                                clades_touched;
+        std::unordered_multimap<uint64_t, size_t>           constraint_index;                                                                                   //!< Fingerprint to (optional) constraint clade
+        std::vector<RbBitSet>                               constraint_clades;
+        std::vector<bool>                                   constraint_is_negative;
+        std::vector<size_t>                                 constraint_matches;                                                                                 //!< The number of active clades equal to the constraint clade
+        std::vector<size_t>                                 constraint_owner;                                                                                   //!< The monophyly constraint the clade belongs to
         std::vector<bool>                                   dirty_nodes;
         std::vector<Clade>                                  monophyly_constraints;
-        std::vector<std::vector<RbBitSet> >                 stored_backbone_clades;
-        std::vector<RbBitSet>                               stored_clades;
+        std::vector<size_t>                                 num_satisfied_options;                                                                              //!< The number of satisfied clades, per monophyly constraint
+        size_t                                              num_violated_constraints;
+        std::vector<uint64_t>                               taxon_fingerprints;
         size_t                                              num_backbones;
         bool                                                use_multiple_backbones;
         Tree*                                               starting_tree;
@@ -344,8 +344,8 @@ double ConditionedBirthDeathShiftProcessContinuous::computeNodeProbability(const
         double end_time = begin_time + branch_length;
         
         const BranchHistory& bh = branch_histories[ node_index ];
-        const std::multiset<CharacterEvent*,CharacterEventCompare>& hist = bh.getHistory();
-        for (std::multiset<CharacterEvent*,CharacterEventCompare>::const_iterator it=hist.begin(); it!=hist.end(); ++it)
+        const CharacterEventList& hist = bh.getHistory();
+        for (CharacterEventList::const_iterator it=hist.begin(); it!=hist.end(); ++it)
         {
             
             // we need to set the current rate category
@@ -412,7 +412,7 @@ double ConditionedBirthDeathShiftProcessContinuous::computeStartValue(size_t i,
     if ( value->getNode(node_index).isRoot() == false )
     {
         const BranchHistory &bh = branch_histories[ node_index ];
-        const std::multiset<CharacterEvent*, CharacterEventCompare> &h = bh.getHistory();
+        const CharacterEventList &h = bh.getHistory();
         
         CharacterEventContinuous *event = static_cast<CharacterEventContinuous*>(*h.begin());
         return event->getState(j);
@@ -461,8 +461,8 @@ double ConditionedBirthDeathShiftProcessContinuous::computeStateValue(size_t i,
         {
             
             const BranchHistory &bh = branch_histories[ node_index ];
-            const std::multiset<CharacterEvent*, CharacterEventCompare> &h = bh.getHistory();
-            for (std::multiset<CharacterEvent*,CharacterEventCompare>::const_iterator it=h.begin(); it!=h.end(); ++it)
+            const CharacterEventList &h = bh.getHistory();
+            for (CharacterEventList::const_iterator it=h.begin(); it!=h.end(); ++it)
             {
                 CharacterEventContinuous* event = static_cast<CharacterEventContinuous*>(*it);
                 double event_time = event->getAge();
@@ -553,13 +553,13 @@ void ConditionedBirthDeathShiftProcessContinuous::executeMethod(const std::strin
         {
             const TopologyNode &node = this->value->getNode( i );
             const BranchHistory& bh = branch_histories[ i ];
-            const std::multiset<CharacterEvent*,CharacterEventCompare>& hist = bh.getHistory();
+            const CharacterEventList& hist = bh.getHistory();
             double value_rootwards = computeStartValue( node.getParent().getIndex(), 0 );
             
             double rate = 0;
             double begin_time = 0.0;
             double branch_length = node.getBranchLength();
-            for (std::multiset<CharacterEvent*,CharacterEventCompare>::const_iterator it=hist.begin(); it!=hist.end(); ++it)
+            for (CharacterEventList::const_iterator it=hist.begin(); it!=hist.end(); ++it)
             {
                 CharacterEventContinuous* event = static_cast<CharacterEventContinuous*>(*it);
                 double end_time = event->getAge() - node.getAge();
@@ -589,13 +589,13 @@ void ConditionedBirthDeathShiftProcessContinuous::executeMethod(const std::strin
         {
             const TopologyNode &node = this->value->getNode( i );
             const BranchHistory& bh = branch_histories[ i ];
-            const std::multiset<CharacterEvent*,CharacterEventCompare>& hist = bh.getHistory();
+            const CharacterEventList& hist = bh.getHistory();
             double value_rootwards = computeStartValue( node.getParent().getIndex(), 1 );
             
             double rate = 0;
             double begin_time = 0.0;
             double branch_length = node.getBranchLength();
-            for (std::multiset<CharacterEvent*,CharacterEventCompare>::const_iterator it=hist.begin(); it!=hist.end(); ++it)
+            for (CharacterEventList::const_iterator it=hist.begin(); it!=hist.end(); ++it)
             {
                 CharacterEventContinuous* event = static_cast<CharacterEventContinuous*>(*it);
                 double end_time = event->getAge() - node.getAge();
@@ -625,7 +625,7 @@ void ConditionedBirthDeathShiftProcessContinuous::executeMethod(const std::strin
         {
             const TopologyNode &node = this->value->getNode( i );
             const BranchHistory& bh = branch_histories[ i ];
-            // const std::multiset<CharacterEvent*,CharacterEventCompare>& hist = bh.getHistory();
+            // const CharacterEventList& hist = bh.getHistory();
             bh.getHistory();
             double value_rootwards = computeStartValue( node.getParent().getIndex(), 0 );
             double value_tipwards  = computeStartValue( node.getIndex(), 0 );
@@ -645,7 +645,7 @@ void ConditionedBirthDeathShiftProcessContinuous::executeMethod(const std::strin
         {
             const TopologyNode &node = this->value->getNode( i );
             const BranchHistory& bh = branch_histories[ i ];
-//            const std::multiset<CharacterEvent*,CharacterEventCompare>& hist = bh.getHistory();
+//            const CharacterEventList& hist = bh.getHistory();
             bh.getHistory();
             double value_rootwards = computeStartValue( node.getParent().getIndex(), 0 );
             double value_tipwards  = computeStartValue( node.getIndex(), 0 );
@@ -665,7 +665,7 @@ void ConditionedBirthDeathShiftProcessContinuous::executeMethod(const std::strin
         {
             const TopologyNode &node = this->value->getNode( i );
             const BranchHistory& bh = branch_histories[ i ];
-//            const std::multiset<CharacterEvent*,CharacterEventCompare>& hist = bh.getHistory();
+//            const CharacterEventList& hist = bh.getHistory();
             bh.getHistory();
             double value_rootwards = computeStartValue( node.getParent().getIndex(), 1 );
             double value_tipwards  = computeStartValue( node.getIndex(), 1 );
@@ -685,7 +685,7 @@ void ConditionedBirthDeathShiftProcessContinuous::executeMethod(const std::strin
         {
             const TopologyNode &node = this->value->getNode( i );
             const BranchHistory& bh = branch_histories[ i ];
-//            const std::multiset<CharacterEvent*,CharacterEventCompare>& hist = bh.getHistory();
+//            const CharacterEventList& hist = bh.getHistory();
             bh.getHistory();
             double value_rootwards = computeStartValue( node.getParent().getIndex(), 1 );
             double value_tipwards  = computeStartValue( node.getIndex(), 1 );
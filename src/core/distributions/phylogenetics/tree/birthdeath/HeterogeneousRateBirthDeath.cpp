@@ -267,7 +267,7 @@ void HeterogeneousRateBirthDeath::computeNodeProbability(const RevBayesCore::Top
         
         
         const BranchHistory& bh = branch_histories[ node_index ];
-        const std::multiset<CharacterEvent*,CharacterEventCompare>& hist = bh.getHistory();
+        const CharacterEventList& hist = bh.getHistory();
         
         //        const std::vector<CharacterEvent*> child_states = bh.getChildCharacters();
         //        size_t start_index = child_states[0]->getState();
@@ -322,7 +322,7 @@ void HeterogeneousRateBirthDeath::computeNodeProbability(const RevBayesCore::Top
         // set the previous state to an impossible state
         // we need this for checking if the states were different
         size_t previous_state = state_index_tipwards;
-        for (std::multiset<CharacterEvent*,CharacterEventCompare>::const_iterator it=hist.begin(); it!=hist.end(); ++it)
+        for (CharacterEventList::const_iterator it=hist.begin(); it!=hist.end(); ++it)
         {
             CharacterEvent* event = *it;
             double event_time = event->getAge();
@@ -383,7 +383,7 @@ size_t HeterogeneousRateBirthDeath::computeStartIndex(size_t i) const
     if ( value->getNode(node_index).isRoot() == false )
     {
         const BranchHistory &bh = branch_histories[ node_index ];
-        const std::multiset<CharacterEvent*, CharacterEventCompare> &h = bh.getHistory();
+        const CharacterEventList &h = bh.getHistory();
         CharacterEvent *event = *(h.begin());
         return static_cast<CharacterEventDiscrete*>(event)->getState();
     }
@@ -414,8 +414,8 @@ size_t HeterogeneousRateBirthDeath::computeStateIndex(size_t i, double time) con
         {
             
             const BranchHistory &bh = branch_histories[ node_index ];
-            const std::multiset<CharacterEvent*, CharacterEventCompare> &h = bh.getHistory();
-            for (std::multiset<CharacterEvent*,CharacterEventCompare>::const_iterator it=h.begin(); it!=h.end(); ++it)
+            const CharacterEventList &h = bh.getHistory();
+            for (CharacterEventList::const_iterator it=h.begin(); it!=h.end(); ++it)
             {
                 CharacterEventDiscrete* event = static_cast<CharacterEventDiscrete*>(*it);
                 double event_time = event->getAge();
@@ -512,13 +512,13 @@ void HeterogeneousRateBirthDeath::executeMethod(const std::string &n, const std:
         {
             const TopologyNode &node = this->value->getNode( i );
             const BranchHistory& bh = branch_histories[ i ];
-            const std::multiset<CharacterEvent*,CharacterEventCompare>& hist = bh.getHistory();
+            const CharacterEventList& hist = bh.getHistory();
             size_t state_index_rootwards = computeStartIndex( node.getParent().getIndex() );
             
             double rate = 0;
             double begin_time = 0.0;
             double branch_length = node.getBranchLength();
-            for (std::multiset<CharacterEvent*,CharacterEventCompare>::const_iterator it=hist.begin(); it!=hist.end(); ++it)
+            for (CharacterEventList::const_iterator it=hist.begin(); it!=hist.end(); ++it)
             {
                 CharacterEventDiscrete* event = static_cast<CharacterEventDiscrete*>(*it);
                 double end_time = event->getAge() - node.getAge();
@@ -549,13 +549,13 @@ void HeterogeneousRateBirthDeath::executeMethod(const std::string &n, const std:
         {
             const TopologyNode &node = this->value->getNode( i );
             const BranchHistory& bh = branch_histories[ i ];
-            const std::multiset<CharacterEvent*,CharacterEventCompare>& hist = bh.getHistory();
+            const CharacterEventList& hist = bh.getHistory();
             size_t state_index_rootwards = computeStartIndex( node.getParent().getIndex() );
             
             double rate = 0;
             double begin_time = 0.0;
             double branch_length = node.getBranchLength();
-            for (std::multiset<CharacterEvent*,CharacterEventCompare>::const_iterator it=hist.begin(); it!=hist.end(); ++it)
+            for (CharacterEventList::const_iterator it=hist.begin(); it!=hist.end(); ++it)
             {
                 CharacterEventDiscrete* event = static_cast<CharacterEventDiscrete*>(*it);
                 double end_time = event->getAge() - node.getAge();
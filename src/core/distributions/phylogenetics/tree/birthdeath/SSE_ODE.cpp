@@ -13,13 +13,31 @@ using namespace RevBayesCore;
 SSE_ODE::SSE_ODE( const std::vector<double> &m, const RateGenerator* q, double r, bool backward_time, bool extinction_only, bool allow_shifts_extinct ) :
     mu( m ),
     num_states( q->getNumberOfStates() ),
-    Q( q ),
+    anagenetic_rates( num_states * num_states, 0.0 ),
     rate( r ),
+    event_offsets( num_states + 1, 0 ),
+    no_event_rate( num_states, 0.0 ),
+    total_rates_dirty( true ),
+    safe_x( 2 * num_states, 0.0 ),
     extinction_only( extinction_only ),
+    use_speciation_from_event_map( false ),
     backward_time( backward_time ),
     allow_rate_shifts_extinction( allow_shifts_extinct )
 {
     
+    // the rates of the rate generator do not depend on the age here, so we ask for them only once
+    double age = 0.0;
+    for (size_t i = 0; i < num_states; ++i)
+    {
+        for (size_t j = 0; j < num_states; ++j)
+        {
+            if ( i != j )
+            {
+                anagenetic_rates[i * num_states + j] = q->getRate(i, j, age, rate);
+            }
+        }
+    }
+    
 }
 
 
@@ -27,96 +45,57 @@ void SSE_ODE::operator()(const std::vector< double > &x, std::vector< double > &
 {
     // ClaSSE equations A1 and A2 from Goldberg and Igic, 2012
     
+    if ( total_rates_dirty == true )
+    {
+        updateTotalRates();
+    }
+    
     // catch negative extinction probabilities that can result from
     // rounding errors in the ODE stepper
-    std::vector< double > safe_x = x;
     for (size_t i = 0; i < num_states * 2; ++i)
     {
         safe_x[i] = ( x[i] < 0.0 ? 0.0 : x[i] );
     }
     
-    double age = 0.0;
+    const double* extinct  = &safe_x[0];
+    const double* observed = &safe_x[num_states];
+    
     for (size_t i = 0; i < num_states; ++i)
     {
-        
-        // calculate sum of speciation rates
-        // lambda_ijk for all possible values of j and k
-        double lambda_sum = 0.0;
-        
-        if ( use_speciation_from_event_map == true )
-        {
-            std::map<std::vector<unsigned>, double>::iterator it;
-            for (it = event_map.begin(); it != event_map.end(); it++)
-            {
-                const std::vector<unsigned>& states = it->first;
-                double curr_lambda = it->second;
-            
-                if (i == states[0])
-                {
-                    lambda_sum += curr_lambda;
-                }
-            }
-        }
-        else
-        {
-            lambda_sum = lambda[i];
-        }
+        const double* q_row = &anagenetic_rates[i * num_states];
         
         /**** Extinction ****/
         /**** equation A2 ***/
         
         // extinction event
-        dxdt[i] = mu[i];
+        double dx = mu[i];
         
         // no event
-        double no_event_rate = mu[i] + lambda_sum;
-        for (size_t j = 0; j < num_states; ++j)
-        {
-            if ( i != j && allow_rate_shifts_extinction == true )
-            {
-                no_event_rate += Q->getRate(i, j, age, rate);
-            }
-        }
-        
-        if (psi.empty() == false)
-        {
-            no_event_rate += psi[i];
-        }
-
-        dxdt[i] -= no_event_rate * safe_x[i];
+        dx -= no_event_rate[i] * extinct[i];
         
         // speciation event
         if ( use_speciation_from_event_map == true )
         {
-            std::map<std::vector<unsigned>, double>::iterator it;
-            for (it = event_map.begin(); it != event_map.end(); it++)
+            for (size_t e = event_offsets[i]; e < event_offsets[i+1]; ++e)
             {
-                const std::vector<unsigned>& states = it->first;
-                double curr_lambda = it->second;
-                if (i == states[0])
-                {
-                    dxdt[i] += curr_lambda * safe_x[states[1]] * safe_x[states[2]];
-                }
+                dx += event_rate[e] * extinct[event_daughter_1[e]] * extinct[event_daughter_2[e]];
             }
         }
         else
         {
-            dxdt[i] += lambda[i] * safe_x[i] * safe_x[i];
+            dx += lambda[i] * extinct[i] * extinct[i];
         }
         
-        // anagenetic state change
-        for (size_t j = 0; j < num_states; ++j)
+        // anagenetic state change (the diagonal of q_row is zero)
+        if ( allow_rate_shifts_extinction == true )
         {
-            if ( i != j && allow_rate_shifts_extinction == true )
+            for (size_t j = 0; j < num_states; ++j)
             {
-                dxdt[i] += Q->getRate(i, j, age, rate) * safe_x[j];
+                dx += q_row[j] * extinct[j];
             }
         }
 
-        if ( backward_time == false )
-        {
-            dxdt[i] = -dxdt[i];
-        }
+        dxdt[i] = ( backward_time == true ? dx : -dx );
         
         if ( extinction_only == false )
         {
@@ -124,72 +103,116 @@ void SSE_ODE::operator()(const std::vector< double > &x, std::vector< double > &
             /**** equation A1 ****/
         
             // no event
-            dxdt[i + num_states] = -no_event_rate * safe_x[i + num_states];
+            double dd = -no_event_rate[i] * observed[i];
             
             // speciation event
             if ( use_speciation_from_event_map == true )
             {
-                std::map<std::vector<unsigned>, double>::iterator it;
-                for (it = event_map.begin(); it != event_map.end(); it++)
+                // forward in time the daughters receive the contributions, which we add below in a single pass over the events
+                if ( backward_time == true )
                 {
-                    const std::vector<unsigned>& states = it->first;
-                    double lambda = it->second;
-                    if ( backward_time == true )
-                    {
-                        if (i == states[0])
-                        {
-                            double term1 = safe_x[states[1] + num_states] * safe_x[states[2]];
-                            double term2 = safe_x[states[2] + num_states] * safe_x[states[1]];
-                            dxdt[i + num_states] += lambda * (term1 + term2 );
-                        }
-                    }
-                    else
+                    for (size_t e = event_offsets[i]; e < event_offsets[i+1]; ++e)
                     {
-                        if (i == states[1])
-                        {
-                            dxdt[i + num_states] += lambda * safe_x[states[0] + num_states] * safe_x[states[2]];
-                        }
-                        if (i == states[2])
-                        {
-                            dxdt[i + num_states] += lambda * safe_x[states[0] + num_states] * safe_x[states[1]];
-                        }
+                        unsigned d1 = event_daughter_1[e];
+                        unsigned d2 = event_daughter_2[e];
+                        dd += event_rate[e] * ( observed[d1] * extinct[d2] + observed[d2] * extinct[d1] );
                     }
                 }
             }
             else
             {
-                dxdt[i + num_states] += 2 * lambda[i] * safe_x[i] * safe_x[i + num_states];
+                dd += 2 * lambda[i] * extinct[i] * observed[i];
             }
         
             // anagenetic state change
-            for (size_t j = 0; j < num_states; ++j)
+            if ( backward_time == true )
             {
-                if ( i != j )
+                for (size_t j = 0; j < num_states; ++j)
                 {
-                    if ( backward_time == true )
-                    {
-                        dxdt[i + num_states] += Q->getRate(i, j, age, rate) * safe_x[j + num_states];
-                    }
-                    else
-                    {
-                        dxdt[i + num_states] += Q->getRate(j, i, age, rate) * safe_x[j + num_states];
-                    }
+                    dd += q_row[j] * observed[j];
+                }
+            }
+            else
+            {
+                for (size_t j = 0; j < num_states; ++j)
+                {
+                    dd += anagenetic_rates[j * num_states + i] * observed[j];
                 }
-                
             }
             
+            dxdt[i + num_states] = dd;
+            
         } // end if extinction_only
         
     } // end for num_states
     
+    if ( extinction_only == false && use_speciation_from_event_map == true && backward_time == false )
+    {
+        for (size_t a = 0; a < num_states; ++a)
+        {
+            for (size_t e = event_offsets[a]; e < event_offsets[a+1]; ++e)
+            {
+                unsigned d1 = event_daughter_1[e];
+                unsigned d2 = event_daughter_2[e];
+                dxdt[d1 + num_states] += event_rate[e] * observed[a] * extinct[d2];
+                dxdt[d2 + num_states] += event_rate[e] * observed[a] * extinct[d1];
+            }
+        }
+    }
+    
 }
 
 
+void SSE_ODE::setBackwardTime( bool b )
+{
+    
+    backward_time = b;
+}
+
+
+/**
+ * Set the cladogenetic events.
+ * We copy the event map into flat arrays grouped by the ancestor state (a counting sort),
+ * so that the right-hand side only touches the events of one ancestor state at a time.
+ */
 void SSE_ODE::setEventMap( const std::map<std::vector<unsigned>, double> &e )
 {
     
     use_speciation_from_event_map = true;
-    event_map = e;
+    total_rates_dirty = true;
+    
+    event_offsets.assign( num_states + 1, 0 );
+    std::map<std::vector<unsigned>, double>::const_iterator it;
+    for (it = e.begin(); it != e.end(); ++it)
+    {
+        event_offsets[ it->first[0] + 1 ]++;
+    }
+    for (size_t i = 0; i < num_states; ++i)
+    {
+        event_offsets[i+1] += event_offsets[i];
+    }
+    
+    event_daughter_1.resize( e.size() );
+    event_daughter_2.resize( e.size() );
+    event_rate.resize( e.size() );
+    
+    std::vector<size_t> next_event( event_offsets.begin(), event_offsets.end() - 1 );
+    for (it = e.begin(); it != e.end(); ++it)
+    {
+        const std::vector<unsigned>& states = it->first;
+        size_t index = next_event[ states[0] ]++;
+        event_daughter_1[index] = states[1];
+        event_daughter_2[index] = states[2];
+        event_rate[index]       = it->second;
+    }
+    
+}
+
+
+void SSE_ODE::setExtinctionOnly( bool e )
+{
+    
+    extinction_only = e;
 }
 
 
@@ -197,6 +220,7 @@ void SSE_ODE::setSpeciationRate( const std::vector<double> &s )
 {
     
     use_speciation_from_event_map = false;
+    total_rates_dirty = true;
     lambda = s;
     
 }
@@ -204,7 +228,51 @@ void SSE_ODE::setSpeciationRate( const std::vector<double> &s )
 void SSE_ODE::setSerialSamplingRate( const std::vector<double> &s )
 {
 
+    total_rates_dirty = true;
     psi = s;
 
 }
 
+
+/**
+ * Compute the total speciation rate and the total rate of leaving each state.
+ */
+void SSE_ODE::updateTotalRates( void )
+{
+    
+    for (size_t i = 0; i < num_states; ++i)
+    {
+        
+        // calculate sum of speciation rates
+        // lambda_ijk for all possible values of j and k
+        double sum = 0.0;
+        if ( use_speciation_from_event_map == true )
+        {
+            for (size_t e = event_offsets[i]; e < event_offsets[i+1]; ++e)
+            {
+                sum += event_rate[e];
+            }
+        }
+        else
+        {
+            sum = lambda[i];
+        }
+        double total = mu[i] + sum;
+        if ( allow_rate_shifts_extinction == true )
+        {
+            for (size_t j = 0; j < num_states; ++j)
+            {
+                total += anagenetic_rates[i * num_states + j];
+            }
+        }
+        
+        if ( psi.empty() == false )
+        {
+            total += psi[i];
+        }
+        
+        no_event_rate[i] = total;
+    }
+    
+    total_rates_dirty = false;
+}
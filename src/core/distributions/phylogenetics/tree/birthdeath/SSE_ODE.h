@@ -4,6 +4,7 @@
 #include "AbstractBirthDeathProcess.h"
 #include "RateMatrix.h"
 
+#include <map>
 #include <vector>
 
 namespace RevBayesCore {
@@ -16,6 +17,11 @@ namespace RevBayesCore {
      * cladogenetic multi-rate birth-death process (ClaSSE: Goldberg and Igic, 2012)
      * Will Freyman 6/22/16
      *
+     * The rates are copied into flat arrays when they are set: the anagenetic rates into a dense matrix
+     * and the cladogenetic event map into arrays of (daughter_1, daughter_2, rate) grouped by the ancestor state.
+     * Thus, the right-hand side of the ODE neither searches the event map nor allocates memory,
+     * and the same object can be reused for all branches as long as the parameters do not change.
+     *
      */
     class SSE_ODE {
         
@@ -25,20 +31,35 @@ namespace RevBayesCore {
         
         void operator() ( const std::vector< double > &x, std::vector< double > &dxdt , const double t );
         
+        void            setBackwardTime( bool b );
         void            setEventMap( const std::map<std::vector<unsigned>, double> &e );
+        void            setExtinctionOnly( bool e );
         void            setSpeciationRate( const std::vector<double> &s );
         void            setSerialSamplingRate( const std::vector<double> &s );
         
     private:
         
+        void            updateTotalRates( void );
+        
         std::vector<double>                         mu;                                 //!< vector of extinction rates, one rate for each character state
         std::vector<double>                         lambda;                             //!< vector of speciation rates, one rate for each character state
         std::vector<double>                         psi;                                //!< vector of fossilization rates, one rate for each character state
         size_t                                      num_states;                         //!< the number of character states = q->getNumberOfStates()
-        const RateGenerator*                        Q;                                  //!< anagenetic rate matrix
-        std::map<std::vector<unsigned>, double>     event_map;                          //!< cladogenetic event map, with the structure pair< [ancestor_state, daughter_1_state, daughter_2_state], speciation_rate >
+        std::vector<double>                         anagenetic_rates;                   //!< the off-diagonal anagenetic rates (times the clock rate), row-major with zeros on the diagonal
         double                                      rate;                               //!< clock rate for anagenetic change
         
+        // the cladogenetic event map as flat arrays, sorted by the ancestor state
+        std::vector<size_t>                         event_offsets;                      //!< the events of ancestor state i are [event_offsets[i], event_offsets[i+1])
+        std::vector<unsigned>                       event_daughter_1;                   //!< the state of the first daughter of each event
+        std::vector<unsigned>                       event_daughter_2;                   //!< the state of the second daughter of each event
+        std::vector<double>                         event_rate;                         //!< the speciation rate of each event
+        
+        // per-state totals, computed once from the rates above
+        std::vector<double>                         no_event_rate;                      //!< the total rate of leaving each state (extinction, speciation, sampling and rate shifts)
+        bool                                        total_rates_dirty;                  //!< do we need to recompute the totals?
+        
+        std::vector<double>                         safe_x;                             //!< work space for the clamped ODE state
+        
         // flags to modify behabior
         bool                                        extinction_only;                    //!< calculate only extinction probabilities
         bool                                        use_speciation_from_event_map;      //!< do we use the speciation rates from the event map?
@@ -275,7 +275,7 @@ void SampledSpeciationBirthDeathProcess::computeNodeProbability(const RevBayesCo
         
         // get value
         const BranchHistory& bh = branch_histories[ node_index ];
-        const std::multiset<CharacterEvent*,CharacterEventCompare>& hist = bh.getHistory();
+        const CharacterEventList& hist = bh.getHistory();
         
         // process parameters
         const double &birth       = speciation->getValue();
@@ -300,7 +300,7 @@ void SampledSpeciationBirthDeathProcess::computeNodeProbability(const RevBayesCo
         double prev_time     = 0.0;
         
         // compute probability for the observed and sampled speciation events on the branch
-        for (std::multiset<CharacterEvent*,CharacterEventCompare>::const_reverse_iterator it=hist.rbegin(); it!=hist.rend(); ++it)
+        for (CharacterEventList::const_reverse_iterator it=hist.rbegin(); it!=hist.rend(); ++it)
         {
             CharacterEvent* event = *it;
             double curr_time = event->getAge(); // CHECK THIS AGE
@@ -426,8 +426,8 @@ void SampledSpeciationBirthDeathProcess::executeMethod(const std::string &n, con
             rv[i].resize(num_slots, 0.0);
             
             size_t j = 0;
-            std::multiset<CharacterEvent*, CharacterEventCompare> h = branch_histories[i].getHistory();
-            for ( std::multiset<CharacterEvent*, CharacterEventCompare>::reverse_iterator it = h.rbegin(); it != h.rend(); it++ )
+            CharacterEventList h = branch_histories[i].getHistory();
+            for ( CharacterEventList::reverse_iterator it = h.rbegin(); it != h.rend(); it++ )
             {
                 rv[i][j++] = (*it)->getAge(); // CHECK THIS AGE
                 if (j > num_slots) break;
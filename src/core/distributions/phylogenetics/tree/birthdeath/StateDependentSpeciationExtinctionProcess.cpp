@@ -1882,6 +1882,12 @@ void StateDependentSpeciationExtinctionProcess::restoreSpecialization(const DagN
         }
     }
     
+    // the parameters are restored, so the ODE holds the rates of the rejected values
+    if ( affecter != this->dag_node )
+    {
+        sse_ode = boost::none;
+    }
+    
     // reset the flags
     for (std::vector<bool>::iterator it = dirty_nodes.begin(); it != dirty_nodes.end(); ++it)
     {
@@ -1915,6 +1921,9 @@ void StateDependentSpeciationExtinctionProcess::setCladogenesisMatrix(const Type
     // set the value
     cladogenesis_matrix = cm;
     
+    // the rates of the ODE have changed
+    sse_ode = boost::none;
+    
     // should we use the event map for the speciation rates?
     use_cladogenetic_events = true;
     
@@ -1937,6 +1946,9 @@ void StateDependentSpeciationExtinctionProcess::setSerialSamplingRates(const Typ
 
     // set the value
     phi = r;
+    
+    // the rates of the ODE have changed
+    sse_ode = boost::none;
 
     // add the new parameter
     this->addParameter( phi );
@@ -2010,6 +2022,9 @@ void StateDependentSpeciationExtinctionProcess::setSpeciationRates(const TypedDa
     // set the value
     lambda = r;
     
+    // the rates of the ODE have changed
+    sse_ode = boost::none;
+    
     // should we use the event map for the speciation rates?
     use_cladogenetic_events = false;
     
@@ -3145,6 +3160,8 @@ void StateDependentSpeciationExtinctionProcess::swapParameterInternal(const DagN
         cladogenesis_matrix = static_cast<const TypedDagNode<CladogeneticSpeciationRateMatrix>* >( newP );
     }
     
+    sse_ode = boost::none;
+    
 }
 
 
@@ -3172,6 +3189,9 @@ void StateDependentSpeciationExtinctionProcess::touchSpecialization(const DagNod
     if ( affecter != this->dag_node )
     {
         
+        // a parameter has changed, so we need to recompute the rates of the ODE
+        sse_ode = boost::none;
+        
         for (std::vector<bool>::iterator it = dirty_nodes.begin(); it != dirty_nodes.end(); ++it)
         {
             (*it) = true;
@@ -3196,34 +3216,42 @@ void StateDependentSpeciationExtinctionProcess::touchSpecialization(const DagNod
  */
 void StateDependentSpeciationExtinctionProcess::numericallyIntegrateProcess(std::vector< double > &likelihoods, double begin_age, double end_age, bool backward_time, bool extinction_only) const
 {
-    const std::vector<double> &extinction_rates = mu->getValue();
-    SSE_ODE ode = SSE_ODE(extinction_rates, &getEventRateMatrix(), getEventRate(), backward_time, extinction_only, allow_rate_shifts_on_extinct_lineages);
-    if ( use_cladogenetic_events == true )
-    {
-        cladogenesis_matrix->getValue(); // we must call getValue() to update the speciation and extinction rates in the event map
-        
-        // get cladogenesis event map (sparse speciation rate matrix)
-        std::map<std::vector<unsigned>, double> event_map = cladogenesis_matrix->getValue().getEventMap();
-        
-        ode.setEventMap( event_map );
-    }
-    else
+    
+    // we compile the rates into the ODE only once after each change of the parameters
+    if ( sse_ode == boost::none )
     {
-        const std::vector<double> &speciation_rates = lambda->getValue();
-        ode.setSpeciationRate( speciation_rates );
-    }
+        const std::vector<double> &extinction_rates = mu->getValue();
+        sse_ode = SSE_ODE(extinction_rates, &getEventRateMatrix(), getEventRate(), backward_time, extinction_only, allow_rate_shifts_on_extinct_lineages);
+        if ( use_cladogenetic_events == true )
+        {
+            cladogenesis_matrix->getValue(); // we must call getValue() to update the speciation and extinction rates in the event map
+            
+            // get cladogenesis event map (sparse speciation rate matrix)
+            const std::map<std::vector<unsigned>, double>& event_map = cladogenesis_matrix->getValue().getEventMap();
+            
+            sse_ode->setEventMap( event_map );
+        }
+        else
+        {
+            const std::vector<double> &speciation_rates = lambda->getValue();
+            sse_ode->setSpeciationRate( speciation_rates );
+        }
 
-    if ( phi != NULL )
-    {
-        const std::vector<double> &serial_sampling_rates = phi->getValue();
-        ode.setSerialSamplingRate( serial_sampling_rates );
+        if ( phi != NULL )
+        {
+            const std::vector<double> &serial_sampling_rates = phi->getValue();
+            sse_ode->setSerialSamplingRate( serial_sampling_rates );
+        }
     }
     
+    SSE_ODE& ode = *sse_ode;
+    ode.setBackwardTime( backward_time );
+    ode.setExtinctionOnly( extinction_only );
    
     typedef boost::numeric::odeint::runge_kutta_dopri5< std::vector< double > > stepper_type;
 
 //    boost::numeric::odeint::integrate_adaptive( make_controlled( 1E-7, 1E-7, stepper_type() ) , ode , likelihoods , begin_age , end_age , dt );
-    boost::numeric::odeint::integrate_adaptive( stepper_type(), ode , likelihoods , begin_age , end_age , dt );
+    boost::numeric::odeint::integrate_adaptive( stepper_type(), boost::ref(ode) , likelihoods , begin_age , end_age , dt );
     
     // catch negative extinction probabilities that can result from
     // rounding errors in the ODE stepper
@@ -18,6 +18,7 @@
 
 
 #include <vector>
+#include <boost/optional.hpp>
 
 namespace RevBayesCore {
     
@@ -125,6 +126,7 @@ namespace RevBayesCore {
         mutable std::vector<std::vector<double> >                       extinction_probabilities;
         size_t                                                          num_states;
         mutable std::vector<std::vector<double> >                       scaling_factors;
+        mutable boost::optional<SSE_ODE>                                sse_ode;                                                                                            //!< The ODE with the current rates, shared by all branches until a parameter changes.
         bool                                                            use_cladogenetic_events;                                                                            //!< do we use the speciation rates from the cladogenetic event map?
         bool                                                            use_origin;
         bool                                                            sample_character_history;                                                                           //!< are we sampling the character history along branches?
@@ -2607,7 +2607,7 @@ void TimeVaryingStateDependentSpeciationExtinctionProcess::numericallyIntegrateP
             cladogenesis_matrix->getValue(); // we must call getValue() to update the speciation and extinction rates in the event map
         
             // get cladogenesis event map (sparse speciation rate matrix)
-            std::map<std::vector<unsigned>, double> event_map = cladogenesis_matrix->getValue().getEventMap();
+            const std::map<std::vector<unsigned>, double>& event_map = cladogenesis_matrix->getValue().getEventMap();
         
             ode.setEventMap( event_map );
         }
@@ -2624,7 +2624,7 @@ void TimeVaryingStateDependentSpeciationExtinctionProcess::numericallyIntegrateP
         }
     
         typedef boost::numeric::odeint::runge_kutta_dopri5< std::vector< double > > stepper_type;
-        boost::numeric::odeint::integrate_adaptive( make_controlled( 1E-6 , 1E-6 , stepper_type() ) , ode , likelihoods , current_begin_age , current_end_age , dt );
+        boost::numeric::odeint::integrate_adaptive( make_controlled( 1E-6 , 1E-6 , stepper_type() ) , boost::ref(ode) , likelihoods , current_begin_age , current_end_age , dt );
     
         // catch negative extinction probabilities that can result from
         // rounding errors in the ODE stepper
@@ -142,6 +142,47 @@ void Function::keep( const DagNode* affecter )
 }
 
 
+/**
+ * Element i of our value only depends on element i of the parameter p (and on parameters that are not vectors).
+ * Hence, if the parameter touched us and knows which of its elements changed, exactly these elements of our value changed.
+ */
+bool Function::forwardTouchedElementIndices(const DagNode *toucher, const DagNode *p, std::set<size_t> &indices) const
+{
+    
+    if ( toucher != p )
+    {
+        return false;
+    }
+    
+    const std::set<size_t> &touched_indices = p->getTouchedElementIndices();
+    
+    // maybe all of them have been touched or the flags haven't been set properly
+    if ( touched_indices.empty() == true )
+    {
+        return false;
+    }
+    
+    indices.insert( touched_indices.begin(), touched_indices.end() );
+    
+    return true;
+}
+
+
+/**
+ * Get the indices of the elements of our value that change when the toucher changed.
+ * This allows the deterministic node to tell its children which elements changed, so that a change of a single element,
+ * e.g., the rate of one branch, reaches the likelihood as a single dirty branch through chains of deterministic nodes.
+ * By default we cannot tell, so all elements may have changed. Functions with element-wise dependencies override this method.
+ *
+ * \return True if we know the affected elements, false if all elements may change.
+ */
+bool Function::getAffectedElementIndices(const DagNode *toucher, std::set<size_t> &indices) const
+{
+    
+    return false;
+}
+
+
 /* Method stub: override for specialized treatment. */
 void Function::reInitialized( void )
 {
@@ -20,6 +20,7 @@ namespace RevBayesCore {
                
         // public methods
         bool                                        forceUpdates(void) const;                                                   //!< Does this method forces the DAG node to always call update even if not touched?
+        virtual bool                                getAffectedElementIndices(const DagNode *toucher, std::set<size_t> &indices) const;    //!< Which elements of our value change if the toucher changed? False if all may change.
         virtual void                                getAffected(RbOrderedSet<DagNode *>& affected, const DagNode* affecter);    //!< get affected nodes
         const std::vector<const DagNode*>&          getParameters(void) const;                                                  //!< get the parameters of the function
         virtual void                                keep(const DagNode* affecter);
@@ -39,6 +40,7 @@ namespace RevBayesCore {
         Function&                                   operator=(const Function &f);                                               //!< Assignment operator
         
         void                                        addParameter(const DagNode* p);                                             //!< add a parameter to the function
+        bool                                        forwardTouchedElementIndices(const DagNode *toucher, const DagNode *p, std::set<size_t> &indices) const;      //!< Element i of our value only depends on element i of the parameter
         void                                        removeParameter(const DagNode* p);                                          //!< remove a parameter from the function
         virtual void                                swapParameterInternal(const DagNode *oldP, const DagNode *newP) = 0;        //!< Exchange the parameter
                 
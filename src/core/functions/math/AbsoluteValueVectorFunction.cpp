@@ -30,6 +30,13 @@ AbsoluteValueVectorFunction* AbsoluteValueVectorFunction::clone( void ) const
 }
 
 
+bool AbsoluteValueVectorFunction::getAffectedElementIndices(const DagNode *toucher, std::set<size_t> &indices) const
+{
+    
+    return forwardTouchedElementIndices( toucher, a, indices );
+}
+
+
 void AbsoluteValueVectorFunction::swapParameterInternal(const DagNode *oldP, const DagNode *newP)
 {
     
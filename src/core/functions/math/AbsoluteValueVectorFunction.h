@@ -22,6 +22,7 @@ template <class valueType> class TypedDagNode;
         AbsoluteValueVectorFunction(const TypedDagNode<RbVector<double> > *a);
         
         AbsoluteValueVectorFunction*                clone(void) const;                                                  //!< Create a clon.
+        bool                                        getAffectedElementIndices(const DagNode *toucher, std::set<size_t> &indices) const;    //!< Element i only depends on element i of the argument
         void                                        update(void);                                                       //!< Recompute the value
         
     protected:
@@ -33,6 +33,17 @@ PowerVectorFunction* PowerVectorFunction::clone( void ) const
     return new PowerVectorFunction(*this);
 }
 
+
+/**
+ * Element i is b[i]^e, so only the touched elements of the base change. A new exponent changes all elements.
+ */
+bool PowerVectorFunction::getAffectedElementIndices(const DagNode *toucher, std::set<size_t> &indices) const
+{
+    
+    return forwardTouchedElementIndices( toucher, base, indices );
+}
+
+
 void PowerVectorFunction::swapParameterInternal(const DagNode *oldP, const DagNode *newP)
 {
     if (oldP == base)
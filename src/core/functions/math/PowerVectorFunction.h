@@ -24,6 +24,7 @@ template <class valueType> class TypedDagNode;
         PowerVectorFunction(const TypedDagNode<RbVector<double> > *b, const TypedDagNode<double> *e);
         
         PowerVectorFunction*                        clone(void) const;                                                  //!< Create a clon.
+        bool                                        getAffectedElementIndices(const DagNode *toucher, std::set<size_t> &indices) const;    //!< Element i only depends on element i of the base
         void                                        update(void);                                                       //!< Recompute the value
         
     protected:
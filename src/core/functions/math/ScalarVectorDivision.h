@@ -27,6 +27,7 @@ namespace RevBayesCore {
         ScalarVectorDivision(const TypedDagNode<firstValueType> *a, const TypedDagNode<RbVector<secondValueType> > *b);
         
         ScalarVectorDivision*                               clone(void) const;                                                          //!< Create a clon.
+        bool                                                getAffectedElementIndices(const DagNode *toucher, std::set<size_t> &indices) const;     //!< Element i only depends on element i of the vector
         void                                                update(void);                                                               //!< Recompute the value
         
     protected:
@@ -60,6 +61,17 @@ RevBayesCore::ScalarVectorDivision<firstValueType, secondValueType, return_type>
 }
 
 
+/**
+ * Element i of the result is a / b[i], so only the touched elements of the vector change. A new a changes all elements.
+ */
+template<class firstValueType, class secondValueType, class return_type>
+bool RevBayesCore::ScalarVectorDivision<firstValueType, secondValueType, return_type>::getAffectedElementIndices(const DagNode *toucher, std::set<size_t> &indices) const
+{
+    
+    return this->forwardTouchedElementIndices( toucher, b, indices );
+}
+
+
 template<class firstValueType, class secondValueType, class return_type>
 void RevBayesCore::ScalarVectorDivision<firstValueType, secondValueType, return_type>::swapParameterInternal(const DagNode *oldP, const DagNode *newP)
 {
@@ -27,6 +27,7 @@ namespace RevBayesCore {
         VectorScalarDivision(const TypedDagNode< RbVector<firstValueType> > *a, const TypedDagNode<secondValueType> *b);
         
         VectorScalarDivision*                               clone(void) const;                                                          //!< Create a clon.
+        bool                                                getAffectedElementIndices(const DagNode *toucher, std::set<size_t> &indices) const;     //!< Element i only depends on element i of the vector
         void                                                update(void);                                                               //!< Recompute the value
         
     protected:
@@ -60,6 +61,17 @@ RevBayesCore::VectorScalarDivision<firstValueType, secondValueType, return_type>
 }
 
 
+/**
+ * Element i of the result is a[i] / b, so only the touched elements of the vector change. A new b changes all elements.
+ */
+template<class firstValueType, class secondValueType, class return_type>
+bool RevBayesCore::VectorScalarDivision<firstValueType, secondValueType, return_type>::getAffectedElementIndices(const DagNode *toucher, std::set<size_t> &indices) const
+{
+    
+    return this->forwardTouchedElementIndices( toucher, a, indices );
+}
+
+
 template<class firstValueType, class secondValueType, class return_type>
 void RevBayesCore::VectorScalarDivision<firstValueType, secondValueType, return_type>::swapParameterInternal(const DagNode *oldP, const DagNode *newP)
 {
@@ -62,6 +62,17 @@ TreeAssemblyFunction* TreeAssemblyFunction::clone( void ) const
 }
 
 
+/**
+ * The branch length vector is indexed by the node indices, so a change of some branch lengths
+ * only changes the tree at these nodes. A change of the topology may change everything.
+ */
+bool TreeAssemblyFunction::getAffectedElementIndices(const DagNode *toucher, std::set<size_t> &indices) const
+{
+    
+    return forwardTouchedElementIndices( toucher, brlen, indices );
+}
+
+
 void TreeAssemblyFunction::keep( const DagNode *affecter )
 {
     //delegate to base class
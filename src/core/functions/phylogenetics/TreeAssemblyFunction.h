@@ -24,6 +24,7 @@ template <class valueType> class TypedDagNode;
         
         // public member functions
         TreeAssemblyFunction*                               clone(void) const;                                                                  //!< Create an independent clone
+        bool                                                getAffectedElementIndices(const DagNode *toucher, std::set<size_t> &indices) const; //!< The nodes whose branch lengths changed
         void                                                keep(const DagNode* affecter);
         void                                                restore(const DagNode *restorer);
         void                                                reInitialized(void);                                                                //!< The arguments have been re-initialized
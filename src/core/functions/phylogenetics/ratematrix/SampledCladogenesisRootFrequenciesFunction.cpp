@@ -169,7 +169,7 @@ void SampledCladogenesisRootFrequenciesFunction::update( void ) {
         const AbstractCharacterHistoryBirthDeathProcess* dist = dynamic_cast<const AbstractCharacterHistoryBirthDeathProcess* >( &tree->getDistribution() );
         const CharacterHistoryDiscrete& tree_history = static_cast<const CharacterHistoryDiscrete&>(dist->getCharacterHistory());
         const BranchHistory& branch_history = tree_history[root.getIndex()];
-        const std::multiset<CharacterEvent*,CharacterEventCompare>& events = branch_history.getHistory();
+        const CharacterEventList& events = branch_history.getHistory();
         
         // for each interval between events, go from present to past
         double brlen = root.getAge();
@@ -180,7 +180,7 @@ void SampledCladogenesisRootFrequenciesFunction::update( void ) {
         double dt = 0.0;
         double prev_age = startAge;
         double event_age = prev_age;
-        std::multiset<CharacterEvent*,CharacterEventCompare>::reverse_iterator it;
+        CharacterEventList::const_reverse_iterator it;
         for (it = events.rbegin(); it != events.rend(); it++)
         {
             
@@ -38,10 +38,10 @@ namespace RevBayesCore {
         
         // public member functions
         VectorFunction*                                     clone(void) const;                                                          //!< Create an independent clone
+        bool                                                getAffectedElementIndices(const DagNode *toucher, std::set<size_t> &indices) const;     //!< The elements that are the toucher
         const std::vector<const TypedDagNode<valueType>* >& getVectorParameters(void) const;
         void                                                keep(const DagNode* affecter);
         void                                                restore(const DagNode *restorer);
-        void                                                touch(const DagNode *toucher );
         void                                                update(void);
         
     protected:
@@ -92,6 +92,26 @@ RevBayesCore::VectorFunction<valueType>* RevBayesCore::VectorFunction<valueType>
 }
 
 
+/**
+ * The toucher changed the elements of our vector that are the toucher.
+ */
+template <class valueType>
+bool RevBayesCore::VectorFunction<valueType>::getAffectedElementIndices( const DagNode *toucher, std::set<size_t> &indices ) const
+{
+    
+    for (size_t i = 0; i < vectorParams.size(); ++i)
+    {
+        if (toucher == vectorParams[i])
+        {
+            indices.insert( i );
+            // don't jump out of the loop because we could have the same parameter multiple times for this vector, e.g., v(a,a,b,a)
+        }
+    }
+    
+    return indices.empty() == false;
+}
+
+
 template <class valueType>
 const std::vector<const RevBayesCore::TypedDagNode<valueType>* >& RevBayesCore::VectorFunction<valueType>::getVectorParameters( void ) const
 {
@@ -169,23 +189,4 @@ void RevBayesCore::VectorFunction<valueType>::swapParameterInternal(const DagNod
     
 }
 
-
-template <class valueType>
-void RevBayesCore::VectorFunction<valueType>::touch( const DagNode *toucher )
-{
-    
-    //delegate to base class
-    TypedFunction< RbVector<valueType> >::touch( toucher );
-    
-    for (size_t i = 0; i < vectorParams.size(); ++i)
-    {
-        if (toucher == vectorParams[i]) 
-        {
-            this->dag_node->addTouchedElementIndex( i );
-            // don't jump out of the loop because we could have the same parameter multiple times for this vector, e.g., v(a,a,b,a)
-        }
-    }
-    
-}
-
 #endif
@@ -1,8 +1,7 @@
 #include "NewickConverter.h"
 
-#include <stdio.h>
 #include <stdlib.h>
-#include <sstream>
+#include <charconv>
 #include <vector>
 #include <string>
 
@@ -12,6 +11,88 @@
 
 using namespace RevBayesCore;
 
+
+namespace {
+
+    /**
+     * Read a branch length in the same way as a stream would: leading whitespace and a plus sign are skipped,
+     * trailing characters are ignored and the value is 0 if the token does not start with a number.
+     */
+    double parseDouble(std::string_view token)
+    {
+
+        size_t start = 0;
+        while ( start < token.size() && isspace( token[start] ) )
+        {
+            ++start;
+        }
+        if ( start < token.size() && token[start] == '+' )
+        {
+            ++start;
+        }
+
+        double d = 0.0;
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+        std::from_chars( token.data() + start, token.data() + token.size(), d );
+#else
+        // older standard libraries do not convert floating point numbers with from_chars
+        std::string tmp( token.substr( start ) );
+        char* end = NULL;
+        d = strtod( tmp.c_str(), &end );
+        if ( end == tmp.c_str() )
+        {
+            d = 0.0;
+        }
+#endif
+
+        return d;
+    }
+
+
+    /**
+     * Read an integer in the same way as atoi.
+     */
+    long parseInteger(std::string_view token)
+    {
+
+        size_t start = 0;
+        while ( start < token.size() && isspace( token[start] ) )
+        {
+            ++start;
+        }
+        if ( start < token.size() && token[start] == '+' )
+        {
+            ++start;
+        }
+
+        long i = 0;
+        std::from_chars( token.data() + start, token.data() + token.size(), i );
+
+        return i;
+    }
+
+
+    /**
+     * Read a token starting at pos until the end of the string or the first of the given stop characters.
+     */
+    std::string_view readToken(std::string_view n, size_t &pos, const char* stop)
+    {
+
+        size_t end = n.find_first_of( stop, pos );
+        if ( end == std::string_view::npos )
+        {
+            end = n.size();
+        }
+
+        std::string_view token = n.substr( pos, end - pos );
+        pos = end;
+
+        return token;
+    }
+
+}
+
+
 NewickConverter::NewickConverter()
 {
 
@@ -34,31 +115,39 @@ Tree* NewickConverter::convertFromNewick(std::string const &n, bool reindex)
     std::vector<TopologyNode*> nodes;
     std::vector<double> brlens;
 
-    // create a string-stream and throw the string into it
-    std::stringstream ss (std::stringstream::in | std::stringstream::out);
-    ss << n;
-
-    // ignore white spaces
-    std::string trimmed = "";
-    char c;
-    while ( ss.good() )
+    // ignore white spaces (we only need a copy if there are any)
+    std::string trimmed;
+    std::string_view newick = n;
+    if ( n.find(' ') != std::string::npos )
     {
-        // check for EOF
-        int c_int = ss.get();
-        if (c_int != EOF)
+        trimmed.reserve( n.size() );
+        for (size_t i = 0; i < n.size(); ++i)
         {
-            c = char( c_int );
-            if ( c != ' ')
+            if ( n[i] != ' ' )
             {
-                trimmed += c;
+                trimmed += n[i];
             }
-
         }
-
+        newick = trimmed;
     }
 
     // construct the tree starting from the root
-    TopologyNode *root = createNode( trimmed, nodes, brlens );
+    size_t pos = 0;
+    TopologyNode *root = NULL;
+    try
+    {
+        root = createNode( newick, pos, nodes, brlens );
+        readNodeInformation( root, newick, pos, true, nodes, brlens );
+    }
+    catch (...)
+    {
+        if ( root != NULL )
+        {
+            delete root;
+        }
+        delete t;
+        throw;
+    }
 
     // set up the tree
     t->setRoot( root, reindex );
@@ -91,220 +180,64 @@ Tree* NewickConverter::convertFromNewick(std::string const &n, bool reindex)
 }
 
 
-
-TopologyNode* NewickConverter::createNode(const std::string &n, std::vector<TopologyNode*> &nodes, std::vector<double> &brlens) {
-
-    // create a string-stream and throw the string into it
-    std::stringstream ss (std::stringstream::in | std::stringstream::out);
-    ss << n;
-
-    char c = ' ';
-    ss.get(c);
+/**
+ * Parse the internal node starting with the opening parenthesis at pos, including all its descendants.
+ * On return, pos points to the first character after the closing parenthesis. The label, parameters
+ * and branch length following the closing parenthesis are read by the caller.
+ */
+TopologyNode* NewickConverter::createNode(std::string_view n, size_t &pos, std::vector<TopologyNode*> &nodes, std::vector<double> &brlens)
+{
 
     // the initial character has to be '('
-    if ( c != '(')
+    if ( pos >= n.size() || n[pos] != '(' )
     {
-        throw RbException("Error while converting Newick tree. We expected an opening parenthesis, but didn't get one. Problematic string: " + n);
+        throw RbException("Error while converting Newick tree. We expected an opening parenthesis, but didn't get one. Problematic string: " + std::string( n.substr(pos) ));
     }
+    ++pos;
 
     TopologyNode *node = new TopologyNode();
-    while ( ss.good() && ss.peek() != ')' )
+    try
     {
-
-        TopologyNode *childNode;
-        if (ss.peek() == '(' )
-        {
-            // we received an internal node
-            int depth = 0;
-            std::string child = "";
-            do
-            {
-                ss.get(c);
-                child += c;
-                if ( c == '(' )
-                {
-                    depth++;
-                }
-                else if ( c == ')' )
-                {
-                    depth--;
-                }
-
-            } while ( ss.good() && depth > 0 );
-
-            // construct the child node
-            childNode = createNode( child, nodes, brlens );
-        }
-        else
-        {
-            // construct the node
-            childNode = new TopologyNode();
-        }
-
-        // set the parent child relationship
-        node->addChild( childNode );
-        childNode->setParent( node );
-
-        // read the optional label
-        std::string lbl = "";
-        while ( ss.good() && (c = char( ss.peek() ) ) != ':' && c != '[' && c != ';' && c != ',' && c != ')')
-        {
-            lbl += char( ss.get() );
-        }
-        childNode->setName( lbl );
-
-        // read the optional node parameters
-        if ( ss.peek() == '[' )
+        while ( pos < n.size() && n[pos] != ')' )
         {
 
-            do
+            TopologyNode *childNode;
+            if ( n[pos] == '(' )
             {
-
-                ss.ignore();
-                // ignore the '&' before parameter name
-                if ( ss.peek() == '&')
-                {
-                    ss.ignore();
-                }
-
-                // read the parameter name
-                std::string paramName = "";
-                while ( ss.good() && (c = char( ss.peek() ) ) != '=' && c != ',' && c != ']')
-                {
-                    paramName += char( ss.get() );
-                }
-
-                // ignore the equal sign between parameter name and value
-                if ( ss.peek() == '=')
-                {
-                    ss.ignore();
-                }
-
-                // read the parameter name
-                std::string paramValue = "";
-                while ( ss.good() && (c = char( ss.peek() ) ) != ']' && c != ',' && c != ':')
-                {
-                    paramValue += char( ss.get() );
-                }
-
-				if (paramName == "index")
-                {
-					// subtract by 1 to correct RevLanguage 1-based indexing
-                    childNode->setIndex( atoi(paramValue.c_str()) - 1 );
-
-                }
-                else if (paramName=="species")
-                {
-                    childNode->setSpeciesName(paramValue);
-				}
-                else
-                {
-                    childNode->addNodeParameter(paramName, paramValue);
-                }
-
-            } while ( (c = char( ss.peek() ) ) == ',' );
-
-            // ignore the final ']'
-            if ( (c = char( ss.peek( ) ) ) == ']' )
-            {
-                ss.ignore();
+                // we received an internal node
+                childNode = createNode( n, pos, nodes, brlens );
             }
-
-        }
-
-        // read the optional branch length
-        if ( ss.peek() == ':' )
-        {
-            ss.ignore();
-            std::string time = "";
-            while ( ss.good() && (c = char( ss.peek( ) ) ) != ';' && c != ',' && c != ')' && c != '[' )
+            else
             {
-                time += char( ss.get() );
+                // construct the node
+                childNode = new TopologyNode();
             }
 
-            std::istringstream stm;
-            stm.str(time);
-            double d;
-            stm >> d;
-            nodes.push_back( childNode );
-            brlens.push_back( d );
-        }
-        else
-        {
-            nodes.push_back( childNode );
-            brlens.push_back( 0.0 );
-        }
+            // set the parent child relationship
+            node->addChild( childNode );
+            childNode->setParent( node );
 
-        // read the optional branch parameters
-        if ( char( ss.peek() ) == '[' )
-        {
+            // read the label, parameters and branch length of the child
+            readNodeInformation( childNode, n, pos, false, nodes, brlens );
 
-            do
+            // skip comma
+            if ( pos < n.size() && n[pos] == ',' )
             {
+                ++pos;
+            }
 
-                ss.ignore();
-
-                // ignore the '&' before parameter name
-                if ( char( ss.peek() ) == '&')
-                {
-                    ss.ignore();
-                }
-
-                // read the parameter name
-                std::string paramName = "";
-                while ( ss.good() && (c = char( ss.peek() )) != '=' && c != ',')
-                {
-                    paramName += char( ss.get() );
-                }
-
-                // ignore the equal sign between parameter name and value
-                if ( char( ss.peek() ) == '=')
-                {
-                    ss.ignore();
-                }
-
-                // read the parameter name
-                std::string paramValue = "";
-                while ( ss.good() && (c = char( ss.peek() )) != ']' && c != ',' && c != ':')
-                {
-                    paramValue += char( ss.get() );
-                }
-
-                if (paramName=="index")
-                {
-                    // subtract by 1 to correct RevLanguage 1-based indexing
-                    childNode->setIndex( atoi(paramValue.c_str()) - 1 );
-                }
-                else if (paramName=="species")
-                {
-                    childNode->setSpeciesName(paramValue);
-                }
-                else
-                {
-                    childNode->addBranchParameter(paramName, paramValue);
-                }
-
-
-            } while ( (c = char( ss.peek() )) != ']' );
-
-            ss.ignore();
-
-        }
-
-
-        // skip comma
-        if ( char( ss.peek() ) == ',' )
-        {
-            ss.ignore();
-        }
-
-        // skip comma
-        if ( char( ss.peek() ) == ';' )
-        {
-            // Avoid infinite loop.
-            throw RbException()<<"Not enough closing parentheses!";
+            if ( pos < n.size() && n[pos] == ';' )
+            {
+                // Avoid infinite loop.
+                throw RbException()<<"Not enough closing parentheses!";
+            }
         }
     }
+    catch (...)
+    {
+        delete node;
+        throw;
+    }
 
     if (node->getNumberOfChildren() == 1)
     {
@@ -312,161 +245,108 @@ TopologyNode* NewickConverter::createNode(const std::string &n, std::vector<Topo
     }
 
     // remove closing parenthesis
-    ss.ignore();
-
-    // read the optional label, checking for EOF = '\377'
-    std::string lbl = "";
-    while ( ss.good() && (c = char( ss.peek() )) != ':' && c != ';' && c != ',' && c != '[' && c != '\377')
+    if ( pos < n.size() )
     {
-        lbl += char( ss.get() );
+        ++pos;
     }
-    node->setName( lbl );
-
-    // read the optional node parameters
-    if ( char( ss.peek() ) == '[' )
-    {
-
-        do
-        {
-
-            ss.ignore();
-
-            // ignore the '&' before parameter name
-            if ( char( ss.peek() ) == '&')
-            {
-                ss.ignore();
-            }
-
-            // read the parameter name
-            std::string paramName = "";
-            while ( ss.good() && (c = char( ss.peek() )) != '=' && c != ',')
-            {
-                paramName += char( ss.get() );
-            }
-
-            // ignore the equal sign between parameter name and value
-            if ( char( ss.peek() ) == '=')
-            {
-                ss.ignore();
-            }
 
-            // read the parameter name
-            std::string paramValue = "";
-            while ( ss.good() && (c = char( ss.peek() )) != ']' && c != ',' && c != ':')
-            {
-                paramValue += char( ss.get() );
-            }
-
-			if (paramName=="index")
-            {
-				// subtract by 1 to correct RevLanguage 1-based indexing
-				node->setIndex( atoi(paramValue.c_str()) - 1 );
-
-			}
-            else if (paramName=="species")
-            {
-				node->setSpeciesName(paramValue);
-            }
-            else
-            {
-                node->addNodeParameter(paramName, paramValue);
-            }
+    return node;
+}
 
 
-        } while ( (c = char( ss.peek() )) == ',' );
+/**
+ * Read the optional label, node parameters, branch length and branch parameters following a node.
+ * The label and branch length of the root may not contain a closing parenthesis.
+ */
+void NewickConverter::readNodeInformation(TopologyNode *node, std::string_view n, size_t &pos, bool is_root, std::vector<TopologyNode*> &nodes, std::vector<double> &brlens)
+{
 
-        // ignore the final ']'
-        if ( (c = char( ss.peek() )) == ']' )
-        {
-            ss.ignore();
-        }
+    // read the optional label
+    std::string_view lbl = readToken( n, pos, (is_root ? ":[;," : ":[;,)") );
+    node->setName( std::string( lbl ) );
 
+    // read the optional node parameters
+    if ( pos < n.size() && n[pos] == '[' )
+    {
+        readParameters( node, n, pos, false );
     }
 
     // read the optional branch length
-    if ( char( ss.peek() ) == ':' )
+    double d = 0.0;
+    if ( pos < n.size() && n[pos] == ':' )
     {
-        ss.ignore();
-        std::string time = "";
-        while ( ss.good() && (c = char( ss.peek() )) != ';' && c != ',' && c != '[' )
-        {
-            time += char( ss.get() );
-        }
-
-        std::istringstream stm;
-        stm.str(time);
-        double d;
-        stm >> d;
-        nodes.push_back( node );
-        brlens.push_back( d );
+        ++pos;
+        d = parseDouble( readToken( n, pos, (is_root ? ";,[" : ";,)[") ) );
     }
-    else
-    {
-        nodes.push_back( node );
-        brlens.push_back( 0.0 );
-    }
-
-
+    nodes.push_back( node );
+    brlens.push_back( d );
 
     // read the optional branch parameters
-    if ( char( ss.peek() ) == '[' )
+    if ( pos < n.size() && n[pos] == '[' )
     {
+        readParameters( node, n, pos, true );
+    }
 
-        do
-        {
+}
 
-            ss.ignore();
 
-            // ignore the '&' before parameter name
-            if ( char( ss.peek() ) == '&')
-            {
-                ss.ignore();
-            }
+/**
+ * Read a comment with node or branch parameters, e.g., [&index=3,rate=0.5].
+ * The index is converted from the 1-based indexing of the Rev language.
+ */
+void NewickConverter::readParameters(TopologyNode *node, std::string_view n, size_t &pos, bool branch)
+{
 
-            // read the parameter name
-            std::string paramName = "";
-            while ( ss.good() && (c = char( ss.peek() )) != '=' && c != ',')
-            {
-                paramName += char( ss.get() );
-            }
+    do
+    {
 
-            // ignore the equal sign between parameter name and value
-            if ( char( ss.peek() ) == '=')
-            {
-                ss.ignore();
-            }
+        // skip the '[' or the ',' between parameters
+        ++pos;
 
-            // read the parameter name
-            std::string paramValue = "";
-            while ( ss.good() && (c = char( ss.peek() )) != ']' && c != ',' && c != ':')
-            {
-                paramValue += char( ss.get() );
-            }
+        // ignore the '&' before parameter name
+        if ( pos < n.size() && n[pos] == '&' )
+        {
+            ++pos;
+        }
 
-            if (paramName=="index")
-            {
-                // subtract by 1 to correct RevLanguage 1-based indexing
-                node->setIndex( atoi(paramValue.c_str()) - 1 );
+        // read the parameter name
+        std::string_view param_name = readToken( n, pos, "=,]" );
 
-            }
-            else if (paramName=="species")
-            {
-                node->setSpeciesName(paramValue);
-            }
-            else
-            {
-                node->addBranchParameter(paramName, paramValue);
-            }
+        // ignore the equal sign between parameter name and value
+        if ( pos < n.size() && n[pos] == '=' )
+        {
+            ++pos;
+        }
 
+        // read the parameter value
+        std::string_view param_value = readToken( n, pos, "],:" );
 
-        } while ( (c = char( ss.peek() )) != ']' );
+        if ( param_name == "index" )
+        {
+            // subtract by 1 to correct RevLanguage 1-based indexing
+            node->setIndex( parseInteger( param_value ) - 1 );
+        }
+        else if ( param_name == "species" )
+        {
+            node->setSpeciesName( std::string(param_value) );
+        }
+        else if ( branch == true )
+        {
+            node->addBranchParameter( std::string(param_name), std::string(param_value) );
+        }
+        else
+        {
+            node->addNodeParameter( std::string(param_name), std::string(param_value) );
+        }
 
-        ss.ignore();
+    } while ( pos < n.size() && ( branch == true ? n[pos] != ']' : n[pos] == ',' ) );
 
+    // ignore the final ']'
+    if ( pos < n.size() && n[pos] == ']' )
+    {
+        ++pos;
     }
 
-
-    return node;
 }
 
 
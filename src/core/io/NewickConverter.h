@@ -20,14 +20,21 @@
 #define NewickConverter_H
 
 
+#include <stddef.h>
+#include <string>
+#include <string_view>
 #include <vector>
-#include <iosfwd>
 
 namespace RevBayesCore {
 
     class Tree;
     class TopologyNode;
 
+    /**
+     * The Newick string is parsed in a single pass over a view of the string. The parser does not copy
+     * the string or build temporary streams: labels, comments and branch lengths are read as views
+     * and numbers are converted in place.
+     */
     class NewickConverter {
 
     public:
@@ -38,7 +45,9 @@ namespace RevBayesCore {
 //        AdmixtureTree*          getAdmixtureTreeFromNewick(const std::string &n);
 
     private:
-        TopologyNode*           createNode(const std::string &n, std::vector<TopologyNode*> &nodes, std::vector<double> &brlens);
+        TopologyNode*           createNode(std::string_view n, size_t &pos, std::vector<TopologyNode*> &nodes, std::vector<double> &brlens);
+        void                    readNodeInformation(TopologyNode *node, std::string_view n, size_t &pos, bool is_root, std::vector<TopologyNode*> &nodes, std::vector<double> &brlens);
+        void                    readParameters(TopologyNode *node, std::string_view n, size_t &pos, bool branch);
     };
 
 }
@@ -6,8 +6,7 @@
 #include "NewickTreeReader.h"
 #include "RbException.h"
 #include "RbFileManager.h"
-
-namespace RevBayesCore { class Tree; }
+#include "Tree.h"
 
 using namespace RevBayesCore;
 
@@ -37,27 +36,36 @@ std::vector<Tree*>* NewickTreeReader::readBranchLengthTrees(const path& fn)
     
     /* Initialize */
     std::vector<Tree*>* trees = new std::vector<Tree*>();
-    std::string commandLine;
+    NewickConverter c;
+    std::string line;
     
     /* line-processing loop */
-    while ( inFile.good() ) 
+    try
+    {
+        while ( inFile.good() ) 
+        {
+            
+            // Read a line
+            safeGetline( inFile, line );
+            
+            // skip empty lines
+            if (line.length() == 0) 
+            {
+                continue;
+            }
+            
+            // convert the tree right away, so that we never hold more than one line
+            trees->push_back( c.convertFromNewick( line ) );
+        }
+    }
+    catch (...)
     {
-        
-        // Read a line
-        std::string line;
-        safeGetline( inFile, line );
-        
-        // skip empty lines
-        if (line.length() == 0) 
+        for (size_t i = 0; i < trees->size(); ++i)
         {
-            continue;
+            delete (*trees)[i];
         }
-                
-        
-        NewickConverter c;
-        Tree *blTree = c.convertFromNewick( line );
-        
-        trees->push_back( blTree );
+        delete trees;
+        throw;
     }
     
     return trees;
@@ -6,6 +6,8 @@
 
 using namespace RevBayesCore;
 
+thread_local RandomNumberGenerator* RandomNumberFactory::threadGenerator = NULL;
+
 /** Default constructor */
 RandomNumberFactory::RandomNumberFactory(void)
 {
@@ -28,3 +30,20 @@ void RandomNumberFactory::deleteRandomNumberGenerator(RandomNumberGenerator* r)
     
     delete r;
 }
+
+
+/**
+ * Set the random number object used by GLOBAL_RNG on the calling thread.
+ * The caller keeps ownership of the object and must restore the previous one when done.
+ *
+ * \param[in]    r    The random number object, or NULL for the global one.
+ * \return The random number object that was used before.
+ */
+RandomNumberGenerator* RandomNumberFactory::setThreadRandomNumberGenerator(RandomNumberGenerator* r)
+{
+    
+    RandomNumberGenerator* previous = threadGenerator;
+    threadGenerator = r;
+    
+    return previous;
+}
@@ -3,6 +3,7 @@
 #ifndef RandomNumberFactory_H
 #define RandomNumberFactory_H
 
+#include <cstddef>
 #include <set>
 
 namespace RevBayesCore {
@@ -20,6 +21,11 @@ namespace RevBayesCore {
      * class has two seeds it manages: one is a global seed and the other is
      * is a so called local seed.
      *
+     * Code running several independent computations on different threads (e.g. the chains of an MCMCMC)
+     * can give each computation its own random number object through setThreadRandomNumberGenerator.
+     * GLOBAL_RNG then returns that object on the calling thread, so the draws do not depend on
+     * how the computations are scheduled.
+     *
      */
     class RandomNumberFactory {
 
@@ -30,7 +36,8 @@ namespace RevBayesCore {
                                                         return singleRandomNumberFactory;
                                                     }
 		void                                        deleteRandomNumberGenerator(RandomNumberGenerator* r);                                 //!< Return a random number object to the pool
-		RandomNumberGenerator*                      getGlobalRandomNumberGenerator(void) { return seedGenerator; }                         //!< Return a pointer to the global random number object
+		RandomNumberGenerator*                      getGlobalRandomNumberGenerator(void) { return ( threadGenerator != NULL ? threadGenerator : seedGenerator ); }   //!< Return a pointer to the random number object of the calling thread (the global one unless overridden)
+		RandomNumberGenerator*                      setThreadRandomNumberGenerator(RandomNumberGenerator* r);                              //!< Let the calling thread draw from r (NULL restores the global one); returns the previous one
 
 	private:
                                                     RandomNumberFactory(void);                                                             //!< Default constructor
@@ -39,6 +46,27 @@ namespace RevBayesCore {
                                                    ~RandomNumberFactory(void);                                                             //!< Destructor
 		RandomNumberGenerator*                      seedGenerator;                                                                         //!< A random number object that generates seeds
 		std::set<RandomNumberGenerator*>            allocatedRandomNumbers;                                                                //!< The pool of random number objects
+        static thread_local RandomNumberGenerator*  threadGenerator;                                                                       //!< The random number object overriding the global one on this thread
+    };
+    
+    
+    /**
+     * @brief Scoped override of the random number generator of the calling thread.
+     *
+     * While an object of this class lives, GLOBAL_RNG returns the given generator on the thread
+     * that created the object. The previous generator is restored on destruction, also if an exception is thrown.
+     */
+    class ScopedRandomNumberGenerator {
+        
+    public:
+                                                    ScopedRandomNumberGenerator(RandomNumberGenerator* r) : previous( RandomNumberFactory::randomNumberFactoryInstance().setThreadRandomNumberGenerator( r ) ) {}
+                                                   ~ScopedRandomNumberGenerator(void) { RandomNumberFactory::randomNumberFactoryInstance().setThreadRandomNumberGenerator( previous ); }
+        
+    private:
+                                                    ScopedRandomNumberGenerator(const ScopedRandomNumberGenerator&);                        //!< Not copyable
+        ScopedRandomNumberGenerator&                operator=(const ScopedRandomNumberGenerator&);                                         //!< Not assignable
+        
+        RandomNumberGenerator*                      previous;                                                                              //!< The generator to restore
     };
 }
 
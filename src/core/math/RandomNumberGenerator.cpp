@@ -6,6 +6,7 @@
 #include <boost/random/uniform_01.hpp> // IWYU pragma: keep
 #include <boost/random/linear_congruential.hpp> // IWYU pragma: keep
 #include <boost/random/mersenne_twister.hpp>
+#include <boost/random/seed_seq.hpp>
 
 using namespace RevBayesCore;
 
@@ -24,6 +25,29 @@ RandomNumberGenerator::RandomNumberGenerator(void) :
 }
 
 
+/**
+ * Create n independent random number generators.
+ * We draw a single key from this generator and seed the i-th new generator with stream i of this key.
+ * Thus, the streams are reproducible for a given seed and do not depend on the order in which they are used.
+ *
+ * \param[in]    n    The number of streams.
+ * \return The random number generators.
+ */
+std::vector<RandomNumberGenerator> RandomNumberGenerator::createStreams(size_t n)
+{
+    
+    unsigned int key = (unsigned int)( uniform01() * RbConstants::Integer::max );
+    
+    std::vector<RandomNumberGenerator> streams = std::vector<RandomNumberGenerator>( n );
+    for (size_t i = 0; i < n; ++i)
+    {
+        streams[i].setSeed( key, i );
+    }
+    
+    return streams;
+}
+
+
 /* Get the seed values */
 unsigned int RandomNumberGenerator::getNewSeed( void ) const
 {
@@ -59,6 +83,24 @@ void RandomNumberGenerator::setSeed(unsigned int s)
 }
 
 
+/**
+ * Set the seed of the random number generator to stream s of the given seed.
+ * The whole state of the Mersenne twister is initialized from a seed sequence of the seed and the stream index,
+ * so different streams of the same seed are independent.
+ */
+void RandomNumberGenerator::setSeed(unsigned int s, size_t stream)
+{
+    
+    seed = s % RbConstants::Integer::max;
+    
+    boost::random::seed_seq seq = { boost::uint32_t(seed), boost::uint32_t(stream & 0xFFFFFFFF), boost::uint32_t(stream >> 16 >> 16) };
+    boost::mt19937 rng;
+    rng.seed( seq );
+    zeroone = boost::uniform_01<boost::mt19937>(rng);
+    
+}
+
+
 /*!
  *
  * \brief Uniform[0,1) random variable.
@@ -72,3 +114,26 @@ double RandomNumberGenerator::uniform01(void)
 	// Returns a pseudo-random number between 0 and 1.
     return last_u;
 }
+
+
+/**
+ * Fill an array with uniform[0,1) random variables.
+ * This gives the same values as n calls to uniform01() but avoids the call overhead in hot loops.
+ *
+ * \param[out]   u    The array to fill.
+ * \param[in]    n    The number of random variables.
+ */
+void RandomNumberGenerator::uniform01(double *u, size_t n)
+{
+    
+    for (size_t i = 0; i < n; ++i)
+    {
+        u[i] = zeroone();
+    }
+    
+    if ( n > 0 )
+    {
+        last_u = u[n-1];
+    }
+    
+}
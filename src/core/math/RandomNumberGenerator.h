@@ -4,8 +4,20 @@
 #include <boost/random/uniform_01.hpp>
 #include <boost/random/mersenne_twister.hpp>
 
+#include <cstddef>
+#include <vector>
+
 namespace RevBayesCore {
 
+    /**
+     * @brief Random number generator based on the Mersenne twister.
+     *
+     * Independent computations (MCMCMC chains, Monte Carlo replicates, simulations) should not share
+     * one generator because then their draws depend on the order in which they are executed.
+     * createStreams splits a generator into independent, reproducible streams instead:
+     * stream i is seeded with the full state of a seed sequence built from a key drawn from
+     * this generator and the stream index i.
+     */
     class RandomNumberGenerator {
 
     public:
@@ -13,10 +25,13 @@ namespace RevBayesCore {
                                                     RandomNumberGenerator(void);                            //!< Default constructor using time seed
                                             
         // Regular functions
+        std::vector<RandomNumberGenerator>          createStreams(size_t n);                                //!< Split off n independent generators (draws one key from this generator)
         unsigned int                                getNewSeed(void) const;                                 //!< Get the new seed values
         unsigned int                                getSeed(void) const;                                    //!< Get the seed values
         void                                        setSeed(unsigned int s);                                //!< Set the seeds of the RNG
+        void                                        setSeed(unsigned int s, size_t stream);                 //!< Set the seeds of the RNG to the given stream of seed s
         double                                      uniform01(void);                                        //!< Get a random [0,1) var
+        void                                        uniform01(double *u, size_t n);                         //!< Fill u with n random [0,1) vars
 
     private:
         
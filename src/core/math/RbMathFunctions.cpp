@@ -813,8 +813,8 @@ double RbMath::lnGamma_sign(double x, int *sgn)
     double ans, y, sinpiy;
     
 #ifdef NOMORE_FOR_THREADS
-    static double xmax = 0.;
-    static double dxrel = 0.;
+    static thread_local double xmax = 0.;
+    static thread_local double dxrel = 0.;
     
     if (xmax == 0) {/* initialize machine dependent constants _ONCE_ */
         xmax = d1mach(2)/log(d1mach(2));/* = 2.533 e305	 for IEEE double */
@@ -196,8 +196,8 @@ double RbStatistics::Helper::pointChi2(double prob, double v) {
 int RbStatistics::Helper::poissonInver(double lambda, RandomNumberGenerator& rng) {
     
 	const int bound = 130;
-	static double p_L_last = -1.0;
-	static double p_f0;
+	static thread_local double p_L_last = -1.0;
+	static thread_local double p_f0;
 	int x;
     
 	if (lambda != p_L_last) {
@@ -257,12 +257,12 @@ int RbStatistics::Helper::poissonLow(double lambda, RandomNumberGenerator& rng)
  */
 int RbStatistics::Helper::poissonRatioUniforms(double lambda, RandomNumberGenerator& rng) {
     
-	static double p_L_last = -1.0;  /* previous L */
-	static double p_a;              /* hat center */
-	static double p_h;              /* hat width */
-	static double p_g;              /* ln(L) */
-	static double p_q;              /* value at mode */
-	static int p_bound;             /* upper bound */
+	static thread_local double p_L_last = -1.0;  /* previous L */
+	static thread_local double p_a;              /* hat center */
+	static thread_local double p_h;              /* hat width */
+	static thread_local double p_g;              /* ln(L) */
+	static thread_local double p_q;              /* value at mode */
+	static thread_local int p_bound;             /* upper bound */
 	int mode;                       /* mode */
 	double u;                       /* uniform random */
 	double lf;                      /* ln(f(x)) */
@@ -498,7 +498,7 @@ double RbStatistics::Helper::rndGamma1(double s, RandomNumberGenerator& rng)
 {
     
     double r, x = 0.0, small = 1e-37, w;
-    static double   a, p, uf, ss = 10.0, d;
+    static thread_local double a, p, uf, ss = 10.0, d;
 
     if (s != ss) {
         a  = 1.0 - s;
@@ -543,7 +543,7 @@ double RbStatistics::Helper::rndGamma2(double s, RandomNumberGenerator& rng)
 {
     
     double              r, d, f, g, x;
-    static double       b, h, ss = 0.0;
+    static thread_local double b, h, ss = 0.0;
 
     if (s != ss) {
         b  = s - 1.0;
@@ -601,11 +601,11 @@ double RbStatistics::Helper::rndGamma3(double a, RandomNumberGenerator& rng) {
     const static double a6 = -0.1367177;
     const static double a7 = 0.1233795;
     
-    /* State variables [FIXME for threading!] :*/
-    static double aa = 0.;
-    static double aaa = 0.;
-    static double s, s2, d;    /* no. 1 (step 1) */
-    static double q0, b, si, c;/* no. 2 (step 4) */
+    /* State variables (one copy per thread) :*/
+    static thread_local double aa = 0.;
+    static thread_local double aaa = 0.;
+    static thread_local double s, s2, d;    /* no. 1 (step 1) */
+    static thread_local double q0, b, si, c;/* no. 2 (step 4) */
     
     double e, p, q, r, t, u, v, w, x, ret_val;
     
@@ -197,11 +197,11 @@ double RbStatistics::Beta::rv(double aa, double bb, RandomNumberGenerator& rng)
     double r, s, t, u1, u2, v, w, y, z;
 
     int qsame;
-    /* FIXME:  Keep Globals (properly) for threading */
+    /* These are thread-local, so that concurrent chains do not share them */
     /* Uses these GLOBALS to save time when many rv's are generated : */
-    static double beta, gamma, delta, k1, k2;
-    static double olda = -1.0;
-    static double oldb = -1.0;
+    static thread_local double beta, gamma, delta, k1, k2;
+    static thread_local double olda = -1.0;
+    static thread_local double oldb = -1.0;
 
     if (aa <= 0. || bb <= 0. || (!RbMath::isFinite(aa) && !RbMath::isFinite(bb)))
     {
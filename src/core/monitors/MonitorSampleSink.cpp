@@ -0,0 +1,152 @@
+#include "MonitorSampleSink.h"
+
+#include <stdlib.h>
+
+#include "StringUtilities.h"
+
+using namespace RevBayesCore;
+
+
+/**
+ * Get the process-wide sink.
+ */
+MonitorSampleSink& MonitorSampleSink::monitorSampleSinkInstance( void )
+{
+    static MonitorSampleSink sink;
+
+    return sink;
+}
+
+
+MonitorSampleSink::MonitorSampleSink( void )
+{
+
+}
+
+
+/**
+ * A monitor wrote the column header to the file. The samples written before belong to an earlier table,
+ * so we start a new, empty trace for each column except the first one.
+ */
+void MonitorSampleSink::addHeader(const path &fn, const std::string &line)
+{
+
+    std::vector<std::string> columns;
+    StringUtilities::stringSplit(line, "", columns, true);
+
+    std::vector<TraceNumeric> traces;
+    for (size_t j = 1; j < columns.size(); ++j)
+    {
+        TraceNumeric t;
+        t.setParameterName( columns[j] );
+        t.setFileName( fn );
+        traces.push_back( t );
+    }
+
+    std::lock_guard<std::mutex> lock( sink_mutex );
+
+    std::map<std::string, SampleTable>::iterator it = tables.find( fn.string() );
+    if ( it != tables.end() )
+    {
+        it->second.has_header = true;
+        it->second.complete   = true;
+        it->second.traces.swap( traces );
+    }
+
+}
+
+
+/**
+ * A monitor wrote a row of samples to the file. We parse the row once and append the values to the traces.
+ * If we have not seen the header, or the row does not match it, the table does not reflect the file anymore.
+ */
+void MonitorSampleSink::addSample(const path &fn, const std::string &line)
+{
+
+    std::vector<std::string> columns;
+    StringUtilities::stringSplit(line, "", columns, true);
+
+    std::lock_guard<std::mutex> lock( sink_mutex );
+
+    std::map<std::string, SampleTable>::iterator it = tables.find( fn.string() );
+    if ( it == tables.end() || it->second.complete == false )
+    {
+        return;
+    }
+
+    SampleTable &table = it->second;
+    if ( table.has_header == false || columns.size() != table.traces.size() + 1 )
+    {
+        table.complete = false;
+        table.traces.clear();
+        return;
+    }
+
+    for (size_t j = 1; j < columns.size(); ++j)
+    {
+        table.traces[j-1].addObject( atof( columns[j].c_str() ) );
+    }
+
+}
+
+
+/**
+ * Get the traces of the file. The traces stay valid until a monitor writes a new header to the file,
+ * so they should only be used while no monitor writes to the file, e.g., when the stopping rules are checked.
+ *
+ * \return The traces, or NULL if the sink has not seen every row of the file.
+ */
+std::vector<TraceNumeric>* MonitorSampleSink::getTraces(const path &fn)
+{
+    std::lock_guard<std::mutex> lock( sink_mutex );
+
+    std::map<std::string, SampleTable>::iterator it = tables.find( fn.string() );
+    if ( it == tables.end() || it->second.has_header == false || it->second.complete == false )
+    {
+        return NULL;
+    }
+
+    return &it->second.traces;
+}
+
+
+bool MonitorSampleSink::isSubscribed(const path &fn) const
+{
+    std::lock_guard<std::mutex> lock( sink_mutex );
+
+    return tables.find( fn.string() ) != tables.end();
+}
+
+
+/**
+ * Start collecting the samples of the file. If we already collect the samples, e.g., because another rule
+ * assesses the same file, we keep the samples collected so far.
+ */
+void MonitorSampleSink::subscribe(const path &fn)
+{
+    std::lock_guard<std::mutex> lock( sink_mutex );
+
+    std::map<std::string, SampleTable>::iterator it = tables.find( fn.string() );
+    if ( it == tables.end() )
+    {
+        SampleTable table;
+        table.has_header = false;
+        table.complete   = true;
+        tables.insert( std::make_pair( fn.string(), table ) );
+    }
+
+}
+
+
+/**
+ * Stop collecting the samples of the file and free the traces.
+ * If the analysis is continued later, the monitors append to the file without writing a new header,
+ * so the rules then read the file instead.
+ */
+void MonitorSampleSink::unsubscribe(const path &fn)
+{
+    std::lock_guard<std::mutex> lock( sink_mutex );
+
+    tables.erase( fn.string() );
+
+}
@@ -0,0 +1,62 @@
+#ifndef MonitorSampleSink_H
+#define MonitorSampleSink_H
+
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "RbFileManager.h"
+#include "TraceNumeric.h"
+
+namespace RevBayesCore {
+
+    /**
+     * @brief Process-wide sink that collects the samples written by variable monitors.
+     *
+     * Convergence stopping rules subscribe to the files of the replicates they assess. From then on,
+     * every variable monitor writing to one of these files passes its column header and each sampled row
+     * to the sink, which parses the row once and appends the values to one trace per column (the first column,
+     * the iteration, is skipped as in the TraceContinuousReader). The rules can then assess convergence
+     * on the samples in memory instead of reading and parsing the whole file again at every check.
+     *
+     * A table is only used if the sink has seen the header of the file and every row written after it.
+     * This is not the case, for example, when the monitor appends to a file written by a previous session,
+     * or when the replicate runs in another process. Then the rules fall back to reading the file.
+     *
+     * @copyright Copyright 2009-
+     * @author The RevBayes Development Core Team
+     * @since 2026-10-16, version 1.2.2
+     */
+    class MonitorSampleSink {
+
+    public:
+
+        static MonitorSampleSink&                   monitorSampleSinkInstance(void);                                    //!< Get the process-wide sink
+
+        void                                        addHeader(const path &fn, const std::string &line);                 //!< A monitor wrote the column header, starting a new table
+        void                                        addSample(const path &fn, const std::string &line);                 //!< A monitor wrote a row of samples
+        std::vector<TraceNumeric>*                  getTraces(const path &fn);                                          //!< The traces of the file, or NULL if the samples are not complete
+        bool                                        isSubscribed(const path &fn) const;                                 //!< Does anybody listen to this file?
+        void                                        subscribe(const path &fn);                                          //!< Start collecting the samples written to this file
+        void                                        unsubscribe(const path &fn);                                        //!< Stop collecting the samples written to this file and free them
+
+    private:
+
+        struct SampleTable {
+            bool                                    has_header;
+            bool                                    complete;
+            std::vector<TraceNumeric>               traces;
+        };
+
+                                                    MonitorSampleSink(void);
+                                                    MonitorSampleSink(const MonitorSampleSink &s);                      //!< Prevent copy
+        MonitorSampleSink&                          operator=(const MonitorSampleSink &s);                              //!< Prevent assignment
+
+        std::map<std::string, SampleTable>          tables;
+        mutable std::mutex                          sink_mutex;
+    };
+
+}
+
+#endif
@@ -1,10 +1,12 @@
 #include "VariableMonitor.h"
 
 #include <fstream>
+#include <sstream>
 #include <string>
 
 #include "DagNode.h"
 #include "Model.h"
+#include "MonitorSampleSink.h"
 #include "RbException.h"
 #include "RbFileManager.h"
 #include "RbSettings.h"
@@ -66,6 +68,8 @@ void VariableMonitor::printHeader( void )
             out_stream << "#Build from " + version.getGitBranch() + " (" + version.getGitCommit() + ") on " + version.getDate() + "\n";
         }
 
+        LineCapture capture( *this );
+
         // print one column for the iteration number
         out_stream << "Iteration";
 
@@ -93,6 +97,8 @@ void VariableMonitor::printHeader( void )
         // print the headers for the variables
         printFileHeader();
 
+        capture.finish( true );
+
         out_stream << std::endl;
 
         out_stream.flush();
@@ -116,6 +122,8 @@ void VariableMonitor::monitor(unsigned long gen)
 //        out_stream.open( working_file_name.c_str(), std::fstream::out | std::fstream::app);
         out_stream.seekg(0, std::ios::end);
 
+        LineCapture capture( *this );
+
         // print the iteration number first
         out_stream << gen;
         
@@ -176,6 +184,8 @@ void VariableMonitor::monitor(unsigned long gen)
 
         monitorVariables( gen );
 
+        capture.finish( false );
+
         out_stream << std::endl;
 
         out_stream.flush();
@@ -231,6 +241,68 @@ void VariableMonitor::monitorVariables(unsigned long gen)
 
 }
 
+/**
+ * If a stopping rule collects the samples written to the file of the monitor, we let the next line go into our buffer instead of the file,
+ * so that we can pass it on to the sample sink. The stream keeps its formatting, only the buffer is exchanged.
+ */
+VariableMonitor::LineCapture::LineCapture(VariableMonitor &m) :
+    monitor( m ),
+    file_buffer( NULL )
+{
+
+    if ( MonitorSampleSink::monitorSampleSinkInstance().isSubscribed( monitor.working_file_name ) == true )
+    {
+        file_buffer = static_cast<std::ios&>( monitor.out_stream ).rdbuf( &buffer );
+    }
+
+}
+
+
+/**
+ * Give the buffer of the file back to the stream if the line was not finished.
+ * The incomplete line is neither written to the file nor passed to the sample sink.
+ */
+VariableMonitor::LineCapture::~LineCapture( void )
+{
+
+    if ( file_buffer != NULL )
+    {
+        static_cast<std::ios&>( monitor.out_stream ).rdbuf( file_buffer );
+    }
+
+}
+
+
+/**
+ * Give the buffer of the file back to the stream, write the captured line to the file and pass it to the sample sink.
+ * Nothing happens if the line was not captured.
+ */
+void VariableMonitor::LineCapture::finish(bool header)
+{
+
+    if ( file_buffer == NULL )
+    {
+        return;
+    }
+
+    static_cast<std::ios&>( monitor.out_stream ).rdbuf( file_buffer );
+    file_buffer = NULL;
+
+    std::string line = buffer.str();
+    monitor.out_stream << line;
+
+    MonitorSampleSink &sink = MonitorSampleSink::monitorSampleSinkInstance();
+    if ( header == true )
+    {
+        sink.addHeader( monitor.working_file_name, line );
+    }
+    else
+    {
+        sink.addSample( monitor.working_file_name, line );
+    }
+
+}
+
 /**
  * Combine output for the monitor.
  * Overwrite this method for specialized behavior.
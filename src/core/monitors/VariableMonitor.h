@@ -4,6 +4,7 @@
 #include <stddef.h>
 #include <vector>
 #include <iosfwd>
+#include <sstream>
 
 #include "AbstractFileMonitor.h"
 #include "MonteCarloAnalysisOptions.h"
@@ -35,6 +36,29 @@ class DagNode;
         void                                    setPrintPrior(bool tf);
 
     protected:
+
+        /**
+         * Captures the next line of the monitor if a stopping rule collects the samples written to its file.
+         * While the capture lives, the stream writes into a string buffer instead of the file.
+         * The buffer of the file is restored by finish() or, e.g. if an exception interrupts the line, by the destructor.
+         */
+        class LineCapture {
+
+        public:
+                                                LineCapture(VariableMonitor &m);                                    //!< Start capturing if anybody collects our samples
+                                                ~LineCapture(void);                                                 //!< Restore the buffer of the file
+
+            void                                finish(bool header);                                                //!< Write the captured line to the file and the sample sink
+
+        private:
+                                                LineCapture(const LineCapture &c);                                  //!< Prevent copy
+            LineCapture&                        operator=(const LineCapture &c);                                    //!< Prevent assignment
+
+            VariableMonitor&                    monitor;
+            std::stringbuf                      buffer;                                                             //!< The captured line
+            std::streambuf*                     file_buffer;                                                        //!< The buffer of the file, or NULL if we do not capture
+        };
+
         bool                                    posterior;
         bool                                    prior;
         bool                                    likelihood;
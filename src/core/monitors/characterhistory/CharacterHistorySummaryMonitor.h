@@ -255,7 +255,7 @@ std::string RevBayesCore::CharacterHistorySummaryMonitor<charType>::buildIterati
     ss_suffix << child2_index_ss.str();
     
     // get event list
-    std::multiset<CharacterEvent*,CharacterEventCompare> h = bh.getHistory();
+    CharacterEventList h = bh.getHistory();
     
     // what events to expect?
     bool has_cladogenetic = isCladogenetic( n );
@@ -286,7 +286,7 @@ std::string RevBayesCore::CharacterHistorySummaryMonitor<charType>::buildIterati
         // anagenetic events along branch
         if (has_anagenetic) {
             std::vector<CharacterEvent*> next_states = start_states;
-            std::multiset<CharacterEvent*, CharacterEventCompare>::reverse_iterator it;
+            CharacterEventList::reverse_iterator it;
             for (it = h.rbegin(); it != h.rend(); it++)
             {
                 std::stringstream curr_state_ss;
@@ -202,8 +202,8 @@ std::string RevBayesCore::TreeCharacterHistoryNodeMonitor<charType>::buildCharac
     else if (infoStr=="state_into")
     {
         // loop over events
-        const std::multiset<CharacterEvent*,CharacterEventCompare>& evts = bh.getHistory();
-        std::multiset<CharacterEvent*,CharacterEventCompare>::const_reverse_iterator it;
+        const CharacterEventList& evts = bh.getHistory();
+        CharacterEventList::const_reverse_iterator it;
         
         std::vector<unsigned> v(num_states,0);
         for (it = evts.rbegin(); it != evts.rend(); it++)
@@ -224,8 +224,8 @@ std::string RevBayesCore::TreeCharacterHistoryNodeMonitor<charType>::buildCharac
     else if (infoStr=="state_betw")
     {
         // loop over events
-        const std::multiset<CharacterEvent*,CharacterEventCompare>& evts = bh.getHistory();
-        std::multiset<CharacterEvent*,CharacterEventCompare>::const_reverse_iterator it;
+        const CharacterEventList& evts = bh.getHistory();
+        CharacterEventList::const_reverse_iterator it;
         std::vector<CharacterEvent*> characters = bh.getParentCharacters();
         
         std::vector<unsigned> v(num_states*num_states,0);
@@ -258,8 +258,8 @@ std::string RevBayesCore::TreeCharacterHistoryNodeMonitor<charType>::buildCharac
     }
     else if (infoStr=="events")
     {
-        const std::multiset<CharacterEvent*,CharacterEventCompare>& evts = bh.getHistory();
-        std::multiset<CharacterEvent*,CharacterEventCompare>::const_reverse_iterator it;
+        const CharacterEventList& evts = bh.getHistory();
+        CharacterEventList::const_reverse_iterator it;
         std::vector<CharacterEvent*> characters = bh.getParentCharacters();
         
         std::vector<unsigned> v(num_states*num_states,0);
@@ -395,8 +395,8 @@ std::string RevBayesCore::TreeCharacterHistoryNodeMonitor<charType>::buildNumEve
     TreeHistoryCtmc<charType>* p = static_cast< TreeHistoryCtmc<charType>* >(&variable->getDistribution());
     BranchHistory* bh = &p->getHistory(*nd);
 
-    const std::multiset<CharacterEvent*,CharacterEventCompare>& evts = bh->getHistory();
-    std::multiset<CharacterEvent*,CharacterEventCompare>::const_reverse_iterator it;
+    const CharacterEventList& evts = bh->getHistory();
+    CharacterEventList::const_reverse_iterator it;
 
     std::stringstream ss;
 
@@ -426,8 +426,8 @@ std::string RevBayesCore::TreeCharacterHistoryNodeMonitor<charType>::buildNumEve
     {
         BranchHistory* bh = &p->getHistory(*nds[i]);
 
-        const std::multiset<CharacterEvent*,CharacterEventCompare>& evts = bh->getHistory();
-        std::multiset<CharacterEvent*,CharacterEventCompare>::const_reverse_iterator it;
+        const CharacterEventList& evts = bh->getHistory();
+        CharacterEventList::const_reverse_iterator it;
 
 
         for (it = evts.rbegin(); it != evts.rend(); it++)
@@ -23,6 +23,7 @@ AbstractMove::AbstractMove( double weight, bool tuning ) :
     affected_nodes(  ),
     weight( weight ),
     auto_tuning( tuning ),
+    delayed_acceptance( false ),
     num_tried_current_period( 0 ),
     num_tried_total( 0 )
 {
@@ -44,6 +45,7 @@ AbstractMove::AbstractMove( const std::vector<DagNode*> &nodes, double weight, b
     affected_nodes( ),
     weight( weight ),
     auto_tuning( tuning ),
+    delayed_acceptance( false ),
     num_tried_current_period( 0 ),
     num_tried_total( 0 )
 {
@@ -89,6 +91,7 @@ AbstractMove::AbstractMove( const AbstractMove &move ) : Move( move ),
     affected_nodes( move.affected_nodes ),
     weight( move.weight ),
     auto_tuning( move.auto_tuning  ),
+    delayed_acceptance( move.delayed_acceptance ),
     num_tried_current_period( move.num_tried_current_period ),
     num_tried_total( move.num_tried_total )
 {
@@ -165,6 +168,7 @@ AbstractMove& AbstractMove::operator=(const RevBayesCore::AbstractMove &move)
         }
         
         affected_nodes              = move.affected_nodes;
+        delayed_acceptance          = move.delayed_acceptance;
         nodes                       = move.nodes;
         num_tried_current_period    = move.num_tried_current_period;
         num_tried_total             = move.num_tried_total;
@@ -528,6 +532,17 @@ void AbstractMove::setNumberAcceptedTotal( size_t na )
 }
 
 
+/**
+ * Set whether the move should use delayed acceptance,
+ * i.e., accept or reject on the prior first and compute the likelihoods only if the proposal passes.
+ * Only Metropolis-Hastings moves make use of this flag.
+ */
+void AbstractMove::setDelayedAcceptance( bool tf )
+{
+    delayed_acceptance = tf;
+}
+
+
 void AbstractMove::setNumberTriedCurrentPeriod( size_t nt )
 {
     num_tried_current_period = nt;
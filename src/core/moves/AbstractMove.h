@@ -51,6 +51,7 @@ namespace RevBayesCore {
         void                                                    performHillClimbingStep(double lHeat, double pHeat);                //!< Perform the move.
         void                                                    removeNode(DagNode* p);                                             //!< remove a node from the proposal
         void                                                    resetCounters(void);                                                //!< Reset the counters such as numTried.
+        void                                                    setDelayedAcceptance(bool tf);                                      //!< Should the move screen proposals with the prior before computing the likelihoods?
         virtual void                                            setNumberAcceptedCurrentPeriod(size_t na);
         virtual void                                            setNumberAcceptedTotal(size_t na);
         void                                                    setNumberTriedCurrentPeriod(size_t nt);
@@ -78,6 +79,7 @@ namespace RevBayesCore {
         RbOrderedSet<DagNode*>                                  affected_nodes;                                                     //!< The affected nodes by this move.
         double                                                  weight;
         bool                                                    auto_tuning;
+        bool                                                    delayed_acceptance;                                                 //!< Do we accept in two stages, first on the prior and then on the likelihood?
         size_t                                                  num_tried_current_period;                                           //!< Number of times tried
         size_t                                                  num_tried_total;                                                    //!< Number of times tried
 
@@ -1,10 +1,15 @@
 #include <stddef.h>
+#include <algorithm>
 #include <cmath>
 #include <iomanip>
 #include <iostream>
+#include <functional>
+#include <map>
+#include <set>
 #include <vector>
 
 #include "DagNode.h"
+#include "Distribution.h"
 #include "MetropolisHastingsMove.h"
 #include "Proposal.h"
 #include "RandomNumberFactory.h"
@@ -14,10 +19,98 @@
 #include "AbstractMove.h"
 #include "RbOrderedSet.h"
 #include "RbException.h"
+#include "LikelihoodScheduler.h"
+#include "ThreadPool.h"
 
 using namespace RevBayesCore;
 
 
+namespace {
+
+    /*
+     * Compute the probability ratio of a node. Math errors count as a ratio of zero.
+     */
+    double computeLnProbabilityRatio( DagNode *the_node )
+    {
+        try
+        {
+            return the_node->getLnProbabilityRatio();
+        }
+        catch (const RbException &e)
+        {
+            if ( e.getExceptionType() != RbException::MATH_ERROR )
+            {
+                throw e;
+            }
+        }
+
+        return RbConstants::Double::neginf;
+    }
+
+
+    /*
+     * Does this deterministic node (transitively through other deterministic nodes) depend on one of the moved nodes?
+     */
+    bool dependsOnMovedNodes( const DagNode *the_node, const std::set<const DagNode*> &moved, std::map<const DagNode*, bool> &depends )
+    {
+        std::map<const DagNode*, bool>::const_iterator it = depends.find( the_node );
+        if ( it != depends.end() )
+        {
+            return it->second;
+        }
+
+        bool d = false;
+        std::vector<const DagNode*> parents = the_node->getParents();
+        for (size_t i = 0; i < parents.size() && d == false; ++i)
+        {
+            const DagNode *p = parents[i];
+            if ( moved.find( p ) != moved.end() )
+            {
+                d = true;
+            }
+            else if ( p->isStochastic() == false && p->isConstant() == false )
+            {
+                d = dependsOnMovedNodes( p, moved, depends );
+            }
+        }
+
+        depends[the_node] = d;
+        return d;
+    }
+
+
+    /*
+     * Collect the deterministic ancestors of this node that are updated when we compute its probability,
+     * i.e., those that depend on the moved nodes and those that update on every access (e.g., Rev member functions).
+     * The ancestors at which we stop are only read, and we remember them so that we can check later that they are still clean.
+     */
+    void collectUpdatedAncestors( const DagNode *the_node, const std::set<const DagNode*> &moved, std::map<const DagNode*, bool> &depends, std::set<const DagNode*> &updated, std::set<const DagNode*> &read )
+    {
+        std::vector<const DagNode*> parents = the_node->getParents();
+        for (size_t i = 0; i < parents.size(); ++i)
+        {
+            const DagNode *p = parents[i];
+            if ( p->isStochastic() == true || p->isConstant() == true || updated.find( p ) != updated.end() )
+            {
+                continue;
+            }
+            
+            if ( p->isUpdatedOnAccess() == true || dependsOnMovedNodes( p, moved, depends ) == true )
+            {
+                // updating this node reads all its parents
+                updated.insert( p );
+                collectUpdatedAncestors( p, moved, depends, updated, read );
+            }
+            else
+            {
+                read.insert( p );
+            }
+        }
+    }
+
+}
+
+
 /** 
  * Constructor
  *
@@ -29,7 +122,8 @@ using namespace RevBayesCore;
 MetropolisHastingsMove::MetropolisHastingsMove( Proposal *p, double w, bool t ) : AbstractMove(p->getNodes(), w, t),
     num_accepted_current_period( 0 ),
     num_accepted_total( 0 ),
-    proposal( p )
+    proposal( p ),
+    affected_node_groups_valid( false )
 {
     
     proposal->setMove( this );
@@ -47,7 +141,8 @@ MetropolisHastingsMove::MetropolisHastingsMove( Proposal *p, double w, bool t )
 MetropolisHastingsMove::MetropolisHastingsMove(const MetropolisHastingsMove &m) : AbstractMove(m),
     num_accepted_current_period( m.num_accepted_current_period ),
     num_accepted_total( m.num_accepted_total ),
-    proposal( m.proposal->clone() )
+    proposal( m.proposal->clone() ),
+    affected_node_groups_valid( false )
 {
     
     proposal->setMove( this );
@@ -55,6 +150,146 @@ MetropolisHastingsMove::MetropolisHastingsMove(const MetropolisHastingsMove &m)
 }
 
 
+/**
+ * Add the probability ratios of the affected nodes to the prior and likelihood ratios.
+ * As soon as one of the ratios is not a computable number, we stop adding.
+ * If there are several independent groups of affected nodes and several threads, the ratios are
+ * computed concurrently, but they are still added in the order of the affected nodes.
+ *
+ * \param[in,out]    ln_prior_ratio          The prior ratio.
+ * \param[in,out]    ln_likelihood_ratio     The likelihood ratio.
+ * \param[in]        add_prior               Add the ratios of the unclamped nodes?
+ * \param[in]        add_likelihood          Add the ratios of the clamped nodes?
+ */
+void MetropolisHastingsMove::addAffectedLnProbabilityRatios(double &ln_prior_ratio, double &ln_likelihood_ratio, bool add_prior, bool add_likelihood)
+{
+    const RbOrderedSet<DagNode*> &affected_nodes = getAffectedNodes();
+    
+    bool concurrent = false;
+    if ( affected_nodes.size() > 1 && ThreadPool::threadPoolInstance().getNumberOfThreads() > 1 )
+    {
+        updateIndependentAffectedNodes();
+        concurrent = ( affected_node_groups.size() > 1 );
+    }
+    
+    if ( concurrent == false )
+    {
+        for (RbOrderedSet<DagNode*>::const_iterator it = affected_nodes.begin(); it != affected_nodes.end(); ++it)
+        {
+            DagNode *the_node = *it;
+            
+            if ( RbMath::isAComputableNumber(ln_prior_ratio) && RbMath::isAComputableNumber(ln_likelihood_ratio) )
+            {
+                if ( the_node->isClamped() )
+                {
+                    if ( add_likelihood == true )
+                    {
+                        ln_likelihood_ratio += computeLnProbabilityRatio( the_node );
+                    }
+                }
+                else if ( add_prior == true )
+                {
+                    ln_prior_ratio += computeLnProbabilityRatio( the_node );
+                }
+            }
+        }
+        
+        return;
+    }
+    
+    if ( RbMath::isAComputableNumber(ln_prior_ratio) == false || RbMath::isAComputableNumber(ln_likelihood_ratio) == false )
+    {
+        return;
+    }
+    
+    // compute the ratios of each group on its own thread
+    // the likelihood scheduler starts the groups with the most expensive likelihoods first
+    const std::vector< std::vector<size_t> > &groups = affected_node_groups;
+    std::vector<double> ln_ratios( affected_nodes.size(), 0.0 );
+    std::vector<double> costs( groups.size(), 0.0 );
+    std::vector< std::function<void(void)> > tasks;
+    for (size_t i = 0; i < groups.size(); ++i)
+    {
+        const std::vector<size_t>& group = groups[i];
+        for (size_t j = 0; j < group.size(); ++j)
+        {
+            const DagNode *the_node = affected_nodes[ group[j] ];
+            if ( the_node->isStochastic() == true )
+            {
+                costs[i] += the_node->getDistribution().getComputationCost();
+            }
+        }
+        tasks.push_back( [&affected_nodes, &ln_ratios, &group, add_prior, add_likelihood]()
+        {
+            for (size_t j = 0; j < group.size(); ++j)
+            {
+                DagNode *the_node = affected_nodes[ group[j] ];
+                if ( the_node->isClamped() ? add_likelihood : add_prior )
+                {
+                    ln_ratios[ group[j] ] = computeLnProbabilityRatio( the_node );
+                }
+            }
+        });
+    }
+    LikelihoodScheduler::likelihoodSchedulerInstance().run( tasks, costs );
+    
+    // add the ratios in the original order
+    size_t index = 0;
+    for (RbOrderedSet<DagNode*>::const_iterator it = affected_nodes.begin(); it != affected_nodes.end(); ++it, ++index)
+    {
+        if ( RbMath::isAComputableNumber(ln_prior_ratio) && RbMath::isAComputableNumber(ln_likelihood_ratio) )
+        {
+            if ( (*it)->isClamped() )
+            {
+                ln_likelihood_ratio += ln_ratios[index];
+            }
+            else
+            {
+                ln_prior_ratio += ln_ratios[index];
+            }
+        }
+    }
+    
+}
+
+
+/**
+ * Add the probability ratios of the touched nodes to the prior and likelihood ratios.
+ * As soon as one of the ratios is not a computable number, we stop adding.
+ *
+ * \param[in]        touched_nodes           The nodes touched by the proposal.
+ * \param[in,out]    ln_prior_ratio          The prior ratio.
+ * \param[in,out]    ln_likelihood_ratio     The likelihood ratio.
+ * \param[in]        add_prior               Add the ratios of the unclamped nodes?
+ * \param[in]        add_likelihood          Add the ratios of the clamped nodes?
+ */
+void MetropolisHastingsMove::addTouchedLnProbabilityRatios(const std::vector<DagNode*> &touched_nodes, double &ln_prior_ratio, double &ln_likelihood_ratio, bool add_prior, bool add_likelihood)
+{
+    
+    for (size_t i = 0; i < touched_nodes.size(); ++i)
+    {
+        // get the pointer to the current node
+        DagNode* the_node = touched_nodes[i];
+        
+        if ( RbMath::isAComputableNumber(ln_prior_ratio) && RbMath::isAComputableNumber(ln_likelihood_ratio) )
+        {
+            if ( the_node->isClamped() )
+            {
+                if ( add_likelihood == true )
+                {
+                    ln_likelihood_ratio += computeLnProbabilityRatio( the_node );
+                }
+            }
+            else if ( add_prior == true )
+            {
+                ln_prior_ratio += computeLnProbabilityRatio( the_node );
+            }
+        }
+    }
+    
+}
+
+
 /**
  * Basic destructor doing nothing.
  */
@@ -83,6 +318,7 @@ MetropolisHastingsMove& MetropolisHastingsMove::operator=(const RevBayesCore::Me
         num_accepted_current_period     = m.num_accepted_current_period;
         num_accepted_total              = m.num_accepted_total;
         proposal                        = m.proposal->clone();
+        affected_node_groups_valid      = false;
         
         proposal->setMove( this );
         
@@ -155,6 +391,124 @@ Proposal& MetropolisHastingsMove::getProposal( void )
 }
 
 
+/**
+ * Partition the affected nodes into groups that can be computed concurrently.
+ * Two affected nodes end up in the same group if they share a deterministic ancestor that is updated when it is read,
+ * i.e., one that depends on the moved nodes or that updates on every access, because whichever node asks first would update it.
+ * All other deterministic ancestors are clean and only read. We remember them, and if one of them needs an update later
+ * (e.g., because some other move left it dirty), we partition the nodes again.
+ * The values of the stochastic ancestors do not change while we compute the ratios, so they can be read concurrently.
+ * If a node that is updated cannot run at the same time as other code (e.g., user-defined functions that use the
+ * Rev workspace), we use a single group.
+ *
+ * The groups are computed once and reused for all proposals of this move until the affected nodes change.
+ */
+void MetropolisHastingsMove::updateIndependentAffectedNodes( void )
+{
+    const RbOrderedSet<DagNode*> &affected_nodes = getAffectedNodes();
+    
+    if ( affected_node_groups_valid == true && affected_node_groups_nodes.size() == affected_nodes.size() )
+    {
+        // check that the affected nodes are still the same
+        bool valid = true;
+        size_t index = 0;
+        for (RbOrderedSet<DagNode*>::const_iterator it = affected_nodes.begin(); it != affected_nodes.end() && valid == true; ++it, ++index)
+        {
+            valid = ( affected_node_groups_nodes[index] == *it );
+        }
+        
+        // check that the shared ancestors are still clean
+        for (size_t i = 0; i < affected_node_groups_read_nodes.size() && valid == true; ++i)
+        {
+            valid = ( affected_node_groups_read_nodes[i]->isUpdatedOnAccess() == false );
+        }
+        
+        if ( valid == true )
+        {
+            return;
+        }
+    }
+    
+    const std::vector<DagNode*>& nodes = getDagNodes();
+    
+    std::set<const DagNode*> moved( nodes.begin(), nodes.end() );
+    std::map<const DagNode*, bool> depends;
+    std::set<const DagNode*> read;
+    
+    affected_node_groups.clear();
+    affected_node_groups_nodes.assign( affected_nodes.begin(), affected_nodes.end() );
+    affected_node_groups_read_nodes.clear();
+    affected_node_groups_valid = true;
+    
+    // the group of each affected node as a union-find forest
+    std::vector<size_t> group_of( affected_nodes.size() );
+    std::map<const DagNode*, size_t> owner;
+    
+    std::function<size_t(size_t)> find_group = [&group_of, &find_group](size_t i) -> size_t
+    {
+        if ( group_of[i] != i )
+        {
+            group_of[i] = find_group( group_of[i] );
+        }
+        return group_of[i];
+    };
+    
+    for (size_t i = 0; i < affected_nodes.size(); ++i)
+    {
+        group_of[i] = i;
+        
+        const DagNode *the_node = affected_nodes[i];
+        if ( the_node->isThreadSafe() == false )
+        {
+            affected_node_groups = std::vector< std::vector<size_t> >( 1 );
+            return;
+        }
+        
+        std::set<const DagNode*> updated;
+        collectUpdatedAncestors( the_node, moved, depends, updated, read );
+        
+        for (std::set<const DagNode*>::const_iterator it = updated.begin(); it != updated.end(); ++it)
+        {
+            if ( (*it)->isThreadSafe() == false )
+            {
+                affected_node_groups = std::vector< std::vector<size_t> >( 1 );
+                return;
+            }
+            
+            std::map<const DagNode*, size_t>::iterator o = owner.find( *it );
+            if ( o == owner.end() )
+            {
+                owner[*it] = i;
+            }
+            else
+            {
+                group_of[ find_group(i) ] = find_group( o->second );
+            }
+        }
+    }
+    
+    affected_node_groups_read_nodes.assign( read.begin(), read.end() );
+    
+    // collect the groups in the order of their first member
+    std::map<size_t, size_t> group_index;
+    for (size_t i = 0; i < affected_nodes.size(); ++i)
+    {
+        size_t root = find_group( i );
+        std::map<size_t, size_t>::iterator it = group_index.find( root );
+        if ( it == group_index.end() )
+        {
+            group_index[root] = affected_node_groups.size();
+            affected_node_groups.push_back( std::vector<size_t>( 1, i ) );
+        }
+        else
+        {
+            affected_node_groups[it->second].push_back( i );
+        }
+    }
+    
+}
+
+
 void MetropolisHastingsMove::performHillClimbingMove( double lHeat, double pHeat )
 {
 
@@ -369,93 +723,42 @@ void MetropolisHastingsMove::performMcmcMove( double prHeat, double lHeat, doubl
     
     double ln_prior_ratio = 0.0;
     double ln_likelihood_ratio = 0.0;
+    bool rejected_first_stage = false;
 
-    
-    // compute the probability of the current value for each node
-    for (size_t i = 0; i < touched_nodes.size(); ++i)
+    if ( delayed_acceptance == true )
     {
-        // get the pointer to the current node
-        DagNode* the_node = touched_nodes[i];
-        
-        if ( RbMath::isAComputableNumber(ln_prior_ratio) && RbMath::isAComputableNumber(ln_likelihood_ratio) && RbMath::isAComputableNumber(ln_hastings_ratio) )
+        // first stage: accept or reject on the prior and the Hastings ratio alone
+        if ( RbMath::isAComputableNumber(ln_hastings_ratio) )
         {
-
-            if ( the_node->isClamped() )
-            {
-                try {
-                    ln_likelihood_ratio += the_node->getLnProbabilityRatio();
-                }
-                catch (const RbException &e)
-                {
-                    ln_likelihood_ratio = RbConstants::Double::neginf;
-
-                    if ( e.getExceptionType() != RbException::MATH_ERROR )
-                    {
-                        throw e;
-                    }
-                }
-            }
-            else
-            {
-                try
-                {
-                    ln_prior_ratio += the_node->getLnProbabilityRatio();
-                }
-                catch (const RbException &e)
-                {
-                    ln_prior_ratio = RbConstants::Double::neginf;
-
-                    if ( e.getExceptionType() != RbException::MATH_ERROR )
-                    {
-                        throw e;
-                    }
-                }
-            }
-            
+            addTouchedLnProbabilityRatios( touched_nodes, ln_prior_ratio, ln_likelihood_ratio, true, false );
+            addAffectedLnProbabilityRatios( ln_prior_ratio, ln_likelihood_ratio, true, false );
         }
         
+        double ln_first_stage_ratio = pHeat * prHeat * ln_prior_ratio + ln_hastings_ratio;
+        if ( RbMath::isAComputableNumber(ln_first_stage_ratio) == false || ( ln_first_stage_ratio < 0.0 && GLOBAL_RNG->uniform01() >= exp(ln_first_stage_ratio) ) )
+        {
+            rejected_first_stage = true;
+        }
+        else
+        {
+            // second stage: only now we compute the likelihoods
+            addTouchedLnProbabilityRatios( touched_nodes, ln_prior_ratio, ln_likelihood_ratio, false, true );
+            addAffectedLnProbabilityRatios( ln_prior_ratio, ln_likelihood_ratio, false, true );
+        }
     }
-    
-    // then we recompute the probability for all the affected nodes
-    for (RbOrderedSet<DagNode*>::const_iterator it = affected_nodes.begin(); it != affected_nodes.end(); ++it)
+    else
     {
-        DagNode *the_node = *it;
-
-        if ( RbMath::isAComputableNumber(ln_prior_ratio) && RbMath::isAComputableNumber(ln_likelihood_ratio) && RbMath::isAComputableNumber(ln_hastings_ratio) )
+        // compute the probability of the current value for each node
+        if ( RbMath::isAComputableNumber(ln_hastings_ratio) )
         {
-            if ( the_node->isClamped() )
-            {
-                try
-                {
-                    ln_likelihood_ratio += the_node->getLnProbabilityRatio();
-                }
-                catch (const RbException &e)
-                {
-                    ln_likelihood_ratio = RbConstants::Double::neginf;
-
-                    if ( e.getExceptionType() != RbException::MATH_ERROR )
-                    {
-                        throw e;
-                    }
-                }
-            }
-            else
-            {
-                try {
-                    ln_prior_ratio += the_node->getLnProbabilityRatio();
-                }
-                catch (const RbException &e)
-                {
-                    ln_prior_ratio = RbConstants::Double::neginf;
-
-                    if ( e.getExceptionType() != RbException::MATH_ERROR )
-                    {
-                        throw e;
-                    }
-                }
-            }
+            addTouchedLnProbabilityRatios( touched_nodes, ln_prior_ratio, ln_likelihood_ratio, true, true );
+        }
+    
+        // then we recompute the probability for all the affected nodes
+        if ( RbMath::isAComputableNumber(ln_hastings_ratio) )
+        {
+            addAffectedLnProbabilityRatios( ln_prior_ratio, ln_likelihood_ratio, true, true );
         }
-
     }
     
     // exponentiate with the chain heat
@@ -464,7 +767,7 @@ void MetropolisHastingsMove::performMcmcMove( double prHeat, double lHeat, doubl
 	
     bool rejected = false;
     
-	if ( RbMath::isAComputableNumber(ln_posterior_ratio) == false )
+	if ( RbMath::isAComputableNumber(ln_posterior_ratio) == false || rejected_first_stage == true )
     {
         rejected = true;
         
@@ -483,6 +786,12 @@ void MetropolisHastingsMove::performMcmcMove( double prHeat, double lHeat, doubl
     
         // finally add the Hastings ratio
         double ln_acceptance_ratio = ln_posterior_ratio + ln_hastings_ratio;
+        
+        // with delayed acceptance the prior and the Hastings ratio were already accepted in the first stage
+        if ( delayed_acceptance == true )
+        {
+            ln_acceptance_ratio = pHeat * lHeat * ln_likelihood_ratio;
+        }
 
         if (ln_acceptance_ratio >= 0.0)
         {
@@ -748,6 +1057,9 @@ void MetropolisHastingsMove::swapNodeInternal(DagNode *oldN, DagNode *newN)
     
     proposal->swapNode(oldN, newN);
     
+    // the affected nodes have changed
+    affected_node_groups_valid = false;
+    
 }
 
 
@@ -17,6 +17,19 @@ namespace RevBayesCore {
      * Here the perform methods actually does the accept/reject step.
      * All specifics are implemented in the derived classes.
      *
+     * If several threads are available, the probability ratios of the affected nodes
+     * (e.g., the likelihoods of many loci that depend on the same tree or clock rate)
+     * are computed concurrently. The affected nodes are partitioned into groups that share
+     * no deterministic node which is updated when it is read, each group is computed on one thread,
+     * and the ratios are added up in the original order, so the result does not depend on the number of threads.
+     * The partition is computed once per move and recomputed when the affected nodes change.
+     *
+     * With delayed acceptance, the move is accepted in two stages (Christen and Fox 2005).
+     * The first stage accepts or rejects on the prior ratio and the Hastings ratio alone, and only
+     * if the proposal passes we compute the likelihoods (clamped nodes) and accept or reject on the likelihood ratio.
+     * The acceptance probability is the product of the two stages, which keeps the posterior as the stationary distribution.
+     * Proposals that the prior rejects never pay for a likelihood computation, at the cost of a somewhat lower acceptance rate.
+     *
      * @copyright Copyright 2009-
      * @author The RevBayes Development Core Team (Sebastian Hoehna)
      * @since 2014-03-26, version 1.0
@@ -55,10 +68,20 @@ namespace RevBayesCore {
         
     private:
         
+        void                                                    addAffectedLnProbabilityRatios(double &ln_prior_ratio, double &ln_likelihood_ratio, bool add_prior, bool add_likelihood);   //!< Add the probability ratios of the affected nodes, possibly computed concurrently
+        void                                                    addTouchedLnProbabilityRatios(const std::vector<DagNode*> &touched_nodes, double &ln_prior_ratio, double &ln_likelihood_ratio, bool add_prior, bool add_likelihood);   //!< Add the probability ratios of the touched nodes
+        void                                                    updateIndependentAffectedNodes(void);                   //!< Partition the affected nodes into groups that do not share any state that needs an update (if the partition is out of date)
+        
         // parameters
         unsigned int                                            num_accepted_current_period;                            //!< Number of times accepted
         unsigned int                                            num_accepted_total;                                     //!< Number of times accepted
         Proposal*                                               proposal;                                               //!< The proposal distribution
+        
+        // the groups of affected nodes that can be computed concurrently
+        std::vector< std::vector<size_t> >                      affected_node_groups;                                   //!< The groups as indices into the affected nodes
+        std::vector<const DagNode*>                             affected_node_groups_nodes;                             //!< The affected nodes when we computed the groups
+        std::vector<const DagNode*>                             affected_node_groups_read_nodes;                        //!< The deterministic ancestors that must stay clean so that the groups are valid
+        bool                                                    affected_node_groups_valid;                             //!< Are the groups up to date?
     };
     
 }
@@ -49,6 +49,7 @@ template <class valueType> class RbOrderedSet;
         virtual void                                            printSummary(std::ostream &o, bool current_period) const = 0;                    //!< Print the move summary
         virtual void                                            removeNode(DagNode* p) = 0;                                 //!< remove a node from the proposal
         virtual void                                            resetCounters(void) = 0;                                    //!< Reset the counters such as numTried and numAccepted.
+        virtual void                                            setDelayedAcceptance(bool tf) = 0;                          //!< Should the move screen proposals with the prior before computing the likelihoods?
         virtual void                                            setMoveTuningParameter(double tp) = 0;
         virtual void                                            setNumberAcceptedCurrentPeriod(size_t na) = 0;
         virtual void                                            setNumberAcceptedTotal(size_t na) = 0;
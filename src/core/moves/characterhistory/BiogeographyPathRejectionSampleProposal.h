@@ -116,8 +116,8 @@
 ////        return 0.0;
 ////    }
 ////    
-////    const std::multiset<CharacterEvent*,CharacterEventCompare>& history = bh.getHistory();
-////    std::multiset<CharacterEvent*,CharacterEventCompare>::iterator it_h;
+////    const CharacterEventList& history = bh.getHistory();
+////    CharacterEventList::iterator it_h;
 ////    
 ////    
 ////    double branchLength = nd.getBranchLength();
@@ -315,8 +315,8 @@
 //    if (nd.isRoot() && !useTail)
 //        return 0.0;
 //  
-//    const std::multiset<CharacterEvent*,CharacterEventCompare>& history = bh.getHistory();
-//    std::multiset<CharacterEvent*,CharacterEventCompare>::iterator it_h;
+//    const CharacterEventList& history = bh.getHistory();
+//    CharacterEventList::iterator it_h;
 //    
 //    
 //    double branchLength = nd.getBranchLength();
@@ -606,8 +606,8 @@
 ////    
 ////    
 ////    // store history for events in siteIndexSet
-////    const std::multiset<CharacterEvent*,CharacterEventCompare>& history = bh->getHistory();
-////    std::multiset<CharacterEvent*,CharacterEventCompare>::iterator it_h;
+////    const CharacterEventList& history = bh->getHistory();
+////    CharacterEventList::iterator it_h;
 ////    for (it_h = history.begin(); it_h != history.end(); it_h++)
 ////    {
 ////        if (this->siteIndexSet.find( (*it_h)->getSiteIndex() ) != this->siteIndexSet.end())
@@ -774,8 +774,8 @@
 //    
 //    
 //    // store history for events in siteIndexSet
-//    const std::multiset<CharacterEvent*,CharacterEventCompare>& history = bh->getHistory();
-//    std::multiset<CharacterEvent*,CharacterEventCompare>::iterator it_h;
+//    const CharacterEventList& history = bh->getHistory();
+//    CharacterEventList::iterator it_h;
 //    for (it_h = history.begin(); it_h != history.end(); it_h++)
 //    {
 //        if (this->siteIndexSet.find( (*it_h)->getCharacterIndex() ) != this->siteIndexSet.end())
@@ -82,7 +82,7 @@ namespace RevBayesCore {
         const TypedDagNode<RateGenerator>*                          q_map_site;
         const TypedDagNode<RateGeneratorSequence>*                  q_map_sequence;
 
-        std::multiset<CharacterEvent*,CharacterEventCompare>        storedHistory;
+        CharacterEventList        storedHistory;
 
         const TopologyNode*                                         node;
 
@@ -151,7 +151,7 @@ void RevBayesCore::PathRejectionSampleProposal<charType>::cleanProposal( void )
 //    }
     
     // delete old events
-    std::multiset<CharacterEvent*,CharacterEventCompare>::reverse_iterator it_h;
+    CharacterEventList::reverse_iterator it_h;
     std::vector<CharacterEvent*> events;
     for (it_h = storedHistory.rbegin(); it_h != storedHistory.rend(); ++it_h)
     {
@@ -208,8 +208,8 @@ double RevBayesCore::PathRejectionSampleProposal<charType>::computeLnProposal(co
     double lnP = 0.0;
     
     std::vector<CharacterEvent*> currState = bh.getParentCharacters();
-    const std::multiset<CharacterEvent*,CharacterEventCompare>& history = bh.getHistory();
-    std::multiset<CharacterEvent*,CharacterEventCompare>::reverse_iterator it_h;
+    const CharacterEventList& history = bh.getHistory();
+    CharacterEventList::const_reverse_iterator it_h;
 
     std::vector<size_t> counts(numStates,0);
     fillStateCounts(currState, counts);
@@ -316,7 +316,7 @@ double RevBayesCore::PathRejectionSampleProposal<charType>::doProposal( void )
     BranchHistory* bh = &p->getHistory(*node);
     std::vector<CharacterEvent*> parent_states = bh->getParentCharacters();
     std::vector<CharacterEvent*> child_states  = bh->getChildCharacters();
-    std::multiset<CharacterEvent*,CharacterEventCompare> proposed_histories;
+    CharacterEventList proposed_histories;
     
     // update histories for sites in sampledCharacters
     std::set<size_t>::iterator it_s;
@@ -484,7 +484,7 @@ void RevBayesCore::PathRejectionSampleProposal<charType>::prepareProposal( void
 
 
     BranchHistory* bh = &p->getHistory(*node);
-    const std::multiset<CharacterEvent*,CharacterEventCompare>& history = bh->getHistory();
+    const CharacterEventList& history = bh->getHistory();
     storedHistory = history;
 
     // determine sampled characters
@@ -640,8 +640,8 @@ void RevBayesCore::PathRejectionSampleProposal<charType>::undoProposal( void )
     BranchHistory* bh = &p->getHistory(*node);
     //    bh->print();
     
-    std::multiset<CharacterEvent*,CharacterEventCompare> proposed_history = bh->getHistory();
-    std::multiset<CharacterEvent*,CharacterEventCompare>::reverse_iterator it_h;
+    CharacterEventList proposed_history = bh->getHistory();
+    CharacterEventList::reverse_iterator it_h;
     std::vector<CharacterEvent*> events;
     for (it_h = proposed_history.rbegin(); it_h != proposed_history.rend(); ++it_h)
     {
@@ -76,8 +76,8 @@
 ////        const TypedDagNode<RateGeneratorSequence>*    q_map_sequence;
 ////        
 ////        //BranchHistory*                          storedValue;
-////        std::multiset<CharacterEvent*,CharacterEventCompare> storedHistory;
-////        std::multiset<CharacterEvent*,CharacterEventCompare> proposedHistory;
+////        CharacterEventList storedHistory;
+////        CharacterEventList proposedHistory;
 ////        
 ////        TopologyNode*                           node;
 ////        std::set<size_t>                        siteIndexSet;
@@ -141,7 +141,7 @@
 //////    BranchHistory* bh = &p.getHistory(*node);
 ////    
 ////    // delete old events
-////    std::multiset<CharacterEvent*,CharacterEventCompare>::iterator it_h;
+////    CharacterEventList::iterator it_h;
 ////    for (it_h = storedHistory.begin(); it_h != storedHistory.end(); it_h++)
 ////    {
 ////        delete *it_h;
@@ -186,8 +186,8 @@
 ////        return 0.0;
 //// 
 ////    std::vector<CharacterEvent*> currState = bh.getParentCharacters();
-////    const std::multiset<CharacterEvent*,CharacterEventCompare>& history = bh.getHistory();
-////    std::multiset<CharacterEvent*,CharacterEventCompare>::iterator it_h;
+////    const CharacterEventList& history = bh.getHistory();
+////    CharacterEventList::iterator it_h;
 ////    
 ////    double branchLength = nd.getBranchLength();
 ////    
@@ -348,8 +348,8 @@
 //        TypedDagNode<RateMap>*                  qmap;
 //                
 //        //BranchHistory*                          storedValue;
-//        std::multiset<CharacterEvent*,CharacterEventCompare> storedHistory;
-//        std::multiset<CharacterEvent*,CharacterEventCompare> proposedHistory;
+//        CharacterEventList storedHistory;
+//        CharacterEventList proposedHistory;
 //        
 //        TopologyNode*                           node;
 //        std::set<size_t>                        siteIndexSet;
@@ -667,11 +667,11 @@
 ////    //    }
 ////    
 ////    BranchHistory* bh = &p.getHistory(*node);
-////    const std::multiset<CharacterEvent*,CharacterEventCompare>& history = bh->getHistory();
+////    const CharacterEventList& history = bh->getHistory();
 //////    bh->print();
 ////    
 ////    // store history for events in siteIndexSet
-////    std::multiset<CharacterEvent*,CharacterEventCompare>::iterator it_h;
+////    CharacterEventList::iterator it_h;
 ////    for (it_h = history.begin(); it_h != history.end(); it_h++)
 ////    {
 ////        if (siteIndexSet.find( (*it_h)->getSiteIndex() ) != siteIndexSet.end())
@@ -723,7 +723,7 @@
 ////    bh->updateHistory(storedHistory, siteIndexSet);
 ////    
 ////    // delete new events
-////    std::multiset<CharacterEvent*,CharacterEventCompare>::iterator it_h;
+////    CharacterEventList::iterator it_h;
 ////    for (it_h = proposedHistory.begin(); it_h != proposedHistory.end(); it_h++)
 ////    {
 ////        delete *it_h;
@@ -1035,11 +1035,11 @@
 //    //    }
 //    
 //    BranchHistory* bh = &p.getHistory(*node);
-//    const std::multiset<CharacterEvent*,CharacterEventCompare>& history = bh->getHistory();
+//    const CharacterEventList& history = bh->getHistory();
 ////    bh->print();
 //    
 //    // store history for events in siteIndexSet
-//    std::multiset<CharacterEvent*,CharacterEventCompare>::iterator it_h;
+//    CharacterEventList::iterator it_h;
 //    for (it_h = history.begin(); it_h != history.end(); it_h++)
 //    {
 //        if (siteIndexSet.find( (*it_h)->getCharacterIndex() ) != siteIndexSet.end())
@@ -1091,7 +1091,7 @@
 //    bh->updateHistory(storedHistory, siteIndexSet);
 //    
 //    // delete new events
-//    std::multiset<CharacterEvent*,CharacterEventCompare>::iterator it_h;
+//    CharacterEventList::iterator it_h;
 //    for (it_h = proposedHistory.begin(); it_h != proposedHistory.end(); it_h++)
 //    {
 //        delete *it_h;
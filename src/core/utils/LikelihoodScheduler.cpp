@@ -0,0 +1,202 @@
+#include "LikelihoodScheduler.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <ostream>
+
+#include "Distribution.h"
+#include "RbSettings.h"
+#include "ThreadPool.h"
+
+using namespace RevBayesCore;
+
+
+namespace {
+
+    /*
+     * Order tasks by decreasing cost and keep the given order among tasks of equal cost.
+     */
+    struct DecreasingCost {
+
+        DecreasingCost(const std::vector<double> &c) : costs( c ) {}
+
+        bool operator()(size_t a, size_t b) const { return costs[a] > costs[b]; }
+
+        const std::vector<double>& costs;
+    };
+
+}
+
+
+LikelihoodScheduler::ComputationTimer::ComputationTimer(ComputationStatistics* s) :
+    statistics( s ),
+    timed( false )
+{
+
+    if ( statistics != NULL )
+    {
+        ++statistics->num_computations;
+
+        // reading the clock is not free, so we only do it if the user wants to know the times
+        timed = RbSettings::userSettings().getTimeLikelihoods();
+        if ( timed == true )
+        {
+            start = std::chrono::steady_clock::now();
+        }
+    }
+
+}
+
+
+LikelihoodScheduler::ComputationTimer::~ComputationTimer( void )
+{
+
+    if ( timed == true )
+    {
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        statistics->total_time += elapsed.count();
+    }
+
+}
+
+
+/**
+ * Get the process-wide scheduler.
+ * The scheduler is never destroyed, because distributions held by global objects unregister themselves during the exit of the program.
+ */
+LikelihoodScheduler& LikelihoodScheduler::likelihoodSchedulerInstance( void )
+{
+    static LikelihoodScheduler* scheduler = new LikelihoodScheduler();
+
+    return *scheduler;
+}
+
+
+LikelihoodScheduler::LikelihoodScheduler( void ) :
+    num_registrations( 0 )
+{
+
+}
+
+
+/**
+ * Print one line per registered distribution with the number of likelihood computations
+ * and the time spent in them, in the order in which the distributions were registered.
+ */
+void LikelihoodScheduler::printSummary(std::ostream &o) const
+{
+    std::lock_guard<std::mutex> lock( scheduler_mutex );
+
+    typedef std::map<const Distribution*, InstanceInfo>::const_iterator instance_iterator;
+    std::vector<instance_iterator> sorted;
+    double total_time = 0.0;
+    for (instance_iterator it = instances.begin(); it != instances.end(); ++it)
+    {
+        sorted.push_back( it );
+        total_time += it->second.statistics->total_time;
+    }
+    std::sort( sorted.begin(), sorted.end(), [](instance_iterator a, instance_iterator b) { return a->second.registration_index < b->second.registration_index; } );
+
+    // we change the formatting of the stream, so we remember the settings of the caller
+    std::ios_base::fmtflags flags = o.flags();
+    std::streamsize precision = o.precision();
+
+    o << std::setw(24) << std::left << "Likelihood" << std::right;
+    o << std::setw(16) << "Cost";
+    o << std::setw(16) << "Computations";
+    o << std::setw(16) << "Time (s)";
+    o << std::setw(16) << "Mean (ms)";
+    o << std::setw(10) << "Share";
+    o << std::endl;
+    o << std::string(98, '=') << std::endl;
+
+    for (size_t i = 0; i < sorted.size(); ++i)
+    {
+        const InstanceInfo &info = sorted[i]->second;
+        const ComputationStatistics &statistics = *info.statistics;
+        double mean_time = ( statistics.num_computations > 0 ? statistics.total_time / statistics.num_computations : 0.0 );
+        double share = ( total_time > 0.0 ? statistics.total_time / total_time : 0.0 );
+
+        std::string name = ( info.name == "" ? "<unnamed>" : info.name );
+        o << std::setw(24) << std::left << name << std::right;
+        o << std::setw(16) << std::fixed << std::setprecision(0) << sorted[i]->first->getComputationCost();
+        o << std::setw(16) << statistics.num_computations;
+        o << std::setw(16) << std::setprecision(3) << statistics.total_time;
+        o << std::setw(16) << std::setprecision(3) << 1000.0 * mean_time;
+        o << std::setw(9) << std::setprecision(1) << 100.0 * share << "%";
+        o << std::endl;
+    }
+    o.flags( flags );
+    o.precision( precision );
+
+}
+
+
+/**
+ * Register a distribution with its name and its computation statistics. If the distribution is already registered,
+ * we only update the name and keep the recorded times.
+ */
+void LikelihoodScheduler::registerInstance(const Distribution* d, const std::string &name, ComputationStatistics* s)
+{
+    std::lock_guard<std::mutex> lock( scheduler_mutex );
+
+    std::map<const Distribution*, InstanceInfo>::iterator it = instances.find( d );
+    if ( it == instances.end() )
+    {
+        InstanceInfo info;
+        info.registration_index = num_registrations++;
+        it = instances.insert( std::make_pair( d, info ) ).first;
+    }
+
+    it->second.name       = name;
+    it->second.statistics = s;
+
+}
+
+
+void LikelihoodScheduler::resetTimes( void )
+{
+    std::lock_guard<std::mutex> lock( scheduler_mutex );
+
+    for (std::map<const Distribution*, InstanceInfo>::iterator it = instances.begin(); it != instances.end(); ++it)
+    {
+        it->second.statistics->num_computations = 0;
+        it->second.statistics->total_time       = 0.0;
+    }
+
+}
+
+
+/**
+ * Execute a batch of independent tasks on the global thread pool. The threads claim the tasks in the order
+ * of decreasing cost (longest processing time first), which balances tasks of very unequal cost.
+ * The tasks are expected to write their results to their own locations, so the results do not depend on the order.
+ */
+void LikelihoodScheduler::run(const std::vector< std::function<void(void)> > &tasks, const std::vector<double> &costs)
+{
+
+    std::vector<size_t> order( tasks.size() );
+    for (size_t i = 0; i < order.size(); ++i)
+    {
+        order[i] = i;
+    }
+    std::stable_sort( order.begin(), order.end(), DecreasingCost( costs ) );
+
+    std::vector< std::function<void(void)> > sorted_tasks( tasks.size() );
+    for (size_t i = 0; i < order.size(); ++i)
+    {
+        sorted_tasks[i] = tasks[ order[i] ];
+    }
+
+    ThreadPool::threadPoolInstance().run( sorted_tasks );
+
+}
+
+
+void LikelihoodScheduler::unregisterInstance(const Distribution* d)
+{
+    std::lock_guard<std::mutex> lock( scheduler_mutex );
+
+    instances.erase( d );
+
+}
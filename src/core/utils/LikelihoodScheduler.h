@@ -0,0 +1,98 @@
+#ifndef LikelihoodScheduler_H
+#define LikelihoodScheduler_H
+
+#include <stddef.h>
+#include <chrono>
+#include <functional>
+#include <iosfwd>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace RevBayesCore {
+
+    class Distribution;
+
+    /**
+     * @brief Process-wide scheduler of the likelihood computations of many distributions on the shared thread pool.
+     *
+     * Expensive likelihood distributions (e.g., the CTMC of each locus in a multi-locus analysis) report
+     * an estimate of their cost in Distribution::getComputationCost(), such as the number of site patterns
+     * times the number of nodes and states. When the probabilities of several independent DAG nodes need
+     * to be recomputed, e.g., after a move of the shared tree or clock rate, the recomputations are queued
+     * as one batch on the global thread pool. The tasks are started in the order of decreasing cost,
+     * so the many small tasks fill the gaps left by the few large ones and all threads finish at about the same time.
+     *
+     * The scheduler also keeps a list of the registered distributions together with their computation statistics,
+     * i.e., the number of computations and the total time spent per distribution, which can be printed to find the loci
+     * that dominate the run time. The statistics and the cost live in the distribution itself, so computing a likelihood
+     * or scheduling a batch never takes the lock of the scheduler. The times are only measured if the option "timeLikelihoods" is set.
+     *
+     * @copyright Copyright 2009-
+     * @author The RevBayes Development Core Team
+     * @since 2026-10-16, version 1.2.2
+     */
+    class LikelihoodScheduler {
+
+    public:
+
+        /**
+         * The number of likelihood computations of one distribution and the time spent in them.
+         * A distribution is never computed by two threads at the same time, so only one thread writes its statistics.
+         * A copy of a distribution starts with new statistics.
+         */
+        struct ComputationStatistics {
+                                                    ComputationStatistics(void) : num_computations( 0 ), total_time( 0.0 ) {}
+                                                    ComputationStatistics(const ComputationStatistics &) : num_computations( 0 ), total_time( 0.0 ) {}     //!< A copy starts with fresh statistics
+
+            ComputationStatistics&                  operator=(const ComputationStatistics &) { return *this; }                           //!< An assigned copy keeps its own statistics
+
+            size_t                                  num_computations;
+            double                                  total_time;                                                         //!< The time of all computations in seconds
+        };
+
+        /**
+         * Counts one likelihood computation and, if the option "timeLikelihoods" is set, measures its time.
+         * The time is recorded when the timer goes out of scope. A timer for NULL does nothing.
+         */
+        class ComputationTimer {
+
+        public:
+                                                    ComputationTimer(ComputationStatistics* s);
+                                                   ~ComputationTimer(void);
+
+        private:
+            ComputationStatistics*                  statistics;
+            bool                                    timed;
+            std::chrono::steady_clock::time_point   start;
+        };
+
+        static LikelihoodScheduler&                 likelihoodSchedulerInstance(void);                                  //!< Get the process-wide scheduler
+
+        void                                        printSummary(std::ostream &o) const;                                //!< Print the number of computations and the time spent per distribution
+        void                                        registerInstance(const Distribution* d, const std::string &name, ComputationStatistics* s);     //!< Register a distribution or update its name
+        void                                        resetTimes(void);
+        void                                        run(const std::vector< std::function<void(void)> > &tasks, const std::vector<double> &costs);     //!< Execute the tasks on the thread pool, the most expensive first
+        void                                        unregisterInstance(const Distribution* d);
+
+    private:
+
+        struct InstanceInfo {
+            std::string                             name;
+            size_t                                  registration_index;
+            ComputationStatistics*                  statistics;
+        };
+
+                                                    LikelihoodScheduler(void);
+                                                    LikelihoodScheduler(const LikelihoodScheduler &s);                  //!< Prevent copy
+        LikelihoodScheduler&                        operator=(const LikelihoodScheduler &s);                            //!< Prevent assignment
+
+        std::map<const Distribution*, InstanceInfo> instances;
+        size_t                                      num_registrations;
+        mutable std::mutex                          scheduler_mutex;
+    };
+
+}
+
+#endif
@@ -15,10 +15,7 @@
 //#define TESTING
 
 /* Feature enabling switches */
-#ifndef RB_ARM
-#define SSE_ENABLED
-#endif
-//#define AVX_ENABLED
+/* The vectorized CTMC likelihood kernels choose SSE2, AVX2 or AVX-512 at runtime (see PhyloCTMCKernels). */
 
 
 /* Test whether we should use linenoise */
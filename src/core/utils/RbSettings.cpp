@@ -39,6 +39,12 @@ size_t RbSettings::getLineWidth( void ) const
     return lineWidth;
 }
 
+size_t RbSettings::getNumThreads( void ) const
+{
+    // return the internal value
+    return numThreads;
+}
+
 size_t RbSettings::getScalingDensity( void ) const
 {
     // return the internal value
@@ -83,10 +89,22 @@ std::string RbSettings::getOption(const std::string &key) const
     {
         return StringUtilities::to_string(scalingDensity);
     }
+    else if ( key == "numThreads" )
+    {
+        return StringUtilities::to_string(numThreads);
+    }
     else if ( key == "useScaling" )
     {
         return useScaling ? "true" : "false";
     }
+    else if ( key == "padStates" )
+    {
+        return padStates ? "true" : "false";
+    }
+    else if ( key == "timeLikelihoods" )
+    {
+        return timeLikelihoods ? "true" : "false";
+    }
     else if ( key == "collapseSampledAncestors" )
     {
         return collapseSampledAncestors ? "true" : "false";
@@ -107,6 +125,13 @@ size_t RbSettings::getOutputPrecision( void ) const
 }
 
 
+bool RbSettings::getPadStates( void ) const
+{
+    // return the internal value
+    return padStates;
+}
+
+
 bool RbSettings::getPrintNodeIndex( void ) const
 {
     // return the internal value
@@ -114,6 +139,13 @@ bool RbSettings::getPrintNodeIndex( void ) const
 }
 
 
+bool RbSettings::getTimeLikelihoods( void ) const
+{
+    // return the internal value
+    return timeLikelihoods;
+}
+
+
 double RbSettings::getTolerance( void ) const
 {
     
@@ -128,6 +160,9 @@ void RbSettings::initializeUserSettings(void)
     moduleDir = "modules";      // the default module directory
     useScaling = true;         // the default useScaling
     scalingDensity = 1;         // the default scaling density
+    numThreads = 1;             // the default number of threads
+    padStates = false;          // do not pad the states of the CTMC likelihood vectors
+    timeLikelihoods = false;    // do not measure the time of each likelihood computation
     lineWidth = 160;            // the default line width
     tolerance = 10E-10;         // set default value for tolerance comparing doubles
     outputPrecision = 7;
@@ -170,6 +205,9 @@ void RbSettings::listOptions() const
     std::cout << "linewidth = " << lineWidth << std::endl;
     std::cout << "useScaling = " << (useScaling ? "true" : "false") << std::endl;
     std::cout << "scalingDensity = " << scalingDensity << std::endl;
+    std::cout << "numThreads = " << numThreads << std::endl;
+    std::cout << "padStates = " << (padStates ? "true" : "false") << std::endl;
+    std::cout << "timeLikelihoods = " << (timeLikelihoods ? "true" : "false") << std::endl;
     std::cout << "collapseSampledAncestors = " << (collapseSampledAncestors ? "true" : "false") << std::endl;
 }
 
@@ -216,6 +254,21 @@ void RbSettings::setScalingDensity(size_t w)
 }
 
 
+void RbSettings::setNumThreads(size_t n)
+{
+    if ( n < 1 )
+    {
+        throw RbException("numThreads must be an integer greater than 0");
+    }
+
+    // replace the internal value with this new value
+    numThreads = n;
+
+    // save the current settings for the future.
+    writeUserSettings();
+}
+
+
 void RbSettings::setCollapseSampledAncestors(bool w)
 {
     // replace the internal value with this new value
@@ -268,6 +321,22 @@ void RbSettings::setOption(const std::string &key, const std::string &v, bool wr
         
         scalingDensity = atoi(value.c_str());
     }
+    else if ( key == "numThreads" )
+    {
+        int n = atoi(value.c_str());
+        if (n < 1)
+            throw(RbException("numThreads must be an integer greater than 0"));
+
+        numThreads = n;
+    }
+    else if ( key == "padStates" )
+    {
+        padStates = value == "true";
+    }
+    else if ( key == "timeLikelihoods" )
+    {
+        timeLikelihoods = value == "true";
+    }
     else if ( key == "collapseSampledAncestors" )
     {
         collapseSampledAncestors = value == "true";
@@ -295,6 +364,16 @@ void RbSettings::setOutputPrecision(size_t p)
 }
 
 
+void RbSettings::setPadStates(bool tf)
+{
+    // replace the internal value with this new value
+    padStates = tf;
+
+    // save the current settings for the future.
+    writeUserSettings();
+}
+
+
 void RbSettings::setPrintNodeIndex(bool tf)
 {
     // replace the internal value with this new value
@@ -302,6 +381,16 @@ void RbSettings::setPrintNodeIndex(bool tf)
 }
 
 
+void RbSettings::setTimeLikelihoods(bool tf)
+{
+    // replace the internal value with this new value
+    timeLikelihoods = tf;
+
+    // save the current settings for the future.
+    writeUserSettings();
+}
+
+
 void RbSettings::setTolerance(double t)
 {
     // replace the internal value with this new value
@@ -329,6 +418,9 @@ void RbSettings::writeUserSettings( void )
     writeStream << "linewidth=" << lineWidth << std::endl;
     writeStream << "useScaling=" << (useScaling ? "true" : "false") << std::endl;
     writeStream << "scalingDensity=" << scalingDensity << std::endl;
+    writeStream << "numThreads=" << numThreads << std::endl;
+    writeStream << "padStates=" << (padStates ? "true" : "false") << std::endl;
+    writeStream << "timeLikelihoods=" << (timeLikelihoods ? "true" : "false") << std::endl;
     writeStream << "collapseSampledAncestors=" << (collapseSampledAncestors ? "true" : "false") << std::endl;
     writeStream.close();
 
@@ -23,10 +23,13 @@ class RbSettings {
         bool                        getCollapseSampledAncestors(void) const;            //!< Retrieve the whether to should display sampled ancestors as 2-degree nodes when printing
         size_t                      getLineWidth(void) const;                           //!< Retrieve the line width that will be used for the screen width when printing
         const RevBayesCore::path&   getModuleDir(void) const;                           //!< Retrieve the module directory name
+        size_t                      getNumThreads(void) const;                          //!< Retrieve the number of threads used for shared-memory parallel computations
         std::string                 getOption(const std::string &k) const;              //!< Retrieve a user option
         size_t                      getOutputPrecision(void) const;                     //!< Retrieve the default output precision width
+        bool                        getPadStates(void) const;                           //!< Retrieve the flag whether the states of the CTMC likelihood vectors are padded to the vector width
         bool                        getPrintNodeIndex(void) const;                      //!< Retrieve the flag whether we should print node indices
         size_t                      getScalingDensity(void) const;                      //!< Retrieve the scaling density that determines how often to scale the likelihood in CTMC models
+        bool                        getTimeLikelihoods(void) const;                     //!< Retrieve the flag whether we should measure the time of each likelihood computation
         double                      getTolerance(void) const;                           //!< Retrieve the tolerance for comparing doubles
         bool                        getUseScaling(void) const;                          //!< Retrieve the flag whether we should scale the likelihood in CTMC models
         void                        listOptions(void) const;                            //!< Retrieve a list of all user options and their current values
@@ -35,10 +38,13 @@ class RbSettings {
         void                        setCollapseSampledAncestors(bool);                  //!< Set whether to should display sampled ancestors as 2-degree nodes when printing
         void                        setLineWidth(size_t w);                             //!< Set the line width that will be used for the screen width when printing
         void                        setModuleDir(const RevBayesCore::path &md);         //!< Set the module directory name
+        void                        setNumThreads(size_t n);                            //!< Set the number of threads used for shared-memory parallel computations (min 1)
         void                        setOutputPrecision(size_t p);                       //!< Set the default output precision width
         void                        setOption(const std::string &k, const std::string &v, bool write);  //!< Set the key value pair.
+        void                        setPadStates(bool tf);                              //!< Set the flag whether the states of the CTMC likelihood vectors are padded to the vector width
         void                        setPrintNodeIndex(bool tf);                         //!< Set the flag whether we should print node indices
         void                        setScalingDensity(size_t w);                        //!< Set the scaling density n, where CTMC likelihoods are scaled every n-th node (min 1)
+        void                        setTimeLikelihoods(bool tf);                        //!< Set the flag whether we should measure the time of each likelihood computation
         void                        setTolerance(double t);                             //!< Set the tolerance for comparing double
         void                        setUseScaling(bool s);                              //!< Set the flag whether we should scale the likelihood in CTMC models
     
@@ -55,9 +61,12 @@ class RbSettings {
         bool                        collapseSampledAncestors;
         size_t                      lineWidth;
         RevBayesCore::path          moduleDir;
+        size_t                      numThreads;                                         //!< Number of threads for shared-memory parallel computations
         size_t                      outputPrecision;
+        bool                        padStates;                                          //!< Should the CTMC likelihood vectors be padded to the SIMD vector width?
         bool                        printNodeIndex;                                     //!< Should the node index of a tree be printed as a comment?
         size_t                      scalingDensity;
+        bool                        timeLikelihoods;                                    //!< Should the time of each likelihood computation be measured (see printLikelihoodTimes)?
         double                      tolerance;                                          //!< Tolerance for comparison of doubles
         bool                        useScaling;
 };
@@ -0,0 +1,215 @@
+#include "ThreadPool.h"
+
+#include <algorithm>
+
+#include "RbSettings.h"
+
+using namespace RevBayesCore;
+
+
+/**
+ * Get the process-wide thread pool.
+ * The pool is resized lazily whenever the user changed the "numThreads" setting and no batch is running.
+ */
+ThreadPool& ThreadPool::threadPoolInstance( void )
+{
+    static ThreadPool pool( RbSettings::userSettings().getNumThreads() );
+
+    size_t n = RbSettings::userSettings().getNumThreads();
+    if ( n != pool.getNumberOfThreads() )
+    {
+        pool.setNumberOfThreads( n );
+    }
+
+    return pool;
+}
+
+
+/**
+ * Constructor. We use the calling thread as one of the n threads,
+ * so we only need to start n-1 additional workers.
+ */
+ThreadPool::ThreadPool(size_t n) :
+    num_running_batches( 0 ),
+    stopping( false )
+{
+    startWorkers( n );
+}
+
+
+ThreadPool::~ThreadPool( void )
+{
+    stopWorkers();
+}
+
+
+/**
+ * Claim the next unclaimed task of this batch and execute it.
+ *
+ * \return False if there was no task left to claim.
+ */
+bool ThreadPool::executeNextTask(TaskBatch &batch)
+{
+    size_t index = batch.next_task.fetch_add( 1 );
+    if ( index >= batch.tasks.size() )
+    {
+        return false;
+    }
+
+    std::exception_ptr error = nullptr;
+    try
+    {
+        batch.tasks[index]();
+    }
+    catch (...)
+    {
+        error = std::current_exception();
+    }
+
+    std::lock_guard<std::mutex> lock( pool_mutex );
+    if ( error != nullptr && batch.error == nullptr )
+    {
+        batch.error = error;
+    }
+    ++batch.num_completed;
+    if ( batch.num_completed == batch.tasks.size() )
+    {
+        batch_finished.notify_all();
+    }
+
+    return true;
+}
+
+
+size_t ThreadPool::getNumberOfThreads( void ) const
+{
+    return workers.size() + 1;
+}
+
+
+/**
+ * Execute all tasks of this batch and return once they are all finished.
+ * The order in which the tasks are executed is unspecified, so tasks should only write to their own output.
+ */
+void ThreadPool::run(const std::vector< std::function<void(void)> > &tasks)
+{
+
+    // there is nothing to gain from other threads if we only have one task or no workers
+    if ( workers.empty() == true || tasks.size() < 2 )
+    {
+        for (size_t i = 0; i < tasks.size(); ++i)
+        {
+            tasks[i]();
+        }
+        return;
+    }
+
+    TaskBatch batch( tasks );
+    {
+        std::lock_guard<std::mutex> lock( pool_mutex );
+        pending_batches.push_back( &batch );
+        ++num_running_batches;
+    }
+    task_available.notify_all();
+
+    // we work on our own batch while we wait
+    while ( executeNextTask( batch ) == true )
+    {
+        // keep going
+    }
+
+    std::unique_lock<std::mutex> lock( pool_mutex );
+
+    // no new worker can join this batch once it is not pending anymore
+    std::deque<TaskBatch*>::iterator it = std::find( pending_batches.begin(), pending_batches.end(), &batch );
+    if ( it != pending_batches.end() )
+    {
+        pending_batches.erase( it );
+    }
+
+    batch_finished.wait( lock, [&batch]{ return batch.num_completed == batch.tasks.size() && batch.num_active_workers == 0; } );
+    --num_running_batches;
+    batch_finished.notify_all();
+
+    if ( batch.error != nullptr )
+    {
+        std::rethrow_exception( batch.error );
+    }
+
+}
+
+
+void ThreadPool::setNumberOfThreads(size_t n)
+{
+
+    std::unique_lock<std::mutex> lock( pool_mutex );
+    if ( num_running_batches > 0 )
+    {
+        // we cannot change the number of threads while tasks are running; we will try again next time
+        return;
+    }
+    lock.unlock();
+
+    stopWorkers();
+    startWorkers( n );
+}
+
+
+void ThreadPool::startWorkers(size_t n)
+{
+    stopping = false;
+    for (size_t i = 1; i < n; ++i)
+    {
+        workers.push_back( std::thread( &ThreadPool::workerLoop, this ) );
+    }
+}
+
+
+void ThreadPool::stopWorkers( void )
+{
+    {
+        std::lock_guard<std::mutex> lock( pool_mutex );
+        stopping = true;
+    }
+    task_available.notify_all();
+
+    for (size_t i = 0; i < workers.size(); ++i)
+    {
+        workers[i].join();
+    }
+    workers.clear();
+}
+
+
+void ThreadPool::workerLoop( void )
+{
+
+    std::unique_lock<std::mutex> lock( pool_mutex );
+    while ( true )
+    {
+        task_available.wait( lock, [this]{ return stopping == true || pending_batches.empty() == false; } );
+        if ( stopping == true )
+        {
+            return;
+        }
+
+        TaskBatch *batch = pending_batches.front();
+        ++batch->num_active_workers;
+        lock.unlock();
+
+        while ( executeNextTask( *batch ) == true )
+        {
+            // keep going
+        }
+
+        lock.lock();
+        // all tasks of this batch are claimed, so nobody else needs to join it
+        if ( pending_batches.empty() == false && pending_batches.front() == batch )
+        {
+            pending_batches.pop_front();
+        }
+        --batch->num_active_workers;
+        batch_finished.notify_all();
+    }
+
+}
@@ -0,0 +1,77 @@
+#ifndef ThreadPool_H
+#define ThreadPool_H
+
+#include <stddef.h>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace RevBayesCore {
+
+    /**
+     * @brief Process-wide pool of worker threads for shared-memory parallelism.
+     *
+     * The thread pool executes batches of independent tasks. A batch is submitted with run(),
+     * which blocks until all tasks of the batch are finished. The calling thread participates
+     * in executing the tasks of its own batch, so nested calls of run() from within a task are
+     * safe and cannot deadlock. Idle workers pick up the next unclaimed task of any pending batch,
+     * which balances tasks of unequal cost dynamically.
+     *
+     * The number of threads is taken from the user setting "numThreads" (see RbSettings).
+     * With a single thread all tasks are simply executed by the caller in their given order.
+     * If a task throws an exception, the remaining tasks are still executed and the first
+     * exception is rethrown in the calling thread.
+     *
+     * @copyright Copyright 2009-
+     * @author The RevBayes Development Core Team
+     * @since 2026-10-16, version 1.2.2
+     */
+    class ThreadPool {
+
+    public:
+        static ThreadPool&                          threadPoolInstance(void);                                           //!< Get the process-wide thread pool, sized from the user settings
+
+                                                    ThreadPool(size_t n);                                               //!< Constructor with the total number of threads (including the caller)
+                                                   ~ThreadPool(void);
+
+        size_t                                      getNumberOfThreads(void) const;                                     //!< The total number of threads (including the caller)
+        void                                        run(const std::vector< std::function<void(void)> > &tasks);         //!< Execute all tasks and wait for them to finish
+        void                                        setNumberOfThreads(size_t n);                                       //!< Change the number of threads (only when no batch is running)
+
+    private:
+
+        struct TaskBatch {
+                                                    TaskBatch(const std::vector< std::function<void(void)> > &t) : tasks( t ), next_task( 0 ), num_completed( 0 ), num_active_workers( 0 ), error( nullptr ) {}
+
+            const std::vector< std::function<void(void)> >&     tasks;
+            std::atomic<size_t>                     next_task;                                                          //!< The index of the next unclaimed task
+            size_t                                  num_completed;                                                      //!< Guarded by the pool mutex
+            size_t                                  num_active_workers;                                                 //!< Guarded by the pool mutex
+            std::exception_ptr                      error;                                                              //!< Guarded by the pool mutex
+        };
+
+                                                    ThreadPool(const ThreadPool &p);                                    //!< Prevent copy
+        ThreadPool&                                 operator=(const ThreadPool &p);                                     //!< Prevent assignment
+
+        bool                                        executeNextTask(TaskBatch &batch);                                  //!< Claim and execute the next task of the batch
+        void                                        startWorkers(size_t n);
+        void                                        stopWorkers(void);
+        void                                        workerLoop(void);
+
+        std::vector<std::thread>                    workers;
+        std::deque<TaskBatch*>                      pending_batches;
+        size_t                                      num_running_batches;
+        std::mutex                                  pool_mutex;
+        std::condition_variable                     task_available;
+        std::condition_variable                     batch_finished;
+        bool                                        stopping;
+    };
+
+}
+
+#endif
@@ -399,55 +399,73 @@ double RevBayesCore::TreeUtilities::computeRobinsonFouldDistance(const RevBayesC
 double RevBayesCore::TreeUtilities::computeRobinsonFouldDistance(const std::vector<RevBayesCore::RbBitSet>& bipartitions_a, const std::vector<RevBayesCore::RbBitSet>& bipartitions_b, bool symmetric)
 {
 
-    bool found = false;
-    double distance = 0.0;
-    for (size_t i = 0; i< bipartitions_a.size(); ++i)
+    size_t num_tips = 0;
+    if ( bipartitions_a.empty() == false )
     {
-        found = false;
-        for (size_t j = 0; j < bipartitions_b.size(); ++j)
+        num_tips = bipartitions_a[0].size();
+    }
+    else if ( bipartitions_b.empty() == false )
+    {
+        num_tips = bipartitions_b[0].size();
+    }
+    size_t num_words = (num_tips + 63) / 64;
+
+    return computeRobinsonFouldDistance( packSplits(bipartitions_a, num_tips), packSplits(bipartitions_b, num_tips), num_words, symmetric );
+}
+
+
+/** Calculate Robinson-Foulds distance between two trees
+ * The splits of both trees must have been packed and sorted by packSplits,
+ * so that we can compare them in a single merge scan.
+ * @param a,b packed splits of the trees between which to calculate the distance
+ * @param num_words number of 64-bit words per split
+ * @return RF distance
+ */
+double RevBayesCore::TreeUtilities::computeRobinsonFouldDistance(const std::vector<uint64_t>& a, const std::vector<uint64_t>& b, size_t num_words, bool symmetric)
+{
+
+    if ( num_words == 0 )
+    {
+        return 0.0;
+    }
+
+    std::vector<uint64_t>::const_iterator it_a = a.begin();
+    std::vector<uint64_t>::const_iterator it_b = b.begin();
+
+    double only_in_a = 0.0;
+    double only_in_b = 0.0;
+    while ( it_a != a.end() && it_b != b.end() )
+    {
+        if ( std::lexicographical_compare(it_a, it_a + num_words, it_b, it_b + num_words) )
         {
-            if (bipartitions_a[i] == bipartitions_b[j])
-            {
-                found = true;
-                break;
-            }
+            only_in_a += 1.0;
+            it_a += num_words;
+        }
+        else if ( std::lexicographical_compare(it_b, it_b + num_words, it_a, it_a + num_words) )
+        {
+            only_in_b += 1.0;
+            it_b += num_words;
         }
-        if (found == false)
+        else
         {
-            distance += 1.0;
+            it_a += num_words;
+            it_b += num_words;
         }
     }
-    
+    only_in_a += (a.end() - it_a) / num_words;
+    only_in_b += (b.end() - it_b) / num_words;
+
     if ( symmetric == true )
     {
-        distance *= 2;
+        return 2 * only_in_a;
     }
     else
     {
-
-        for (size_t i = 0; i< bipartitions_b.size(); ++i)
-        {
-            found = false;
-            for (size_t j = 0; j < bipartitions_a.size(); ++j)
-            {
-                if (bipartitions_b[i] == bipartitions_a[j])
-                {
-                    found = true;
-                    break;
-                }
-            }
-
-            if (found == false)
-            {
-                distance += 1.0;
-            }
-        }
-        
+        return only_in_a + only_in_b;
     }
-
-    return distance;
 }
 
+
 /**
  * Helper function to recusively build a time tree
  * @param tn current time tree node
@@ -1260,6 +1278,51 @@ void RevBayesCore::TreeUtilities::offsetTree(TopologyNode& node, double factor)
 }
 
 
+/**
+ * Pack the splits into blocks of 64-bit words and sort the blocks.
+ * Each split takes (num_tips+63)/64 consecutive words. Sorting the splits of a tree once
+ * lets us compute the Robinson-Foulds distance between two trees by a merge scan.
+ * @param splits the splits as bitsets over the tips
+ * @param num_tips number of tips (i.e., the size of the bitsets)
+ * @return the sorted packed splits
+ */
+std::vector<uint64_t> RevBayesCore::TreeUtilities::packSplits(const std::vector<RbBitSet>& splits, size_t num_tips)
+{
+
+    size_t num_words = (num_tips + 63) / 64;
+
+    std::vector<uint64_t> unsorted( splits.size() * num_words, 0 );
+    for (size_t i = 0; i < splits.size(); ++i)
+    {
+        const RbBitSet& split = splits[i];
+        uint64_t* words = &unsorted[i * num_words];
+        for (size_t j = split.find_first(); j != RbBitSet::npos; j = split.find_next(j))
+        {
+            words[j / 64] |= uint64_t(1) << (j % 64);
+        }
+    }
+
+    std::vector<size_t> order( splits.size() );
+    for (size_t i = 0; i < order.size(); ++i)
+    {
+        order[i] = i;
+    }
+    std::sort( order.begin(), order.end(), [&](size_t l, size_t r)
+    {
+        return std::lexicographical_compare(unsorted.begin() + l*num_words, unsorted.begin() + (l+1)*num_words, unsorted.begin() + r*num_words, unsorted.begin() + (r+1)*num_words);
+    });
+
+    std::vector<uint64_t> packed;
+    packed.reserve( unsorted.size() );
+    for (size_t i = 0; i < order.size(); ++i)
+    {
+        packed.insert( packed.end(), unsorted.begin() + order[i]*num_words, unsorted.begin() + (order[i]+1)*num_words );
+    }
+
+    return packed;
+}
+
+
 /**
  * Helper function for calculating distance matrix between all tips of a tree, recursively
  * @param[in] node current node
@@ -22,6 +22,7 @@
 #include "RbVector.h"
 #include "Tree.h"
 #include "TopologyNode.h"
+#include <stdint.h>
 #include <string>
 #include <vector>
 
@@ -39,6 +40,7 @@ namespace RevBayesCore {
         void                    climbUpTheTree(const TopologyNode& node, boost::unordered_set< const TopologyNode* >& node_root_path) ; //!< find path from given node to root
         double                  computeRobinsonFouldDistance(const std::vector<RbBitSet>& a, const std::vector<RbBitSet>& b, bool symmetric);//!< Robinson-Foulds distance
         double                  computeRobinsonFouldDistance(const Tree& a, const Tree& b, bool symmetric);                             //!< Robinson-Foulds distance
+        double                  computeRobinsonFouldDistance(const std::vector<uint64_t>& a, const std::vector<uint64_t>& b, size_t num_words, bool symmetric); //!< Robinson-Foulds distance of packed splits (see packSplits)
         Tree*                   convertTree(const Tree& t, bool resetIndex=true);                                                       //!< convert tree to time tree
         double                  getAgeOfMRCA(const Tree& t, const std::string& first, const std::string& second);                       //!< calculate age of MRCA based on tip names
         void                    getAges(const TopologyNode& n, std::vector<double>& ages, bool internals_only=true);                    //!< fill vector with node ages
@@ -56,6 +58,7 @@ namespace RevBayesCore {
         std::vector<double>     getPSSP(const Tree& t, const AbstractHomologousDiscreteCharacterData& c, size_t state_index);           //!< calculate the Parsimoniously Same State Paths
         void                    getTaxaInSubtree(TopologyNode& n, std::vector<TopologyNode*>& taxa );                                   //!< get taxa below specified node
         bool                    isConnectedNNI(const Tree& a, const Tree& b);                                                           //!< Check if the two trees are connected by a single NNI move
+        std::vector<uint64_t>   packSplits(const std::vector<RbBitSet>& splits, size_t num_tips);                                       //!< pack the splits into sorted blocks of 64-bit words
         void                    offsetTree(TopologyNode& n, double factor);                                                             //!< offset node and its children by a factor
         void                    makeUltrametric(Tree& t);                                                                               //!< make the tree ultrametric by extending terminal branches
         void                    rescaleSubtree(TopologyNode& n, double factor, bool v=false);                                           //!< rescale tree ages below a node by a factor, except tips
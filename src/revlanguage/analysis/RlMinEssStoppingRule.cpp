@@ -11,6 +11,7 @@
 #include "RlString.h"
 #include "TypeSpec.h"
 #include "Natural.h"
+#include "RevNullObject.h"
 #include "RevObject.h"
 #include "RevPtr.h"
 #include "RevVariable.h"
@@ -54,7 +55,16 @@ void MinEssStoppingRule::constructInternalObject( void )
     
     RevBayesCore::BurninEstimatorContinuous *burninEst = constructBurninEstimator();
     
-    value = new RevBayesCore::MinEssStoppingRule(min, fn, size_t(fq), burninEst);
+    if ( burnin->getRevObject() != RevNullObject::getInstance() )
+    {
+        // a fixed burnin lets the rule accumulate the ESS while the samples arrive
+        long b = static_cast<const Natural &>( burnin->getRevObject() ).getValue();
+        value = new RevBayesCore::MinEssStoppingRule(min, fn, size_t(fq), burninEst, size_t(b));
+    }
+    else
+    {
+        value = new RevBayesCore::MinEssStoppingRule(min, fn, size_t(fq), burninEst);
+    }
 
 }
 
@@ -107,6 +117,7 @@ const MemberRules& MinEssStoppingRule::getParameterRules(void) const
         /* Inherit weight from Move, put it after variable */
         const MemberRules& inheritedRules = AbstractConvergenceStoppingRule::getParameterRules();
         memberRules.insert( memberRules.end(), inheritedRules.begin(), inheritedRules.end() );
+        memberRules.push_back( new ArgumentRule( "burnin"   , Natural::getClassTypeSpec(), "The fixed number of samples discarded as burnin (optional). If omitted, the burnin is estimated with the burnin method.", ArgumentRule::BY_VALUE, ArgumentRule::ANY, NULL ) );
 
 
         rules_set = true;
@@ -141,6 +152,10 @@ void MinEssStoppingRule::setConstParameter(const std::string& name, const RevPtr
     {
         minEss = var;
     }
+    else if ( name == "burnin" )
+    {
+        burnin = var;
+    }
     else
     {
         AbstractConvergenceStoppingRule::setConstParameter(name, var);
@@ -42,6 +42,7 @@ namespace RevLanguage {
         virtual void                                printValue(std::ostream& o) const;                                                      //!< Print value (for user)
         void                                        setConstParameter(const std::string& name, const RevPtr<const RevVariable> &var);       //!< Set member variable
         
+        RevPtr<const RevVariable>                   burnin;
         RevPtr<const RevVariable>                   minEss;
         
     };
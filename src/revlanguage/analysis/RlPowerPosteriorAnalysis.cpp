@@ -14,6 +14,7 @@
 #include "RevObject.h"
 #include "RealPos.h"
 #include "RevNullObject.h"
+#include "RlBoolean.h"
 #include "RlModel.h"
 #include "RlMonitor.h"
 #include "RlMove.h"
@@ -117,6 +118,7 @@ void PowerPosteriorAnalysis::constructInternalObject( void )
 
     value->setPowers( beta );
     value->setSampleFreq( sf );
+    value->setIndependentStones( static_cast<const RlBoolean &>( independent_stones->getRevObject() ).getValue() );
 }
 
 
@@ -210,6 +212,7 @@ const MemberRules& PowerPosteriorAnalysis::getParameterRules(void) const
         member_rules.push_back( new ArgumentRule("alpha"      , RealPos::getClassTypeSpec()                 , "The alpha parameter of the beta distribution if no powers are specified.", ArgumentRule::BY_VALUE, ArgumentRule::ANY, new RealPos(0.2) ) );
         member_rules.push_back( new ArgumentRule("sampleFreq" , Natural::getClassTypeSpec()                 , "The sampling frequency of the likelihood values.", ArgumentRule::BY_VALUE, ArgumentRule::ANY, new Natural(100) ) );
         member_rules.push_back( new ArgumentRule("procPerLikelihood" , Natural::getClassTypeSpec()          , "Number of processors used to compute the likelihood.", ArgumentRule::BY_VALUE, ArgumentRule::ANY, new Natural(1) ) );
+        member_rules.push_back( new ArgumentRule("independentStones" , RlBoolean::getClassTypeSpec()        , "Should every stone start from the burnt-in state (and run concurrently if possible) instead of continuing from the previous stone?", ArgumentRule::BY_VALUE, ArgumentRule::ANY, new RlBoolean(false) ) );
 
         rules_set = true;
     }
@@ -276,6 +279,10 @@ void PowerPosteriorAnalysis::setConstParameter(const std::string& name, const Re
     {
         proc_per_lik = var;
     }
+    else if ( name == "independentStones" )
+    {
+        independent_stones = var;
+    }
     else
     {
         RevObject::setConstParameter(name, var);
@@ -9,6 +9,7 @@
 #include "Natural.h"
 #include "Mcmc.h"
 #include "RevObject.h"
+#include "RlBoolean.h"
 #include "RealPos.h"
 #include "RlModel.h"
 #include "RlMonitor.h"
@@ -108,6 +109,9 @@ void Mcmc::constructInternalObject( void )
         m->setChainPriorHeat(prHeat);
     }
     
+    bool                                                    da      = static_cast<const RlBoolean &>( delayed_acceptance->getRevObject() ).getValue();
+    m->setDelayedAcceptance( da );
+    
     value = new RevBayesCore::MonteCarloAnalysis(m,nreps,ct);
     
 }
@@ -167,6 +171,7 @@ const MemberRules& Mcmc::getParameterRules(void) const
         memberRules.push_back( new ArgumentRule("priorHeat", RealPos::getClassTypeSpec(), "The power that the prior will be raised to.", ArgumentRule::BY_VALUE, ArgumentRule::ANY, new RealPos(1.0) ) );
         memberRules.push_back( new ArgumentRule("likelihoodHeat", RealPos::getClassTypeSpec(), "The power that the likelihood will be raised to.", ArgumentRule::BY_VALUE, ArgumentRule::ANY, new RealPos(1.0) ) );
         memberRules.push_back( new ArgumentRule("posteriorHeat", RealPos::getClassTypeSpec(), "The power that the posterior will be raised to.", ArgumentRule::BY_VALUE, ArgumentRule::ANY, new RealPos(1.0) ) );
+        memberRules.push_back( new ArgumentRule("delayedAcceptance", RlBoolean::getClassTypeSpec(), "Should the moves first accept or reject on the prior alone, and compute the likelihoods only for proposals that pass?", ArgumentRule::BY_VALUE, ArgumentRule::ANY, new RlBoolean(false) ) );
         
         rules_set = true;
     }
@@ -196,7 +201,11 @@ void Mcmc::printValue(std::ostream &o) const
 /** Set a member variable */
 void Mcmc::setConstParameter(const std::string& name, const RevPtr<const RevVariable> &var)
 {
-    if ( name == "likelihoodHeat" )
+    if ( name == "delayedAcceptance" )
+    {
+        delayed_acceptance = var;
+    }
+    else if ( name == "likelihoodHeat" )
     {
         likelihood_heat = var;
     }
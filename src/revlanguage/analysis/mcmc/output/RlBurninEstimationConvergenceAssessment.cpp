@@ -167,25 +167,21 @@ RevPtr<RevVariable> BurninEstimationConvergenceAssessment::executeMethod(std::st
             // add the traces to our runs
             std::vector<RevBayesCore::TraceNumeric>& data = runs[p];
             
-            size_t maxBurnin = 0;
-            
             // find the max burnin
+            size_t maxBurnin = burninEst->estimateMaximumBurnin( data );
+            
+            // set the burnins and compute the ESS of all parameters at once
             for ( size_t i = 0; i < data.size(); ++i)
             {
-                size_t b = burninEst->estimateBurnin( data[i] );
-
-                if ( maxBurnin < b )
-                {
-                    maxBurnin = b;
-                }
+                data[i].setBurnin( maxBurnin );
+                data[i].computeStatistics();
             }
+            RevBayesCore::TraceNumeric::computeCorrelationStatistics( data );
             
             bool failed = false;
             size_t numFailedParams = 0;
             for ( size_t i = 0; i < data.size(); ++i)
             {
-                data[i].setBurnin( maxBurnin );
-                data[i].computeStatistics();
                 
                 bool gewekeStat = gewekeTest->assessConvergence( data[i] );
                 bool essStat = essTest->assessConvergence( data[i] );
@@ -176,6 +176,23 @@ RevPtr<RevVariable> TraceTree::executeMethod(std::string const &name, const std:
         
         return new RevVariable( rl_dist );
     }
+    else if ( name == "computePairwiseRFDistanceHistogram" )
+    {
+        found = true;
+        
+        double tree_CI         = static_cast<const Probability &>( args[0].getVariable()->getRevObject() ).getValue();
+        bool verbose           = static_cast<const RlBoolean &>( args[1].getVariable()->getRevObject() ).getValue();
+        
+        std::vector<long> histogram = this->value->computePairwiseRFDistanceHistogram(tree_CI, verbose);
+        
+        ModelVector<Natural> *rl_histogram = new ModelVector<Natural>;
+        for (size_t i=0; i<histogram.size(); ++i)
+        {
+            rl_histogram->push_back( histogram[i] );
+        }
+        
+        return new RevVariable( rl_histogram );
+    }
     else if ( name == "computeTreeLengths" )
     {
         found = true;
@@ -512,6 +529,12 @@ void TraceTree::initMethods( void )
     computePairwiseRFDistanceArgRules->push_back( new ArgumentRule("verbose", RlBoolean::getClassTypeSpec(), "Printing verbose output.", ArgumentRule::BY_VALUE, ArgumentRule::ANY, new RlBoolean(true)) );
     this->methods.addFunction( new MemberProcedure( "computePairwiseRFDistances", ModelVector<RealPos>::getClassTypeSpec(), computePairwiseRFDistanceArgRules) );
     
+    // the i-th element is the number of pairs of sampled trees with RF distance i-1
+    ArgumentRules* computePairwiseRFDistanceHistogramArgRules = new ArgumentRules();
+    computePairwiseRFDistanceHistogramArgRules->push_back( new ArgumentRule("credibleTreeSetSize", Probability::getClassTypeSpec(), "The size of the credible set.", ArgumentRule::BY_VALUE, ArgumentRule::ANY, new Probability(0.95)) );
+    computePairwiseRFDistanceHistogramArgRules->push_back( new ArgumentRule("verbose", RlBoolean::getClassTypeSpec(), "Printing verbose output.", ArgumentRule::BY_VALUE, ArgumentRule::ANY, new RlBoolean(true)) );
+    this->methods.addFunction( new MemberProcedure( "computePairwiseRFDistanceHistogram", ModelVector<Natural>::getClassTypeSpec(), computePairwiseRFDistanceHistogramArgRules) );
+    
     ArgumentRules* computeTreeLengthsArgRules = new ArgumentRules();
     this->methods.addFunction( new MemberProcedure( "computeTreeLengths", ModelVector<RealPos>::getClassTypeSpec(), computeTreeLengthsArgRules) );
     
@@ -42,6 +42,7 @@ namespace RevLanguage {
         typename rlType::valueType&             getValue(void);                                                     //!< Get the value
         const typename rlType::valueType&       getValue(void) const;                                               //!< Get the value (const)
         bool                                    isConstant(void) const;                                             //!< Is this DAG node constant?
+        bool                                    isThreadSafe(void) const { return false; }                          //!< The Rev code is executed in the shared workspace
         virtual void                            printStructureInfo(std::ostream& o, bool verbose=false) const;      //!< Print structure info
         void                                    redraw(RevBayesCore::SimulationCondition c) {}                      //!< Redraw (or not)
         void                                    setMcmcMode(bool tf);                                               //!< Set the modus of the DAG node to MCMC mode.
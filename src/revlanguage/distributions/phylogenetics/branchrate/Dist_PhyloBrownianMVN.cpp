@@ -10,11 +10,13 @@
 #include "ModelObject.h"
 #include "ModelVector.h"
 #include "Natural.h"
+#include "OptionRule.h"
 #include "RbException.h"
 #include "RbVector.h"
 #include "Real.h"
 #include "RealPos.h"
 #include "RlDistribution.h"
+#include "RlString.h"
 #include "StringUtilities.h"
 #include "Tree.h"
 #include "TypeSpec.h"
@@ -99,6 +101,10 @@ RevBayesCore::TypedDistribution< RevBayesCore::ContinuousCharacterData >* Dist_P
         dist->setRootState( rs );
     }
     
+    // the pruning algorithm computes the same likelihood in linear time
+    const std::string &m = static_cast<const RlString &>( method->getRevObject() ).getValue();
+    dist->setUsePruning( m == "pruning" );
+    
     return dist;
 }
 
@@ -169,6 +175,11 @@ const MemberRules& Dist_PhyloBrownianMVN::getParameterRules(void) const
         
         dist_member_rules.push_back( new ArgumentRule( "nSites"         ,  Natural::getClassTypeSpec(), "The number of sites which is used for the initialized (random draw) from this distribution.", ArgumentRule::BY_VALUE, ArgumentRule::ANY, new Natural(10) ) );
         
+        std::vector<std::string> options_method;
+        options_method.push_back( "covariance" );
+        options_method.push_back( "pruning" );
+        dist_member_rules.push_back( new OptionRule( "method", new RlString("covariance"), options_method, "The algorithm used for the likelihood: the multivariate normal density with the inverted covariance matrix, or pruning along the tree in linear time." ) );
+        
         rules_set = true;
     }
     
@@ -263,6 +274,10 @@ void Dist_PhyloBrownianMVN::setConstParameter(const std::string& name, const Rev
     {
         nSites = var;
     }
+    else if ( name == "method" )
+    {
+        method = var;
+    }
     else
     {
         Distribution::setConstParameter(name, var);
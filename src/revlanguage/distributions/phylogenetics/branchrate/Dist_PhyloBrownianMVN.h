@@ -58,6 +58,7 @@ class TypeSpec;
         RevPtr<const RevVariable>                       site_rates;
         RevPtr<const RevVariable>                       rootStates;
         RevPtr<const RevVariable>                       nSites;
+        RevPtr<const RevVariable>                       method;
         
         
     };
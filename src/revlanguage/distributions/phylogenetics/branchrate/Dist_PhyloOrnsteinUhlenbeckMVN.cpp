@@ -10,9 +10,11 @@
 #include "ModelObject.h"
 #include "ModelVector.h"
 #include "Natural.h"
+#include "OptionRule.h"
 #include "Real.h"
 #include "RealPos.h"
 #include "RlDistribution.h"
+#include "RlString.h"
 #include "StringUtilities.h"
 #include "Tree.h"
 #include "TypeSpec.h"
@@ -101,6 +103,10 @@ RevBayesCore::TypedDistribution< RevBayesCore::ContinuousCharacterData >* Dist_P
         dist->setRootState( rs );
 //    }
     
+    // the pruning algorithm computes the same likelihood in linear time
+    const std::string &m = static_cast<const RlString &>( method->getRevObject() ).getValue();
+    dist->setUsePruning( m == "pruning" );
+    
     return dist;
 }
 
@@ -175,6 +181,11 @@ const MemberRules& Dist_PhyloOrnsteinUhlenbeckMVN::getParameterRules(void) const
         
         dist_member_rules.push_back( new ArgumentRule( "nSites"         ,  Natural::getClassTypeSpec(), "The number of sites which is used for the initialized (random draw) from this distribution.", ArgumentRule::BY_VALUE, ArgumentRule::ANY, new Natural(10) ) );
         
+        std::vector<std::string> options_method;
+        options_method.push_back( "covariance" );
+        options_method.push_back( "pruning" );
+        dist_member_rules.push_back( new OptionRule( "method", new RlString("covariance"), options_method, "The algorithm used for the likelihood: the multivariate normal density with the inverted covariance matrix, or pruning along the tree in linear time." ) );
+        
         rules_set = true;
     }
     
@@ -256,6 +267,10 @@ void Dist_PhyloOrnsteinUhlenbeckMVN::setConstParameter(const std::string& name,
     {
         n_sites = var;
     }
+    else if ( name == "method" )
+    {
+        method = var;
+    }
     else
     {
         Distribution::setConstParameter(name, var);
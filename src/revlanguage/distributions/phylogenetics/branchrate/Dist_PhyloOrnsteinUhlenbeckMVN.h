@@ -59,6 +59,7 @@ class TypeSpec;
         RevPtr<const RevVariable>                       sigma;
         RevPtr<const RevVariable>                       root_states;
         RevPtr<const RevVariable>                       n_sites;
+        RevPtr<const RevVariable>                       method;
         
         
     };
@@ -0,0 +1,115 @@
+#include "Func_printLikelihoodTimes.h"
+
+#include <stddef.h>
+#include <iostream>
+
+#include "ArgumentRule.h"
+#include "LikelihoodScheduler.h"
+#include "RevNullObject.h"
+#include "RlBoolean.h"
+#include "TypeSpec.h"
+#include "ArgumentRules.h"
+#include "RbHelpReference.h"
+#include "RevVariable.h"
+#include "RlFunction.h"
+
+using namespace RevLanguage;
+
+Func_printLikelihoodTimes::Func_printLikelihoodTimes() : Procedure()
+{
+
+}
+
+/* Clone object */
+Func_printLikelihoodTimes* Func_printLikelihoodTimes::clone( void ) const
+{
+
+    return new Func_printLikelihoodTimes( *this );
+}
+
+
+/** Execute function: print the summary of the likelihood scheduler */
+RevPtr<RevVariable> Func_printLikelihoodTimes::execute( void )
+{
+
+    bool reset = static_cast<const RlBoolean &>( args[0].getVariable()->getRevObject() ).getValue();
+
+    RevBayesCore::LikelihoodScheduler &scheduler = RevBayesCore::LikelihoodScheduler::likelihoodSchedulerInstance();
+    scheduler.printSummary( std::cout );
+
+    if ( reset == true )
+    {
+        scheduler.resetTimes();
+    }
+
+    return NULL;
+}
+
+
+/** Get argument rules */
+const ArgumentRules& Func_printLikelihoodTimes::getArgumentRules( void ) const
+{
+
+    static ArgumentRules argumentRules = ArgumentRules();
+    static bool rules_set = false;
+
+    if ( !rules_set )
+    {
+
+        argumentRules.push_back( new ArgumentRule( "reset", RlBoolean::getClassTypeSpec(), "Should the times be reset after printing?", ArgumentRule::BY_VALUE, ArgumentRule::ANY, new RlBoolean(false) ) );
+        rules_set = true;
+    }
+
+    return argumentRules;
+}
+
+
+/** Get Rev type of object */
+const std::string& Func_printLikelihoodTimes::getClassType(void)
+{
+
+    static std::string rev_type = "Func_printLikelihoodTimes";
+
+	return rev_type;
+}
+
+
+/** Get class type spec describing type of object */
+const TypeSpec& Func_printLikelihoodTimes::getClassTypeSpec(void)
+{
+
+    static TypeSpec rev_type_spec = TypeSpec( getClassType(), new TypeSpec( Function::getClassTypeSpec() ) );
+
+	return rev_type_spec;
+}
+
+
+/**
+ * Get the primary Rev name for this function.
+ */
+std::string Func_printLikelihoodTimes::getFunctionName( void ) const
+{
+    // create a name variable that is the same for all instance of this class
+    std::string f_name = "printLikelihoodTimes";
+
+    return f_name;
+}
+
+
+
+/** Get type spec */
+const TypeSpec& Func_printLikelihoodTimes::getTypeSpec( void ) const
+{
+
+    static TypeSpec type_spec = getClassTypeSpec();
+
+    return type_spec;
+}
+
+
+/** Get return type */
+const TypeSpec& Func_printLikelihoodTimes::getReturnType( void ) const
+{
+
+    return RevNullObject::getClassTypeSpec();
+}
@@ -0,0 +1,58 @@
+/**
+ * @file
+ * This file contains the declaration and implementation
+ * of the Func_printLikelihoodTimes, which is used to print the time spent in each registered likelihood.
+ *
+ * @brief Declaration and implementation of Func_printLikelihoodTimes
+ *
+ * (c) Copyright 2009- under GPL version 3
+ * @author The RevBayes Development Core Team
+ * @license GPL version 3
+ * @version 1.0
+ */
+
+#ifndef Func_printLikelihoodTimes_H
+#define Func_printLikelihoodTimes_H
+
+#include <iosfwd>
+#include <vector>
+
+#include "Procedure.h"
+#include "RevPtr.h"
+
+namespace RevBayesCore { class RbHelpReference; }
+
+namespace RevLanguage {
+class ArgumentRules;
+class RevVariable;
+class TypeSpec;
+    
+    class Func_printLikelihoodTimes : public Procedure {
+        
+    public:
+        Func_printLikelihoodTimes();
+        
+        // Basic utility functions
+        Func_printLikelihoodTimes*                                 clone(void) const;                                          //!< Clone the object
+        static const std::string&                       getClassType(void);                                         //!< Get Rev type
+        static const TypeSpec&                          getClassTypeSpec(void);                                     //!< Get class type spec
+        std::string                                     getFunctionName(void) const;                                //!< Get the primary name of the function in Rev
+        const TypeSpec&                                 getTypeSpec(void) const;                                    //!< Get language type of the object
+        
+        // Regular functions
+        const ArgumentRules&                            getArgumentRules(void) const;                               //!< Get argument rules
+        const TypeSpec&                                 getReturnType(void) const;                                  //!< Get type of return value
+        
+        
+        RevPtr<RevVariable>                             execute(void);                                              //!< Execute function
+        
+    protected:
+        
+    };
+    
+}
+
+
+#endif
+
+
@@ -2,6 +2,10 @@
 
 #include <math.h>
 #include <stddef.h>
+#include <algorithm>
+#include <cctype>
+#include <fstream>
+#include <functional>
 #include <map>
 #include <set>
 #include <sstream>
@@ -24,6 +28,7 @@
 #include "RlTraceTree.h"
 #include "RlUserInterface.h"
 #include "StringUtilities.h"
+#include "ThreadPool.h"
 #include "TraceTree.h"
 #include "TreeUtilities.h"
 #include "Argument.h"
@@ -57,6 +62,175 @@ namespace RevBayesCore { class Tree; }
 
 using namespace RevLanguage;
 
+
+namespace {
+
+    /**
+     * Count the samples in a tree trace file, i.e., the non-empty lines that are not comments, without the header line.
+     * We scan the file in large blocks instead of reading it line by line.
+     */
+    size_t countSamples(const RevBayesCore::path &fn)
+    {
+
+        std::ifstream in_file( fn.string(), std::ios::binary );
+        if ( !in_file )
+        {
+            throw RbException()<<"Could not open file "<<fn;
+        }
+
+        std::vector<char> buffer( 1 << 22 );
+        size_t lines = 0;
+        bool line_start = true;
+        while ( in_file.good() )
+        {
+            in_file.read( buffer.data(), buffer.size() );
+            std::streamsize n = in_file.gcount();
+            for (std::streamsize i = 0; i < n; ++i)
+            {
+                char c = buffer[i];
+                if ( c == '\n' || c == '\r' )
+                {
+                    line_start = true;
+                }
+                else if ( line_start == true )
+                {
+                    line_start = false;
+                    if ( c != '#' )
+                    {
+                        ++lines;
+                    }
+                }
+            }
+        }
+
+        return ( lines > 0 ? lines - 1 : 0 );
+    }
+
+
+    /**
+     * Extract a single column of a line, with the same rules as StringUtilities::stringSplit
+     * (an empty delimiter stands for any run of whitespace), but without copying all other columns.
+     */
+    std::string extractColumn(const std::string &line, const std::string &delimiter, size_t index)
+    {
+
+        std::string::const_iterator begin = line.begin();
+        std::string::const_iterator end = line.end();
+        if ( delimiter.empty() )
+        {
+            end = std::find_if( line.rbegin(), line.rend(), [](char c) {return not isspace(c);} ).base();
+            begin = std::find_if( line.begin(), end, [](char c) {return not isspace(c);} );
+        }
+
+        for (size_t i = 0; ; ++i)
+        {
+            std::string::const_iterator cut;
+            if ( delimiter.empty() )
+            {
+                cut = std::find_if( begin, end, ::isspace );
+            }
+            else
+            {
+                cut = std::search( begin, end, delimiter.begin(), delimiter.end() );
+            }
+
+            if ( i == index )
+            {
+                return std::string( begin, cut );
+            }
+
+            if ( cut == end )
+            {
+                throw RbException()<<"Missing column "<<(index+1)<<" in line of tree trace: "<<line.substr(0, 100);
+            }
+
+            if ( delimiter.empty() )
+            {
+                begin = std::find_if( cut, end, [](char c) {return not isspace(c);} );
+            }
+            else
+            {
+                begin = cut + delimiter.size();
+            }
+        }
+
+    }
+
+
+    /**
+     * Convert a batch of Newick strings into trees and append them to the trace in their order.
+     * The trees are converted concurrently on the global thread pool.
+     */
+    void addTreesFromNewick(const std::vector<std::string> &newick_strings, bool clock, bool unroot_nonclock, RevBayesCore::TraceTree &trace)
+    {
+
+        size_t num_trees = newick_strings.size();
+        std::vector<RevBayesCore::Tree*> trees( num_trees, NULL );
+
+        RevBayesCore::ThreadPool& pool = RevBayesCore::ThreadPool::threadPoolInstance();
+        size_t num_blocks = std::min( num_trees, 4 * pool.getNumberOfThreads() );
+
+        std::vector< std::function<void(void)> > tasks;
+        for (size_t b = 0; b < num_blocks; ++b)
+        {
+            tasks.push_back( [&, b]()
+            {
+                RevBayesCore::NewickConverter c;
+                for (size_t i = b; i < num_trees; i += num_blocks)
+                {
+                    if ( clock == true )
+                    {
+                        RevBayesCore::Tree *blTree = c.convertFromNewick( newick_strings[i] );
+                        trees[i] = RevBayesCore::TreeUtilities::convertTree( *blTree );
+                        delete blTree;
+                    }
+                    else
+                    {
+                        trees[i] = c.convertFromNewick( newick_strings[i] );
+                        if (unroot_nonclock)
+                        {
+                            trees[i]->removeRootIfDegree2();
+//                          Perhaps we should mark the tree unrooted, since we have removed the old root,
+//                            and chosen a neighbor as the now root.
+//                          However, RevBayes has bugs with unrooted trees and may crash.
+//                            trees[i]->setRooted(false);
+                        }
+                    }
+                }
+            });
+        }
+
+        try
+        {
+            pool.run( tasks );
+        }
+        catch (...)
+        {
+            for (size_t i = 0; i < num_trees; ++i)
+            {
+                delete trees[i];
+            }
+            throw;
+        }
+
+        for (size_t i = 0; i < num_trees; ++i)
+        {
+            trace.addObject( trees[i] );
+        }
+
+    }
+
+
+    /**
+     * Does the thinning skip this sample (counted from 0)?
+     */
+    bool isThinnedOut(size_t sample, long thinning, long offset)
+    {
+        return (sample-offset) % thinning > 0;
+    }
+
+}
+
 /**
  * The clone function is a convenience function to create proper copies of inherited objected.
  * E.g. a.clone() will create a clone of the correct type even if 'a' is of derived type 'b'.
@@ -84,6 +258,7 @@ RevPtr<RevVariable> Func_readTreeTrace::execute( void )
     size_t arg_index_offset    = 7;
     size_t arg_index_nexus     = 8;
     size_t arg_index_nruns     = 9;
+    size_t arg_index_discard   = 10;
 
     // get the information from the arguments for reading the file
     const std::string&  treetype = static_cast<const RlString&>( args[arg_index_tree_type].getVariable()->getRevObject() ).getValue();
@@ -94,6 +269,8 @@ RevPtr<RevVariable> Func_readTreeTrace::execute( void )
     long                offset   = static_cast<const Natural&>( args[arg_index_offset].getVariable()->getRevObject() ).getValue();
     bool nexus = static_cast<RlBoolean&>(args[arg_index_nexus].getVariable()->getRevObject()).getValue();
     long                nruns    = static_cast<const Natural&>( args[arg_index_nruns].getVariable()->getRevObject() ).getValue();
+    const RevObject&    burnin   = args[arg_index_burnin].getVariable()->getRevObject();
+    bool discard_burnin = static_cast<const RlBoolean&>( args[arg_index_discard].getVariable()->getRevObject() ).getValue();
 
     std::vector<RevBayesCore::path> vectorOfFileNames;
     
@@ -170,13 +347,13 @@ RevPtr<RevVariable> Func_readTreeTrace::execute( void )
     WorkspaceVector<TraceTree> *rv = NULL;
     if ( treetype == "clock" )
     {
-        if(nexus) rv = readTreesNexus(vectorOfFileNames, treetype, unroot_nonclock, thin, offset);
-        else rv = readTrees(vectorOfFileNames, sep, treetype, unroot_nonclock, thin, offset);
+        if(nexus) rv = readTreesNexus(vectorOfFileNames, treetype, unroot_nonclock, thin, offset, burnin, discard_burnin);
+        else rv = readTrees(vectorOfFileNames, sep, treetype, unroot_nonclock, thin, offset, burnin, discard_burnin);
     }
     else if ( treetype == "non-clock" )
     {
-        if(nexus) rv = readTreesNexus(vectorOfFileNames, treetype, unroot_nonclock, thin, offset);
-        else rv = readTrees(vectorOfFileNames, sep, treetype, unroot_nonclock, thin, offset);
+        if(nexus) rv = readTreesNexus(vectorOfFileNames, treetype, unroot_nonclock, thin, offset, burnin, discard_burnin);
+        else rv = readTrees(vectorOfFileNames, sep, treetype, unroot_nonclock, thin, offset, burnin, discard_burnin);
         
         RevBayesCore::Clade og;
         if ( args[arg_index_outgroup].getVariable() != NULL && args[arg_index_outgroup].getVariable()->getRevObject() != RevNullObject::getInstance())
@@ -195,27 +372,12 @@ RevPtr<RevVariable> Func_readTreeTrace::execute( void )
         throw RbException("Unknown tree type to read.");
     }
     
-    long burnin = 0;
-
-    RevObject& b = args[arg_index_burnin].getVariable()->getRevObject();
-    if ( b.isType( Integer::getClassTypeSpec() ) )
+    // the burnin samples have already been skipped while reading if they should be discarded
+    if ( discard_burnin == false )
     {
-        burnin = static_cast<const Integer &>(b).getValue();
-
         for(size_t i = 0; i < rv->getValue().size(); i++)
         {
-            (*rv)[i].getValue().setBurnin(burnin);
-        }
-    }
-    else
-    {
-        double burninFrac = static_cast<const Probability &>(b).getValue();
-
-        for(size_t i = 0; i < rv->getValue().size(); i++)
-        {
-            burnin = long( floor( rv->getValue()[i].getValue().size()*burninFrac ) );
-
-            (*rv)[i].getValue().setBurnin(burnin);
+            (*rv)[i].getValue().setBurnin( computeBurnin( burnin, rv->getValue()[i].getValue().size() ) );
         }
     }
 
@@ -266,6 +428,7 @@ const ArgumentRules& Func_readTreeTrace::getArgumentRules( void ) const
         argumentRules.push_back( new ArgumentRule( "nexus", RlBoolean::getClassTypeSpec(), "Whether the file to read is in NEXUS format.", ArgumentRule::BY_VALUE, ArgumentRule::ANY, new RlBoolean(false)) );
 
         argumentRules.push_back( new ArgumentRule( "nruns", Natural::getClassTypeSpec(), "The number of trace files with the same basename (i.e. the number of filenames with pattern <file>_run_<n>.trees", ArgumentRule::BY_VALUE, ArgumentRule::ANY, new Natural( 1l ) ) );
+        argumentRules.push_back( new ArgumentRule( "discardBurnin", RlBoolean::getClassTypeSpec(), "Should the burnin samples be skipped while reading instead of being kept in the trace? This saves time and memory for large tree traces.", ArgumentRule::BY_VALUE, ArgumentRule::ANY, new RlBoolean(false) ) );
 
         rules_set = true;
     }
@@ -316,6 +479,27 @@ const TypeSpec& Func_readTreeTrace::getTypeSpec( void ) const
 }
 
 
+/**
+ * Compute the number of burnin samples of a trace with the given number of samples from the burnin argument,
+ * which is either the number or the fraction of samples to discard.
+ */
+long Func_readTreeTrace::computeBurnin(const RevObject &b, size_t num_samples)
+{
+
+    if ( b.isType( Integer::getClassTypeSpec() ) )
+    {
+        return static_cast<const Integer &>(b).getValue();
+    }
+    else
+    {
+        double burninFrac = static_cast<const Probability &>(b).getValue();
+
+        return long( floor( num_samples*burninFrac ) );
+    }
+
+}
+
+
 /** Get return type */
 const TypeSpec& Func_readTreeTrace::getReturnType( void ) const
 {
@@ -325,42 +509,43 @@ const TypeSpec& Func_readTreeTrace::getReturnType( void ) const
 }
 
 
-WorkspaceVector<TraceTree>* Func_readTreeTrace::readTrees(const std::vector<RevBayesCore::path> &vector_of_file_names, const std::string &delimiter, const std::string& treetype, bool unroot_nonclock, long thinning, long offset)
+/**
+ * Read the tree traces from one or several delimited text files.
+ * The files are streamed: we only extract the tree column of the samples that survive the thinning (and the burnin,
+ * if it is discarded) and convert them in batches on the global thread pool, so the raw lines are never kept in memory.
+ */
+WorkspaceVector<TraceTree>* Func_readTreeTrace::readTrees(const std::vector<RevBayesCore::path> &vector_of_file_names, const std::string &delimiter, const std::string& treetype, bool unroot_nonclock, long thinning, long offset, const RevObject &burnin, bool discard_burnin)
 {
     bool clock = (treetype == "clock");
 
     std::vector<TraceTree> data;
     
-    // Set up a map with the file name to be read as the key and the file type as the value. Note that we may not
-    // read all of the files in the string called "vectorOfFileNames" because some of them may not be in a format
-    // that can be read.
-    std::map<RevBayesCore::path,std::string> file_ap;
+    size_t batch_size = 256 * RevBayesCore::ThreadPool::threadPoolInstance().getNumberOfThreads();
+
     for (auto& fn: vector_of_file_names)
     {
         bool has_header_been_read = false;
         
-        // let us quickly count the number of lines
-        size_t lines = 0;
-        std::ifstream tmp_in_file( fn.string() );
-        
-        if ( !tmp_in_file )
-        {
-            throw RbException()<<"Could not open file "<<fn;
-        }
-        while ( tmp_in_file.good() )
+        // let us quickly count the number of samples
+        size_t num_samples = countSamples( fn );
+
+        // we skip the burnin samples before converting them if they are discarded anyways
+        size_t num_burnin = 0;
+        if ( discard_burnin == true )
         {
-            // Read a line
-            std::string line;
-            RevBayesCore::safeGetline(tmp_in_file, line);
-            if (line.length() == 0 || line[0] == '#')
+            size_t num_kept = 0;
+            for (size_t i = 0; i < num_samples; ++i)
             {
-                continue;
+                if ( isThinnedOut( i, thinning, offset ) == false )
+                {
+                    ++num_kept;
+                }
             }
-            ++lines;
+            long b = computeBurnin( burnin, num_kept );
+            num_burnin = ( b == -1 ? num_kept / 4 : std::min( size_t(b), num_kept ) );
         }
-        tmp_in_file.close();
-        
-        RevBayesCore::ProgressBar progress = RevBayesCore::ProgressBar( lines, 0 );
+
+        RevBayesCore::ProgressBar progress = RevBayesCore::ProgressBar( num_samples, 0 );
 
         // now we actually process the input
         
@@ -373,26 +558,28 @@ WorkspaceVector<TraceTree>* Func_readTreeTrace::readTrees(const std::vector<RevB
         }
         
         /* Initialize */
-        std::string commandLine;
         RBOUT( "Processing file \"" + fn.string() + "\"");
         
         size_t n_samples = 0;
+        size_t n_kept = 0;
         size_t index = 0;
         progress.start();
         
         RevBayesCore::TraceTree t(clock);
         t.setFileName(fn);
 
+        std::vector<std::string> newick_strings;
+        newick_strings.reserve( batch_size );
+
         /* Command-processing loop */
+        std::string line;
         while ( in_file.good() )
         {
             
             // Read a line
-            std::string line;
             RevBayesCore::safeGetline(in_file, line);
             
             // skip empty lines
-            //line = StringByTrimmingCharactersInSet:[NSCharacterSet whitespaceAndNewlineCharacterSet]];
             if (line.length() == 0)
             {
                 continue;
@@ -405,16 +592,13 @@ WorkspaceVector<TraceTree>* Func_readTreeTrace::readTrees(const std::vector<RevB
                 continue;
             }
             
-            // splitting every line into its columns
-            std::vector<std::string> columns;
-            
-            // we should provide other delimiters too
-            StringUtilities::stringSplit(line, delimiter, columns);
-            
             // we assume a header at the first line of the file
             if ( has_header_been_read == false )
             {
-                
+                // splitting the header into its columns
+                std::vector<std::string> columns;
+                StringUtilities::stringSplit(line, delimiter, columns);
+
                 for (size_t j=1; j<columns.size(); j++)
                 {
                     
@@ -439,37 +623,32 @@ WorkspaceVector<TraceTree>* Func_readTreeTrace::readTrees(const std::vector<RevB
             ++n_samples;
             
             // we need to check if we skip this sample in case of thinning.
-            if ( (n_samples-1-offset) % thinning > 0 )
+            if ( isThinnedOut( n_samples-1, thinning, offset ) == true )
             {
                 continue;
             }
-            
-            RevBayesCore::Tree *tau = NULL;
-            if ( clock == true )
+
+            // or if it is part of the discarded burnin
+            ++n_kept;
+            if ( n_kept <= num_burnin )
             {
-                RevBayesCore::NewickConverter c;
-                RevBayesCore::Tree *blTree = c.convertFromNewick( columns[index] );
-                tau = RevBayesCore::TreeUtilities::convertTree( *blTree );
+                continue;
             }
-            else
+            
+            newick_strings.push_back( extractColumn( line, delimiter, index ) );
+
+            if ( newick_strings.size() == batch_size )
             {
-                RevBayesCore::NewickConverter c;
-                tau = c.convertFromNewick( columns[index] );
-                if (unroot_nonclock)
-                {
-                    tau->removeRootIfDegree2();
-//                  Perhaps we should mark the tree unrooted, since we have removed the old root,
-//                    and chosen a neighbor as the now root.
-//                  However, RevBayes has bugs with unrooted trees and may crash.
-//                    tau->setRooted(false);
-                }
+                addTreesFromNewick( newick_strings, clock, unroot_nonclock, t );
+                newick_strings.clear();
+                progress.update( n_samples );
             }
             
-            t.addObject( tau );
-            progress.update( n_samples );
-            
         }
         in_file.close();
+
+        addTreesFromNewick( newick_strings, clock, unroot_nonclock, t );
+        progress.update( n_samples );
         
         progress.finish();
 
@@ -483,12 +662,14 @@ WorkspaceVector<TraceTree>* Func_readTreeTrace::readTrees(const std::vector<RevB
  * @param fns vector of file names
  * @param clock whether trees have a clock
  * @param thin keep only every thin-th sample
+ * @param burnin the number or fraction of burnin samples
+ * @param discard_burnin whether the burnin trees are dropped instead of being kept in the trace
  * @return tree trace
  * @see Func_readTrees::execute
  *
  * @note if multiple files are given, the traces will all be appended without regard for burnin
  * */
-WorkspaceVector<TraceTree>* Func_readTreeTrace::readTreesNexus(const std::vector<RevBayesCore::path> &fns, const string& treetype, bool unroot_nonclock, long thin, long offset)
+WorkspaceVector<TraceTree>* Func_readTreeTrace::readTreesNexus(const std::vector<RevBayesCore::path> &fns, const string& treetype, bool unroot_nonclock, long thin, long offset, const RevObject &burnin, bool discard_burnin)
 {
     std::vector<TraceTree> data;
 
@@ -514,21 +695,46 @@ WorkspaceVector<TraceTree>* Func_readTreeTrace::readTreesNexus(const std::vector
         int nsamples = 0;
         if (tmp)
         {
+            std::vector<RevBayesCore::Tree*> kept;
             for (auto& tree: *tmp)
             {
                 if ( (nsamples-offset) % thin == 0)
                 {
-                    if (unroot_nonclock)
-                    {
-                        tree->removeRootIfDegree2();
-                        tree->setRooted(false);
-                    }
-
-                    tt.addObject(tree);
+                    kept.push_back(tree);
+                }
+                else
+                {
+                    delete tree;
                 }
                 nsamples++;
             }
             delete tmp;
+
+            // the trees have been parsed already, but we do not need to keep the burnin
+            size_t num_burnin = 0;
+            if ( discard_burnin == true )
+            {
+                long b = computeBurnin( burnin, kept.size() );
+                num_burnin = ( b == -1 ? kept.size() / 4 : std::min( size_t(b), kept.size() ) );
+            }
+
+            for (size_t i = 0; i < kept.size(); ++i)
+            {
+                RevBayesCore::Tree* tree = kept[i];
+                if ( i < num_burnin )
+                {
+                    delete tree;
+                    continue;
+                }
+
+                if (unroot_nonclock)
+                {
+                    tree->removeRootIfDegree2();
+                    tree->setRooted(false);
+                }
+
+                tt.addObject(tree);
+            }
         }
 
         data.push_back(TraceTree(tt));
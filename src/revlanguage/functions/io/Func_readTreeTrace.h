@@ -34,8 +34,9 @@ namespace RevLanguage {
         
     private:
         
-        WorkspaceVector<TraceTree>*         readTrees(const std::vector<RevBayesCore::path> &fns, const std::string &d, const std::string& treetype, bool unroot_nonclock, long thin, long offset);
-        WorkspaceVector<TraceTree>*         readTreesNexus(const std::vector<RevBayesCore::path> &fns, const std::string& treetype, bool unroot_nonclock, long thin, long offset);  //!< Read tree trace from Nexus file(s)
+        static long                         computeBurnin(const RevObject &burnin, size_t n);                                   //!< The number of burnin samples of a trace with n samples
+        WorkspaceVector<TraceTree>*         readTrees(const std::vector<RevBayesCore::path> &fns, const std::string &d, const std::string& treetype, bool unroot_nonclock, long thin, long offset, const RevObject &burnin, bool discard_burnin);
+        WorkspaceVector<TraceTree>*         readTreesNexus(const std::vector<RevBayesCore::path> &fns, const std::string& treetype, bool unroot_nonclock, long thin, long offset, const RevObject &burnin, bool discard_burnin);  //!< Read tree trace from Nexus file(s)
     };
     
 }
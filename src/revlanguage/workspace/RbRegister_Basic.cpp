@@ -139,6 +139,7 @@
 #include "Func_license.h"
 #include "Func_listOptions.h"
 #include "Func_ls.h"
+#include "Func_printLikelihoodTimes.h"
 #include "Func_printSeed.h"
 #include "Func_quit.h"
 #include "Func_range.h"
@@ -323,6 +324,7 @@ void RevLanguage::Workspace::initializeBasicGlobalWorkspace(void)
         addFunction( new Func_license()                     );
         addFunction( new Func_listOptions()                 );
         addFunction( new Func_ls()                          );
+        addFunction( new Func_printLikelihoodTimes()        );
         addFunction( new Func_printSeed()                   );
         addFunction( new Func_quit()                        );
         addFunction( new Func_replicate<Integer>()          );